@@ -170,6 +170,12 @@ extern void _ldivu_(ldivu_t *ld,unsigned long numer,unsigned long denom);
 extern void _insertion_sort_(void *base,size_t nmemb,size_t size,void *compar);
 
 
+extern void _introsort_(void *base,size_t nmemb,size_t size,void *compar);
+
+
+extern void _mergesort_(void *base,size_t nmemb,size_t size,void *compar,void *buffer);
+
+
 extern void _quicksort_(void *base,size_t nmemb,size_t size,void *compar);
 
 
@@ -6,6 +6,7 @@
 #define __THREADS_H__
 
 #include <stdint.h>
+#include <time.h>
 
 // DATA STRUCTURES
 
@@ -24,6 +25,31 @@ typedef struct mtx_s
 typedef uint16_t       once_flag;
 #define ONCE_FLAG_INIT 0x00fe
 
+typedef int (*thrd_start_t)(void *);
+
+// A thread is identified by a pointer to its struct thrd_s, which
+// thrd_create_stack() places at the top of the thread's stack
+
+struct thrd_s
+{
+
+   void    *next;         // ready list or wait queue link
+   uint8_t  priority;     // higher values run first
+   uint8_t  id;
+   uint8_t  state;        // 0 = ready or running, 1 = waiting, 2 = exited
+   void    *sp;           // stack pointer while suspended
+   void    *sleep_next;   // sleep list link
+   uint16_t ticks;        // ticks until sleep or timeout ends
+   void    *q;            // p_forward_list * waited on
+   int      result;       // exit code once exited
+   void    *join_q;       // p_forward_list *
+
+};
+
+typedef struct thrd_s *thrd_t;
+
+#define thrd_equal(thr0, thr1)  ((thr0) == (thr1))
+
 // mutex
 
 extern void call_once(once_flag *flag,void *func);
@@ -57,4 +83,34 @@ extern int spinlock_tryacquire(char *spinlock);
 
 
 
+// scheduler
+
+extern int thrd_create_stack(thrd_t *thr,void *stack,thrd_start_t func,void *arg);
+
+
+extern thrd_t thrd_current(void);
+
+
+extern void thrd_exit(int res);
+
+
+extern int thrd_join(thrd_t thr,int *res);
+
+
+extern void thrd_scheduler_init(uint16_t ticks_per_second,uint8_t timeslice);
+
+
+extern void thrd_scheduler_isr(void);
+
+
+extern void thrd_set_priority(thrd_t thr,uint8_t priority);
+
+
+extern int thrd_sleep(struct timespec *duration,struct timespec *remaining);
+
+
+extern void thrd_yield(void);
+
+
+
 #endif
@@ -158,6 +158,8 @@ __DPROTO(,,void,,_divu_,divu_t *d,unsigned int numer,unsigned int denom)
 __DPROTO(,,void,,_ldiv_,ldiv_t *ld,long numer,long denom)
 __DPROTO(,,void,,_ldivu_,ldivu_t *ld,unsigned long numer,unsigned long denom)
 __DPROTO(,,void,,_insertion_sort_,void *base,size_t nmemb,size_t size,void *compar)
+__DPROTO(,,void,,_introsort_,void *base,size_t nmemb,size_t size,void *compar)
+__DPROTO(,,void,,_mergesort_,void *base,size_t nmemb,size_t size,void *compar,void *buffer)
 __DPROTO(,,void,,_quicksort_,void *base,size_t nmemb,size_t size,void *compar)
 __DPROTO(,,void,,_shellsort_,void *base,size_t nmemb,size_t size,void *compar)
 __DPROTO(,,uint16_t,,_random_uniform_cmwc_8_,void *seed)
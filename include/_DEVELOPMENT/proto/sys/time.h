@@ -51,10 +51,13 @@ extern "C" {
  * and used in other calls.
  */
  
+#ifndef _TIMESPEC
+#define _TIMESPEC
 struct timespec {
     time_t      tv_sec;     /* seconds */
     nseconds_t  tv_nsec;    /* and nanoseconds */
 };
+#endif
 
 enum clockid_t {
     CLOCK_REALTIME,
@@ -4,6 +4,7 @@ include(__link__.m4)
 #define __THREADS_H__
 
 #include <stdint.h>
+#include <time.h>
 
 // DATA STRUCTURES
 
@@ -22,6 +23,31 @@ typedef struct mtx_s
 typedef uint16_t       once_flag;
 #define ONCE_FLAG_INIT 0x00fe
 
+typedef int (*thrd_start_t)(void *);
+
+// A thread is identified by a pointer to its struct thrd_s, which
+// thrd_create_stack() places at the top of the thread's stack
+
+struct thrd_s
+{
+
+   void    *next;         // ready list or wait queue link
+   uint8_t  priority;     // higher values run first
+   uint8_t  id;
+   uint8_t  state;        // 0 = ready or running, 1 = waiting, 2 = exited
+   void    *sp;           // stack pointer while suspended
+   void    *sleep_next;   // sleep list link
+   uint16_t ticks;        // ticks until sleep or timeout ends
+   void    *q;            // p_forward_list * waited on
+   int      result;       // exit code once exited
+   void    *join_q;       // p_forward_list *
+
+};
+
+typedef struct thrd_s *thrd_t;
+
+#define thrd_equal(thr0, thr1)  ((thr0) == (thr1))
+
 // mutex
 
 __DPROTO(,,void,,call_once,once_flag *flag,void *func)
@@ -35,4 +61,16 @@ __DPROTO(`a,b,c,d,e,h,l',`b,c,d,e',void,,spinlock_acquire,char *spinlock)
 __DPROTO(`a,b,c,d,e,h,l',`b,c,d,e',void,,spinlock_release,char *spinlock)
 __DPROTO(`a,b,c,d,e',`b,c,d,e',int,,spinlock_tryacquire,char *spinlock)
 
+// scheduler
+
+__DPROTO(,,int,,thrd_create_stack,thrd_t *thr,void *stack,thrd_start_t func,void *arg)
+__OPROTO(`a,b,c,d,e',`a,b,c,d,e',thrd_t,,thrd_current,void)
+__DPROTO(,,void,,thrd_exit,int res)
+__DPROTO(,,int,,thrd_join,thrd_t thr,int *res)
+__DPROTO(,,void,,thrd_scheduler_init,uint16_t ticks_per_second,uint8_t timeslice)
+__OPROTO(,,void,,thrd_scheduler_isr,void)
+__DPROTO(,,void,,thrd_set_priority,thrd_t thr,uint8_t priority)
+__DPROTO(,,int,,thrd_sleep,struct timespec *duration,struct timespec *remaining)
+__OPROTO(`a,b,c,d,e,h,l',`a,b,c,d,e,h,l',void,,thrd_yield,void)
+
 #endif
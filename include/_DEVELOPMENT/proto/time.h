@@ -30,6 +30,28 @@ struct tm
    // const unsigned char tm_zone[6];   // name of timezone
 };
 
+// Durations for thrd_sleep() and mtx_timedlock()
+// (struct timespec is shared with sys/time.h)
+
+#ifndef _TIME_T
+#define _TIME_T
+typedef long time_t;
+#endif
+
+#ifndef _NSECONDS_T
+#define _NSECONDS_T
+typedef unsigned long nseconds_t;
+#endif
+
+#ifndef _TIMESPEC
+#define _TIMESPEC
+struct timespec
+{
+   time_t      tv_sec;     // seconds
+   nseconds_t  tv_nsec;    // 0-999999999 nanoseconds
+};
+#endif
+
 // MSDOS Time for FAT
 
 struct dos_tm
@@ -180,6 +180,16 @@ extern void _insertion_sort__callee(void *base,size_t nmemb,size_t size,void *co
 #define _insertion_sort_(a,b,c,d) _insertion_sort__callee(a,b,c,d)
 
 
+extern void _introsort_(void *base,size_t nmemb,size_t size,void *compar);
+extern void _introsort__callee(void *base,size_t nmemb,size_t size,void *compar) __z88dk_callee;
+#define _introsort_(a,b,c,d) _introsort__callee(a,b,c,d)
+
+
+extern void _mergesort_(void *base,size_t nmemb,size_t size,void *compar,void *buffer);
+extern void _mergesort__callee(void *base,size_t nmemb,size_t size,void *compar,void *buffer) __z88dk_callee;
+#define _mergesort_(a,b,c,d,e) _mergesort__callee(a,b,c,d,e)
+
+
 extern void _quicksort_(void *base,size_t nmemb,size_t size,void *compar);
 extern void _quicksort__callee(void *base,size_t nmemb,size_t size,void *compar) __z88dk_callee;
 #define _quicksort_(a,b,c,d) _quicksort__callee(a,b,c,d)
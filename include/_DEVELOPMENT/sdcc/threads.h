@@ -6,6 +6,7 @@
 #define __THREADS_H__
 
 #include <stdint.h>
+#include <time.h>
 
 // DATA STRUCTURES
 
@@ -24,6 +25,31 @@ typedef struct mtx_s
 typedef uint16_t       once_flag;
 #define ONCE_FLAG_INIT 0x00fe
 
+typedef int (*thrd_start_t)(void *);
+
+// A thread is identified by a pointer to its struct thrd_s, which
+// thrd_create_stack() places at the top of the thread's stack
+
+struct thrd_s
+{
+
+   void    *next;         // ready list or wait queue link
+   uint8_t  priority;     // higher values run first
+   uint8_t  id;
+   uint8_t  state;        // 0 = ready or running, 1 = waiting, 2 = exited
+   void    *sp;           // stack pointer while suspended
+   void    *sleep_next;   // sleep list link
+   uint16_t ticks;        // ticks until sleep or timeout ends
+   void    *q;            // p_forward_list * waited on
+   int      result;       // exit code once exited
+   void    *join_q;       // p_forward_list *
+
+};
+
+typedef struct thrd_s *thrd_t;
+
+#define thrd_equal(thr0, thr1)  ((thr0) == (thr1))
+
 // mutex
 
 extern void call_once(once_flag *flag,void *func);
@@ -77,4 +103,43 @@ extern int spinlock_tryacquire_fastcall(char *spinlock) __preserves_regs(a,b,c,d
 
 
 
+// scheduler
+
+extern int thrd_create_stack(thrd_t *thr,void *stack,thrd_start_t func,void *arg);
+extern int thrd_create_stack_callee(thrd_t *thr,void *stack,thrd_start_t func,void *arg) __z88dk_callee;
+#define thrd_create_stack(a,b,c,d) thrd_create_stack_callee(a,b,c,d)
+
+
+extern thrd_t thrd_current(void) __preserves_regs(a,b,c,d,e);
+
+extern void thrd_exit(int res);
+extern void thrd_exit_fastcall(int res) __z88dk_fastcall;
+#define thrd_exit(a) thrd_exit_fastcall(a)
+
+
+extern int thrd_join(thrd_t thr,int *res);
+extern int thrd_join_callee(thrd_t thr,int *res) __z88dk_callee;
+#define thrd_join(a,b) thrd_join_callee(a,b)
+
+
+extern void thrd_scheduler_init(uint16_t ticks_per_second,uint8_t timeslice);
+extern void thrd_scheduler_init_callee(uint16_t ticks_per_second,uint8_t timeslice) __z88dk_callee;
+#define thrd_scheduler_init(a,b) thrd_scheduler_init_callee(a,b)
+
+
+extern void thrd_scheduler_isr(void);
+
+extern void thrd_set_priority(thrd_t thr,uint8_t priority);
+extern void thrd_set_priority_callee(thrd_t thr,uint8_t priority) __z88dk_callee;
+#define thrd_set_priority(a,b) thrd_set_priority_callee(a,b)
+
+
+extern int thrd_sleep(struct timespec *duration,struct timespec *remaining);
+extern int thrd_sleep_callee(struct timespec *duration,struct timespec *remaining) __z88dk_callee;
+#define thrd_sleep(a,b) thrd_sleep_callee(a,b)
+
+
+extern void thrd_yield(void) __preserves_regs(a,b,c,d,e,h,l);
+
+
 #endif
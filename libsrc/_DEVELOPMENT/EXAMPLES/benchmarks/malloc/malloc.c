@@ -0,0 +1,155 @@
+/*
+ * MALLOC/FREE
+ *
+ * Allocate and free many small, short-lived objects among a
+ * smaller number of larger, long-lived ones so that the heap
+ * becomes fragmented as the program runs.
+ */
+
+/*
+ * COMMAND LINE DEFINES
+ * 
+ * -DLIVE=N
+ * Number of objects alive at the same time (default 200).
+ *
+ * -DCHURN=N
+ * Number of objects freed and replaced (default 5000).
+ *
+ * -DSTATIC
+ * Use static variables instead of locals.
+ *
+ * -DPRINTF
+ * Enable printing of results.
+ *
+ * -DTIMER
+ * Insert asm labels into source code at timing points (Z88DK).
+ *
+ * MALLOC and FREE
+ * Can be defined to replace malloc() and free().
+ *
+ */
+
+#ifdef STATIC
+   #undef  STATIC
+   #define STATIC            static
+#else
+   #define STATIC
+#endif
+
+#ifdef PRINTF
+   #define PRINTF2(a,b)      printf(a,b)
+#else
+   #define PRINTF2(a,b)
+#endif
+
+#ifdef TIMER
+   #define TIMER_START()     intrinsic_label(TIMER_START)
+   #define TIMER_STOP()      intrinsic_label(TIMER_STOP)
+#else
+   #define TIMER_START()
+   #define TIMER_STOP()
+#endif
+
+#ifndef MALLOC
+   #define MALLOC  malloc
+#endif
+
+#ifndef FREE
+   #define FREE    free
+#endif
+
+#ifndef LIVE
+   #define LIVE    200
+#endif
+
+#ifndef CHURN
+   #define CHURN   5000
+#endif
+
+#ifdef __Z88DK
+   #include <intrinsic.h>
+   #ifdef PRINTF
+      // enable printf %u
+      #pragma output CLIB_OPT_PRINTF = 0x02
+   #endif
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+unsigned char *objects[LIVE];
+unsigned int seed = 1;
+
+unsigned int g_rand(void)
+{
+   /* 16-bit xorshift so that all compilers see the same sequence */
+   seed ^= seed << 7;
+   seed ^= seed >> 9;
+   seed ^= seed << 8;
+
+   return seed;
+}
+
+unsigned char *new_object(unsigned int i)
+{
+   unsigned char *p;
+   unsigned int   size;
+
+   /* one object in eight is large, the rest hold 2 to 32 bytes */
+
+   if ((i & 7) == 0)
+      size = 33 + g_rand() % 96;
+   else
+      size = 2 + g_rand() % 31;
+
+   p = MALLOC(size);
+
+#ifdef PRINTF
+   if (p == NULL)
+   {
+      printf("Out of Memory, size %u\n", size);
+      exit(1);
+   }
+#endif
+
+   p[0] = i;
+   p[size - 1] = i;
+
+   return p;
+}
+
+int main(void)
+{
+   STATIC unsigned int i, j, check;
+
+TIMER_START();
+
+   for (i = 0; i < LIVE; ++i)
+      objects[i] = new_object(i);
+
+   check = 0;
+
+   for (i = 0; i < CHURN; ++i)
+   {
+      /* objects at indices that are multiples of 8 live longer */
+
+      j = g_rand() % LIVE;
+
+      if (((j & 7) == 0) && (g_rand() & 15))
+         j |= 1;
+
+      check += objects[j][0];
+
+      FREE(objects[j]);
+      objects[j] = new_object(j);
+   }
+
+   for (i = 0; i < LIVE; ++i)
+      FREE(objects[i]);
+
+TIMER_STOP();
+
+   PRINTF2("check: %u\n", check);
+
+   return 0;
+}
@@ -5,7 +5,12 @@
  * Set size of array to be sorted (>10).
  *
  * -DSTYLE=N
- * 0 = random, 1 = in order, 2 = reverse order, 3 = all same
+ * 0 = random, 1 = in order, 2 = reverse order, 3 = all same,
+ * 4 = random with many duplicates
+ *
+ * -DMERGESORT
+ * Call z88dk's stable merge sort with a scratch buffer instead
+ * of qsort.
  *
  * -DPRINTF
  * Enable printf.
@@ -49,6 +54,10 @@
 int i;
 int numbers[NUM];
 
+#ifdef MERGESORT
+int buffer[NUM/2];
+#endif
+
 int g_rand(void);
 
 int ascending_order(int *a, int *b)
@@ -61,7 +70,11 @@ void perform_sort(void)
 {
 TIMER_START();
 
+#ifdef MERGESORT
+   _mergesort_(numbers, NUM, sizeof(int), ascending_order, buffer);
+#else
    qsort(numbers, NUM, sizeof(int), ascending_order);
+#endif
 
 TIMER_STOP();
 }
@@ -82,7 +95,11 @@ int main(void)
 #if STYLE == 2
       numbers[i] = NUM - i - 1;
 #else
+#if STYLE == 3
       numbers[i] = NUM/2;
+#else
+      numbers[i] = g_rand() & 0x0f;
+#endif
 #endif
 #endif
 #endif
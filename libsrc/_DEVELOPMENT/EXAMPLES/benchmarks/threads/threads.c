@@ -0,0 +1,127 @@
+/*
+ * THREADS
+ *
+ * Run threads of equal priority that never give up the cpu so
+ * that every switch between them is made by the scheduler when
+ * it is entered from the timer interrupt.
+ */
+
+/*
+ * COMMAND LINE DEFINES
+ * 
+ * -DTHREADS=N
+ * Number of worker threads (default 3).
+ *
+ * -DCOUNT=N
+ * Iterations of each worker's loop (default 20000).
+ *
+ * -DSTACK=N
+ * Bytes of stack for each worker (default 128).
+ *
+ * -DPRINTF
+ * Enable printing of results.
+ *
+ * -DTIMER
+ * Insert asm labels into source code at timing points (Z88DK).
+ *
+ */
+
+#ifdef PRINTF
+   #define PRINTF2(a,b)      printf(a,b)
+#else
+   #define PRINTF2(a,b)
+#endif
+
+#ifdef TIMER
+   #define TIMER_START()     intrinsic_label(TIMER_START)
+   #define TIMER_STOP()      intrinsic_label(TIMER_STOP)
+#else
+   #define TIMER_START()
+   #define TIMER_STOP()
+#endif
+
+#ifndef THREADS
+   #define THREADS 3
+#endif
+
+#ifndef COUNT
+   #define COUNT   20000
+#endif
+
+#ifndef STACK
+   #define STACK   128
+#endif
+
+#ifdef PRINTF
+   // enable printf %u
+   #pragma output CLIB_OPT_PRINTF = 0x02
+#endif
+
+#include <stdio.h>
+#include <threads.h>
+#include <im2.h>
+#include <intrinsic.h>
+
+thrd_t thr[THREADS];
+unsigned char stacks[THREADS][STACK];
+unsigned int work[THREADS];
+
+thrd_t last;
+unsigned int switches;
+
+int worker(void *arg)
+{
+   thrd_t self;
+   unsigned int i;
+
+   self = thrd_current();
+
+   /* the thread that finds another thread's handle in last was
+      switched to since it last ran */
+
+   for (i = 0; i < COUNT; ++i)
+   {
+      if (!thrd_equal(last, self))
+      {
+         last = self;
+         ++switches;
+      }
+
+      ++*(unsigned int *)arg;
+   }
+
+   return 0;
+}
+
+int main(void)
+{
+   unsigned int i, check;
+
+   im2_init((void *)0xd000);
+   im2_install_isr(0xff, thrd_scheduler_isr);
+
+   /* 50 ticks per second, a timeslice of one tick */
+
+   thrd_scheduler_init(50, 1);
+   intrinsic_ei();
+
+TIMER_START();
+
+   for (i = 0; i < THREADS; ++i)
+      thrd_create_stack(&thr[i], stacks[i] + STACK, worker, &work[i]);
+
+   check = 0;
+
+   for (i = 0; i < THREADS; ++i)
+   {
+      thrd_join(thr[i], 0);
+      check += work[i];
+   }
+
+TIMER_STOP();
+
+   PRINTF2("check: %u\n", check);
+   PRINTF2("switches: %u\n", switches);
+
+   return 0;
+}
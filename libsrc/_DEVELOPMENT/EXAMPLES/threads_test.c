@@ -0,0 +1,171 @@
+// Checks of the preemptive thread scheduler, run under ticks
+//
+// zcc +z80 -vn -startup=0 -O2 -clib=new threads_test.c -o threads_test -create-app
+// zcc +z80 -vn -startup=0 -SO3 -clib=sdcc_iy --max-allocs-per-node200000 threads_test.c -o threads_test -create-app
+//
+// z88dk-ticks -w 10 -int 70000 threads_test.bin
+//
+// ticks exits with 0 if all checks pass, otherwise with the number of
+// the check that failed.  -int is the period in cycles of the timer
+// interrupt that drives the scheduler; without it the timed lock never
+// expires and ticks gives up after 10 seconds with exit code 1.
+
+#include <arch.h>
+#include <threads.h>
+#include <time.h>
+#include <im2.h>
+#include <intrinsic.h>
+
+static thrd_t t1, t2, t3, t4;
+static unsigned char s1[256], s2[256], s3[256], s4[256];
+
+static mtx_t m;
+static unsigned int shared;
+static unsigned int count1, count2;
+
+static thrd_t timed_self;
+static int timed_result;
+
+static unsigned char order[2];
+static unsigned char order_n;
+
+// leave ticks with hl as the exit code
+
+void ticks_exit(int code) __z88dk_fastcall __naked
+{
+   __asm
+   ld a,0                      ; CMD_EXIT
+   defb $ed, $fe
+   __endasm;
+}
+
+// 1 if interrupts are enabled
+
+int ints_enabled(void) __naked
+{
+   __asm
+   ld hl,0
+   ld a,i
+   ret po
+   inc l
+   ret
+   __endasm;
+}
+
+// two workers count under the same mutex
+
+int worker(void *arg)
+{
+   unsigned int i, j;
+
+   for (i = 0; i < 300; ++i)
+   {
+      mtx_lock(&m);
+      j = shared;
+      intrinsic_nop();
+      intrinsic_nop();
+      intrinsic_nop();
+      shared = j + 1;
+      mtx_unlock(&m);
+
+      ++*(unsigned int *)arg;
+   }
+
+   return 7;
+}
+
+// waits for a mutex held by main for longer than it is prepared to
+
+int timed(void *arg)
+{
+   static struct timespec ts = { 0, 60000000 };   // 3 ticks
+
+   timed_self = thrd_current();
+   timed_result = mtx_timedlock(&m, &ts);
+
+   return 0;
+}
+
+// notes the order in which sleepers wake
+
+static struct timespec sleep_ts = { 0, 20000000 };   // 1 tick
+
+int sleeper(void *arg)
+{
+   thrd_sleep(&sleep_ts, 0);
+   order[order_n++] = (unsigned int)arg;
+
+   return (unsigned int)arg;
+}
+
+int main(void)
+{
+   int res;
+
+   im2_init((void *)0xd000);
+   im2_install_isr(0xff, thrd_scheduler_isr);
+
+   thrd_scheduler_init(50, 1);
+   mtx_init(&m, mtx_timed);
+
+   intrinsic_ei();
+
+   // 1-3: two threads contend for a mutex under preemption
+
+   if (thrd_create_stack(&t1, s1 + sizeof(s1), worker, &count1) != thrd_success) ticks_exit(1);
+   if (thrd_create_stack(&t2, s2 + sizeof(s2), worker, &count2) != thrd_success) ticks_exit(1);
+
+   if (thrd_join(t1, &res) != thrd_success || res != 7) ticks_exit(2);
+   if (thrd_join(t2, &res) != thrd_success || res != 7) ticks_exit(2);
+
+   if (shared != 600 || count1 != 300 || count2 != 300) ticks_exit(3);
+
+   // 4-5: a timed lock expires while main holds the mutex
+
+   mtx_lock(&m);
+
+   thrd_create_stack(&t3, s3 + sizeof(s3), timed, 0);
+   thrd_join(t3, 0);
+
+   if (!thrd_equal(timed_self, t3) || (unsigned char *)t3 != s3 + sizeof(s3) - sizeof(struct thrd_s)) ticks_exit(4);
+
+   mtx_unlock(&m);
+
+   if (timed_result != thrd_timedout) ticks_exit(5);
+
+   // 6-7: the higher priority sleeper runs first when both wake
+
+   thrd_create_stack(&t3, s3 + sizeof(s3), sleeper, (void *)1);
+   thrd_create_stack(&t4, s4 + sizeof(s4), sleeper, (void *)2);
+   thrd_set_priority(t4, 10);
+
+   thrd_join(t3, &res);
+   if (res != 1) ticks_exit(6);
+
+   thrd_join(t4, &res);
+   if (res != 2) ticks_exit(6);
+
+   if (order_n != 2 || order[0] != 2 || order[1] != 1) ticks_exit(7);
+
+   // 8-9: the scheduler returns with interrupts as they were
+
+   intrinsic_di();
+
+   thrd_yield();
+   if (ints_enabled()) ticks_exit(8);
+
+   mtx_lock(&m);
+   mtx_unlock(&m);
+   if (ints_enabled()) ticks_exit(8);
+
+   thrd_sleep(&sleep_ts, 0);
+   if (ints_enabled()) ticks_exit(8);
+
+   intrinsic_ei();
+
+   thrd_yield();
+   if (!ints_enabled()) ticks_exit(9);
+
+   ticks_exit(0);
+   return 0;
+}
@@ -0,0 +1,87 @@
+
+INCLUDE "config_private.inc"
+
+SECTION code_clib
+SECTION code_alloc_malloc
+
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+
+PUBLIC __heap_flush_lists
+
+EXTERN __heap_free_block
+
+__heap_flush_lists:
+
+   ; Return the blocks on the free lists of the size classes to
+   ; the chain of blocks so that their space can be joined with
+   ; the spare space around them
+   ;
+   ; enter : de = void *heap
+   ;
+   ; exit  : bc, de, hl unchanged
+   ;
+   ;         carry set if the free lists were empty
+   ;
+   ; uses  : af
+
+   push hl
+   push bc
+   push de
+
+   ld hl,12                    ; sizeof(mutex) + sizeof(heap header)
+   add hl,de                   ; hl = & free lists
+
+   ld bc,$0800                 ; b = number of size classes, c = 0 if nothing returned
+
+list_loop:
+
+   ld e,(hl)
+   ld (hl),0
+   inc hl
+   ld d,(hl)                   ; de = first block on free list
+   ld (hl),0                   ; free list = empty
+   inc hl
+
+block_loop:
+
+   ; bc = class count, returned flag
+   ; de = void *p
+   ; hl = & next free list
+
+   ld a,d
+   or e
+   jr z, list_end              ; if end of free list
+
+   push hl
+   push bc
+
+   ex de,hl
+
+   ld e,(hl)
+   inc hl
+   ld d,(hl)                   ; de = p->next
+   dec hl
+
+   push de
+   call __heap_free_block
+   pop de
+
+   pop bc
+   pop hl
+
+   ld c,1                      ; a block was returned
+   jr block_loop
+
+list_end:
+
+   djnz list_loop
+
+   ld a,c
+   sub 1                       ; carry set if no blocks were returned
+
+   pop de
+   pop bc
+   pop hl
+   ret
+
+ENDIF
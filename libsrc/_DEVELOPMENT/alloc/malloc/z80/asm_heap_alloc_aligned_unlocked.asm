@@ -17,6 +17,8 @@
 ;
 ; ===============================================================
 
+INCLUDE "config_private.inc"
+
 SECTION code_clib
 SECTION code_alloc_malloc
 
@@ -25,6 +27,10 @@ PUBLIC asm_heap_alloc_aligned_unlocked
 EXTERN __heap_place_block, __heap_allocate_block, l_andc_hl_bc
 EXTERN l_power_2_bc, asm_heap_alloc_unlocked, error_enomem_zc, error_einval_zc
 
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+EXTERN __heap_flush_lists
+ENDIF
+
 asm_heap_alloc_aligned_unlocked:
 
    ; Attempt to allocate memory at an address that is aligned to a power of 2
@@ -68,6 +74,10 @@ asm_heap_alloc_aligned_unlocked:
    ; hl = size
    ; bc = alignment - 1
 
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+   call __heap_flush_lists     ; search the whole chain of blocks
+ENDIF
+
    push bc                     ; save alignment - 1
    
    ld bc,6                     ; sizeof(heap header)
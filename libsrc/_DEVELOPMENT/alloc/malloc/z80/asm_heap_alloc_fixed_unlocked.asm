@@ -15,6 +15,8 @@
 ;
 ; ===============================================================
 
+INCLUDE "config_private.inc"
+
 SECTION code_clib
 SECTION code_alloc_malloc
 
@@ -22,6 +24,10 @@ PUBLIC asm_heap_alloc_fixed_unlocked
 
 EXTERN l_ltu_de_hl, __heap_place_block, __heap_allocate_block, error_enomem_zc
 
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+EXTERN __heap_flush_lists
+ENDIF
+
 asm_heap_alloc_fixed_unlocked:
 
    ; Attempt to allocate memory from a heap at a fixed
@@ -43,6 +49,10 @@ asm_heap_alloc_fixed_unlocked:
    ;
    ; uses  : af, bc, de, hl
 
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+   call __heap_flush_lists     ; blocks on free lists may cover p
+ENDIF
+
    push hl                     ; save size
 
    ld hl,6                     ; sizeof(mutex)
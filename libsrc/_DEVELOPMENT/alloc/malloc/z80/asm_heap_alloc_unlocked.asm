@@ -12,6 +12,8 @@
 ;
 ; ===============================================================
 
+INCLUDE "config_private.inc"
+
 SECTION code_clib
 SECTION code_alloc_malloc
 
@@ -19,6 +21,10 @@ PUBLIC asm_heap_alloc_unlocked
 
 EXTERN __heap_allocate_block, error_enomem_zc
 
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+EXTERN __heap_flush_lists
+ENDIF
+
 asm_heap_alloc_unlocked:
 
    ; Allocate memory from a heap without locking
@@ -41,6 +47,69 @@ asm_heap_alloc_unlocked:
    ld a,h
    or l
    ret z                       ; return 0 if size == 0
+
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+
+   ; requests of up to 32 bytes are rounded up to a size class
+   ; and taken from the free list of the class if it is not empty
+   
+   ld a,h
+   or a
+   jr nz, large_request        ; if size > 255
+
+   ld a,l
+   cp 33
+   jr nc, large_request        ; if size > 32
+
+   dec a
+   and $1c
+   ld c,a                      ; c = size class * 4
+
+   rrca
+   add a,12                    ; offset of free list in heap
+
+   ld l,a
+   ld h,0
+   add hl,de                   ; hl = & free list
+
+   ld a,(hl)
+   inc hl
+   or (hl)
+   jr z, class_empty           ; if free list is empty
+
+   ; pop block from the free list
+
+   ld d,(hl)
+   dec hl
+   ld e,(hl)                   ; de = void *p
+
+   ld a,(de)
+   ld (hl),a
+   inc hl
+   inc de
+   ld a,(de)
+   ld (hl),a                   ; free list = p->next
+
+   ex de,hl
+   dec hl                      ; hl = void *p
+
+   ret                         ; carry is reset
+
+class_empty:
+
+   ; de = void *heap
+   ; c = size class * 4
+
+   ld a,c
+   add a,10                    ; class size + sizeof(heap header)
+   ld c,a
+   ld b,0                      ; bc = gross request size
+   
+   jr first_fit
+
+large_request:
+
+ENDIF
    
    ld bc,6                     ; sizeof(heap header)
    add hl,bc                   ; add space for header to request
@@ -48,7 +117,43 @@ asm_heap_alloc_unlocked:
    
    ld c,l
    ld b,h                      ; bc = gross request size
+
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+
+first_fit:
+
+   ; bc = gross request size
+   ; de = void *heap
+
+   push de                     ; save void *heap
+   push bc                     ; save gross request size
+   
+   call first_fit_search
+   
+   pop bc
+   pop de
+   ret nc                      ; if memory was allocated
+
+   ; no block has enough spare space so return the blocks on the
+   ; free lists to the chain of blocks and search again
+   
+   call __heap_flush_lists
+   jp c, error_enomem_zc       ; if there were no blocks to return
+
+   call first_fit_search
+   ret nc
    
+   jp error_enomem_zc
+
+first_fit_search:
+
+   ; bc = gross request size
+   ; de = void *heap
+   ;
+   ; exit : carry set if no block has enough spare space
+
+ENDIF
+
    ld hl,6                     ; hl = sizeof(mutex)
    add hl,de
 
@@ -66,7 +171,11 @@ block_loop:
    
    ld a,d
    or e
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+   jr z, heap_end              ; if reached end of heap
+ELSE
    jp z, error_enomem_zc - 2   ; if reached end of heap
+ENDIF
    
    inc hl
    ld c,(hl)
@@ -106,3 +215,15 @@ found_memory:
    
    pop hl
    jp __heap_allocate_block
+
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+
+heap_end:
+
+   pop bc
+   pop bc                      ; junk & block
+   
+   scf
+   ret
+
+ENDIF
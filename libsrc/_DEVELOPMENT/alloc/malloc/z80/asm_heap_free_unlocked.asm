@@ -2,7 +2,7 @@
 ; ===============================================================
 ; Dec 2013
 ; ===============================================================
-; 
+;
 ; void heap_free_unlocked(void *heap, void *p)
 ;
 ; Deallocate memory previously allocated at p from the heap.
@@ -11,19 +11,29 @@
 ;
 ; ===============================================================
 
+INCLUDE "config_private.inc"
+
 SECTION code_clib
 SECTION code_alloc_malloc
 
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
 PUBLIC asm_heap_free_unlocked
 
-EXTERN l_setmem_hl
+EXTERN __heap_free_block
 
 asm_heap_free_unlocked:
 
    ; Return the memory block to the heap for reuse without locking
    ;
+   ; Blocks holding 4 to 35 bytes are pushed onto the free list
+   ; of the largest size class they can hold, the others are
+   ; returned to the chain of blocks.
+   ;
    ; enter : hl = void *p
-   ;         de = void *heap (unused)
+   ;         de = void *heap
    ;
    ; exit  : carry reset
    ;
@@ -32,50 +42,67 @@ asm_heap_free_unlocked:
    ld a,h
    or l
    ret z                       ; if p == 0
-   
-   dec hl                      ; step into block header
-   ld d,(hl)
+
+   push hl                     ; save void *p
+
    dec hl
-   ld e,(hl)                   ; de = block->prev = & block_prev
-   
    dec hl
-   dec hl                      ; hl = & block->committed
+   dec hl                      ; hl = & block->committed + 1b
 
-   ld a,d
-   or e
-   jp z, l_setmem_hl - 4       ; if there is no previous block, set block->committed = 0
-
-remove_block:
+   ld a,(hl)
+   or a
+   jr nz, free_block           ; if committed > 255
 
    dec hl
-   dec hl
+   ld a,(hl)                   ; a = block->committed
 
-   ; hl = & block
-   ; de = & block_prev
+   sub 10                      ; a = block size - 4
+   jr c, free_block            ; if block holds less than 4 bytes
 
-   ldi
-   inc bc                      ; undo changes to bc
+   cp 32
+   jr nc, free_block           ; if block holds more than 35 bytes
 
-   ld a,(hl)
-   ld (de),a                   ; block_prev->next = block->next
-   
-   dec de                      ; de = & block_prev
-   dec hl                      ; hl = & block
-   
-   ld l,(hl)
-   ld h,a                      ; hl = block->next = & block_next
+   and $1c
+   rrca                        ; a = size class * 2
 
-   ld a,(hl)
-   inc hl
-   or (hl)
-   ret z                       ; if there is no block_next
+   add a,12                    ; offset of free list in heap
 
-   inc hl
-   inc hl
-   inc hl
-   
+   ld l,a
+   ld h,0
+   add hl,de                   ; hl = & free list
+
+   pop de                      ; de = void *p
+
+   ; push block onto the free list
+
+   ld a,(hl)
+   ld (de),a
    ld (hl),e
    inc hl
-   ld (hl),d                   ; block_next->prev = & block_prev
-   
+   inc de
+   ld a,(hl)
+   ld (de),a                   ; p->next = free list
+   dec de
+   ld (hl),d                   ; free list = p
+
+   or a
    ret
+
+free_block:
+
+   pop hl                      ; hl = void *p
+   jp __heap_free_block
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+ELSE
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+PUBLIC asm_heap_free_unlocked
+
+EXTERN __heap_free_block
+
+defc asm_heap_free_unlocked = __heap_free_block
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+ENDIF
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -10,6 +10,8 @@
 ;
 ; ===============================================================
 
+INCLUDE "config_private.inc"
+
 SECTION code_clib
 SECTION code_alloc_malloc
 
@@ -17,6 +19,10 @@ PUBLIC asm_heap_info_unlocked
 
 EXTERN l_jpix, l_inc_sp
 
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+EXTERN __heap_flush_lists
+ENDIF
+
 asm_heap_info_unlocked:
 
    ; enter : ix = void *callback
@@ -26,6 +32,10 @@ asm_heap_info_unlocked:
    ;
    ; uses  : af, bc, de, hl + callback
 
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+   call __heap_flush_lists     ; report blocks on free lists as free
+ENDIF
+
    ld hl,6                     ; sizeof(mutex)
    add hl,de                   ; hl = & heap.hdr
 
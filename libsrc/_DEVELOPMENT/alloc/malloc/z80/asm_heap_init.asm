@@ -6,23 +6,25 @@
 ; void *heap_init(void *heap, size_t size)
 ;
 ; Initialize a heap of size bytes.
-; An unchecked condition is that size > 14 bytes.
+; An unchecked condition is that size > 14 bytes (30 bytes
+; for the segregated heap).
 ;
 ; ===============================================================
 
+INCLUDE "config_private.inc"
+
 SECTION code_clib
 SECTION code_alloc_malloc
 
 PUBLIC asm_heap_init
 
-EXTERN mtx_plain
-
 EXTERN asm_mtx_init, error_enolck_zc, l_setmem_hl
 
 asm_heap_init:
 
    ; initialize the heap to empty
    ; area reserved for the heap must be at least 14 bytes
+   ; (30 bytes for the segregated heap)
    ;
    ; enter : hl = void *heap
    ;         bc = number of available bytes >= 14
@@ -72,8 +74,28 @@ asm_heap_init:
    inc hl
    ld (hl),d                   ; block_first->next = & heap_end
    inc hl
+
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+
+   ; the first block holds the free lists of the size classes
+   
+   ld (hl),22                  ; sizeof(heap header) + sizeof(free lists)
+   inc hl
+   ld (hl),a                   ; block_first->committed = 22
+   inc hl
    
+   ld (hl),a
+   inc hl
+   ld (hl),a                   ; block_first->prev = 0
+   inc hl
+   
+   call l_setmem_hl - 32       ; free lists are empty
+
+ELSE
+
    call l_setmem_hl - 8        ; zero out four bytes
+
+ENDIF
    
    pop hl                      ; hl = void *heap
    ret
@@ -23,12 +23,18 @@
 ;
 ; ===============================================================
 
+INCLUDE "config_private.inc"
+
 SECTION code_clib
 SECTION code_alloc_malloc
 
 PUBLIC asm_heap_realloc_unlocked
 
-EXTERN error_enomem_zc, __heap_allocate_block, asm_memmove, asm_heap_free_unlocked, l_ltu_bc_hl
+EXTERN error_enomem_zc, __heap_allocate_block, asm_memmove, __heap_free_block, l_ltu_bc_hl
+
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+EXTERN __heap_flush_lists
+ENDIF
 
 asm_heap_realloc_unlocked:
 
@@ -118,6 +124,17 @@ allocating:
    ; hl = void *heap
    ; bc = gross request size
 
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+
+   ; the blocks on the free lists must be in the chain of
+   ; blocks for the largest one to be found
+
+   ex de,hl
+   call __heap_flush_lists
+   ex de,hl
+
+ENDIF
+
    call largest_fit
    jp c, error_enomem_zc
    
@@ -153,6 +170,15 @@ resize_fail:
    ; bc = gross request size
    ; stack = void *heap
 
+IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+
+   pop de
+   push de
+   
+   call __heap_flush_lists     ; before block_p->prev is relied on
+
+ENDIF
+
    inc hl
    inc hl
    
@@ -173,7 +199,7 @@ resize_fail:
    ; bc = gross request size
    ; stack = void *p_old, p_old->committed, void *heap
 
-   call asm_heap_free_unlocked
+   call __heap_free_block
    pop hl
 
    ; find the largest block in the heap
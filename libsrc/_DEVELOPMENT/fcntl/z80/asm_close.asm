@@ -148,7 +148,7 @@ close_fdstruct:
    call __fcntl_fdchain_descend
    push af                     ; save descend flag
    
-   ld de,__stdio_heap
+   ld de,(__stdio_heap)
    call asm_heap_free          ; free(FDSTRUCT)
    
    pop af                      ; descend flag
@@ -77,9 +77,18 @@ ENDIF
    jp c, error_ebadf_mc        ; if FILE* is invalid
 
    ; close FILE and underlying fd
-   
+
+   ld a,(ix+3)
+   inc a
+   and $07
+
+   push af                     ; save memstream?
+
    call asm1_fclose_unlocked
 
+   pop af                      ; z flag set if memstream
+   jp z, error_znc             ; memstream FILE was returned to the stdio heap
+
    ; append FILE to closed list
    
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -0,0 +1,33 @@
+
+SECTION code_clib
+SECTION code_stdio
+
+PUBLIC __stdio_lowered_c
+
+EXTERN __stdio_lowered_output
+
+__stdio_lowered_c:
+
+   ; %c from a printf expanded by sccz80
+   ;
+   ; enter : l = char
+   ;         stack = FILE *, count, ret
+   ;
+   ; exit  : count += 1, count = -1 on stream error
+   ;
+   ; uses  : all
+
+   push hl
+
+   ld hl,4
+   add hl,sp
+   ex de,hl                    ; de = & count
+
+   ld hl,0
+   add hl,sp                   ; hl = & char
+
+   ld bc,1
+   call __stdio_lowered_output
+
+   pop hl
+   ret
@@ -0,0 +1,73 @@
+
+SECTION code_clib
+SECTION code_stdio
+
+PUBLIC __stdio_lowered_d, __stdio_lowered_u, __stdio_lowered_o
+PUBLIC __stdio_lowered_x, __stdio_lowered_xx
+
+EXTERN asm_itoa, asm_utoa, __stdio_lowered_number
+
+   ; %d %i %u %o %x %X from a printf expanded by sccz80
+   ;
+   ; enter : hl = int
+   ;         stack = FILE *, count, ret
+   ;
+   ; exit  : count += number of digits, count = -1 on stream error
+   ;
+   ; uses  : all
+
+__stdio_lowered_d:
+
+   ld a,$01                    ; signed
+   ld bc,10
+   jr convert
+
+__stdio_lowered_u:
+
+   xor a
+   ld bc,10
+   jr convert
+
+__stdio_lowered_o:
+
+   xor a
+   ld bc,8
+   jr convert
+
+__stdio_lowered_x:
+
+   ld a,$02                    ; lower case
+   ld bc,16
+   jr convert
+
+__stdio_lowered_xx:
+
+   xor a
+   ld bc,16
+
+convert:
+
+   push af                     ; save flags
+
+   push bc
+   push bc
+   push bc
+   push bc
+   push bc
+   push bc                     ; buffer[12] for the digits
+
+   ex de,hl
+   ld hl,0
+   add hl,sp
+   ex de,hl                    ; de = buffer
+
+   rra
+   jr nc, unsigned_int
+
+   call asm_itoa
+   jp __stdio_lowered_number
+
+unsigned_int:
+
+   call asm_utoa
+   jp __stdio_lowered_number
@@ -0,0 +1,71 @@
+
+SECTION code_clib
+SECTION code_stdio
+
+PUBLIC __stdio_lowered_ld, __stdio_lowered_lu, __stdio_lowered_lo
+PUBLIC __stdio_lowered_lx, __stdio_lowered_lxx
+
+EXTERN asm_ltoa, asm_ultoa, __stdio_lowered_number
+
+   ; %ld %li %lu %lo %lx %lX from a printf expanded by sccz80
+   ;
+   ; enter : dehl = long
+   ;         stack = FILE *, count, ret
+   ;
+   ; exit  : count += number of digits, count = -1 on stream error
+   ;
+   ; uses  : all
+
+__stdio_lowered_ld:
+
+   ld a,$01                    ; signed
+   ld bc,10
+   jr convert
+
+__stdio_lowered_lu:
+
+   xor a
+   ld bc,10
+   jr convert
+
+__stdio_lowered_lo:
+
+   xor a
+   ld bc,8
+   jr convert
+
+__stdio_lowered_lx:
+
+   ld a,$02                    ; lower case
+   ld bc,16
+   jr convert
+
+__stdio_lowered_lxx:
+
+   xor a
+   ld bc,16
+
+convert:
+
+   push af                     ; save flags
+
+   push bc
+   push bc
+   push bc
+   push bc
+   push bc
+   push bc                     ; buffer[12] for the digits
+
+   ld ix,0
+   add ix,sp                   ; ix = buffer
+
+   rra
+   jr nc, unsigned_long
+
+   call asm_ltoa
+   jp __stdio_lowered_number
+
+unsigned_long:
+
+   call asm_ultoa
+   jp __stdio_lowered_number
@@ -0,0 +1,58 @@
+
+SECTION code_clib
+SECTION code_stdio
+
+PUBLIC __stdio_lowered_number
+
+EXTERN asm__memlwr, __stdio_lowered_output
+
+__stdio_lowered_number:
+
+   ; common tail for numbers converted on the stack
+   ;
+   ; enter : hl = address of terminating 0 following the digits
+   ;         stack = FILE *, count, ret, flags, buffer[12]
+   ;
+   ;         flags = af pushed, bit 1 of a set for lower case
+   ;
+   ; exit  : count += number of digits, count = -1 on stream error
+   ;         buffer and flags are popped before returning
+   ;
+   ; uses  : all
+
+   ex de,hl
+   ld hl,0
+   add hl,sp
+   ex de,hl                    ; de = buffer
+
+   or a
+   sbc hl,de
+
+   ld c,l
+   ld b,h                      ; bc = number of digits
+
+   ld hl,13
+   add hl,sp
+   bit 1,(hl)                  ; lower case ?
+
+   ex de,hl                    ; hl = buffer
+   jr z, upper_case
+
+   push bc
+   call asm__memlwr
+   pop bc
+
+upper_case:
+
+   ld de,16
+   ex de,hl
+   add hl,sp
+   ex de,hl                    ; de = & count
+
+   call __stdio_lowered_output
+
+   ld hl,14
+   add hl,sp
+   ld sp,hl                    ; discard buffer and flags
+
+   ret
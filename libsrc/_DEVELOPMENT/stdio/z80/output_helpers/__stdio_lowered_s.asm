@@ -0,0 +1,41 @@
+
+SECTION code_clib
+SECTION code_stdio
+
+PUBLIC __stdio_lowered_s
+
+EXTERN asm_strlen, __stdio_lowered_text
+
+__stdio_lowered_s:
+
+   ; %s from a printf expanded by sccz80
+   ;
+   ; enter : hl = char *s
+   ;         stack = FILE *, count, ret
+   ;
+   ; exit  : count += strlen(s), count = -1 on stream error
+   ;
+   ; uses  : all
+
+   ld a,h
+   or l
+   jr nz, string_valid         ; if s != 0
+
+   ld hl,null_s                ; output special string for NULL
+
+string_valid:
+
+   push hl
+
+   call asm_strlen
+
+   ld c,l
+   ld b,h                      ; bc = strlen(s)
+
+   pop hl
+   jp __stdio_lowered_text
+
+null_s:
+
+   defm "<null>"
+   defb 0
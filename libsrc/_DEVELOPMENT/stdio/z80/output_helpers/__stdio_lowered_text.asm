@@ -0,0 +1,86 @@
+
+SECTION code_clib
+SECTION code_stdio
+
+PUBLIC __stdio_lowered_text
+PUBLIC __stdio_lowered_output
+
+EXTERN asm_fwrite
+
+; OUTPUT HELPERS FOR PRINTF CALLS EXPANDED BY SCCZ80 -lower-printf
+; THE COMPILED CODE PUSHES FILE * AND A ZERO COUNT BEFORE CALLING THEM
+
+__stdio_lowered_text:
+
+   ; text from the format string
+   ;
+   ; enter : hl = char *text
+   ;         bc = length
+   ;         stack = FILE *, count, ret
+   ;
+   ; exit  : count += length, count = -1 on stream error
+   ;
+   ; uses  : all
+
+   ex de,hl
+   ld hl,2
+   add hl,sp
+   ex de,hl                    ; de = & count
+
+__stdio_lowered_output:
+
+   ; enter : hl = void *buffer
+   ;         bc = length
+   ;         de = & count (followed by FILE *)
+   ;
+   ; exit  : count += length, count = -1 on stream error
+   ;
+   ; uses  : all
+
+   ex de,hl
+   inc hl
+
+   bit 7,(hl)
+   ret nz                      ; if an earlier write failed
+
+   push hl                     ; save & count + 1b
+
+   inc hl
+   ld a,(hl)
+   inc hl
+   ld h,(hl)
+   ld l,a
+
+   push hl
+   pop ix                      ; ix = FILE *
+
+   ex de,hl                    ; hl = buffer
+
+   push bc                     ; save length
+   ld de,1                     ; write the buffer as one record
+
+   call asm_fwrite
+
+   pop de                      ; de = length
+   pop hl                      ; hl = & count + 1b
+
+   jr c, error
+
+   dec hl
+   ld a,(hl)
+   add a,e
+   ld (hl),a
+   inc hl
+   ld a,(hl)
+   adc a,d
+   ld (hl),a                   ; count += length
+
+   ret
+
+error:
+
+   ld (hl),$ff
+   dec hl
+   ld (hl),$ff                 ; count = -1
+
+   ret
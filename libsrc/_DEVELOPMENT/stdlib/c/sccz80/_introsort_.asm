@@ -0,0 +1,25 @@
+
+; void introsort(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *))
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC _introsort_
+
+EXTERN asm_introsort
+
+_introsort_:
+
+   pop af
+   pop ix
+   pop de
+   pop hl
+   pop bc
+   
+   push bc
+   push hl
+   push de
+   push hl
+   push af
+   
+   jp asm_introsort
@@ -0,0 +1,20 @@
+
+; void introsort(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *))
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC _introsort__callee
+
+EXTERN asm_introsort
+
+_introsort__callee:
+
+   pop af
+   pop ix
+   pop de
+   pop hl
+   pop bc
+   push af
+   
+   jp asm_introsort
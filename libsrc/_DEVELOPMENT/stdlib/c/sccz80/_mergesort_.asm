@@ -0,0 +1,35 @@
+
+; void mergesort(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *), void *buffer)
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC _mergesort_
+
+EXTERN asm_mergesort
+
+_mergesort_:
+
+   pop af
+   exx
+   pop bc
+   exx
+   pop ix
+   pop de
+   pop hl
+   pop bc
+   
+   push bc
+   push hl
+   push de
+   push hl
+   
+   exx
+   push bc
+   push af
+   push bc
+   exx
+   
+   pop af
+   
+   jp asm_mergesort
@@ -0,0 +1,29 @@
+
+; void mergesort(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *), void *buffer)
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC _mergesort__callee
+
+EXTERN asm_mergesort
+
+_mergesort__callee:
+
+   pop af
+   exx
+   pop bc
+   exx
+   pop ix
+   pop de
+   pop hl
+   pop bc
+   push af
+   
+   exx
+   push bc
+   exx
+   
+   pop af
+   
+   jp asm_mergesort
@@ -0,0 +1,31 @@
+
+; void introsort_callee(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *))
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC __introsort__callee, l0__introsort__callee
+
+EXTERN asm_introsort
+
+__introsort__callee:
+
+   pop af
+   pop bc
+   pop hl
+   pop de
+   exx
+   pop bc
+   push af
+
+l0__introsort__callee:
+
+   push bc
+   exx
+   
+   ex (sp),ix
+   
+   call asm_introsort
+   
+   pop ix
+   ret
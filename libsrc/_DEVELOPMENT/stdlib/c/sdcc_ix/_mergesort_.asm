@@ -0,0 +1,28 @@
+
+; void mergesort(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *), void *buffer)
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC __mergesort_
+
+EXTERN l0__mergesort__callee
+
+__mergesort_:
+
+   pop af
+   pop bc
+   pop hl
+   pop de
+   exx
+   pop bc
+   pop de
+   
+   push de
+   push bc
+   push hl
+   push hl
+   push hl
+   push af
+   
+   jp l0__mergesort__callee
@@ -0,0 +1,34 @@
+
+; void mergesort_callee(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *), void *buffer)
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC __mergesort__callee, l0__mergesort__callee
+
+EXTERN asm_mergesort
+
+__mergesort__callee:
+
+   pop af
+   pop bc
+   pop hl
+   pop de
+   exx
+   pop bc
+   pop de
+   push af
+
+l0__mergesort__callee:
+
+   push bc
+   push de
+   exx
+   
+   pop af
+   ex (sp),ix
+   
+   call asm_mergesort
+   
+   pop ix
+   ret
@@ -0,0 +1,25 @@
+
+; void introsort(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *))
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC __introsort_
+
+EXTERN asm_introsort
+
+__introsort_:
+
+   pop af
+   pop bc
+   pop hl
+   pop de
+   pop ix
+
+   push hl
+   push de
+   push hl
+   push bc
+   push af
+
+   jp asm_introsort
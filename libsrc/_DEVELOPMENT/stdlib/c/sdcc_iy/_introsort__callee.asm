@@ -0,0 +1,20 @@
+
+; void introsort_callee(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *))
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC __introsort__callee
+
+EXTERN asm_introsort
+
+__introsort__callee:
+
+   pop af
+   pop bc
+   pop hl
+   pop de
+   pop ix
+   push af
+
+   jp asm_introsort
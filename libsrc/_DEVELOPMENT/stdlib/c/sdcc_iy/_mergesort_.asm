@@ -0,0 +1,35 @@
+
+; void mergesort(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *), void *buffer)
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC __mergesort_
+
+EXTERN asm_mergesort
+
+__mergesort_:
+
+   pop af
+   pop bc
+   pop hl
+   pop de
+   pop ix
+   exx
+   pop bc
+   
+   push bc
+   push bc
+   exx
+   push de
+   push hl
+   push bc
+   push af
+   
+   exx
+   push bc
+   exx
+   
+   pop af
+   
+   jp asm_mergesort
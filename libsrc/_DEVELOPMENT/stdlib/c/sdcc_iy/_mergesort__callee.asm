@@ -0,0 +1,27 @@
+
+; void mergesort_callee(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *), void *buffer)
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC __mergesort__callee
+
+EXTERN asm_mergesort
+
+__mergesort__callee:
+
+   pop af
+   pop bc
+   pop hl
+   pop de
+   pop ix
+   exx
+   pop bc
+   push af
+   
+   push bc
+   exx
+   
+   pop af
+   
+   jp asm_mergesort
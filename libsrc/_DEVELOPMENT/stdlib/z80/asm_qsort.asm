@@ -50,7 +50,7 @@ IF __CLIB_OPT_SORT = 1
 
 ENDIF
 
-IF __CLIB_OPT_SORT >= 2
+IF __CLIB_OPT_SORT = 2
 
    ; quicksort selected
    
@@ -58,3 +58,29 @@ IF __CLIB_OPT_SORT >= 2
    defc asm_qsort = asm_quicksort
 
 ENDIF
+
+IF __CLIB_OPT_SORT = 3
+
+   ; introsort selected
+   
+   EXTERN asm_introsort
+   defc asm_qsort = asm_introsort
+
+ENDIF
+
+IF __CLIB_OPT_SORT >= 4
+
+   ; merge sort selected, runs are merged in place
+   
+   EXTERN asm_mergesort
+
+asm_qsort:
+
+   push hl
+   ld hl,0
+   ex (sp),hl
+   pop af                      ; af = buffer = 0
+   
+   jp asm_mergesort
+
+ENDIF
@@ -0,0 +1,645 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; void introsort(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *))
+;
+; Sort the array using the comparison function supplied.
+;
+; Notes:
+;
+; * Quicksort with the pivot chosen as the median of the first,
+;   middle and last items of each partition.  Items equal to
+;   the pivot stop the scans from both sides so that arrays with
+;   many equal items are still split in half.
+;
+; * Partitions are split until they hold 16 items or less.  An
+;   insertion sort over the whole array completes the sort.
+;
+; * The smaller partition is sorted first so that stack usage
+;   is bounded by log2(nmemb) levels.
+;
+; * Each partition may be split at most 2*log2(nmemb) times.
+;   A partition that reaches that limit is sorted by heapsort
+;   instead, so the worst case is O(n log n) comparisons.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC asm_introsort
+
+EXTERN __sort_parameters, asm0_insertion_sort, asm0_memswap
+EXTERN l_compare_de_hl, l0_divu_16_16x16
+
+asm_introsort:
+
+   ; enter : ix = int (*compar)(de=const void *, hl=const void *)
+   ;         bc = void *base
+   ;         hl = size_t nmemb
+   ;         de = size_t size
+   ;
+   ; exit  : none
+   ;
+   ;         if an error below occurs, no sorting is done.
+   ;
+   ;         einval if size == 0
+   ;         einval if array size > 64k
+   ;         erange if array wraps 64k boundary
+   ;
+   ; uses  : af, bc, de, hl, compare function
+
+   ; depth limit = 2 * floor(log2(nmemb))
+
+   push bc
+   push hl
+
+   ld c,-2
+
+depth_loop:
+
+   inc c
+   inc c
+
+   srl h
+   rr l
+
+   ld a,h
+   or l
+   jr nz, depth_loop
+
+   ld a,c
+
+   pop hl
+   pop bc
+
+   or a
+   jp z, __sort_parameters     ; if nmemb < 2 nothing to sort
+
+   push af                     ; save depth limit
+
+   call __sort_parameters
+   jr c, error
+
+   pop af                      ; a = depth limit
+
+   ; de = array_lo
+   ; hl = array_hi
+   ; bc = size
+   ; ix = compare
+
+   push de
+   push hl
+
+   call introsort              ; partition until partitions are small
+
+   pop hl
+   pop de
+
+   jp asm0_insertion_sort      ; sort small partitions using insertion sort
+
+error:
+
+   pop de
+   ret
+
+introsort:
+
+   ; enter : de = lo
+   ;         hl = hi
+   ;         bc = size
+   ;          a = depth limit
+   ;         ix = compare
+   ;
+   ; exit  : bc = size
+   ;
+   ; uses  : af, de, hl
+
+   push af
+
+while_lohi:
+
+   ; current partition is interval [lo, hi]
+
+   ; de = lo
+   ; hl = hi
+   ; bc = size
+   ; ix = compare
+   ; stack = depth
+
+   pop af
+
+   or a
+   jp z, heapsort              ; if depth limit reached
+
+   dec a
+   push af
+
+   push hl                     ; save hi
+   push de                     ; save lo
+   push bc                     ; save size
+
+   or a
+   sbc hl,de
+   srl h
+   rr l                        ; hl = (hi-lo)/2
+
+   push hl                     ; save (hi-lo)/2
+
+   ld e,c
+   ld d,b                      ; de = size
+
+   call l0_divu_16_16x16       ; hl = [(hi-lo)/2] / size, de = [(hi-lo)/2] % size
+
+   ld a,h
+   or a
+   jr nz, partition_size_large
+
+   ld a,l
+   cp 8
+   jr nc, partition_size_large
+
+partition_size_small:
+
+   ; sixteen items or less are left for insertion sort
+
+   pop hl
+   pop bc                      ; bc = size
+   pop de
+   pop hl
+   pop af
+
+   ret
+
+partition_size_large:
+
+   pop hl                      ; hl = (hi-lo)/2
+
+   or a
+   sbc hl,de
+
+   pop bc                      ; bc = size
+   pop de                      ; de = lo
+
+   add hl,de                   ; hl = mid = lo + (hi-lo)/2 - ((hi-lo)/2)%size
+
+   ; median of three
+
+   ; de = lo
+   ; hl = mid
+   ; bc = size
+   ; ix = compare
+   ; stack = depth, hi
+
+   call order_de_hl            ; item[lo] <= item[mid]
+
+   ex de,hl
+   ex (sp),hl
+
+   ; de = mid
+   ; hl = hi
+   ; stack = depth, lo
+
+   call order_de_hl            ; item[mid] <= item[hi]
+
+   ex (sp),hl
+   ex de,hl
+
+   ; de = lo
+   ; hl = mid
+   ; stack = depth, hi
+
+   call order_de_hl            ; item[lo] <= item[mid]
+
+   call swap_de_hl             ; move pivot to lo
+
+   ; item[lo] = pivot
+   ; item[hi] >= pivot stops the first left scan
+   ; item[lo] = pivot stops all right scans
+
+   pop hl                      ; hl = hi
+   push hl
+   push de                     ; save lo=pivot
+
+   ex de,hl
+   add hl,bc
+   ex de,hl
+
+   ; de = i = lo + size
+   ; hl = j = hi
+   ; bc = size
+   ; ix = compare
+   ; stack = depth, hi, lo=pivot
+
+partition_loop:
+
+   ex (sp),hl
+
+   ; de = i
+   ; hl = lo=pivot
+   ; stack = depth, hi, j
+
+left_squeeze:
+
+   call l_compare_de_hl        ; compare(de=i, hl=lo=pivot)
+   jp p, left_squeeze_done     ; if item[i] >= pivot
+
+   ex de,hl
+   add hl,bc                   ; i += size
+   ex de,hl
+
+   jr left_squeeze
+
+left_squeeze_done:
+
+   ex (sp),hl
+   ex de,hl
+   ex (sp),hl
+   ex de,hl
+
+   ; de = lo=pivot
+   ; hl = j
+   ; stack = depth, hi, i
+
+right_squeeze:
+
+   call l_compare_de_hl        ; compare(de=lo=pivot, hl=j)
+   jp p, right_squeeze_done    ; if pivot >= item[j]
+
+   sbc hl,bc                   ; j -= size
+   jr right_squeeze
+
+right_squeeze_done:
+
+   ex (sp),hl
+   ex de,hl
+   ex (sp),hl
+
+   ; de = i
+   ; hl = j
+   ; stack = depth, hi, lo=pivot
+
+   or a
+   sbc hl,de
+   jr c, partition_done        ; if i > j
+   jr z, partition_done        ; if i == j
+
+   add hl,de
+   call swap_de_hl             ; swap(i, j)
+
+   ex de,hl
+   add hl,bc                   ; i += size
+   ex de,hl
+
+   sbc hl,bc                   ; j -= size
+   jr partition_loop
+
+partition_done:
+
+   add hl,de                   ; hl = j = final position of pivot
+   pop de                      ; de = lo
+
+   call swap_de_hl             ; move pivot into position
+
+   ; de = lo
+   ; hl = j
+   ; bc = size
+   ; ix = compare
+   ; stack = depth, hi
+
+   ; lowest bound on stack usage occurs if the smallest partition is pursued
+
+   push bc                     ; save size
+
+   or a
+   sbc hl,de
+
+   ld c,l
+   ld b,h                      ; bc = j - lo
+
+   pop af                      ; af = size
+   pop hl                      ; hl = hi
+   push hl
+   push af
+
+   or a
+   sbc hl,de
+   sbc hl,bc                   ; hl = hi - j
+   sbc hl,bc                   ; carry set if hi - j < j - lo
+
+   ld l,c
+   ld h,b
+
+   pop bc                      ; bc = size
+   jr c, right_smallest
+
+left_smallest:
+
+   ; de = lo
+   ; hl = j - lo
+   ; bc = size
+   ; stack = depth, hi
+
+   add hl,de                   ; hl = j
+   push hl
+
+   or a
+   sbc hl,de
+   jr z, left_done             ; if left partition is empty
+
+   add hl,de
+   sbc hl,bc                   ; hl = j - size
+
+   push hl
+
+   ld hl,7
+   add hl,sp
+   ld a,(hl)                   ; a = depth
+
+   pop hl
+
+   ; de = lo
+   ; hl = j - size
+   ; stack = depth, hi, j
+
+   call introsort              ; sort left partition
+
+left_done:
+
+   pop hl
+   add hl,bc
+   ex de,hl                    ; de = j + size
+
+   pop hl                      ; hl = hi
+   jp while_lohi
+
+right_smallest:
+
+   ; de = lo
+   ; hl = j - lo
+   ; bc = size
+   ; stack = depth, hi
+
+   add hl,de                   ; hl = j
+
+   pop af                      ; af = hi
+   push hl
+   push de
+   push af
+   pop de
+
+   ; de = hi
+   ; hl = j
+   ; stack = depth, j, lo
+
+   or a
+   sbc hl,de
+   jr z, right_done            ; if right partition is empty
+
+   add hl,de
+   add hl,bc
+   ex de,hl
+
+   push hl
+
+   ld hl,7
+   add hl,sp
+   ld a,(hl)                   ; a = depth
+
+   pop hl
+
+   ; de = j + size
+   ; hl = hi
+   ; stack = depth, j, lo
+
+   call introsort              ; sort right partition
+
+right_done:
+
+   pop de                      ; de = lo
+   pop hl                      ; hl = j
+
+   or a
+   sbc hl,bc                   ; hl = j - size
+
+   jp while_lohi
+
+heapsort:
+
+   ; sort the partition in place with heapsort
+   ;
+   ; enter : de = lo
+   ;         hl = hi
+   ;         bc = size
+   ;         ix = compare
+   ;
+   ; exit  : bc = size
+   ;
+   ; uses  : af, de, hl
+
+   push hl                     ; save hi
+   push de                     ; save lo
+
+   or a
+   sbc hl,de
+   srl h
+   rr l                        ; hl = (hi-lo)/2
+
+   push bc
+   push hl
+
+   ld e,c
+   ld d,b
+
+   call l0_divu_16_16x16       ; de = [(hi-lo)/2] % size
+
+   pop hl
+
+   or a
+   sbc hl,de
+
+   pop bc                      ; bc = size
+   pop de                      ; de = lo
+   push de
+
+   add hl,de                   ; hl = middle item, no item after it has children
+
+heapify_loop:
+
+   ; build the heap from the last parent down to lo
+
+   ; hl = r
+   ; bc = size
+   ; stack = hi, lo
+
+   push hl
+   call sift_down
+   pop hl
+
+   pop de
+   push de
+
+   or a
+   sbc hl,de
+   jr z, sortdown_loop         ; if r == lo
+
+   add hl,de
+   sbc hl,bc                   ; r -= size
+
+   jr heapify_loop
+
+sortdown_loop:
+
+   ; move the largest item to the end and restore the heap
+
+   ; bc = size
+   ; stack = hi, lo
+
+   pop de                      ; de = lo
+   pop hl                      ; hl = hi
+
+   or a
+   sbc hl,de
+   ret z                       ; if one item is left
+
+   add hl,de
+   call swap_de_hl             ; swap(lo, hi)
+
+   or a
+   sbc hl,bc                   ; hi -= size
+
+   push hl
+   push de
+   push de
+
+   ex de,hl                    ; hl = lo
+
+   call sift_down
+
+   pop hl
+   jr sortdown_loop
+
+sift_down:
+
+   ; sift the item at r down the heap
+   ;
+   ; enter : hl = r
+   ;         bc = size
+   ;         ix = compare
+   ;         stack = hi, lo, (item), ret
+   ;
+   ; exit  : bc = size
+   ;
+   ; uses  : af, de, hl
+
+   push hl
+
+   ld hl,6
+   add hl,sp
+
+   ld e,(hl)
+   inc hl
+   ld d,(hl)                   ; de = lo
+
+   pop hl
+   push hl
+
+   or a
+   sbc hl,de                   ; hl = r - lo
+
+   pop de
+   push de
+
+   add hl,de
+   jr c, sift_down_done        ; if no child
+
+   add hl,bc                   ; hl = child = r + (r - lo) + size
+   jr c, sift_down_done        ; if no child
+
+   push hl
+
+   ld hl,10
+   add hl,sp
+
+   ld a,(hl)
+   inc hl
+   ld h,(hl)
+   ld l,a                      ; hl = hi
+
+   pop de                      ; de = child
+
+   or a
+   sbc hl,de
+   jr c, sift_down_done        ; if no child
+
+   ex de,hl
+   jr z, sift_down_child       ; if only one child
+
+   ld e,l
+   ld d,h
+
+   add hl,bc
+
+   ; de = left child
+   ; hl = right child
+   ; stack = hi, lo, (item), ret, r
+
+   call l_compare_de_hl        ; compare(de=left, hl=right)
+   jp m, sift_down_child       ; if right child is larger
+
+   ex de,hl
+
+sift_down_child:
+
+   ; hl = larger child
+   ; stack = hi, lo, (item), ret, r
+
+   pop de                      ; de = r
+
+   call l_compare_de_hl        ; compare(de=r, hl=child)
+   ret p                       ; if item[r] >= item[child]
+
+   call swap_de_hl
+   jr sift_down
+
+sift_down_done:
+
+   pop hl
+   ret
+
+order_de_hl:
+
+   ; swap items if item[hl] < item[de]
+   ;
+   ; enter : de = void *a
+   ;         hl = void *b
+   ;         bc = size
+   ;         ix = compare
+   ;
+   ; uses  : af
+
+   ex de,hl
+   call l_compare_de_hl        ; compare(de=b, hl=a)
+   ex de,hl
+
+   ret p
+
+swap_de_hl:
+
+   ; enter : de = void *a
+   ;         hl = void *b
+   ;         bc = size
+   ;
+   ; uses  : af
+
+   push bc
+   push de
+
+   call asm0_memswap
+
+   pop de
+   pop bc
+
+   ret
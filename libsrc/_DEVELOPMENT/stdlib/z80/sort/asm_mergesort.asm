@@ -0,0 +1,1343 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; void mergesort(void *base, size_t nmemb, size_t size,
+;                int (*compar)(const void *, const void *),
+;                void *buffer)
+;
+; Stable sort of the array using the comparison function supplied.
+;
+; Notes:
+;
+; * Bottom-up merge sort.  Runs of eight items are sorted by
+;   insertion sort and then merged in pairs, doubling the run
+;   length on each pass.  Runs are counted from the end of the
+;   array so that the left run of a pair is never longer than
+;   the right run.
+;
+; * Two runs that are already in order are not merged, so the
+;   sort is linear on sorted input.
+;
+; * If a buffer is supplied, the left run of each pair is copied
+;   to it and merged back into the array.  The buffer must hold
+;   (nmemb/2) items.  The sort is O(n log n) in the worst case.
+;
+; * If buffer == 0, runs are merged in place by rotation and the
+;   sort is O(n log n log n) in the worst case.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_stdlib
+
+PUBLIC asm_mergesort
+
+EXTERN __sort_parameters, asm0_insertion_sort
+EXTERN l_compare_de_hl
+
+asm_mergesort:
+
+   ; enter : ix = int (*compar)(de=const void *, hl=const void *)
+   ;         bc = void *base
+   ;         hl = size_t nmemb
+   ;         de = size_t size
+   ;         af = void *buffer (0 to merge in place)
+   ;
+   ; exit  : none
+   ;
+   ;         if an error below occurs, no sorting is done.
+   ;
+   ;         einval if size == 0
+   ;         einval if array size > 64k
+   ;         erange if array wraps 64k boundary
+   ;
+   ; uses  : af, bc, de, hl, compare function
+
+   push af                     ; save buffer
+
+   ld a,h
+   or a
+   jr nz, sort_begin
+
+   ld a,l
+   cp 2
+   jr nc, sort_begin
+
+   pop af
+   jp __sort_parameters        ; if nmemb < 2 nothing to sort
+
+sort_begin:
+
+   call __sort_parameters
+   jp c, error
+
+   ; de = array_lo
+   ; hl = array_hi
+   ; bc = size
+   ; ix = compare
+   ; stack = buffer
+
+   push de                     ; save lo
+
+   or a
+   sbc hl,de
+   add hl,bc
+
+   push hl                     ; save T = array size in bytes
+   push bc                     ; save size
+
+   ld l,c
+   ld h,b
+
+   add hl,hl
+   jr c, run_max
+   add hl,hl
+   jr c, run_max
+   add hl,hl
+   jr nc, run_size
+
+run_max:
+
+   ld hl,$ffff
+
+run_size:
+
+   push hl                     ; save w = run width in bytes
+
+   ; stack = buffer, lo, T, size, w
+
+   ; insertion sort runs of eight items
+
+   ld hl,4
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,6
+   call peek_hl
+
+   add hl,de                   ; hl = end = lo + T
+
+run_loop:
+
+   ; hl = end
+   ; stack = buffer, lo, T, size, w
+
+   push hl
+
+   ex de,hl
+
+   ld hl,8
+   call peek_hl
+
+   ex de,hl
+
+   or a
+   sbc hl,de
+   jr z, run_done              ; if no items before end
+
+   ex de,hl                    ; de = end - lo
+
+   ld hl,2
+   call peek_hl
+
+   ex de,hl
+
+   ; hl = end - lo
+   ; de = w
+   ; stack = buffer, lo, T, size, w, end
+
+   or a
+   sbc hl,de
+   jr c, run_first             ; if this is the first run
+
+   pop hl
+   push hl
+
+   sbc hl,de                   ; hl = start = end - w
+   jr run_sort
+
+run_first:
+
+   ld hl,8
+   call peek_hl                ; hl = start = lo
+
+run_sort:
+
+   ex (sp),hl
+   push hl
+
+   ld hl,6
+   call peek_hl
+
+   ld c,l
+   ld b,h                      ; bc = size
+
+   pop hl
+
+   or a
+   sbc hl,bc                   ; hl = end - size
+
+   pop de
+   push de
+
+   ; de = start
+   ; hl = address of last item in run
+   ; bc = size
+   ; stack = buffer, lo, T, size, w, start
+
+   call asm0_insertion_sort
+
+   pop hl                      ; hl = end = start
+   jr run_loop
+
+run_done:
+
+   pop hl
+
+pass_loop:
+
+   ; merge pairs of runs of width w
+
+   ; stack = buffer, lo, T, size, w
+
+   pop de
+   push de
+
+   ld hl,4
+   call peek_hl
+
+   or a
+   sbc hl,de
+   jp c, sorted
+   jp z, sorted                ; if T <= w
+
+   add hl,de
+   ex de,hl
+
+   ld hl,6
+   call peek_hl
+
+   add hl,de                   ; hl = end = lo + T
+
+merge_loop:
+
+   ; hl = end
+   ; stack = buffer, lo, T, size, w
+
+   push hl
+
+   ex de,hl
+
+   ld hl,8
+   call peek_hl
+
+   ex de,hl
+
+   or a
+   sbc hl,de                   ; hl = end - lo
+
+   ex de,hl
+
+   ld hl,2
+   call peek_hl
+
+   ex de,hl
+
+   ; hl = end - lo
+   ; de = w
+   ; stack = buffer, lo, T, size, w, end
+
+   or a
+   sbc hl,de
+   jp c, pass_done
+   jp z, pass_done             ; if only one run left
+
+   sbc hl,de
+   add hl,de
+   jr c, left_size             ; if left run is shorter than w
+
+   ex de,hl
+
+left_size:
+
+   ; hl = size of left run in bytes
+   ; stack = buffer, lo, T, size, w, end
+
+   push hl
+
+   ld hl,4
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,2
+   call peek_hl
+
+   or a
+   sbc hl,de                   ; hl = mid = end - w
+
+   pop de
+   push hl
+
+   or a
+   sbc hl,de                   ; hl = start = mid - left size
+
+   push hl
+
+   ; stack = buffer, lo, T, size, w, end, mid, start
+
+   ld hl,8
+   call peek_hl
+
+   ld c,l
+   ld b,h                      ; bc = size
+
+   ld hl,2
+   call peek_hl
+
+   ld e,l
+   ld d,h
+
+   ex de,hl
+   or a
+   sbc hl,bc
+   ex de,hl
+
+   ; de = last item in left run
+   ; hl = first item in right run
+
+   call l_compare_de_hl
+   jp m, merge_skip
+
+   jr nz, merge_runs
+   or a
+   jp z, merge_skip            ; if runs are already in order
+
+merge_runs:
+
+   ld hl,14
+   call peek_hl                ; hl = buffer
+
+   ld a,h
+   or l
+   jr z, merge_without_buffer
+
+merge_with_buffer:
+
+   ; copy left run into buffer
+
+   push hl
+
+   ld hl,6
+   call peek_hl
+
+   push hl
+
+   ld hl,4
+   call peek_hl
+
+   push hl
+
+   ; stack = ..., end, mid, start, buffer, end, start
+
+   ld hl,8
+   call peek_hl                ; hl = mid
+
+   pop de
+   push de
+
+   or a
+   sbc hl,de                   ; hl = size of left run in bytes
+
+   push bc
+
+   ld c,l
+   ld b,h
+
+   ld hl,6
+   call peek_hl
+
+   ex de,hl
+
+   ; hl = start
+   ; de = buffer
+   ; bc = size of left run in bytes
+
+   ldir
+
+   pop bc
+
+   ld hl,8
+   call peek_hl
+
+   ex de,hl                    ; de = mid
+
+   ld hl,4
+   call peek_hl                ; hl = buffer
+
+merge_buffer_loop:
+
+   ; hl = item in left run (buffer)
+   ; de = item in right run
+   ; bc = size
+   ; stack = ..., end, mid, start, buffer, end, destination
+
+   call l_compare_de_hl        ; compare(de=right, hl=left)
+   jp m, merge_buffer_right    ; if right < left
+
+merge_buffer_left:
+
+   ex (sp),hl
+   ex de,hl
+   ex (sp),hl
+
+   push bc
+   ldir                        ; copy left item to destination
+   pop bc
+
+   ex (sp),hl
+
+   or a
+   sbc hl,de
+   jr z, merge_buffer_end      ; if left run is exhausted the rest is in place
+
+   add hl,de
+
+   ex de,hl
+   ex (sp),hl
+
+   jr merge_buffer_loop
+
+merge_buffer_right:
+
+   ex (sp),hl
+   ex de,hl
+
+   push bc
+   ldir                        ; copy right item to destination
+   pop bc
+
+   ex de,hl
+   ex (sp),hl
+
+   push hl
+
+   ld hl,4
+   add hl,sp
+
+   ld a,(hl)
+   cp e
+   jr nz, merge_buffer_more
+
+   inc hl
+   ld a,(hl)
+   cp d
+
+merge_buffer_more:
+
+   pop hl
+   jr nz, merge_buffer_loop    ; if right run is not exhausted
+
+   ; copy the rest of the left run from the buffer
+
+   pop de                      ; de = destination
+   ex (sp),hl
+
+   or a
+   sbc hl,de
+
+   ld c,l
+   ld b,h
+
+   pop hl
+
+   ldir
+
+   pop hl
+   jr merge_skip
+
+merge_buffer_end:
+
+   pop hl
+   pop hl
+   pop hl
+
+   jr merge_skip
+
+merge_without_buffer:
+
+   ld hl,4
+   call peek_hl
+
+   push hl
+
+   ld hl,4
+   call peek_hl
+
+   push hl
+
+   ld hl,4
+   call peek_hl
+
+   push hl
+
+   ; stack = ..., end, mid, start, end, mid, start
+
+   call merge_in_place
+
+   pop hl
+   pop hl
+   pop hl
+
+merge_skip:
+
+   ; stack = buffer, lo, T, size, w, end, mid, start
+
+   pop hl                      ; hl = end of next pair = start
+   pop de
+   pop de
+
+   jp merge_loop
+
+pass_done:
+
+   ; stack = buffer, lo, T, size, w, end
+
+   pop hl
+   pop hl                      ; hl = w
+
+   add hl,hl
+   jr nc, pass_width
+
+   ld hl,$ffff
+
+pass_width:
+
+   push hl
+   jp pass_loop
+
+sorted:
+
+   pop hl
+   pop hl
+   pop hl
+   pop hl
+
+error:
+
+   pop hl
+   ret
+
+merge_in_place:
+
+   ; merge two adjacent sorted runs without a buffer
+   ;
+   ; enter : bc = size
+   ;         ix = compare
+   ;         stack = last, middle, first, ret
+   ;
+   ; exit  : bc = size
+   ;
+   ; uses  : af, de, hl
+
+   ld hl,2
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,4
+   call peek_hl
+
+   or a
+   sbc hl,de                   ; hl = len1 = middle - first
+   ret z
+
+   push hl
+
+   ld hl,6
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,8
+   call peek_hl
+
+   or a
+   sbc hl,de                   ; hl = len2 = last - middle
+
+   pop de                      ; de = len1
+   ret z
+
+   ; de = len1
+   ; hl = len2
+   ; bc = size
+   ; stack = last, middle, first, ret
+
+   ld a,l
+   xor c
+   jr nz, check_len1
+
+   ld a,h
+   xor b
+   jr z, insert_last           ; if second run holds one item
+
+check_len1:
+
+   ld a,e
+   xor c
+   jr nz, split_runs
+
+   ld a,d
+   xor b
+   jr nz, split_runs
+
+insert_first:
+
+   ; move the only item of the first run forward
+   ; second_cut = lower_bound(middle, last, first)
+
+   ld hl,2
+   call peek_hl
+
+   push hl                     ; key = first
+
+   ld hl,6
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,8
+   call peek_hl
+
+   call lower_bound            ; hl = second_cut
+
+   pop af
+
+   push bc
+
+   ld c,l
+   ld b,h
+
+   ld hl,6
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,4
+   call peek_hl
+
+   call rotate                 ; rotate [first, middle) and [middle, second_cut)
+
+   pop bc
+   ret
+
+insert_last:
+
+   ; move the only item of the second run back
+   ; first_cut = upper_bound(first, middle, middle)
+
+   ld hl,4
+   call peek_hl
+
+   push hl                     ; key = middle
+
+   ld hl,4
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,0
+   call peek_hl
+
+   call upper_bound            ; hl = first_cut
+
+   pop af
+
+   push bc
+   push hl
+
+   ld hl,10
+   call peek_hl
+
+   ld c,l
+   ld b,h
+
+   ld hl,8
+   call peek_hl
+
+   ex de,hl
+
+   pop hl
+
+   call rotate                 ; rotate [first_cut, middle) and [middle, last)
+
+   pop bc
+   ret
+
+split_runs:
+
+   ; both runs hold at least two items
+
+   ; de = len1
+   ; hl = len2
+   ; bc = size
+   ; stack = last, middle, first, ret
+
+   or a
+   sbc hl,de
+   add hl,de
+   jr c, split_first           ; if len1 > len2
+
+split_second:
+
+   ; second_cut = middle + about len2/2
+   ; first_cut = upper_bound(first, middle, second_cut)
+
+   call half_hl
+
+   ex de,hl
+
+   ld hl,4
+   call peek_hl
+
+   add hl,de
+
+   push hl                     ; save second_cut
+
+   ld hl,4
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,6
+   call peek_hl
+
+   call upper_bound            ; hl = first_cut
+
+   ex (sp),hl
+   jr rotate_runs
+
+split_first:
+
+   ; first_cut = first + about len1/2
+   ; second_cut = lower_bound(middle, last, first_cut)
+
+   ex de,hl
+
+   call half_hl
+
+   ex de,hl
+
+   ld hl,2
+   call peek_hl
+
+   add hl,de
+
+   push hl                     ; save first_cut
+
+   ld hl,6
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,8
+   call peek_hl
+
+   call lower_bound            ; hl = second_cut
+
+rotate_runs:
+
+   ; rotate [first_cut, middle) and [middle, second_cut)
+
+   ; hl = second_cut
+   ; bc = size
+   ; stack = last, middle, first, ret, first_cut
+
+   push hl
+
+   ex de,hl
+
+   ld hl,8
+   call peek_hl                ; hl = middle
+
+   call reverse                ; reverse [middle, second_cut)
+
+   ex de,hl
+
+   ld hl,2
+   call peek_hl                ; hl = first_cut
+
+   call reverse                ; reverse [first_cut, middle)
+
+   or a
+   sbc hl,de
+
+   ex de,hl
+
+   ld hl,0
+   call peek_hl
+
+   add hl,de                   ; hl = new_middle = first_cut + second_cut - middle
+
+   push hl
+
+   ld hl,2
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,4
+   call peek_hl
+
+   call reverse                ; reverse [first_cut, second_cut)
+
+   ; merge [first, first_cut) with [first_cut, new_middle)
+   ; merge [new_middle, second_cut) with [second_cut, last)
+   ;
+   ; the smaller is merged by recursion to bound stack usage
+
+   ; stack = last, middle, first, ret, first_cut, second_cut, new_middle
+
+   ld hl,8
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,0
+   call peek_hl
+
+   or a
+   sbc hl,de
+
+   push hl                     ; save new_middle - first
+
+   ld hl,2
+   call peek_hl
+
+   ex de,hl
+
+   ld hl,14
+   call peek_hl
+
+   or a
+   sbc hl,de                   ; hl = last - new_middle
+
+   pop de
+
+   or a
+   sbc hl,de
+   jr c, recurse_right         ; if last - new_middle < new_middle - first
+
+recurse_left:
+
+   pop hl
+   push hl
+   push hl
+
+   ld hl,6
+   call peek_hl
+
+   push hl
+
+   ld hl,12
+   call peek_hl
+
+   push hl
+
+   call merge_in_place         ; merge(first, first_cut, new_middle)
+
+   pop hl
+   pop hl
+   pop hl
+
+   pop de
+
+   ld hl,6
+   call poke_de                ; first = new_middle
+
+   pop de
+
+   ld hl,6
+   call poke_de                ; middle = second_cut
+
+   pop af
+   jp merge_in_place
+
+recurse_right:
+
+   ld hl,12
+   call peek_hl
+
+   push hl
+
+   ld hl,4
+   call peek_hl
+
+   push hl
+
+   ld hl,4
+   call peek_hl
+
+   push hl
+
+   call merge_in_place         ; merge(new_middle, second_cut, last)
+
+   pop hl
+   pop hl
+   pop hl
+
+   pop de
+
+   ld hl,10
+   call poke_de                ; last = new_middle
+
+   pop af
+   pop de
+
+   ld hl,4
+   call poke_de                ; middle = first_cut
+
+   jp merge_in_place
+
+lower_bound:
+
+   ; find the first item in [p, e) that is not less than key
+   ;
+   ; enter : de = p
+   ;         hl = e
+   ;         bc = size
+   ;         ix = compare
+   ;         stack = key, ret
+   ;
+   ; exit  : hl = item
+   ;         bc = size
+   ;
+   ; uses  : af, de, hl
+
+   or a
+   sbc hl,de                   ; hl = len = e - p
+   jp z, bound_empty
+
+   push hl
+   call step_hl                ; hl = s = largest size * 2^k <= len
+   ex (sp),hl
+   push hl
+
+   ; de = p
+   ; stack = key, ret, s, len
+
+   ld hl,2
+   call peek_hl
+
+   add hl,de
+   or a
+   sbc hl,bc                   ; hl = item s-1
+
+   push de
+   ex de,hl
+
+   ld hl,8
+   call peek_hl                ; hl = key
+
+   call l_compare_de_hl        ; compare(de=item, hl=key)
+
+   pop de                      ; de = p
+   pop hl                      ; hl = len
+
+   jp p, lower_bound_low       ; if item >= key
+
+   call bound_high
+   jr lower_bound_loop
+
+lower_bound_low:
+
+   call bound_low
+
+lower_bound_loop:
+
+   ; de = q = item before the remaining interval
+   ; hl = step
+   ; bc = size
+   ; stack = key, ret
+
+   srl h
+   rr l                        ; step /= 2
+
+   push hl
+
+   or a
+   sbc hl,bc
+
+   pop hl
+   jr c, bound_done            ; if step < size
+
+   push hl
+   add hl,de
+
+   push de
+   ex de,hl
+
+   ld hl,6
+   call peek_hl                ; hl = key
+
+   call l_compare_de_hl        ; compare(de=q+step, hl=key)
+
+   pop hl
+   jp m, lower_bound_next      ; if item < key, q += step
+
+   ex de,hl
+
+lower_bound_next:
+
+   pop hl
+   jr lower_bound_loop
+
+upper_bound:
+
+   ; find the first item in [p, e) that is greater than key
+   ;
+   ; enter : de = p
+   ;         hl = e
+   ;         bc = size
+   ;         ix = compare
+   ;         stack = key, ret
+   ;
+   ; exit  : hl = item
+   ;         bc = size
+   ;
+   ; uses  : af, de, hl
+
+   or a
+   sbc hl,de                   ; hl = len = e - p
+   jr z, bound_empty
+
+   push hl
+   call step_hl                ; hl = s = largest size * 2^k <= len
+   ex (sp),hl
+   push hl
+
+   ; de = p
+   ; stack = key, ret, s, len
+
+   ld hl,2
+   call peek_hl
+
+   add hl,de
+   or a
+   sbc hl,bc                   ; hl = item s-1
+
+   push de
+
+   ld de,8
+   ex de,hl
+   call peek_hl
+   ex de,hl                    ; de = key
+
+   call l_compare_de_hl        ; compare(de=key, hl=item)
+
+   pop de                      ; de = p
+   pop hl                      ; hl = len
+
+   jp m, upper_bound_low       ; if key < item
+
+   call bound_high
+   jr upper_bound_loop
+
+upper_bound_low:
+
+   call bound_low
+
+upper_bound_loop:
+
+   ; de = q = item before the remaining interval
+   ; hl = step
+   ; bc = size
+   ; stack = key, ret
+
+   srl h
+   rr l                        ; step /= 2
+
+   push hl
+
+   or a
+   sbc hl,bc
+
+   pop hl
+   jr c, bound_done            ; if step < size
+
+   push hl
+   add hl,de
+
+   push de
+   push hl
+
+   ld hl,8
+   call peek_hl
+
+   ex de,hl                    ; de = key
+
+   pop hl                      ; hl = q+step
+
+   call l_compare_de_hl        ; compare(de=key, hl=q+step)
+
+   ex de,hl
+   pop hl
+   jp p, upper_bound_next      ; if item <= key, q += step
+
+   ex de,hl
+
+upper_bound_next:
+
+   pop hl
+   jr upper_bound_loop
+
+bound_done:
+
+   ex de,hl
+   add hl,bc                   ; hl = q + size
+   ret
+
+bound_empty:
+
+   ex de,hl                    ; hl = p
+   ret
+
+bound_high:
+
+   ; the answer lies in the last s items of the interval
+   ;
+   ; enter : de = p
+   ;         hl = len
+   ;         stack = s, ret
+   ;
+   ; exit  : de = q = p + len - s
+   ;         hl = s, popped from stack
+
+   add hl,de
+
+   pop af
+   pop de
+   push de
+   push af
+
+   or a
+   sbc hl,de
+   ex de,hl
+
+   pop af
+   pop hl
+   push af
+
+   ret
+
+bound_low:
+
+   ; the answer lies in the first s-1 items of the interval
+   ;
+   ; enter : de = p
+   ;         bc = size
+   ;         stack = s, ret
+   ;
+   ; exit  : de = q = p - size
+   ;         hl = s, popped from stack
+
+   ex de,hl
+   or a
+   sbc hl,bc
+   ex de,hl
+
+   pop af
+   pop hl
+   push af
+
+   ret
+
+half_hl:
+
+   ; enter : hl = length of run in bytes, at least two items
+   ;         bc = size
+   ;
+   ; exit  : hl = largest size * 2^k <= length / 2
+   ;         bc, de unchanged
+   ;
+   ; uses  : af, hl
+
+   call step_hl
+
+   srl h
+   rr l
+
+   ret
+
+step_hl:
+
+   ; enter : hl = length of interval in bytes, at least one item
+   ;         bc = size
+   ;
+   ; exit  : hl = largest size * 2^k <= length
+   ;         bc, de unchanged
+   ;
+   ; uses  : af, hl
+
+   push de
+
+   ex de,hl                    ; de = length
+
+   ld l,c
+   ld h,b                      ; hl = size
+
+step_loop:
+
+   push hl
+
+   add hl,hl
+   jr c, step_done
+
+   ld a,e
+   sub l
+   ld a,d
+   sbc a,h
+   jr c, step_done             ; if length < 2 * step
+
+   pop af
+   jr step_loop
+
+step_done:
+
+   pop hl
+   pop de
+
+   ret
+
+rotate:
+
+   ; exchange the adjacent blocks [a, m) and [m, b)
+   ;
+   ; enter : hl = void *a
+   ;         de = void *m
+   ;         bc = void *b
+   ;
+   ; uses  : af, bc, de, hl
+
+   call reverse                ; reverse [a, m)
+
+   push hl
+
+   ex de,hl
+
+   ld e,c
+   ld d,b
+
+   call reverse                ; reverse [m, b)
+
+   pop hl
+
+   jp reverse                  ; reverse [a, b)
+
+reverse:
+
+   ; reverse the bytes in [hl, de)
+   ;
+   ; enter : hl = void *start
+   ;         de = void *end
+   ;
+   ; exit  : bc, de, hl unchanged
+   ;
+   ; uses  : af
+
+   push bc
+   push de
+   push hl
+
+   ld a,e
+   sub l
+   ld c,a
+   ld a,d
+   sbc a,h
+
+   srl a
+   rr c                        ; ac = number of byte pairs
+
+   ld b,c
+
+   inc c
+   dec c
+   jr z, reverse_count
+
+   inc a
+
+reverse_count:
+
+   or a
+   jr z, reverse_done          ; if no bytes to exchange
+
+reverse_pass:
+
+   push af
+
+reverse_loop:
+
+   dec de
+
+   ld a,(de)
+   ld c,(hl)
+   ld (hl),a
+   ld a,c
+   ld (de),a
+
+   inc hl
+   djnz reverse_loop
+
+   pop af
+
+   dec a
+   jr nz, reverse_pass
+
+reverse_done:
+
+   pop hl
+   pop de
+   pop bc
+
+   ret
+
+peek_hl:
+
+   ; enter : hl = offset from caller's stack pointer
+   ;
+   ; exit  : hl = word at that offset
+   ;
+   ; uses  : af, hl
+
+   add hl,sp
+
+   inc hl
+   inc hl
+
+   ld a,(hl)
+   inc hl
+   ld h,(hl)
+   ld l,a
+
+   ret
+
+poke_de:
+
+   ; enter : hl = offset from caller's stack pointer
+   ;         de = word to store at that offset
+   ;
+   ; uses  : hl
+
+   add hl,sp
+
+   inc hl
+   inc hl
+
+   ld (hl),e
+   inc hl
+   ld (hl),d
+
+   ret
@@ -189,6 +189,24 @@ dnl############################################################
    ; __I_FCNTL_NUM_HEAP   = number of heap allocations
    ; __i_fcntl_heap_n     = address of allocation #n on heap (0..__I_FCNTL_NUM_HEAP-1)
 
+   ; __clib_heap_overhead = bytes written by asm_heap_init (mutex, first block, end marker)
+   ; __stdio_heap_lists   = bytes of the block holding the free lists of the size
+   ;                        classes that starts a static segregated heap
+   ;
+   ; __clib_heap_overhead is also used by clib_variables.inc
+
+   IF __CLIB_OPT_MALLOC = __CLIB_OPT_MALLOC_SEGREGATED
+   
+      defc __clib_heap_overhead = 30
+      defc __stdio_heap_lists = 22
+   
+   ELSE
+   
+      defc __clib_heap_overhead = 14
+      defc __stdio_heap_lists = 0
+   
+   ENDIF
+
    IF __I_FCNTL_HEAP_SIZE > 0
    
       ; static FDSTRUCTs have been allocated in the heap
@@ -210,7 +228,20 @@ dnl############################################################
          defb 0xfe             ; spinlock (unlocked)
          defw 0                ; list of threads blocked on mutex
       
-      IF __clib_stdio_heap_size > (__I_FCNTL_HEAP_SIZE + 14)
+      IF __stdio_heap_lists > 0
+      
+         ; the segregated heap keeps its free lists in the first block
+         ; the first FDSTRUCT has no previous block so freeing it leaves
+         ; an empty block in the chain, as happens to a first block
+         
+         defw __i_fcntl_heap_0 ; block->next
+         defw 22               ; block->committed
+         defw 0                ; block->prev
+         defs 16               ; free lists are empty
+      
+      ENDIF
+      
+      IF __clib_stdio_heap_size > (__I_FCNTL_HEAP_SIZE + __stdio_heap_lists + 14)
       
          ; expand stdio heap to desired size
          
@@ -221,7 +252,7 @@ dnl############################################################
             defw __i_fcntl_heap_`'incr(__I_FCNTL_NUM_HEAP)
             defw 0
             defw __i_fcntl_heap_`'decr(__I_FCNTL_NUM_HEAP)
-            defs __clib_stdio_heap_size - __I_FCNTL_HEAP_SIZE - 14
+            defs __clib_stdio_heap_size - __I_FCNTL_HEAP_SIZE - __stdio_heap_lists - 14
          
          ; terminate stdio heap
          
@@ -243,7 +274,7 @@ dnl############################################################
    
       ; no FDSTRUCTs statically created
       
-      IF __clib_stdio_heap_size > 14
+      IF __clib_stdio_heap_size > __clib_heap_overhead
       
          SECTION data_clib
          SECTION data_fcntl
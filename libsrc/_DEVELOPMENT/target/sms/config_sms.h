@@ -288,6 +288,8 @@
 #define __CLIB_OPT_SORT_INSERTION  0
 #define __CLIB_OPT_SORT_SHELL  1
 #define __CLIB_OPT_SORT_QUICK  2
+#define __CLIB_OPT_SORT_INTRO  3
+#define __CLIB_OPT_SORT_MERGE  4
 
 #define __CLIB_OPT_SORT_QSORT  0x0c
 
@@ -297,6 +299,11 @@
 #define __CLIB_OPT_SORT_QSORT_ENABLE_INSERTION  0x04
 #define __CLIB_OPT_SORT_QSORT_ENABLE_EQUAL  0x08
 
+#define __CLIB_OPT_MALLOC  0
+
+#define __CLIB_OPT_MALLOC_FIRST_FIT  0
+#define __CLIB_OPT_MALLOC_SEGREGATED  1
+
 #define __CLIB_OPT_ERROR  0x00
 
 #define __CLIB_OPT_ERROR_ENABLED  0x01
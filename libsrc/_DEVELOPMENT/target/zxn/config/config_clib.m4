@@ -474,10 +474,14 @@ define(`__CLIB_OPT_SORT', 1)
 define(`__CLIB_OPT_SORT_INSERTION', 0)
 define(`__CLIB_OPT_SORT_SHELL', 1)
 define(`__CLIB_OPT_SORT_QUICK', 2)
+define(`__CLIB_OPT_SORT_INTRO', 3)
+define(`__CLIB_OPT_SORT_MERGE', 4)
 
 ; 0 = insertion sort
 ; 1 = shell sort (not reentrant)
 ; 2 = quick sort
+; 3 = introsort (quick sort with heap sort fallback, O(n log n) worst case)
+; 4 = merge sort (stable, in place)
 
 ; Some sorting algorithms have selectable options.
 
@@ -495,6 +499,18 @@ define(`__CLIB_OPT_SORT_QSORT_ENABLE_EQUAL', 0x08)
 ; bit  2 = $04 = enable insertion sort for small partitions
 ; bit  3 = $08 = enable equal items distribution
 
+; Select the type of heap used by malloc() and the heap_*()
+; functions.
+
+define(`__CLIB_OPT_MALLOC', 0)
+
+define(`__CLIB_OPT_MALLOC_FIRST_FIT', 0)
+define(`__CLIB_OPT_MALLOC_SEGREGATED', 1)
+
+; 0 = a single chain of blocks searched first fit
+; 1 = segregated free lists for small blocks (up to 32 bytes),
+;     first fit with coalescing for larger blocks
+
 ; #############################################################
 ; ## Error Strings ############################################
 ; #############################################################
@@ -703,6 +719,8 @@ PUBLIC `__CLIB_OPT_SORT'
 PUBLIC `__CLIB_OPT_SORT_INSERTION'
 PUBLIC `__CLIB_OPT_SORT_SHELL'
 PUBLIC `__CLIB_OPT_SORT_QUICK'
+PUBLIC `__CLIB_OPT_SORT_INTRO'
+PUBLIC `__CLIB_OPT_SORT_MERGE'
 
 PUBLIC `__CLIB_OPT_SORT_QSORT'
 
@@ -712,6 +730,11 @@ PUBLIC `__CLIB_OPT_SORT_QSORT_PIVOT_RAN'
 PUBLIC `__CLIB_OPT_SORT_QSORT_ENABLE_INSERTION'
 PUBLIC `__CLIB_OPT_SORT_QSORT_ENABLE_EQUAL'
 
+PUBLIC `__CLIB_OPT_MALLOC'
+
+PUBLIC `__CLIB_OPT_MALLOC_FIRST_FIT'
+PUBLIC `__CLIB_OPT_MALLOC_SEGREGATED'
+
 PUBLIC `__CLIB_OPT_ERROR'
 
 PUBLIC `__CLIB_OPT_ERROR_ENABLED'
@@ -906,6 +929,8 @@ defc `__CLIB_OPT_SORT' = __CLIB_OPT_SORT
 defc `__CLIB_OPT_SORT_INSERTION' = __CLIB_OPT_SORT_INSERTION
 defc `__CLIB_OPT_SORT_SHELL' = __CLIB_OPT_SORT_SHELL
 defc `__CLIB_OPT_SORT_QUICK' = __CLIB_OPT_SORT_QUICK
+defc `__CLIB_OPT_SORT_INTRO' = __CLIB_OPT_SORT_INTRO
+defc `__CLIB_OPT_SORT_MERGE' = __CLIB_OPT_SORT_MERGE
 
 defc `__CLIB_OPT_SORT_QSORT' = __CLIB_OPT_SORT_QSORT
 
@@ -915,6 +940,11 @@ defc `__CLIB_OPT_SORT_QSORT_PIVOT_RAN' = __CLIB_OPT_SORT_QSORT_PIVOT_RAN
 defc `__CLIB_OPT_SORT_QSORT_ENABLE_INSERTION' = __CLIB_OPT_SORT_QSORT_ENABLE_INSERTION
 defc `__CLIB_OPT_SORT_QSORT_ENABLE_EQUAL' = __CLIB_OPT_SORT_QSORT_ENABLE_EQUAL
 
+defc `__CLIB_OPT_MALLOC' = __CLIB_OPT_MALLOC
+
+defc `__CLIB_OPT_MALLOC_FIRST_FIT' = __CLIB_OPT_MALLOC_FIRST_FIT
+defc `__CLIB_OPT_MALLOC_SEGREGATED' = __CLIB_OPT_MALLOC_SEGREGATED
+
 defc `__CLIB_OPT_ERROR' = __CLIB_OPT_ERROR
 
 defc `__CLIB_OPT_ERROR_ENABLED' = __CLIB_OPT_ERROR_ENABLED
@@ -1109,6 +1139,8 @@ ifdef(`CFG_C_DEF',
 `#define' `__CLIB_OPT_SORT_INSERTION'  __CLIB_OPT_SORT_INSERTION
 `#define' `__CLIB_OPT_SORT_SHELL'  __CLIB_OPT_SORT_SHELL
 `#define' `__CLIB_OPT_SORT_QUICK'  __CLIB_OPT_SORT_QUICK
+`#define' `__CLIB_OPT_SORT_INTRO'  __CLIB_OPT_SORT_INTRO
+`#define' `__CLIB_OPT_SORT_MERGE'  __CLIB_OPT_SORT_MERGE
 
 `#define' `__CLIB_OPT_SORT_QSORT'  __CLIB_OPT_SORT_QSORT
 
@@ -1118,6 +1150,11 @@ ifdef(`CFG_C_DEF',
 `#define' `__CLIB_OPT_SORT_QSORT_ENABLE_INSERTION'  __CLIB_OPT_SORT_QSORT_ENABLE_INSERTION
 `#define' `__CLIB_OPT_SORT_QSORT_ENABLE_EQUAL'  __CLIB_OPT_SORT_QSORT_ENABLE_EQUAL
 
+`#define' `__CLIB_OPT_MALLOC'  __CLIB_OPT_MALLOC
+
+`#define' `__CLIB_OPT_MALLOC_FIRST_FIT'  __CLIB_OPT_MALLOC_FIRST_FIT
+`#define' `__CLIB_OPT_MALLOC_SEGREGATED'  __CLIB_OPT_MALLOC_SEGREGATED
+
 `#define' `__CLIB_OPT_ERROR'  __CLIB_OPT_ERROR
 
 `#define' `__CLIB_OPT_ERROR_ENABLED'  __CLIB_OPT_ERROR_ENABLED
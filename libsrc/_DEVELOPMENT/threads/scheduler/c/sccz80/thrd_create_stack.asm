@@ -0,0 +1,25 @@
+
+; int thrd_create_stack(thrd_t *thr, void *stack, thrd_start_t func, void *arg)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_create_stack
+
+EXTERN asm_thrd_create_stack
+
+thrd_create_stack:
+
+   pop af
+   pop ix
+   pop bc
+   pop de
+   pop hl
+
+   push hl
+   push de
+   push bc
+   push hl
+   push af
+
+   jp asm_thrd_create_stack
@@ -0,0 +1,11 @@
+
+; thrd_t thrd_current(void)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_current
+
+EXTERN asm_thrd_current
+
+defc thrd_current = asm_thrd_current
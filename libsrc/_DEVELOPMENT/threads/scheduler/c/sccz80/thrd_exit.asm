@@ -0,0 +1,11 @@
+
+; void thrd_exit(int res)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_exit
+
+EXTERN asm_thrd_exit
+
+defc thrd_exit = asm_thrd_exit
@@ -0,0 +1,21 @@
+
+; int thrd_join(thrd_t thr, int *res)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_join
+
+EXTERN asm_thrd_join
+
+thrd_join:
+
+   pop af
+   pop de
+   pop hl
+
+   push hl
+   push de
+   push af
+
+   jp asm_thrd_join
@@ -0,0 +1,17 @@
+
+; int thrd_join(thrd_t thr, int *res)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_join_callee
+
+EXTERN asm_thrd_join
+
+thrd_join_callee:
+
+   pop hl
+   pop de
+   ex (sp),hl
+
+   jp asm_thrd_join
@@ -0,0 +1,21 @@
+
+; void thrd_scheduler_init(uint16_t ticks_per_second, uint8_t timeslice)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_scheduler_init
+
+EXTERN asm_thrd_scheduler_init
+
+thrd_scheduler_init:
+
+   pop af
+   pop bc
+   pop hl
+
+   push hl
+   push bc
+   push af
+
+   jp asm_thrd_scheduler_init
@@ -0,0 +1,17 @@
+
+; void thrd_scheduler_init(uint16_t ticks_per_second, uint8_t timeslice)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_scheduler_init_callee
+
+EXTERN asm_thrd_scheduler_init
+
+thrd_scheduler_init_callee:
+
+   pop hl
+   pop bc
+   ex (sp),hl
+
+   jp asm_thrd_scheduler_init
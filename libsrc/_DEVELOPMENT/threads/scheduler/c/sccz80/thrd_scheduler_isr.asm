@@ -0,0 +1,11 @@
+
+; void thrd_scheduler_isr(void)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_scheduler_isr
+
+EXTERN asm_thrd_scheduler_isr
+
+defc thrd_scheduler_isr = asm_thrd_scheduler_isr
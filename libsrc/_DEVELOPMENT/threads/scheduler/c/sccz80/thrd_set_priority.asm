@@ -0,0 +1,21 @@
+
+; void thrd_set_priority(thrd_t thr, uint8_t priority)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_set_priority
+
+EXTERN asm_thrd_set_priority
+
+thrd_set_priority:
+
+   pop af
+   pop bc
+   pop hl
+
+   push hl
+   push bc
+   push af
+
+   jp asm_thrd_set_priority
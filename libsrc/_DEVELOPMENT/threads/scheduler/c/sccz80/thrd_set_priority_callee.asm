@@ -0,0 +1,17 @@
+
+; void thrd_set_priority(thrd_t thr, uint8_t priority)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_set_priority_callee
+
+EXTERN asm_thrd_set_priority
+
+thrd_set_priority_callee:
+
+   pop hl
+   pop bc
+   ex (sp),hl
+
+   jp asm_thrd_set_priority
@@ -0,0 +1,21 @@
+
+; int thrd_sleep(struct timespec *duration, struct timespec *remaining)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_sleep
+
+EXTERN asm_thrd_sleep
+
+thrd_sleep:
+
+   pop af
+   pop bc
+   pop hl
+
+   push hl
+   push bc
+   push af
+
+   jp asm_thrd_sleep
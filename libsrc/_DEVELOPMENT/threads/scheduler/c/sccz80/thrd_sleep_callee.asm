@@ -0,0 +1,17 @@
+
+; int thrd_sleep(struct timespec *duration, struct timespec *remaining)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_sleep_callee
+
+EXTERN asm_thrd_sleep
+
+thrd_sleep_callee:
+
+   pop hl
+   pop bc
+   ex (sp),hl
+
+   jp asm_thrd_sleep
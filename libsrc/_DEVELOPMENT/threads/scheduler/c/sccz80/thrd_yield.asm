@@ -0,0 +1,11 @@
+
+; void thrd_yield(void)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC thrd_yield
+
+EXTERN asm_thrd_yield
+
+defc thrd_yield = asm_thrd_yield
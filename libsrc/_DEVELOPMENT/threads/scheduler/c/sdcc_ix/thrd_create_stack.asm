@@ -0,0 +1,26 @@
+
+; int thrd_create_stack(thrd_t *thr, void *stack, thrd_start_t func, void *arg)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_create_stack
+
+EXTERN l0_thrd_create_stack_callee
+
+_thrd_create_stack:
+
+   pop af
+   pop hl
+   pop de
+   pop bc
+   exx
+   pop bc
+
+   push bc
+   push de
+   push hl
+   push bc
+   push af
+
+   jp l0_thrd_create_stack_callee
@@ -0,0 +1,31 @@
+
+; int thrd_create_stack_callee(thrd_t *thr, void *stack, thrd_start_t func, void *arg)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_create_stack_callee, l0_thrd_create_stack_callee
+
+EXTERN asm_thrd_create_stack
+
+_thrd_create_stack_callee:
+
+   pop af
+   pop hl
+   pop de
+   pop bc
+   exx
+   pop bc
+   push af
+
+l0_thrd_create_stack_callee:
+
+   push bc
+   exx
+
+   ex (sp),ix
+
+   call asm_thrd_create_stack
+
+   pop ix
+   ret
@@ -0,0 +1,24 @@
+
+; void thrd_scheduler_init(uint16_t ticks_per_second, uint8_t timeslice)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_scheduler_init
+
+EXTERN asm_thrd_scheduler_init
+
+_thrd_scheduler_init:
+
+   pop af
+   pop hl
+   dec sp
+   pop bc
+
+   push bc
+   inc sp
+   push hl
+   push af
+
+   ld c,b
+   jp asm_thrd_scheduler_init
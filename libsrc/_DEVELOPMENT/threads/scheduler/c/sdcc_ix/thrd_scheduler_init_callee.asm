@@ -0,0 +1,20 @@
+
+; void thrd_scheduler_init_callee(uint16_t ticks_per_second, uint8_t timeslice)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_scheduler_init_callee
+
+EXTERN asm_thrd_scheduler_init
+
+_thrd_scheduler_init_callee:
+
+   pop af
+   pop hl
+   dec sp
+   pop bc
+   push af
+
+   ld c,b
+   jp asm_thrd_scheduler_init
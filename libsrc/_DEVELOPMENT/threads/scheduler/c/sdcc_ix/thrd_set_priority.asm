@@ -0,0 +1,24 @@
+
+; void thrd_set_priority(thrd_t thr, uint8_t priority)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_set_priority
+
+EXTERN asm_thrd_set_priority
+
+_thrd_set_priority:
+
+   pop af
+   pop hl
+   dec sp
+   pop bc
+
+   push bc
+   inc sp
+   push hl
+   push af
+
+   ld c,b
+   jp asm_thrd_set_priority
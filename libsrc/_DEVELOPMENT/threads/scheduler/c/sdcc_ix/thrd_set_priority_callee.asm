@@ -0,0 +1,20 @@
+
+; void thrd_set_priority_callee(thrd_t thr, uint8_t priority)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_set_priority_callee
+
+EXTERN asm_thrd_set_priority
+
+_thrd_set_priority_callee:
+
+   pop af
+   pop hl
+   dec sp
+   pop bc
+   push af
+
+   ld c,b
+   jp asm_thrd_set_priority
@@ -0,0 +1,19 @@
+
+; int thrd_sleep(struct timespec *duration, struct timespec *remaining)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_sleep
+
+EXTERN asm_thrd_sleep
+
+_thrd_sleep:
+
+   pop af
+   pop hl
+
+   push hl
+   push af
+
+   jp asm_thrd_sleep
@@ -0,0 +1,11 @@
+
+; void thrd_yield(void)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_yield
+
+EXTERN asm_thrd_yield
+
+defc _thrd_yield = asm_thrd_yield
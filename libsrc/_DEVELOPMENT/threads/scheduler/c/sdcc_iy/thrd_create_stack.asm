@@ -0,0 +1,25 @@
+
+; int thrd_create_stack(thrd_t *thr, void *stack, thrd_start_t func, void *arg)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_create_stack
+
+EXTERN asm_thrd_create_stack
+
+_thrd_create_stack:
+
+   pop af
+   pop hl
+   pop de
+   pop bc
+   pop ix
+
+   push ix
+   push bc
+   push de
+   push hl
+   push af
+
+   jp asm_thrd_create_stack
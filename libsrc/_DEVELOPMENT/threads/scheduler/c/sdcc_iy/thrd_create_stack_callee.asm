@@ -0,0 +1,20 @@
+
+; int thrd_create_stack_callee(thrd_t *thr, void *stack, thrd_start_t func, void *arg)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_create_stack_callee
+
+EXTERN asm_thrd_create_stack
+
+_thrd_create_stack_callee:
+
+   pop af
+   pop hl
+   pop de
+   pop bc
+   pop ix
+   push af
+
+   jp asm_thrd_create_stack
@@ -0,0 +1,19 @@
+
+; void thrd_exit(int res)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_exit
+
+EXTERN asm_thrd_exit
+
+_thrd_exit:
+
+   pop af
+   pop hl
+
+   push hl
+   push af
+
+   jp asm_thrd_exit
@@ -0,0 +1,11 @@
+
+; void thrd_exit_fastcall(int res)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_exit_fastcall
+
+EXTERN asm_thrd_exit
+
+defc _thrd_exit_fastcall = asm_thrd_exit
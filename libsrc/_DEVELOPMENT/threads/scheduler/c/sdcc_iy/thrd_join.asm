@@ -0,0 +1,21 @@
+
+; int thrd_join(thrd_t thr, int *res)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_join
+
+EXTERN asm_thrd_join
+
+_thrd_join:
+
+   pop af
+   pop hl
+   pop de
+
+   push de
+   push hl
+   push af
+
+   jp asm_thrd_join
@@ -0,0 +1,18 @@
+
+; int thrd_join_callee(thrd_t thr, int *res)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_join_callee
+
+EXTERN asm_thrd_join
+
+_thrd_join_callee:
+
+   pop af
+   pop hl
+   pop de
+   push af
+
+   jp asm_thrd_join
@@ -0,0 +1,18 @@
+
+; int thrd_sleep_callee(struct timespec *duration, struct timespec *remaining)
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC _thrd_sleep_callee
+
+EXTERN asm_thrd_sleep
+
+_thrd_sleep_callee:
+
+   pop af
+   pop hl
+   pop de
+   push af
+
+   jp asm_thrd_sleep
@@ -0,0 +1,54 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Scheduler state.
+;
+; struct thrd_s (17 bytes)
+;
+;  +0  next         ready list or wait queue link
+;  +2  priority     higher values run first
+;  +3  id           thread id seen by the mutex functions
+;  +4  state        0 = ready or running, 1 = waiting, 2 = exited
+;  +5  sp           stack pointer while suspended
+;  +7  sleep_next   sleep list link
+;  +9  ticks        ticks until the sleep or timeout ends, 0 = none
+; +11  q            p_forward_list * the thread waits on, 0 = none
+; +13  result       value returned on wake up, exit code once exited
+; +15  join_q       p_forward_list of threads waiting in thrd_join
+;
+; ===============================================================
+
+SECTION data_clib
+SECTION data_threads
+
+PUBLIC __thread_current, __thread_ready, __thread_sleeping
+PUBLIC __thread_timeslice, __thread_countdown, __thread_next_id
+PUBLIC __thread_tick_rate, __thread_tick_ns, __thread_main
+
+__thread_current:     defw 0   ; running thread, 0 if idle or scheduler not started
+__thread_ready:       defw 0   ; ready threads in priority order
+__thread_sleeping:    defw 0   ; sleep_next links of threads with a timeout
+
+__thread_timeslice:   defb 1   ; ticks a thread runs before others of equal priority
+__thread_countdown:   defb 1   ; ticks left in the current timeslice
+__thread_next_id:     defb 2   ; id given to the next thread created
+
+__thread_tick_rate:   defw 0   ; scheduler ticks per second
+__thread_tick_ns:     defw 0, 0   ; nanoseconds per scheduler tick
+
+__thread_main:
+
+   ; struct thrd_s of the thread running main()
+
+   defw 0                      ; next
+   defb 0                      ; priority
+   defb 1                      ; id
+   defb 0                      ; state
+   defw 0                      ; sp
+   defw 0                      ; sleep_next
+   defw 0                      ; ticks
+   defw 0                      ; q
+   defw 0                      ; result
+   defw 0                      ; join_q
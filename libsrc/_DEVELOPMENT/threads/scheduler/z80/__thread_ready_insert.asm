@@ -0,0 +1,78 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Place a thread on the ready list behind all threads of equal
+; or higher priority.  Threads of equal priority take turns.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC __thread_ready_insert
+
+EXTERN __thread_ready
+
+__thread_ready_insert:
+
+   ; enter : hl = thrd_t thr
+   ;         interrupts disabled
+   ;
+   ; exit  : hl = thrd_t thr
+   ;
+   ; uses  : af, c, de
+
+   inc hl
+   inc hl
+   ld c,(hl)                   ; c = thr->priority
+   dec hl
+   dec hl
+   
+   push hl
+   ld hl,__thread_ready
+
+loop:
+
+   ; hl = link to insert after
+   ;  c = priority
+
+   ld e,(hl)
+   inc hl
+   ld d,(hl)
+   dec hl                      ; de = next thread
+   
+   ld a,d
+   or e
+   jr z, insert                ; if end of list
+   
+   inc de
+   inc de
+   
+   ld a,(de)                   ; a = next->priority
+   cp c
+   jr c, insert                ; if next->priority < priority
+   
+   dec de
+   dec de
+   
+   ex de,hl
+   jr loop
+
+insert:
+
+   pop de                      ; de = thr
+
+   ld a,(hl)
+   ld (de),a
+   ld (hl),e
+   inc hl
+   inc de
+   ld a,(hl)
+   ld (de),a                   ; thr->next = link->next
+   dec de
+   ld (hl),d                   ; link->next = thr
+   
+   ex de,hl
+   ret
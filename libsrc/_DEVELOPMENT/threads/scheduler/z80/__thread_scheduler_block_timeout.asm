@@ -0,0 +1,46 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Block the running thread on the list of threads waiting for a
+; spinlock protected object.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC __thread_scheduler_block_timeout
+
+EXTERN __thread_timespec_to_ticks, __thread_wait
+EXTERN asm_cpu_push_di, asm_cpu_pop_ei_jp
+
+__thread_scheduler_block_timeout:
+
+   ; enter : hl = & spinlock, list of waiting threads follows
+   ;         bc = struct timespec *ts (0 = no timeout)
+   ;
+   ;         spinlock is owned
+   ;
+   ; exit  : hl = thrd_success, spinlock is owned
+   ;         hl = thrd_timedout, spinlock not owned
+   ;
+   ; uses  : af, bc, de, hl
+
+   push hl
+   call __thread_timespec_to_ticks
+   pop de
+   
+   ; de = & spinlock
+   ; bc = timeout in ticks
+   
+   call asm_cpu_push_di
+   
+   ld a,$fe
+   ld (de),a                   ; unlock(spinlock)
+   
+   inc de                      ; de = list of waiting threads
+   call __thread_wait
+   
+   jp asm_cpu_pop_ei_jp        ; restore the caller's interrupt state
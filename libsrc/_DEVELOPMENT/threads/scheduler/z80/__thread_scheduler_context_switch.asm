@@ -0,0 +1,33 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Give up the timeslice.  The thread remains ready and runs again
+; after the other ready threads of equal priority.
+;
+; The caller's interrupt state is restored on return.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC __thread_scheduler_context_switch
+
+EXTERN __thread_suspend, asm_cpu_push_di, asm_cpu_pop_ei
+
+__thread_scheduler_context_switch:
+
+   ; uses  : f
+
+   push af
+   call asm_cpu_push_di
+   
+   scf
+   call __thread_suspend
+   
+   call asm_cpu_pop_ei
+   
+   pop af
+   ret
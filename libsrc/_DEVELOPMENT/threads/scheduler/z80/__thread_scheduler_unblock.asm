@@ -0,0 +1,83 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Wake the first thread waiting on a spinlock protected object
+; and hand it the spinlock.
+;
+; The caller's interrupt state is restored on return.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC __thread_scheduler_unblock
+
+EXTERN __thread_current, __thread_wake, __thread_suspend
+EXTERN thrd_success, asm_cpu_push_di, asm_cpu_pop_ei
+
+__thread_scheduler_unblock:
+
+   ; enter : hl = & spinlock, list of waiting threads follows
+   ;
+   ;         spinlock is owned and is not released
+   ;
+   ; exit  : hl unchanged
+   ;         carry set if a thread was unblocked, it owns the spinlock
+   ;
+   ; uses  : af, bc, de
+
+   call asm_cpu_push_di
+   
+   push hl
+   
+   inc hl
+   
+   ld e,(hl)
+   inc hl
+   ld d,(hl)                   ; de = first waiting thread
+   
+   ld a,d
+   or e
+   jr z, none_waiting
+   
+   ex de,hl
+   
+   ld de,thrd_success
+   call __thread_wake
+   
+   inc hl
+   inc hl
+   ld a,(hl)                   ; a = thr->priority
+   
+   ld hl,(__thread_current)
+   inc hl
+   inc hl
+   
+   cp (hl)
+   
+   pop hl
+   
+   jr c, no_preempt
+   jr z, no_preempt            ; if not higher priority than this thread
+
+   scf
+   call __thread_suspend       ; let the unblocked thread run now
+
+no_preempt:
+
+   call asm_cpu_pop_ei
+   
+   scf
+   ret
+
+none_waiting:
+
+   pop hl
+   
+   call asm_cpu_pop_ei
+   
+   or a
+   ret                         ; carry reset
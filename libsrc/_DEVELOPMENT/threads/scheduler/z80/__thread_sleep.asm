@@ -0,0 +1,47 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Suspend the running thread for the time given.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC __thread_sleep
+
+EXTERN __thread_timespec_to_ticks, __thread_wait
+EXTERN __thread_context_switch, thrd_success
+EXTERN asm_cpu_push_di, asm_cpu_pop_ei_jp
+
+__thread_sleep:
+
+   ; enter : bc = struct timespec *ts
+   ;
+   ;         if ts == 0, same as __thread_context_switch
+   ;
+   ; exit  : hl = thrd_success
+   ;
+   ; uses  : af, bc, de, hl
+
+   call __thread_timespec_to_ticks
+   
+   ld a,b
+   or c
+   jr z, yield
+   
+   ld de,0                     ; not waiting on a queue
+   
+   call asm_cpu_push_di
+   call __thread_wait
+   
+   jp asm_cpu_pop_ei_jp        ; restore the caller's interrupt state
+
+yield:
+
+   call __thread_context_switch
+   
+   ld hl,thrd_success
+   ret
@@ -0,0 +1,123 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Suspend the running thread and run the first ready thread.
+;
+; The context of a suspended thread is the frame left on its
+; stack by asm_im2_push_registers under the return address, so
+; threads suspended by the scheduler isr and threads that gave
+; up the cpu are resumed the same way.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC __thread_suspend, __thread_suspend_saved, __thread_dispatch
+
+EXTERN asm_im2_push_registers, asm_im2_pop_registers
+EXTERN __thread_current, __thread_ready, __thread_ready_insert
+EXTERN __thread_timeslice, __thread_countdown, __thrd_id
+
+__thread_suspend:
+
+   ; enter : interrupts disabled
+   ;         carry set to place the running thread on the ready list
+   ;
+   ; exit  : returns when the thread is resumed, interrupts enabled
+   ;
+   ; uses  : none, registers are restored on resume
+
+   call asm_im2_push_registers
+   ex af,af'                   ; carry was left in af'
+
+__thread_suspend_saved:
+
+   ; enter : interrupts disabled
+   ;         registers saved by asm_im2_push_registers
+   ;         carry set to place the running thread on the ready list
+
+   ld hl,(__thread_current)
+   call c, __thread_ready_insert
+
+   ex de,hl
+   ld hl,0
+   add hl,sp
+   ex de,hl
+   
+   ; hl = thrd_t current
+   ; de = sp
+   
+   ld bc,5
+   add hl,bc
+   
+   ld (hl),e
+   inc hl
+   ld (hl),d                   ; current->sp = sp
+
+__thread_dispatch:
+
+   ; enter : interrupts disabled
+   ;         context of the running thread saved or no longer needed
+
+   ld hl,(__thread_ready)
+   
+   ld a,h
+   or l
+   jr z, idle                  ; if no thread is ready
+
+   ld e,(hl)
+   inc hl
+   ld d,(hl)
+   ld (__thread_ready),de      ; pop thread from the ready list
+   
+   dec hl
+   ld (__thread_current),hl
+   
+   inc hl
+   inc hl
+   inc hl
+   
+   ld a,(hl)
+   ld (__thrd_id),a            ; mutex functions see the new thread id
+   
+   inc hl
+   inc hl
+   
+   ld e,(hl)
+   inc hl
+   ld d,(hl)
+   ex de,hl                    ; hl = thread->sp
+   
+   ld a,(__thread_timeslice)
+   ld (__thread_countdown),a   ; start a new timeslice
+
+   ld sp,hl
+   call asm_im2_pop_registers
+   
+   ei
+   ret
+
+idle:
+
+   ; all threads are waiting
+   ; wait for the scheduler isr to make one ready
+   ; using the stack of the last thread suspended
+
+   ld (__thread_current),hl    ; no thread is running
+
+idle_loop:
+
+   ei
+   halt
+   di
+   
+   ld hl,(__thread_ready)
+   
+   ld a,h
+   or l
+   jr z, idle_loop
+   
+   jr __thread_dispatch
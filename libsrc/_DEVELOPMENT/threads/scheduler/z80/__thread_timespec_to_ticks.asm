@@ -0,0 +1,129 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Convert a duration to a number of scheduler ticks.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC __thread_timespec_to_ticks
+
+EXTERN __thread_tick_rate, __thread_tick_ns
+EXTERN l_mulu_32_16x16, l_divu_32_32x32
+
+__thread_timespec_to_ticks:
+
+   ; enter : bc = struct timespec *ts (0 = none)
+   ;
+   ; exit  : bc = 0 if ts == 0
+   ;
+   ;         otherwise bc = duration in ticks rounded up,
+   ;         at least 1 and at most 65535
+   ;
+   ; uses  : af, bc, de, hl
+
+   ld a,b
+   or c
+   ret z                       ; if no duration
+   
+   push ix
+   
+   ld l,c
+   ld h,b                      ; hl = ts
+   
+   ld c,(hl)
+   inc hl
+   ld b,(hl)
+   inc hl                      ; bc = ts->tv_sec & 0xffff
+   
+   ld a,(hl)
+   inc hl
+   or (hl)
+   inc hl                      ; hl = & ts->tv_nsec
+   
+   jr nz, saturate             ; if ts->tv_sec > 65535
+   
+   push hl
+   
+   ld l,c
+   ld h,b
+   ld de,(__thread_tick_rate)
+   
+   call l_mulu_32_16x16        ; dehl = ts->tv_sec * ticks per second
+   
+   ld a,d
+   or e
+   jr nz, saturate_pop
+   
+   ex (sp),hl                  ; hl = & ts->tv_nsec
+   
+   ld c,(hl)
+   inc hl
+   ld b,(hl)
+   inc hl
+   ld e,(hl)
+   inc hl
+   ld d,(hl)
+   
+   ld l,c
+   ld h,b                      ; dehl = ts->tv_nsec
+   
+   exx
+   
+   ld hl,(__thread_tick_ns)
+   ld de,(__thread_tick_ns + 2)
+   
+   call l_divu_32_32x32        ; dehl = tv_nsec / ns per tick, dehl' = remainder
+   
+   ld a,d
+   or e
+   jr nz, saturate_pop
+   
+   exx
+   
+   ld a,d
+   or e
+   or h
+   or l
+   
+   exx
+   
+   jr z, exact
+   
+   inc hl                      ; count part of a tick as a whole tick
+
+exact:
+
+   pop bc
+   
+   add hl,bc
+   jr c, saturate
+   
+   ld a,h
+   or l
+   jr nz, done
+   
+   inc hl                      ; wait at least one tick
+
+done:
+
+   ld c,l
+   ld b,h
+   
+   pop ix
+   ret
+
+saturate_pop:
+
+   pop hl
+
+saturate:
+
+   ld bc,$ffff
+   
+   pop ix
+   ret
@@ -0,0 +1,56 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Entry points into the scheduler used by the mutex functions.
+;
+; Until thrd_scheduler_init() is called the program is a single
+; thread and the vectors return without doing anything.  The
+; scheduler is only linked into programs that start it.
+;
+; ===============================================================
+
+SECTION data_clib
+SECTION data_threads
+
+PUBLIC __thread_context_switch
+PUBLIC __thread_block_timeout
+PUBLIC __thread_unblock
+
+EXTERN l_ret
+
+__thread_context_switch:
+
+   ; give up the timeslice, thread remains ready
+   ;
+   ; uses  : f
+
+   jp l_ret
+
+__thread_block_timeout:
+
+   ; enter : hl = & spinlock, list of waiting threads follows
+   ;         bc = struct timespec *ts (0 = no timeout)
+   ;
+   ;         spinlock is owned
+   ;
+   ; exit  : hl = thrd_success, spinlock is owned
+   ;         hl = thrd_timedout, spinlock not owned
+   ;
+   ; uses  : af, bc, de, hl
+
+   jp l_ret
+
+__thread_unblock:
+
+   ; enter : hl = & spinlock, list of waiting threads follows
+   ;
+   ;         spinlock is owned and is not released
+   ;
+   ; exit  : hl unchanged
+   ;         carry set if a thread was unblocked, it owns the spinlock
+   ;
+   ; uses  : af, bc, de
+
+   jp l_ret
@@ -0,0 +1,101 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Suspend the running thread until it is woken from a queue or
+; its timeout expires.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC __thread_wait
+
+EXTERN __thread_current, __thread_sleeping, __thread_suspend
+EXTERN asm_p_forward_list_push_back, asm_p_forward_list_push_front
+
+__thread_wait:
+
+   ; enter : de = p_forward_list *q to wait on (0 = none)
+   ;         bc = timeout in ticks (0 = none)
+   ;         interrupts disabled
+   ;
+   ; exit  : hl = result given by the thread that woke this one
+   ;              or thrd_timedout if the timeout expired
+   ;
+   ;         interrupts enabled
+   ;
+   ; uses  : af, bc, de, hl
+
+   ld hl,(__thread_current)
+   push hl
+   
+   inc hl
+   inc hl
+   inc hl
+   inc hl
+   
+   ld (hl),1                   ; current->state = waiting
+   
+   push de
+   
+   ld de,5
+   add hl,de
+   
+   pop de
+   
+   ld (hl),c
+   inc hl
+   ld (hl),b                   ; current->ticks = timeout
+   inc hl
+   ld (hl),e
+   inc hl
+   ld (hl),d                   ; current->q = q
+   
+   ld a,d
+   or e
+   jr z, no_queue
+   
+   pop hl
+   push hl
+   push bc
+   
+   ex de,hl
+   call asm_p_forward_list_push_back
+   
+   pop bc
+
+no_queue:
+
+   ld a,b
+   or c
+   jr z, no_timeout
+   
+   pop hl
+   push hl
+   
+   ld de,7
+   add hl,de
+   ex de,hl                    ; de = & current->sleep_next
+   
+   ld hl,__thread_sleeping
+   call asm_p_forward_list_push_front
+
+no_timeout:
+
+   or a
+   call __thread_suspend       ; returns once woken
+   
+   pop hl
+   
+   ld de,13
+   add hl,de
+   
+   ld a,(hl)
+   inc hl
+   ld h,(hl)
+   ld l,a                      ; hl = current->result
+   
+   ret
@@ -0,0 +1,102 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; Move a waiting thread to the ready list.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC __thread_wake
+
+EXTERN __thread_sleeping, __thread_ready_insert
+EXTERN asm_p_forward_list_remove
+
+__thread_wake:
+
+   ; enter : hl = thrd_t thr
+   ;         de = result returned to the thread
+   ;         interrupts disabled
+   ;
+   ; exit  : hl = thrd_t thr
+   ;
+   ; uses  : af, bc, de
+
+   push hl
+   push de
+   
+   ld de,4
+   add hl,de
+   
+   ld (hl),0                   ; thr->state = ready
+   
+   ld e,5
+   add hl,de                   ; hl = & thr->ticks
+   
+   ld a,(hl)
+   ld (hl),d
+   inc hl
+   or (hl)
+   ld (hl),d                   ; thr->ticks = 0
+   
+   jr z, not_sleeping
+
+   ; remove from the sleep list
+   
+   push hl
+   
+   dec hl
+   dec hl
+   dec hl
+   
+   ld c,l
+   ld b,h                      ; bc = & thr->sleep_next
+   
+   ld hl,__thread_sleeping
+   call asm_p_forward_list_remove
+   
+   pop hl
+
+not_sleeping:
+
+   inc hl                      ; hl = & thr->q
+   
+   ld c,(hl)
+   ld (hl),0
+   inc hl
+   ld b,(hl)
+   ld (hl),0                   ; thr->q = 0
+   inc hl
+   
+   pop de
+   
+   ld (hl),e
+   inc hl
+   ld (hl),d                   ; thr->result = result
+
+   pop hl                      ; hl = thr
+   
+   ld a,b
+   or c
+   jr z, ready                 ; if not waiting on a queue
+
+   ; remove from the queue
+
+   push hl
+   
+   ld l,c
+   ld h,b                      ; hl = q
+   
+   pop bc                      ; bc = thr
+   push bc
+   
+   call asm_p_forward_list_remove
+   
+   pop hl
+
+ready:
+
+   jp __thread_ready_insert
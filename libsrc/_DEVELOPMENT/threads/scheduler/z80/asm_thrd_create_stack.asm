@@ -0,0 +1,205 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; int thrd_create_stack(thrd_t *thr, void *stack, thrd_start_t func, void *arg)
+;
+; Create a thread that runs func(arg) on the stack given.  The
+; stack grows down from the address given, which is normally one
+; past the end of the memory set aside for it.
+;
+; The thread's struct thrd_s (17 bytes) is placed at the top of
+; the stack and *thr is set to point at it.  The memory must not
+; be reused until the thread has exited and been joined.
+;
+; The new thread has the priority of the thread creating it and
+; is placed on the ready list.  It calls thrd_exit() with the
+; value returned by func.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC asm_thrd_create_stack
+
+EXTERN __thread_current, __thread_next_id, __thread_ready_insert
+EXTERN asm_thrd_exit, l_jphl, l_setmem_hl, thrd_success, thrd_error
+EXTERN asm_cpu_push_di, asm_cpu_pop_ei
+
+asm_thrd_create_stack:
+
+   ; enter : hl = thrd_t *thr
+   ;         de = void *stack
+   ;         bc = thrd_start_t func
+   ;         ix = void *arg
+   ;
+   ; exit  : success
+   ;
+   ;            hl = thrd_success
+   ;            carry reset
+   ;
+   ;         fail if scheduler not started
+   ;
+   ;            hl = thrd_error
+   ;            carry set
+   ;
+   ; uses  : af, bc, de, hl
+
+   push hl
+   
+   ld hl,(__thread_current)
+   
+   ld a,h
+   or l
+   jr z, error                 ; if scheduler not started
+   
+   ; place struct thrd_s at the top of the new stack
+   
+   ex de,hl                    ; hl = stack
+   
+   ld de,-17
+   add hl,de                   ; hl = struct thrd_s *t
+   
+   ex (sp),hl                  ; hl = thrd_t *thr
+   pop de
+   push de                     ; de = t
+   
+   ld (hl),e
+   inc hl
+   ld (hl),d                   ; *thr = t
+   
+   ex de,hl                    ; hl = t
+   
+   ; build a frame for asm_im2_pop_registers on the new stack
+   
+   dec hl
+   ld (hl),__thread_start / 256
+   dec hl
+   ld (hl),__thread_start % 256
+   
+   dec hl
+   ld (hl),b
+   dec hl
+   ld (hl),c                   ; hl = func
+   
+   xor a
+   ld b,4
+
+af_bc:
+
+   dec hl
+   ld (hl),a
+   djnz af_bc
+   
+   push ix
+   pop de
+   
+   dec hl
+   ld (hl),d
+   dec hl
+   ld (hl),e                   ; de = arg
+   
+   ld b,8
+
+exx_set:
+
+   dec hl
+   ld (hl),a
+   djnz exx_set
+   
+   push ix
+   pop de
+   
+   dec hl
+   ld (hl),d
+   dec hl
+   ld (hl),e                   ; ix
+   
+   push iy
+   pop de
+   
+   dec hl
+   ld (hl),d
+   dec hl
+   ld (hl),e                   ; iy
+   
+   ; initialize struct thrd_s
+   
+   ex de,hl                    ; de = sp of new thread
+   
+   pop hl
+   push hl
+   
+   ld (hl),a
+   inc hl
+   ld (hl),a                   ; t->next = 0
+   inc hl
+   
+   push hl
+   
+   ld hl,(__thread_current)
+   inc hl
+   inc hl
+   ld a,(hl)                   ; a = current->priority
+   
+   pop hl
+   
+   ld (hl),a                   ; t->priority = current->priority
+   inc hl
+   
+   ld a,(__thread_next_id)
+   ld (hl),a                   ; t->id
+   
+   inc a
+   jr nz, id_ok
+   
+   ld a,2                      ; id 1 belongs to main()
+
+id_ok:
+
+   ld (__thread_next_id),a
+   
+   inc hl
+   ld (hl),0                   ; t->state = ready
+   inc hl
+   
+   ld (hl),e
+   inc hl
+   ld (hl),d                   ; t->sp
+   inc hl
+   
+   xor a
+   call l_setmem_hl - 20       ; zero the remaining members
+   
+   pop hl                      ; hl = t
+   
+   call asm_cpu_push_di
+   call __thread_ready_insert
+   call asm_cpu_pop_ei
+   
+   ld hl,thrd_success
+   ret
+
+error:
+
+   pop hl
+   
+   ld hl,thrd_error
+   
+   scf
+   ret
+
+__thread_start:
+
+   ; the new thread starts here
+   ;
+   ; hl = thrd_start_t func
+   ; de = void *arg
+
+   push de
+   call l_jphl
+   pop de
+   
+   jp asm_thrd_exit
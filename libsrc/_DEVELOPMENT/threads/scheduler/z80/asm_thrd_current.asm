@@ -0,0 +1,26 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; thrd_t thrd_current(void)
+;
+; Return the running thread, 0 if the scheduler is not started.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC asm_thrd_current
+
+EXTERN __thread_current
+
+asm_thrd_current:
+
+   ; exit  : hl = thrd_t current
+   ;
+   ; uses  : hl
+
+   ld hl,(__thread_current)
+   ret
@@ -0,0 +1,79 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; void thrd_exit(int res)
+;
+; End the running thread.  Threads waiting in thrd_join() for it
+; are woken.  If the scheduler has not been started the program
+; exits with status res.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC asm_thrd_exit
+
+EXTERN __thread_current, __thread_wake, __thread_dispatch
+EXTERN asm_exit, thrd_success
+
+asm_thrd_exit:
+
+   ; enter : hl = int res
+   ;
+   ; exit  : does not return
+
+   ex de,hl
+   
+   ld hl,(__thread_current)
+   
+   ld a,h
+   or l
+   jr z, exit_program          ; if scheduler not started
+   
+   di
+   
+   ld bc,4
+   add hl,bc
+   
+   ld (hl),2                   ; current->state = exited
+   
+   ld c,9
+   add hl,bc
+   
+   ld (hl),e
+   inc hl
+   ld (hl),d                   ; current->result = res
+   inc hl
+   
+   ; hl = & current->join_q
+
+wake_loop:
+
+   push hl
+   
+   ld a,(hl)
+   inc hl
+   ld h,(hl)
+   ld l,a                      ; hl = first waiting thread
+   
+   or h
+   jr z, wake_done
+   
+   ld de,thrd_success
+   call __thread_wake          ; removes the thread from join_q
+   
+   pop hl
+   jr wake_loop
+
+wake_done:
+
+   pop hl
+   jp __thread_dispatch
+
+exit_program:
+
+   ex de,hl
+   jp asm_exit
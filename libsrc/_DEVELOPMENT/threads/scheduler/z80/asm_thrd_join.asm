@@ -0,0 +1,96 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; int thrd_join(thrd_t thr, int *res)
+;
+; Wait for the thread to exit.  If res is not 0, the thread's
+; exit code is written to *res.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC asm_thrd_join
+
+EXTERN __thread_current, __thread_wait, thrd_success, thrd_error
+EXTERN asm_cpu_push_di, asm_cpu_pop_ei
+
+asm_thrd_join:
+
+   ; enter : hl = thrd_t thr
+   ;         de = int *res
+   ;
+   ; exit  : success
+   ;
+   ;            hl = thrd_success
+   ;            carry reset
+   ;
+   ;         fail if scheduler not started
+   ;
+   ;            hl = thrd_error
+   ;            carry set
+   ;
+   ; uses  : af, bc, de, hl
+
+   ld bc,(__thread_current)
+   
+   ld a,b
+   or c
+   jr z, error                 ; if scheduler not started
+   
+   push de
+   push hl
+   
+   ld bc,4
+   add hl,bc
+   
+   call asm_cpu_push_di
+   
+   ld a,(hl)
+   cp 2
+   jr z, exited                ; if thr->state == exited
+   
+   ld c,11
+   add hl,bc
+   ex de,hl                    ; de = & thr->join_q
+   
+   ld c,b                      ; no timeout
+   call __thread_wait
+
+exited:
+
+   call asm_cpu_pop_ei
+   
+   pop hl
+   
+   ld de,13
+   add hl,de
+   
+   ld e,(hl)
+   inc hl
+   ld d,(hl)                   ; de = thr->result
+   
+   pop hl
+   
+   ld a,h
+   or l
+   jr z, success
+   
+   ld (hl),e
+   inc hl
+   ld (hl),d                   ; *res = thr->result
+
+success:
+
+   ld hl,thrd_success
+   ret
+
+error:
+
+   ld hl,thrd_error
+   
+   scf
+   ret
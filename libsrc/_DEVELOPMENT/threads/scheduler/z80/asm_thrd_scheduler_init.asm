@@ -0,0 +1,81 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; void thrd_scheduler_init(uint16_t ticks_per_second, uint8_t timeslice)
+;
+; Start the scheduler.  The caller becomes the first thread.
+;
+; The scheduler is driven by thrd_scheduler_isr() installed on
+; an im2 vector of a periodic interrupt that occurs the number of
+; times per second given.  A thread runs for timeslice ticks
+; before threads of equal priority are given a turn.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC asm_thrd_scheduler_init
+
+EXTERN __thread_current, __thread_main, __thread_timeslice, __thread_countdown
+EXTERN __thread_tick_rate, __thread_tick_ns, l_divu_32_32x32
+EXTERN __thread_context_switch, __thread_scheduler_context_switch
+EXTERN __thread_block_timeout, __thread_scheduler_block_timeout
+EXTERN __thread_unblock, __thread_scheduler_unblock
+
+asm_thrd_scheduler_init:
+
+   ; enter : hl = ticks per second (> 0)
+   ;          c = timeslice in ticks (0 = 1)
+   ;
+   ; uses  : af, bc, de, hl
+
+   ld a,c
+   or a
+   jr nz, timeslice_ok
+   
+   inc a
+
+timeslice_ok:
+
+   ld (__thread_timeslice),a
+   ld (__thread_countdown),a
+   
+   ld (__thread_tick_rate),hl
+   
+   push ix
+   
+   exx
+   
+   ld de,1000000000 / 65536
+   ld hl,1000000000 % 65536
+   
+   exx
+   
+   ld de,0
+   call l_divu_32_32x32        ; dehl = nanoseconds per tick
+   
+   ld (__thread_tick_ns),hl
+   ld (__thread_tick_ns + 2),de
+   
+   pop ix
+   
+   ; direct the mutex functions to the scheduler
+   
+   ld hl,__thread_scheduler_context_switch
+   ld (__thread_context_switch + 1),hl
+   
+   ld hl,__thread_scheduler_block_timeout
+   ld (__thread_block_timeout + 1),hl
+   
+   ld hl,__thread_scheduler_unblock
+   ld (__thread_unblock + 1),hl
+   
+   ; the caller is the running thread
+   
+   ld hl,__thread_main
+   ld (__thread_current),hl
+   
+   ret
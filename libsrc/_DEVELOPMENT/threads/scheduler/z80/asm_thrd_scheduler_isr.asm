@@ -0,0 +1,158 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; void thrd_scheduler_isr(void)
+;
+; Interrupt service routine driving the scheduler.  Install it
+; on the im2 vector of a periodic interrupt.
+;
+; Each interrupt is one tick.  Threads whose sleep or timeout
+; ends are made ready.  The running thread is preempted if a
+; thread of higher priority is ready or if its timeslice ends
+; while a thread of equal priority is ready.
+;
+; The interrupt uses about 40 bytes of the running thread's stack.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC asm_thrd_scheduler_isr
+
+EXTERN asm_im2_push_registers, asm_im2_pop_registers
+EXTERN __thread_current, __thread_ready, __thread_sleeping
+EXTERN __thread_countdown, __thread_wake, __thread_suspend_saved
+EXTERN thrd_success, thrd_timedout
+
+asm_thrd_scheduler_isr:
+
+   call asm_im2_push_registers
+   call acknowledge
+   
+   ; count down the sleeping threads
+   
+   ld hl,__thread_sleeping
+
+sleep_loop:
+
+   ; hl = link to next item
+
+   ld e,(hl)
+   inc hl
+   ld d,(hl)
+   dec hl                      ; de = & thr->sleep_next
+   
+   ld a,d
+   or e
+   jr z, sleep_done            ; if end of sleep list
+   
+   ex de,hl
+   
+   ; de = link to item
+   ; hl = & thr->sleep_next
+   
+   inc hl
+   inc hl
+   
+   ld c,(hl)
+   inc hl
+   ld b,(hl)
+   dec bc
+   ld (hl),b
+   dec hl
+   ld (hl),c                   ; thr->ticks--
+   
+   dec hl
+   dec hl
+   
+   ld a,b
+   or c
+   jr nz, sleep_loop           ; if time remains
+
+   ; remove from the sleep list
+   
+   ld a,(hl)
+   ld (de),a
+   inc hl
+   inc de
+   ld a,(hl)
+   ld (de),a                   ; link = thr->sleep_next
+   dec de
+   
+   push de
+   
+   ld bc,-8
+   add hl,bc                   ; hl = thr
+   
+   push hl
+   
+   ld bc,11
+   add hl,bc
+   
+   ld a,(hl)
+   inc hl
+   or (hl)                     ; z if not waiting on a queue
+   
+   pop hl
+   
+   ld de,thrd_success          ; sleep is over
+   jr z, wake
+   
+   ld de,thrd_timedout         ; wait timed out
+
+wake:
+
+   call __thread_wake
+   
+   pop hl
+   jr sleep_loop
+
+sleep_done:
+
+   ld hl,(__thread_current)
+   
+   ld a,h
+   or l
+   jr z, resume                ; if no thread is running
+   
+   inc hl
+   inc hl
+   ld c,(hl)                   ; c = current->priority
+   
+   ld hl,(__thread_ready)
+   
+   ld a,h
+   or l
+   jr z, resume                ; if no other thread is ready
+   
+   inc hl
+   inc hl
+   
+   ld a,(hl)                   ; a = priority of first ready thread
+   cp c
+   jr c, resume                ; if lower priority
+   jr nz, preempt              ; if higher priority
+   
+   ld hl,__thread_countdown
+   
+   dec (hl)
+   jr nz, resume               ; if timeslice not over
+
+preempt:
+
+   scf
+   jp __thread_suspend_saved
+
+resume:
+
+   call asm_im2_pop_registers
+   
+   ei
+   ret
+
+acknowledge:
+
+   reti
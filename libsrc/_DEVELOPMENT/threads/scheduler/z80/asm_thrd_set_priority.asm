@@ -0,0 +1,50 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; void thrd_set_priority(thrd_t thr, uint8_t priority)
+;
+; Change the priority of a thread.  Higher priority threads run
+; first.  Threads start with the priority of their creator and
+; main() starts with priority 0.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC asm_thrd_set_priority
+
+EXTERN __thread_ready, __thread_ready_insert, __thread_context_switch
+EXTERN asm_p_forward_list_remove, asm_cpu_push_di, asm_cpu_pop_ei
+
+asm_thrd_set_priority:
+
+   ; enter : hl = thrd_t thr
+   ;          c = priority
+   ;
+   ; uses  : af, bc, de, hl
+
+   call asm_cpu_push_di
+   
+   push hl
+   
+   inc hl
+   inc hl
+   ld (hl),c                   ; thr->priority = priority
+   
+   pop bc
+   push bc
+   
+   ld hl,__thread_ready
+   call asm_p_forward_list_remove
+   
+   pop hl
+   call nc, __thread_ready_insert   ; if thr was ready, place it again
+   
+   call asm_cpu_pop_ei
+   
+   ; let a thread of higher priority run
+   
+   jp __thread_context_switch
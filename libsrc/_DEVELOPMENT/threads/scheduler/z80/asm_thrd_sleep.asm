@@ -0,0 +1,49 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; int thrd_sleep(struct timespec *duration, struct timespec *remaining)
+;
+; Suspend the running thread for the duration given, rounded up
+; to whole scheduler ticks.  The sleep is never interrupted so
+; remaining is not written.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC asm_thrd_sleep
+
+EXTERN __thread_current, __thread_sleep, error_mc
+
+asm_thrd_sleep:
+
+   ; enter : hl = struct timespec *duration
+   ;
+   ; exit  : success
+   ;
+   ;            hl = 0
+   ;            carry reset
+   ;
+   ;         fail if scheduler not started
+   ;
+   ;            hl = -1
+   ;            carry set
+   ;
+   ; uses  : af, bc, de, hl
+
+   ld c,l
+   ld b,h
+   
+   ld hl,(__thread_current)
+   
+   ld a,h
+   or l
+   jp z, error_mc              ; if scheduler not started
+   
+   call __thread_sleep
+   
+   or a
+   ret
@@ -0,0 +1,19 @@
+
+; ===============================================================
+; Oct 2026
+; ===============================================================
+;
+; void thrd_yield(void)
+;
+; Let other threads of equal priority run.
+;
+; ===============================================================
+
+SECTION code_clib
+SECTION code_threads
+
+PUBLIC asm_thrd_yield
+
+EXTERN __thread_context_switch
+
+defc asm_thrd_yield = __thread_context_switch
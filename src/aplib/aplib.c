@@ -0,0 +1,301 @@
+/*
+ * z88dk-aplib - optimal aPLib compressor
+ *
+ * Several files can be compressed at the same time.  Each one is
+ * decompressed again with the reference decompressor before it is
+ * written.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "aplib.h"
+
+long parse_long(char *str) {
+    long value;
+
+    errno = 0;
+    value = strtol(str, NULL, 10);
+    return !errno ? value : LONG_MIN;
+}
+
+/* A file to convert, several of them are converted at the same time in
+   multiple file mode */
+typedef struct {
+    char *input_name;
+    char *output_name;
+    int ok;
+    char message[256];
+} Job;
+
+static int forced_mode = 0;
+
+/* Compress one file, the outcome is left in the job's message */
+static void compress_file(Job *job) {
+    unsigned char *input_data;
+    unsigned char *output_data;
+    FILE *ifp;
+    FILE *ofp;
+    unsigned char *check_data;
+    Token *tokens;
+    size_t num_tokens;
+    size_t input_size;
+    size_t output_size;
+    size_t check_size;
+    size_t partial_counter;
+    size_t total_counter;
+
+    job->ok = 0;
+
+    /* open input file */
+    ifp = fopen(job->input_name, "rb");
+    if (!ifp) {
+        snprintf(job->message, sizeof(job->message), "Error: Cannot access input file %s\n", job->input_name);
+        return;
+    }
+
+    /* determine input size */
+    fseek(ifp, 0L, SEEK_END);
+    input_size = ftell(ifp);
+    fseek(ifp, 0L, SEEK_SET);
+    if (!input_size) {
+        snprintf(job->message, sizeof(job->message), "Error: Empty input file %s\n", job->input_name);
+        fclose(ifp);
+        return;
+    }
+
+    /* allocate input buffer */
+    input_data = (unsigned char *)malloc(input_size);
+    if (!input_data) {
+        fprintf(stderr, "Error: Insufficient memory\n");
+        exit(1);
+    }
+
+    /* read input file */
+    total_counter = 0;
+    do {
+        partial_counter = fread(input_data+total_counter, sizeof(char), input_size-total_counter, ifp);
+        total_counter += partial_counter;
+    } while (partial_counter > 0);
+
+    /* close input file */
+    fclose(ifp);
+
+    if (total_counter != input_size) {
+        snprintf(job->message, sizeof(job->message), "Error: Cannot read input file %s\n", job->input_name);
+        free(input_data);
+        return;
+    }
+
+    /* check output file */
+    if (!forced_mode && (ofp = fopen(job->output_name, "rb")) != NULL) {
+        snprintf(job->message, sizeof(job->message), "Error: Already existing output file %s\n", job->output_name);
+        fclose(ofp);
+        free(input_data);
+        return;
+    }
+
+    /* generate output file */
+    tokens = optimize(input_data, input_size, &num_tokens);
+    output_data = compress(tokens, num_tokens, input_data, input_size, &output_size);
+    free(tokens);
+
+    /* verify output file */
+    check_data = (unsigned char *)malloc(input_size);
+    if (!check_data) {
+        fprintf(stderr, "Error: Insufficient memory\n");
+        exit(1);
+    }
+    if (depack(output_data, output_size, check_data, input_size, &check_size) || check_size != input_size || memcmp(check_data, input_data, input_size)) {
+        snprintf(job->message, sizeof(job->message), "Error: Verification failed for %s\n", job->input_name);
+        free(check_data);
+        free(output_data);
+        free(input_data);
+        return;
+    }
+    free(check_data);
+    free(input_data);
+
+    /* create output file */
+    ofp = fopen(job->output_name, "wb");
+    if (!ofp) {
+        snprintf(job->message, sizeof(job->message), "Error: Cannot create output file %s\n", job->output_name);
+        free(output_data);
+        return;
+    }
+
+    /* write output file */
+    if (fwrite(output_data, sizeof(char), output_size, ofp) != output_size) {
+        snprintf(job->message, sizeof(job->message), "Error: Cannot write output file %s\n", job->output_name);
+        fclose(ofp);
+        free(output_data);
+        return;
+    }
+
+    /* close output file */
+    fclose(ofp);
+    free(output_data);
+
+    /* done! */
+    snprintf(job->message, sizeof(job->message), "File converted from %lu to %lu bytes and verified!\n",
+        (unsigned long)input_size, (unsigned long)output_size);
+    job->ok = 1;
+}
+
+#ifndef _WIN32
+/* The threads take the next file from the list until none is left */
+typedef struct {
+    Job *jobs;
+    int num_jobs;
+    int next_job;
+    pthread_mutex_t lock;
+} JobQueue;
+
+static void *compress_thread(void *arg) {
+    JobQueue *queue = (JobQueue *)arg;
+    int job;
+
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        job = queue->next_job++;
+        pthread_mutex_unlock(&queue->lock);
+        if (job >= queue->num_jobs) {
+            return NULL;
+        }
+        compress_file(&queue->jobs[job]);
+    }
+}
+#endif
+
+/* Compress the files with up to num_threads of them at the same time */
+static void compress_files(Job *jobs, int num_jobs, int num_threads) {
+#ifndef _WIN32
+    JobQueue queue;
+    pthread_t *threads;
+    int started;
+    int i;
+
+    if (num_threads <= 0) {
+        num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (num_threads > num_jobs) {
+        num_threads = num_jobs;
+    }
+    if (num_threads > 1) {
+        queue.jobs = jobs;
+        queue.num_jobs = num_jobs;
+        queue.next_job = 0;
+        pthread_mutex_init(&queue.lock, NULL);
+        threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
+        if (!threads) {
+            fprintf(stderr, "Error: Insufficient memory\n");
+            exit(1);
+        }
+        for (started = 0; started < num_threads; started++) {
+            if (pthread_create(&threads[started], NULL, compress_thread, &queue) != 0) {
+                break;
+            }
+        }
+        /* the calling thread helps if fewer threads could be started */
+        if (started < num_threads) {
+            compress_thread(&queue);
+        }
+        for (i = 0; i < started; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        free(threads);
+        pthread_mutex_destroy(&queue.lock);
+        return;
+    }
+#else
+    int i;
+#endif
+    for (i = 0; i < num_jobs; i++) {
+        compress_file(&jobs[i]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int multiple_mode = 0;
+    int num_threads = 0;
+    int num_jobs;
+    Job *jobs;
+    int failed;
+    int i;
+    int j;
+
+    printf("aPLib: Optimal compression for the aPLib decompressor\n");
+
+    /* process hidden optional parameters */
+    for (i = 1; i < argc && *argv[i] == '-'; i++) {
+        if (!strcmp(argv[i], "-f")) {
+            forced_mode = 1;
+        } else if (!strcmp(argv[i], "-m")) {
+            multiple_mode = 1;
+        } else if (!strncmp(argv[i], "-j", 2)) {
+            if ((num_threads = parse_long(argv[i]+2)) <= 0) {
+                fprintf(stderr, "Error: Invalid parameter %s\n", argv[i]);
+                exit(1);
+            }
+        } else {
+            fprintf(stderr, "Error: Invalid parameter %s\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    /* determine output filenames */
+    if (multiple_mode && argc > i) {
+        num_jobs = argc-i;
+    } else if (!multiple_mode && (argc == i+1 || argc == i+2)) {
+        num_jobs = 1;
+    } else {
+        fprintf(stderr, "Usage: %s [-f] input [output.apl]\n"
+                        "       %s [-f] -m [-jN] input...\n"
+                        "  -f      Force overwrite of output file\n"
+                        "  -m      Compress multiple files, each input to input.apl\n"
+                        "  -jN     Compress up to N files at the same time (default: one per CPU)\n", argv[0], argv[0]);
+
+        exit(1);
+    }
+
+    jobs = (Job *)calloc(num_jobs, sizeof(Job));
+    if (!jobs) {
+        fprintf(stderr, "Error: Insufficient memory\n");
+        exit(1);
+    }
+    for (j = 0; j < num_jobs; j++) {
+        jobs[j].input_name = argv[i+j];
+        if (argc == i+2 && !multiple_mode) {
+            jobs[j].output_name = argv[i+1];
+        } else {
+            jobs[j].output_name = (char *)malloc(strlen(argv[i+j])+5);
+            strcpy(jobs[j].output_name, argv[i+j]);
+            strcat(jobs[j].output_name, ".apl");
+        }
+    }
+
+    compress_files(jobs, num_jobs, num_threads);
+
+    /* report in the order the files were given */
+    failed = 0;
+    for (j = 0; j < num_jobs; j++) {
+        if (jobs[j].ok) {
+            if (multiple_mode) {
+                printf("%s: ", jobs[j].input_name);
+            }
+            printf("%s", jobs[j].message);
+        } else {
+            fprintf(stderr, "%s", jobs[j].message);
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,28 @@
+/*
+ * z88dk-aplib - optimal aPLib compressor
+ *
+ * The output is the raw aPLib bit stream read by the z80 decompressor
+ * in libsrc/_DEVELOPMENT/compress/aplib, without the aPLib header.
+ */
+
+#define MAX_OFFSET  65535  /* range 1..65535, offsets are 16 bits in the decompressor */
+#define MAX_ARRIVALS    8  /* ways of reaching a position kept by the parser */
+
+/* The tokens of the aPLib format */
+#define TOKEN_LITERAL   0  /* 0, byte */
+#define TOKEN_MATCH     1  /* 10, gamma(offset/256 + 2 or 3), byte, gamma(len) */
+#define TOKEN_REP       2  /* 10, gamma(2), gamma(len) */
+#define TOKEN_SHORT     3  /* 110, byte (7 bit offset, len 2 or 3) */
+#define TOKEN_SINGLE    4  /* 111, 4 bit offset (0 writes a zero byte) */
+
+typedef struct token_t {
+    int type;
+    int offset;
+    int len;
+} Token;
+
+Token *optimize(unsigned char *input_data, size_t input_size, size_t *num_tokens);
+
+unsigned char *compress(Token *tokens, size_t num_tokens, unsigned char *input_data, size_t input_size, size_t *output_size);
+
+int depack(unsigned char *input_data, size_t input_size, unsigned char *output_data, size_t output_capacity, size_t *output_size);
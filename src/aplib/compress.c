@@ -0,0 +1,129 @@
+/*
+ * z88dk-aplib - optimal aPLib compressor
+ *
+ * The bits of the tokens are packed into bytes that are placed in the
+ * output at the point the decompressor reads them, between the bytes
+ * of the tokens.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "aplib.h"
+
+/* The output being written, one for each file compressed at the same time */
+typedef struct {
+    unsigned char *output_data;
+    size_t output_index;
+    size_t bit_index;
+    int bit_mask;
+} Output;
+
+static void write_byte(Output *out, int value) {
+    out->output_data[out->output_index++] = value;
+}
+
+static void write_bit(Output *out, int value) {
+    if (out->bit_mask == 0) {
+        out->bit_mask = 128;
+        out->bit_index = out->output_index;
+        write_byte(out, 0);
+    }
+    if (value > 0) {
+        out->output_data[out->bit_index] |= out->bit_mask;
+    }
+    out->bit_mask >>= 1;
+}
+
+static void write_bits(Output *out, int value, int bits) {
+    while (bits-- > 0) {
+        write_bit(out, value & (1 << bits));
+    }
+}
+
+/* The bits below the leading one, each followed by 1 if more follow */
+static void write_gamma(Output *out, int value) {
+    int mask;
+
+    for (mask = 1; mask <= value; mask <<= 1) {
+    }
+    for (mask >>= 2; mask > 0; mask >>= 1) {
+        write_bit(out, value & mask);
+        write_bit(out, mask > 1);
+    }
+}
+
+unsigned char *compress(Token *tokens, size_t num_tokens, unsigned char *input_data, size_t input_size, size_t *output_size) {
+    Output out;
+    size_t input_index;
+    size_t i;
+    int lwm;
+    int adjust;
+
+    /* a literal is the longest coding of a byte, 9 bits */
+    out.output_data = (unsigned char *)malloc(input_size+input_size/8+4);
+    if (!out.output_data) {
+         fprintf(stderr, "Error: Insufficient memory\n");
+         exit(1);
+    }
+
+    out.output_index = 0;
+    out.bit_mask = 0;
+
+    /* first byte is always literal */
+    write_byte(&out, input_data[0]);
+    input_index = 1;
+    lwm = 0;
+
+    for (i = 0; i < num_tokens; i++) {
+        switch (tokens[i].type) {
+        case TOKEN_LITERAL:
+            write_bit(&out, 0);
+            write_byte(&out, input_data[input_index]);
+            lwm = 0;
+            break;
+
+        case TOKEN_SINGLE:
+            write_bits(&out, 7, 3);
+            write_bits(&out, tokens[i].offset, 4);
+            lwm = 0;
+            break;
+
+        case TOKEN_SHORT:
+            write_bits(&out, 6, 3);
+            write_byte(&out, tokens[i].offset << 1 | (tokens[i].len-2));
+            lwm = 1;
+            break;
+
+        case TOKEN_REP:
+            write_bits(&out, 2, 2);
+            write_gamma(&out, 2);
+            write_gamma(&out, tokens[i].len);
+            lwm = 1;
+            break;
+
+        case TOKEN_MATCH:
+            if (tokens[i].offset < 128) {
+                adjust = 2;
+            } else if (tokens[i].offset < 1280) {
+                adjust = 0;
+            } else {
+                adjust = tokens[i].offset < 32000 ? 1 : 2;
+            }
+            write_bits(&out, 2, 2);
+            write_gamma(&out, (tokens[i].offset >> 8) + (lwm ? 2 : 3));
+            write_byte(&out, tokens[i].offset & 255);
+            write_gamma(&out, tokens[i].len-adjust);
+            lwm = 1;
+            break;
+        }
+        input_index += tokens[i].len;
+    }
+
+    /* end marker, a short match at offset 0 */
+    write_bits(&out, 6, 3);
+    write_byte(&out, 0);
+
+    *output_size = out.output_index;
+    return out.output_data;
+}
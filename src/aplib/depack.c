@@ -0,0 +1,150 @@
+/*
+ * z88dk-aplib - optimal aPLib compressor
+ *
+ * Reference decompressor following asm_aplib_depack, used to check
+ * each file after it is compressed.
+ */
+
+#include <stdio.h>
+
+#include "aplib.h"
+
+/* The input being read, every read is checked against its end */
+typedef struct {
+    unsigned char *input_data;
+    size_t input_size;
+    size_t input_index;
+    int bit_mask;
+    int bit_value;
+    int error;
+} Input;
+
+static int read_byte(Input *in) {
+    if (in->input_index >= in->input_size) {
+        in->error = 1;
+        return 0;
+    }
+    return in->input_data[in->input_index++];
+}
+
+static int read_bit(Input *in) {
+    in->bit_mask >>= 1;
+    if (in->bit_mask == 0) {
+        in->bit_mask = 128;
+        in->bit_value = read_byte(in);
+    }
+    return (in->bit_value & in->bit_mask) ? 1 : 0;
+}
+
+static int read_gamma(Input *in) {
+    int value;
+
+    value = 1;
+    do {
+        value = value << 1 | read_bit(in);
+        if (value > 0xffff) {
+            in->error = 1;
+            return 0;
+        }
+    } while (read_bit(in) && !in->error);
+    return value;
+}
+
+/* Returns 0 if the input is a complete stream that decompresses into
+   at most output_capacity bytes */
+int depack(unsigned char *input_data, size_t input_size, unsigned char *output_data, size_t output_capacity, size_t *output_size) {
+    Input in;
+    size_t output_index;
+    int rep_offset;
+    int lwm;
+    int offset;
+    int len;
+    int value;
+
+    in.input_data = input_data;
+    in.input_size = input_size;
+    in.input_index = 0;
+    in.bit_mask = 1;
+    in.bit_value = 0;
+    in.error = 0;
+
+    output_index = 0;
+    rep_offset = 0;
+    lwm = 0;
+
+    /* first byte is always literal */
+    if (output_capacity == 0) {
+        return 1;
+    }
+    output_data[output_index++] = read_byte(&in);
+
+    while (!in.error) {
+        offset = 0;
+        len = 1;
+        if (!read_bit(&in)) {
+            /* literal */
+            value = read_byte(&in);
+            if (output_index >= output_capacity) {
+                return 1;
+            }
+            output_data[output_index++] = value;
+            lwm = 0;
+            continue;
+        }
+        if (!read_bit(&in)) {
+            value = read_gamma(&in);
+            if (!lwm && value == 2) {
+                /* repeated offset */
+                offset = rep_offset;
+                len = read_gamma(&in);
+            } else {
+                offset = (value - (lwm ? 2 : 3)) << 8 | read_byte(&in);
+                rep_offset = offset;
+                len = read_gamma(&in);
+                if (offset >= 32000) {
+                    len++;
+                }
+                if (offset >= 1280) {
+                    len++;
+                }
+                if (offset < 128) {
+                    len += 2;
+                }
+            }
+            lwm = 1;
+        } else if (!read_bit(&in)) {
+            /* short match or end of stream */
+            value = read_byte(&in);
+            offset = value >> 1;
+            if (offset == 0) {
+                break;
+            }
+            len = 2 + (value & 1);
+            rep_offset = offset;
+            lwm = 1;
+        } else {
+            /* single byte or zero */
+            offset = read_bit(&in) << 3;
+            offset |= read_bit(&in) << 2;
+            offset |= read_bit(&in) << 1;
+            offset |= read_bit(&in);
+            lwm = 0;
+            if (offset == 0) {
+                if (output_index >= output_capacity) {
+                    return 1;
+                }
+                output_data[output_index++] = 0;
+                continue;
+            }
+        }
+        if (offset == 0 || (size_t)offset > output_index || (size_t)len > output_capacity - output_index) {
+            return 1;
+        }
+        for (; len > 0; len--, output_index++) {
+            output_data[output_index] = output_data[output_index-offset];
+        }
+    }
+
+    *output_size = output_index;
+    return in.error;
+}
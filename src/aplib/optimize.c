@@ -0,0 +1,311 @@
+/*
+ * z88dk-aplib - optimal aPLib compressor
+ *
+ * The cost of an aPLib token depends on the offset of the last match
+ * (a repeated offset is coded in a few bits) and on whether the last
+ * token was a match (a repeated offset cannot follow a match).  The
+ * parser keeps, for each position, the cheapest ways of reaching it
+ * with different repeated offsets and carries all of them forward.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aplib.h"
+
+#define ALL_LENGTHS  64  /* longer matches are only tried at the end of each gamma band */
+
+/* A way of reaching a position: the bits spent, the state of the
+   decompressor and the token that got there */
+typedef struct arrival_t {
+    size_t bits;
+    int rep_offset;
+    int lwm;
+    int from;
+    int type;
+    int offset;
+    int len;
+} Arrival;
+
+static int gamma_bits(int value) {
+    int bits;
+
+    bits = 0;
+    while (value > 1) {
+        bits += 2;
+        value >>= 1;
+    }
+    return bits;
+}
+
+/* The match lengths are coded shorter for far offsets and for offsets
+   below 128 */
+static int length_adjust(int offset) {
+    if (offset < 128) {
+        return 2;
+    }
+    if (offset < 1280) {
+        return 0;
+    }
+    return offset < 32000 ? 1 : 2;
+}
+
+/* Keep the arrivals of a position sorted by bits, at most one for each
+   decompressor state, and only the MAX_ARRIVALS cheapest */
+static void add_arrival(Arrival *slots, unsigned char *count, Arrival *arrival) {
+    int n;
+    int i;
+
+    n = *count;
+    if (n == MAX_ARRIVALS && slots[n-1].bits <= arrival->bits) {
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        if (slots[i].rep_offset == arrival->rep_offset && slots[i].lwm == arrival->lwm) {
+            if (slots[i].bits <= arrival->bits) {
+                return;
+            }
+            memmove(&slots[i], &slots[i+1], (n-i-1)*sizeof(Arrival));
+            n--;
+            break;
+        }
+    }
+    if (n == MAX_ARRIVALS) {
+        n--;
+    }
+    for (i = n; i > 0 && slots[i-1].bits > arrival->bits; i--) {
+        slots[i] = slots[i-1];
+    }
+    slots[i] = *arrival;
+    *count = n+1;
+}
+
+/* The length of the match at offset, counted on from the match found at
+   the previous byte when there was one */
+static size_t match_len(unsigned char *input_data, size_t input_size, size_t i, int offset, size_t *last, size_t *last_len) {
+    size_t len;
+
+    if (last[offset] == i-1 && last_len[offset] > 0) {
+        len = last_len[offset]-1;
+    } else {
+        for (len = 0; i+len < input_size && input_data[i+len] == input_data[i+len-offset]; len++) {
+        }
+    }
+    last[offset] = i;
+    last_len[offset] = len;
+    return len;
+}
+
+/* Try the tokens of lengths first_len to last_len, each costing bits plus
+   the gamma code of the length less adjust. The lengths with the same
+   gamma code cost the same, so past ALL_LENGTHS only the longest of
+   each is tried */
+static void try_lengths(Arrival *arrivals, unsigned char *num_arrivals, size_t i, Arrival *arrival, size_t bits, int adjust, size_t first_len, size_t last_len) {
+    size_t len;
+    size_t band_end;
+
+    for (len = first_len; len <= last_len; len++) {
+        if (len > ALL_LENGTHS && len < last_len) {
+            for (band_end = 1; band_end <= len-adjust; band_end = 2*band_end+1) {
+            }
+            len = band_end+adjust;
+            if (len > last_len) {
+                len = last_len;
+            }
+        }
+        arrival->bits = bits + gamma_bits(len-adjust);
+        arrival->len = len;
+        add_arrival(&arrivals[(i+len)*MAX_ARRIVALS], &num_arrivals[i+len], arrival);
+    }
+}
+
+Token *optimize(unsigned char *input_data, size_t input_size, size_t *num_tokens) {
+    size_t *last;
+    size_t *last_len;
+    size_t *matches;
+    size_t *match_slots;
+    int *match_offsets;
+    size_t *match_lens;
+    Arrival *arrivals;
+    unsigned char *num_arrivals;
+    Token *tokens;
+    Arrival *from;
+    Arrival next;
+    size_t *match;
+    int num_matches;
+    int match_index;
+    int single_offset;
+    int offset;
+    int adjust;
+    size_t len;
+    size_t prev_len;
+    size_t best_len;
+    size_t bits;
+    size_t first_len;
+    size_t i;
+    size_t n;
+    int j;
+    int k;
+
+    /* allocate all data structures at once */
+    last = (size_t *)calloc(MAX_OFFSET+1, sizeof(size_t));
+    last_len = (size_t *)calloc(MAX_OFFSET+1, sizeof(size_t));
+    matches = (size_t *)calloc(256*256, sizeof(size_t));
+    match_slots = (size_t *)calloc(input_size, sizeof(size_t));
+    match_offsets = (int *)malloc(input_size*sizeof(int));
+    match_lens = (size_t *)malloc(input_size*sizeof(size_t));
+    arrivals = (Arrival *)malloc((input_size+1)*MAX_ARRIVALS*sizeof(Arrival));
+    num_arrivals = (unsigned char *)calloc(input_size+1, sizeof(unsigned char));
+    tokens = (Token *)malloc(input_size*sizeof(Token));
+
+    if (!last || !last_len || !matches || !match_slots || !match_offsets || !match_lens || !arrivals || !num_arrivals || !tokens) {
+         fprintf(stderr, "Error: Insufficient memory\n");
+         exit(1);
+    }
+
+    /* first byte is always literal, copied before the bit stream */
+    arrivals[MAX_ARRIVALS].bits = 8;
+    arrivals[MAX_ARRIVALS].rep_offset = 0;
+    arrivals[MAX_ARRIVALS].lwm = 0;
+    arrivals[MAX_ARRIVALS].from = 0;
+    arrivals[MAX_ARRIVALS].type = TOKEN_LITERAL;
+    arrivals[MAX_ARRIVALS].offset = 0;
+    arrivals[MAX_ARRIVALS].len = 1;
+    num_arrivals[1] = 1;
+
+    /* the chains of positions sharing their first two bytes hold the
+       position plus one, zero ends a chain */
+    if (input_size > 1) {
+        matches[input_data[0] << 8 | input_data[1]] = 1;
+    }
+
+    for (i = 1; i < input_size; i++) {
+
+        /* the offsets that share the next two bytes, nearest first: each
+           one gives the lengths longer than those of the nearer ones */
+        num_matches = 0;
+        best_len = 1;
+        if (i+1 < input_size) {
+            match_index = input_data[i] << 8 | input_data[i+1];
+            for (match = &matches[match_index]; *match != 0 && best_len < input_size-i; match = &match_slots[*match-1]) {
+                offset = i - (*match-1);
+                if (offset > MAX_OFFSET) {
+                    *match = 0;
+                    break;
+                }
+                if (input_data[i+best_len] != input_data[i+best_len-offset]) {
+                    continue;
+                }
+                len = match_len(input_data, input_size, i, offset, last, last_len);
+                if (len > best_len) {
+                    match_offsets[num_matches] = offset;
+                    match_lens[num_matches] = len;
+                    num_matches++;
+                    best_len = len;
+                }
+            }
+            match_slots[i] = matches[match_index];
+            matches[match_index] = i+1;
+        }
+
+        /* a single byte from up to 15 bytes back, or a zero byte */
+        single_offset = -1;
+        if (input_data[i] == 0) {
+            single_offset = 0;
+        } else {
+            for (offset = 1; offset <= 15 && offset <= i; offset++) {
+                if (input_data[i] == input_data[i-offset]) {
+                    single_offset = offset;
+                    break;
+                }
+            }
+        }
+
+        for (k = 0; k < num_arrivals[i]; k++) {
+            from = &arrivals[i*MAX_ARRIVALS+k];
+            next.from = k;
+
+            /* literal */
+            next.bits = from->bits + 9;
+            next.rep_offset = from->rep_offset;
+            next.lwm = 0;
+            next.type = TOKEN_LITERAL;
+            next.offset = 0;
+            next.len = 1;
+            add_arrival(&arrivals[(i+1)*MAX_ARRIVALS], &num_arrivals[i+1], &next);
+
+            /* single byte */
+            if (single_offset >= 0) {
+                next.bits = from->bits + 7;
+                next.type = TOKEN_SINGLE;
+                next.offset = single_offset;
+                add_arrival(&arrivals[(i+1)*MAX_ARRIVALS], &num_arrivals[i+1], &next);
+            }
+
+            next.lwm = 1;
+
+            /* repeated offset, only after a literal */
+            if (!from->lwm && from->rep_offset > 0 && from->rep_offset <= i) {
+                len = match_len(input_data, input_size, i, from->rep_offset, last, last_len);
+                if (len >= 2) {
+                    next.type = TOKEN_REP;
+                    next.offset = from->rep_offset;
+                    try_lengths(arrivals, num_arrivals, i, &next, from->bits + 2 + gamma_bits(2), 0, 2, len);
+                }
+            }
+
+            /* matches, each offset only for the lengths the nearer ones
+               cannot reach */
+            prev_len = 1;
+            for (j = 0; j < num_matches; j++) {
+                offset = match_offsets[j];
+                len = match_lens[j];
+                next.rep_offset = offset;
+                next.offset = offset;
+
+                /* the short token has no length code, the adjust of 2
+                   leaves a gamma code of no bits */
+                if (offset < 128 && prev_len < 3) {
+                    next.type = TOKEN_SHORT;
+                    try_lengths(arrivals, num_arrivals, i, &next, from->bits + 11, 2, prev_len+1, len < 3 ? len : 3);
+                }
+
+                adjust = length_adjust(offset);
+                first_len = prev_len+1 > adjust+2 ? prev_len+1 : adjust+2;
+                if (first_len <= len) {
+                    bits = from->bits + 10 + gamma_bits((offset >> 8) + (from->lwm ? 2 : 3));
+                    next.type = TOKEN_MATCH;
+                    try_lengths(arrivals, num_arrivals, i, &next, bits, adjust, first_len, len);
+                }
+                prev_len = len;
+            }
+        }
+    }
+
+    /* follow the cheapest way back from the end */
+    n = input_size-1;
+    k = 0;
+    for (i = input_size; i > 1; i -= arrivals[i*MAX_ARRIVALS+j].len) {
+        j = k;
+        from = &arrivals[i*MAX_ARRIVALS+j];
+        n--;
+        tokens[n].type = from->type;
+        tokens[n].offset = from->offset;
+        tokens[n].len = from->len;
+        k = from->from;
+    }
+    *num_tokens = input_size-1-n;
+    memmove(tokens, &tokens[n], *num_tokens*sizeof(Token));
+
+    free(last);
+    free(last_len);
+    free(matches);
+    free(match_slots);
+    free(match_offsets);
+    free(match_lens);
+    free(arrivals);
+    free(num_arrivals);
+
+    return tokens;
+}
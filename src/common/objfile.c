@@ -24,6 +24,7 @@ bool opt_obj_list = false;
 bool opt_obj_hide_local = false;
 bool opt_obj_hide_expr = false;
 bool opt_obj_hide_code = false;
+bool opt_obj_hide_libdir = false;
 
 //-----------------------------------------------------------------------------
 // read from file
@@ -202,6 +203,7 @@ expr_t* expr_new()
 	expr_t* self = xnew(expr_t);
 
 	self->text = utstr_new();
+	self->code = utstr_new();
 	self->type = '\0';
 	self->asmpc = self->patch_ptr = 0;
 	self->section = NULL;
@@ -218,6 +220,7 @@ expr_t* expr_new()
 void expr_free(expr_t* self)
 {
 	utstr_free(self->text);
+	utstr_free(self->code);
 	utstr_free(self->target_name);
 	utstr_free(self->filename);
 	xfree(self);
@@ -278,6 +281,7 @@ objfile_t* objfile_new()
 
 	self->version = self->global_org = -1;
 	self->externs = argv_new();
+	self->expr_names = argv_new();
 
 	section_t* section = section_new();			// section "" must exist
 	self->sections = NULL;
@@ -294,6 +298,7 @@ void objfile_free(objfile_t* self)
 	utstr_free(self->signature);
 	utstr_free(self->modname);
 	argv_free(self->externs);
+	argv_free(self->expr_names);
 
 	section_t* section, * tmp;
 	DL_FOREACH_SAFE(self->sections, section, tmp) {
@@ -476,6 +481,18 @@ static void objfile_read_exprs(objfile_t* obj, FILE* fp, long fpos_start, long f
 		printf("  Expressions:\n");
 
 	xfseek(fp, fpos_start, SEEK_SET);
+
+	// table of names used in bytecode
+	if (obj->version >= 15) {
+		UT_string* name = utstr_new();
+		int num_names = xfread_word(fp);
+		for (int i = 0; i < num_names; i++) {
+			xfread_bcount_str(name, fp);
+			argv_push(obj->expr_names, utstr_body(name));
+		}
+		utstr_free(name);
+	}
+
 	while (ftell(fp) < fpos_end) {
 		char type = xfread_byte(fp);
 		if (type == 0)
@@ -540,6 +557,9 @@ static void objfile_read_exprs(objfile_t* obj, FILE* fp, long fpos_start, long f
 					utstr_body(obj->filename));
 		}
 
+		if (obj->version >= 15)
+			xfread_wcount_str(expr->code, fp);
+
 		if (show_expr)
 			printf("%s", utstr_body(expr->text));
 
@@ -618,13 +638,23 @@ static long objfile_write_exprs1(objfile_t* obj, FILE* fp, UT_string* last_filen
 	bool has_exprs = false;
 
 	section_t* section;
+	DL_FOREACH(obj->sections, section) {
+		if (section->exprs != NULL)
+			has_exprs = true;
+	}
+	if (!has_exprs)
+		return -1;
+
+	// table of names used in bytecode
+	xfwrite_word(argv_len(obj->expr_names), fp);
+	for (char** pname = argv_front(obj->expr_names); *pname; pname++)
+		xfwrite_bcount_cstr(*pname, fp);
+
 	DL_FOREACH(obj->sections, section) {
 		utstr_clear(last_filename);
 
 		expr_t* expr;
 		DL_FOREACH(section->exprs, expr) {
-			has_exprs = true;
-
 			// store type
 			xfwrite_byte(expr->type, fp);
 
@@ -644,15 +674,12 @@ static long objfile_write_exprs1(objfile_t* obj, FILE* fp, UT_string* last_filen
 			xfwrite_word(expr->patch_ptr, fp);				// patchptr
 			xfwrite_bcount_str(expr->target_name, fp);		// target symbol for expression
 			xfwrite_wcount_str(expr->text, fp);				// expression
+			xfwrite_wcount_str(expr->code, fp);				// bytecode
 		}
 	}
 
-	if (has_exprs) {
-		xfwrite_byte(0, fp);			// store end-terminator
-		return fpos0;
-	}
-	else
-		return -1;
+	xfwrite_byte(0, fp);				// store end-terminator
+	return fpos0;
 }
 
 static long objfile_write_exprs(objfile_t* obj, FILE* fp)
@@ -826,6 +853,42 @@ static void file_read_object(file_t* file, FILE* fp, UT_string* signature, int v
 	DL_APPEND(file->objs, obj);
 }
 
+// list the module directory if the deleted module at the current position
+// points to it; return false if it is just a deleted module
+static bool file_read_libdir(FILE* fp, long fpos0)
+{
+	char dir_signature[SIGNATURE_SIZE + 1];
+	char expected[SIGNATURE_SIZE + 1];
+
+	snprintf(expected, sizeof(expected), SIGNATURE_LIBDIR SIGNATURE_VERS, LIBDIR_VERSION);
+	if (fread(dir_signature, 1, SIGNATURE_SIZE, fp) != SIGNATURE_SIZE ||
+		strncmp(dir_signature, expected, SIGNATURE_SIZE) != 0)
+		return false;
+
+	int dir_ptr = xfread_dword(fp);
+	xfseek(fp, fpos0 + dir_ptr, SEEK_SET);
+	int count = xfread_dword(fp);
+
+	if (opt_obj_list)
+		printf("  Module directory at $%04X: %d modules\n", dir_ptr, count);
+
+	if (opt_obj_list && !opt_obj_hide_libdir) {
+		UT_string* name = utstr_new();
+		for (int i = 0; i < count; i++) {
+			int ptr = xfread_dword(fp);
+			int size = xfread_dword(fp);
+			uint32_t hash_lo = xfread_dword(fp);
+			uint32_t hash_hi = xfread_dword(fp);
+			xfread_wcount_str(name, fp);
+
+			printf("    $%04X: %s, %d bytes, hash %08X%08X\n",
+				ptr, utstr_body(name), size, hash_hi, hash_lo);
+		}
+		utstr_free(name);
+	}
+	return true;
+}
+
 static void file_read_library(file_t* file, FILE* fp, UT_string* signature, int version)
 {
 	utstr_set_str(file->signature, signature);
@@ -849,7 +912,7 @@ static void file_read_library(file_t* file, FILE* fp, UT_string* signature, int
 			die("File %s: contains non-object file\n", utstr_body(file->filename));
 
 		if (length == 0) {
-			if (opt_obj_list)
+			if (!file_read_libdir(fp, fpos0) && opt_obj_list)
 				printf("  Deleted...\n");
 		}
 		else {
@@ -1072,6 +1135,12 @@ static void obj_rename_symbol(objfile_t* obj, const char* old_name, const char*
 {
 	UT_string* new_text = utstr_new();
 
+	// bytecode refers to symbols by index in the table of names
+	for (size_t i = 0; i < argv_len(obj->expr_names); i++) {
+		if (strcmp(argv_get(obj->expr_names, i), old_name) == 0)
+			argv_set(obj->expr_names, i, new_name);
+	}
+
 	section_t* section;
 	DL_FOREACH(obj->sections, section) {
 		expr_t* expr;
@@ -14,7 +14,7 @@
 #include <stdio.h>
 
 #define MIN_VERSION				1
-#define MAX_VERSION				14
+#define MAX_VERSION				15
 #define CUR_VERSION				MAX_VERSION
 #define SIGNATURE_SIZE			8
 #define SIGNATURE_OBJ			"Z80RMF"
@@ -22,12 +22,17 @@
 #define SIGNATURE_VERS			"%02d"
 #define DEFAULT_ALIGN_FILLER	0xFF
 
+// module directory kept by libraries that z80asm updates in place (-d -x)
+#define SIGNATURE_LIBDIR		"Z80LDR"
+#define LIBDIR_VERSION			1
+
 extern byte_t opt_obj_align_filler;
 extern bool opt_obj_verbose;
 extern bool opt_obj_list;
 extern bool opt_obj_hide_local;
 extern bool opt_obj_hide_expr;
 extern bool opt_obj_hide_code;
+extern bool opt_obj_hide_libdir;
 
 struct section_s;
 
@@ -66,6 +71,7 @@ extern void symbol_free(symbol_t* self);
 typedef struct expr_s
 {
 	UT_string* text;
+	UT_string* code;				// bytecode, empty if not compiled
 	char	 type;
 	int		 asmpc;
 	int		 patch_ptr;
@@ -114,6 +120,7 @@ typedef struct objfile_s
 	int			 version;
 	int			 global_org;
 	argv_t* externs;
+	argv_t* expr_names;					// names used in expressions bytecode
 	section_t* sections;
 
 	struct objfile_s* next, * prev;
@@ -0,0 +1,4 @@
+#define PREFIX "/usr/local/share/z88dk"
+#define UNIX 1
+#define EXEC_PREFIX ""
+#define Z88DK_VERSION "build-20261018"
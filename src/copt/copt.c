@@ -1,11 +1,13 @@
 /* copt version 1.00 (C) Copyright Christopher W. Fraser 1984 */
 /* Added out of memory checking and ANSI prototyping. DG 1999 */
 /* Added %L - %N variables, %activate, regexp, %check. Zrin Z. 2002 */
+/* Added the library interface in copt.h. */
 
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "copt.h"
 
 #define USE_REGEXP
 
@@ -22,20 +24,19 @@
 #define strcasecmp stricmp
 #endif
 
-int rpn_eval(const char* expr, char** vars);
+static int rpn_eval(const char* expr, char** vars);
 
 #define HSIZE 107
 #define MAXLINE 256
 #define MAXFIRECOUNT 65535L
 #define MAX_PASS 16
 
-int debug = 0;
-char *c_cpu = "z80";
-int global_again = 0; /* signalize that rule set has changed */
+static int debug = 0;
+static char *c_cpu = "z80";
+static int global_again = 0; /* signalize that rule set has changed */
 #define FIRSTLAB 'L'
 #define LASTLAB 'N'
-int nextlab = 1; /* unique label counter */
-int labnum[LASTLAB - FIRSTLAB + 1]; /* unique label numbers */
+static int labnum[LASTLAB - FIRSTLAB + 1]; /* unique label numbers */
 
 struct lnode {
     char* l_text;
@@ -46,16 +47,51 @@ struct onode {
     struct lnode *o_old, *o_new;
     struct onode* o_next;
     long firecount;
-}* opts = 0, *activerule = 0;
+    char* o_prefix; /* literal text the first input line must start with */
+    int o_plen;
+    char* o_key; /* opcode of the first input line, 0 if not known */
+    int o_seq; /* position in opts, for the rule index */
+};
+static struct onode* activerule = 0;
+
+/* index of rules by the opcode (leading blanks and first word) of the
+   input line they are tried against; rules without a known opcode are
+   tried on every line */
+struct inode {
+    char* i_key;
+    struct onode** i_rules; /* in opts order */
+    int i_count, i_size;
+    struct inode* i_next;
+};
+
+/* a rule set with the state it keeps between the lines it is applied to,
+   what a z88dk-copt process holds */
+struct copt_rules {
+    struct onode* opts;
+    struct inode* itab[HSIZE];
+    struct inode anyop;
+    int index_valid;
+    int nextlab; /* unique label counter */
+};
+static struct copt_rules* rules; /* the rule set in use */
 
-void printlines(struct lnode* beg, struct lnode* end, FILE* out)
+/* lines read and not optimised yet */
+struct copt_code {
+    struct lnode head, tail;
+    char lin[MAXLINE];
+    int len;
+};
+
+static void prepare(struct onode* o);
+
+static void printlines(struct lnode* beg, struct lnode* end, FILE* out)
 {
     struct lnode* p;
     for (p = beg; p != end; p = p->l_next)
         fputs(p->l_text, out);
 }
 
-void printrule(struct onode* o, FILE* out)
+static void printrule(struct onode* o, FILE* out)
 {
     struct lnode* p = o->o_old;
     while (p->l_prev)
@@ -66,7 +102,7 @@ void printrule(struct onode* o, FILE* out)
 }
 
 /* error - report error and quit */
-void error(char* s)
+static void error(char* s)
 {
     fputs(s, stderr);
     if (activerule) {
@@ -77,7 +113,7 @@ void error(char* s)
 }
 
 /* connect - connect p1 to p2 */
-void connect(struct lnode* p1, struct lnode* p2)
+static void connect(struct lnode* p1, struct lnode* p2)
 {
     if (p1 == 0 || p2 == 0)
         error("connect: can't happen\n");
@@ -86,7 +122,7 @@ void connect(struct lnode* p1, struct lnode* p2)
 }
 
 /* install - install str in string table */
-char* install(char* str)
+static char* install(char* str)
 {
     register struct hnode* p;
     register char *p1, *p2, *s;
@@ -118,8 +154,57 @@ char* install(char* str)
     return (p->h_str);
 }
 
+#ifdef USE_REGEXP
+/* getregex - return compiled regular expression re, compile it only once */
+static regex_t* getregex(char* re, char* start)
+{
+    static struct rnode {
+        char* r_text;
+        regex_t r_reg;
+        struct rnode* r_ptr;
+    } * rtab[HSIZE] = { 0 };
+    struct rnode* p;
+    char *key, msg[MAXLINE];
+    int i, reerr;
+
+    key = install(re); /* installed strings can be compared by pointer */
+    i = (int)(((size_t)key >> 3) % HSIZE);
+    for (p = rtab[i]; p; p = p->r_ptr)
+        if (p->r_text == key)
+            return &p->r_reg;
+
+    p = (struct rnode*)malloc(sizeof *p);
+    if (p == NULL)
+        error("getregex: out of memory\n");
+    reerr = regcomp(&p->r_reg, key, REG_EXTENDED);
+    if (reerr != 0) {
+        regerror(reerr, &p->r_reg, msg, sizeof(msg));
+        fprintf(stderr, "error in \"%s\": %s\n", start, msg);
+        error("error: invalid rule\n");
+    }
+    p->r_text = key;
+    p->r_ptr = rtab[i];
+    rtab[i] = p;
+    return &p->r_reg;
+}
+#endif
+
+/* opkey - copy leading blanks and first word of s to key; return the
+   length of s they take, including the character that ends the word */
+static int opkey(char* s, char* key)
+{
+    char* p = s;
+
+    while (*p == ' ' || *p == '\t')
+        *key++ = *p++;
+    while (*p && *p != ' ' && *p != '\t' && *p != '\n')
+        *key++ = *p++;
+    *key = '\0';
+    return (int)(p - s) + 1;
+}
+
 /* insert - insert a new node with text s before node p */
-void insert(char* s, struct lnode* p)
+static void insert(char* s, struct lnode* p)
 {
     struct lnode* n;
 
@@ -132,7 +217,7 @@ void insert(char* s, struct lnode* p)
 }
 
 /* getlst - link lines from fp in between p1 and p2 */
-void getlst(FILE* fp, char* quit, struct lnode* p1, struct lnode* p2)
+static void getlst(FILE* fp, char* quit, struct lnode* p1, struct lnode* p2)
 {
     char *install(), lin[MAXLINE];
 
@@ -144,7 +229,7 @@ void getlst(FILE* fp, char* quit, struct lnode* p1, struct lnode* p2)
 
 /* getlst_1 - link lines from fp in between p1 and p2 */
 /* skip blank lines and comments at the start */
-void getlst_1(FILE* fp, char* quit, struct lnode* p1, struct lnode* p2)
+static void getlst_1(FILE* fp, char* quit, struct lnode* p1, struct lnode* p2)
 {
     char *install(), lin[MAXLINE];
     int firstline = 1;
@@ -166,12 +251,12 @@ void getlst_1(FILE* fp, char* quit, struct lnode* p1, struct lnode* p2)
 }
 
 /* init - read patterns file */
-void init(FILE* fp)
+static void init(FILE* fp)
 {
     struct lnode head, tail;
     struct onode *p, **next;
 
-    next = &opts;
+    next = &rules->opts;
     while (*next)
         next = &((*next)->o_next);
     while (!feof(fp)) {
@@ -194,16 +279,126 @@ void init(FILE* fp)
         if (head.l_next)
             head.l_next->l_prev = 0;
         p->o_new = head.l_next;
+        prepare(p);
 
         *next = p;
         next = &p->o_next;
     }
     *next = 0;
+    rules->index_valid = 0;
+}
+
+/* prepare - compute the literal prefix and opcode of the first input line
+   a rule is tried against, pre-compile the regular expressions of the pattern */
+static void prepare(struct onode* o)
+{
+    struct lnode* p;
+    char lin[MAXLINE], key[MAXLINE], *s, *d;
+
+    o->o_prefix = install("");
+    o->o_plen = 0;
+    o->o_key = 0;
+
+    /* %cpu and %notcpu are checked without consuming input, other
+       conditions need variables set by the previous lines */
+    for (p = o->o_old; p; p = p->l_prev)
+        if (strncmp(p->l_text, "%notcpu", 7) != 0 && strncmp(p->l_text, "%cpu", 4) != 0)
+            break;
+    if (p && strncmp(p->l_text, "%check", 6) != 0 && strncmp(p->l_text, "%eval", 5) != 0) {
+        /* characters matched literally, see match() */
+        for (s = p->l_text, d = lin; *s && d < lin + MAXLINE - 1;) {
+            if (s[0] == '%' && (isdigit(s[1]) || s[1] == '"'))
+                break;
+            else if (s[0] == '%' && s[1] == '%') {
+                *d++ = '%';
+                s += 2;
+            } else
+                *d++ = *s++;
+        }
+        *d = '\0';
+        o->o_prefix = install(lin);
+        o->o_plen = (int)strlen(lin);
+        if (opkey(lin, key) <= o->o_plen)
+            o->o_key = install(key);
+    }
+
+#ifdef USE_REGEXP
+    for (p = o->o_old; p; p = p->l_prev) {
+        for (s = p->l_text; (s = strstr(s, "%\"")) != NULL;) {
+            for (d = s + 2; *d && (*d != '"' || d[-1] == '\\'); ++d)
+                ;
+            if (*d != '"')
+                break;
+            strncpy(lin, s + 2, d - s - 2);
+            lin[d - s - 2] = '\0';
+            getregex(lin, p->l_text);
+            s = d + 1;
+        }
+    }
+#endif
+}
+
+/* addindex - append rule o to index entry ip */
+static void addindex(struct inode* ip, struct onode* o)
+{
+    if (ip->i_count == ip->i_size) {
+        ip->i_size = ip->i_size ? 2 * ip->i_size : 16;
+        ip->i_rules = (struct onode**)realloc(ip->i_rules, ip->i_size * sizeof(struct onode*));
+        if (ip->i_rules == NULL)
+            error("addindex: out of memory\n");
+    }
+    ip->i_rules[ip->i_count++] = o;
+}
+
+/* findindex - return index entry of opcode key, create it if asked */
+static struct inode* findindex(char* key, int create)
+{
+    struct inode* ip;
+    char* s;
+    int i;
+
+    for (i = 0, s = key; *s; i += *s++)
+        ;
+    i = abs(i) % HSIZE;
+    for (ip = rules->itab[i]; ip; ip = ip->i_next)
+        if (strcmp(ip->i_key, key) == 0)
+            return ip;
+    if (!create)
+        return 0;
+
+    ip = (struct inode*)calloc(1, sizeof *ip);
+    if (ip == NULL)
+        error("findindex: out of memory\n");
+    ip->i_key = key;
+    ip->i_next = rules->itab[i];
+    rules->itab[i] = ip;
+    return ip;
+}
+
+/* buildindex - index all rules by opcode */
+static void buildindex()
+{
+    struct inode* ip;
+    struct onode* o;
+    int i, seq = 0;
+
+    for (i = 0; i < HSIZE; i++)
+        for (ip = rules->itab[i]; ip; ip = ip->i_next)
+            ip->i_count = 0;
+    rules->anyop.i_count = 0;
+
+    for (o = rules->opts; o; o = o->o_next) {
+        o->o_seq = seq++;
+        if (o->o_old == 0)
+            continue; /* empty rules never match */
+        addindex(o->o_key ? findindex(o->o_key, 1) : &rules->anyop, o);
+    }
+    rules->index_valid = 1;
 }
 
 /* match - check conditions in rules */
 /* format: %check min <= %n <= max */
-int check(char* pat, char** vars)
+static int check(char* pat, char** vars)
 {
     int low, high, x;
     char v;
@@ -222,7 +417,7 @@ int check(char* pat, char** vars)
     return low <= x && x <= high;
 }
 
-int check_eval(char* pat, char** vars)
+static int check_eval(char* pat, char** vars)
 {
     char expr[1024];
     int expected,  x;
@@ -237,13 +432,13 @@ int check_eval(char* pat, char** vars)
 }
 
 /* match - match ins against pat and set vars */
-int match(char* ins, char* pat, char** vars)
+static int match(char* ins, char* pat, char** vars)
 {
     char *p, lin[MAXLINE], *start = pat;
 #ifdef USE_REGEXP
     char re[MAXLINE]; /* regular expression */
     char* istart = ins;
-    regex_t reg;
+    regex_t* reg;
 #define NMATCH 3
     regmatch_t match[NMATCH];
     char var;
@@ -281,22 +476,16 @@ int match(char* ins, char* pat, char** vars)
                 strncpy(re, pat + 2, p - pat - 2);
                 re[p - pat - 2] = '\0';
                 pat = p;
-                reerr = regcomp(&reg, re, REG_EXTENDED);
-                if (reerr != 0) {
-                    regerror(reerr, &reg, re, sizeof(re));
-                    fprintf(stderr, "error in \"%s\": %s\n", start, re);
-                    error("error: invalid rule\n");
-                }
+                reg = getregex(re, start);
                 eflags = 0;
                 if (ins != istart)
                     eflags |= REG_NOTBOL;
-                reerr = regexec(&reg, ins, NMATCH, match, eflags);
+                reerr = regexec(reg, ins, NMATCH, match, eflags);
                 if (reerr != 0 && reerr != REG_NOMATCH) {
-                    regerror(reerr, &reg, re, sizeof(re));
+                    regerror(reerr, reg, re, sizeof(re));
                     fprintf(stderr, "error in \"%s\": %s\n", start, re);
                     error("error: while matching REGEXP\n");
                 }
-                regfree(&reg);
                 if (reerr != 0 || match[0].rm_so != 0)
                     return 0; /* not matched */
                 mi = match[1].rm_eo == -1 ? 0 : 1; /* which match to use */
@@ -351,7 +540,7 @@ int match(char* ins, char* pat, char** vars)
 }
 
 /* subst_imp - return result of substituting vars into pat */
-char* subst_imp(char* pat, char** vars)
+static char* subst_imp(char* pat, char** vars)
 {
     static char errormsg[80];
     static char lin[MAXLINE];
@@ -370,7 +559,7 @@ char* subst_imp(char* pat, char** vars)
         } else if (pat[0] == '%' && pat[1] >= FIRSTLAB && pat[1] <= LASTLAB) {
             int il = pat[1] - FIRSTLAB;
             if (!labnum[il])
-                labnum[il] = nextlab++;
+                labnum[il] = rules->nextlab++;
             sprintf(num, "%d", labnum[il]);
             for (s = num; i < MAXLINE && (lin[i] = *s++) != 0; ++i)
                 ;
@@ -405,13 +594,13 @@ char* subst_imp(char* pat, char** vars)
 }
 
 /* subst - return install(result of substituting vars into pat) */
-char* subst(char* pat, char** vars)
+static char* subst(char* pat, char** vars)
 {
     return install(subst_imp(pat, vars));
 }
 
 /* rep - substitute vars into new and replace lines between p1 and p2 */
-struct lnode* rep(
+static struct lnode* rep(
     struct lnode* p1, struct lnode* p2, struct lnode* new, char** vars)
 {
     char *exec(), *subst();
@@ -441,7 +630,7 @@ struct lnode* rep(
 }
 
 /* copylist - copy activated rule; substitute variables */
-struct lnode* copylist(
+static struct lnode* copylist(
     struct lnode* source, struct lnode** pat, struct lnode** sub, char** vars)
 {
     struct lnode head, tail, *more = 0;
@@ -482,135 +671,288 @@ struct lnode* copylist(
     return more;
 }
 
-/* opt - replace instructions ending at r if possible */
-struct lnode* opt(struct lnode* r)
+/* tryrule - try rule o on instructions ending at *pr; return 1 if the rule
+   fired (*pr is where to continue), -1 if it activated new rules after o */
+static int tryrule(struct onode* o, struct lnode** pr)
 {
     char* vars[10];
     int i, lines;
-    struct lnode *c, *p;
-    struct onode* o;
+    struct lnode *c, *p, *r = *pr;
     static char* activated = "%activated ";
 
-    for (o = opts; o; o = o->o_next) {
-        activerule = o;
-        if (o->firecount < 1)
-            continue;
-        c = r;
-        p = o->o_old;
-        if (p == 0)
-            continue; /* skip empty rules */
-        for (i = 0; i < 10; i++)
-            vars[i] = 0;
-        lines = 0;
-        while (p && c) {
-            if (strncmp(p->l_text, "%check", 6) == 0) {
-                if (!check(p->l_text + 6, vars))
-                    break;
-            } else if ( strncmp(p->l_text, "%notcpu", 7) == 0 ) {
-                char  tbuf[1024];
-                snprintf(tbuf,sizeof(tbuf),"%.*s",(int)strlen(p->l_text + 8)-1,p->l_text + 8);
-                if ( strcmp(tbuf, c_cpu) == 0 )
-                    break;
-            } else if ( strncmp(p->l_text, "%cpu", 4) == 0 ) {
-                char  tbuf[1024];
-                snprintf(tbuf,sizeof(tbuf),"%.*s",(int)strlen(p->l_text + 5)-1,p->l_text + 5);
-                if ( strcmp(tbuf, c_cpu) )
-                    break;
-            } else if ( strncmp(p->l_text, "%eval", 5) == 0 ) {
-                if (!check_eval(p->l_text + 5, vars))
-                    break;
-            } else {
-                if (!match(c->l_text, p->l_text, vars))
-                    break;
-                c = c->l_prev;
-                ++lines;
-            }
-            p = p->l_prev;
+    activerule = o;
+    if (o->firecount < 1)
+        return 0;
+    c = r;
+    p = o->o_old;
+    if (p == 0)
+        return 0; /* skip empty rules */
+    if (strncmp(r->l_text, o->o_prefix, o->o_plen) != 0)
+        return 0; /* cannot match */
+    for (i = 0; i < 10; i++)
+        vars[i] = 0;
+    lines = 0;
+    while (p && c) {
+        if (strncmp(p->l_text, "%check", 6) == 0) {
+            if (!check(p->l_text + 6, vars))
+                break;
+        } else if ( strncmp(p->l_text, "%notcpu", 7) == 0 ) {
+            char  tbuf[1024];
+            snprintf(tbuf,sizeof(tbuf),"%.*s",(int)strlen(p->l_text + 8)-1,p->l_text + 8);
+            if ( strcmp(tbuf, c_cpu) == 0 )
+                break;
+        } else if ( strncmp(p->l_text, "%cpu", 4) == 0 ) {
+            char  tbuf[1024];
+            snprintf(tbuf,sizeof(tbuf),"%.*s",(int)strlen(p->l_text + 5)-1,p->l_text + 5);
+            if ( strcmp(tbuf, c_cpu) )
+                break;
+        } else if ( strncmp(p->l_text, "%eval", 5) == 0 ) {
+            if (!check_eval(p->l_text + 5, vars))
+                break;
+        } else {
+            if (!match(c->l_text, p->l_text, vars))
+                break;
+            c = c->l_prev;
+            ++lines;
         }
-        if (p != 0)
-            continue;
+        p = p->l_prev;
+    }
+    if (p != 0)
+        return 0;
 
-        /* decrease firecount */
-        --o->firecount;
+    /* decrease firecount */
+    --o->firecount;
 
-        /* check for %once */
-        if (o->o_new && strcmp(o->o_new->l_text, "%once\n") == 0) {
-            struct lnode* tmp = o->o_new; /* delete the %once line */
-            o->o_new = o->o_new->l_next;
-            o->o_new->l_prev = 0;
-            free(tmp);
-            o->firecount = 0; /* never again */
-        }
+    /* check for %once */
+    if (o->o_new && strcmp(o->o_new->l_text, "%once\n") == 0) {
+        struct lnode* tmp = o->o_new; /* delete the %once line */
+        o->o_new = o->o_new->l_next;
+        o->o_new->l_prev = 0;
+        free(tmp);
+        o->firecount = 0; /* never again */
+    }
 
-        /* check for activation rules */
-        if (o->o_new && strcmp(o->o_new->l_text, "%activate\n") == 0) {
-            /* we have to prevent repeated activation of rules */
-            char signature[300];
-            struct lnode* lnp;
-            struct onode *nn, *last;
-            int skip = 0;
-            /* since we 'install()' strings, we can compare pointers */
-            sprintf(signature, "%s%p%p%p%p%p%p%p%p%p%p\n",
-                activated,
-                (void *) vars[0],(void *) vars[1],(void *) vars[2],(void *) vars[3],(void *) vars[4],
-                (void *) vars[5],(void *) vars[6],(void *) vars[7],(void *) vars[8],(void *) vars[9]);
-            lnp = o->o_new->l_next;
-            while (lnp && strncmp(lnp->l_text, activated, strlen(activated)) == 0) {
-                if (strcmp(lnp->l_text, signature) == 0) {
-                    skip = 1;
-                    break;
-                }
-                lnp = lnp->l_next;
+    /* check for activation rules */
+    if (o->o_new && strcmp(o->o_new->l_text, "%activate\n") == 0) {
+        /* we have to prevent repeated activation of rules */
+        char signature[300];
+        struct lnode* lnp;
+        struct onode *nn, *last;
+        int skip = 0;
+        /* since we 'install()' strings, we can compare pointers */
+        sprintf(signature, "%s%p%p%p%p%p%p%p%p%p%p\n",
+            activated,
+            (void *) vars[0],(void *) vars[1],(void *) vars[2],(void *) vars[3],(void *) vars[4],
+            (void *) vars[5],(void *) vars[6],(void *) vars[7],(void *) vars[8],(void *) vars[9]);
+        lnp = o->o_new->l_next;
+        while (lnp && strncmp(lnp->l_text, activated, strlen(activated)) == 0) {
+            if (strcmp(lnp->l_text, signature) == 0) {
+                skip = 1;
+                break;
             }
-            if (!lnp || skip)
-                continue;
-            insert(install(signature), lnp);
+            lnp = lnp->l_next;
+        }
+        if (!lnp || skip)
+            return 0;
+        insert(install(signature), lnp);
 
+        if (debug) {
+            fputs("matched pattern:\n", stderr);
+            for (p = o->o_old; p->l_prev; p = p->l_prev)
+                ;
+            printlines(p, 0, stderr);
+            fputs("with:\n", stderr);
+            printlines(c->l_next, r->l_next, stderr);
+        }
+        /* allow creation of several rules */
+        last = o;
+        while (lnp) {
+            nn = (struct onode*)
+                malloc((unsigned)sizeof(struct onode));
+            if (nn == NULL)
+                error("activate: out of memory\n");
+            nn->o_old = 0, nn->o_new = 0;
+            nn->firecount = MAXFIRECOUNT;
+            lnp = copylist(lnp, &nn->o_old, &nn->o_new, vars);
+            prepare(nn);
+            nn->o_next = last->o_next;
+            last->o_next = nn;
+            last = nn;
             if (debug) {
-                fputs("matched pattern:\n", stderr);
-                for (p = o->o_old; p->l_prev; p = p->l_prev)
-                    ;
-                printlines(p, 0, stderr);
-                fputs("with:\n", stderr);
-                printlines(c->l_next, r->l_next, stderr);
+                fputs("activated rule:\n", stderr);
+                printrule(nn, stderr);
             }
-            /* allow creation of several rules */
-            last = o;
-            while (lnp) {
-                nn = (struct onode*)
-                    malloc((unsigned)sizeof(struct onode));
-                if (nn == NULL)
-                    error("activate: out of memory\n");
-                nn->o_old = 0, nn->o_new = 0;
-                nn->firecount = MAXFIRECOUNT;
-                lnp = copylist(lnp, &nn->o_old, &nn->o_new, vars);
-                nn->o_next = last->o_next;
-                last->o_next = nn;
-                last = nn;
-                if (debug) {
-                    fputs("activated rule:\n", stderr);
-                    printrule(nn, stderr);
-                }
-            }
-            if (debug)
-                fputs("\n", stderr);
-            /* step back to allow (shorter) activated rules to match
-               in the order they appear */
-            while (--lines && r->l_prev)
-                r = r->l_prev;
-            global_again = 1; /* signalize changes */
-            continue;
         }
+        if (debug)
+            fputs("\n", stderr);
+        /* step back to allow (shorter) activated rules to match
+           in the order they appear */
+        while (--lines && r->l_prev)
+            r = r->l_prev;
+        *pr = r;
+        global_again = 1; /* signalize changes */
+        rules->index_valid = 0;
+        return -1;
+    }
 
-        /* fire the rule */
-        r = rep(c, r->l_next, o->o_new, vars);
-        activerule = 0;
-        return r;
+    /* fire the rule */
+    *pr = rep(c, r->l_next, o->o_new, vars);
+    return 1;
+}
+
+/* opt - replace instructions ending at r if possible */
+static struct lnode* opt(struct lnode* r)
+{
+    struct inode* ip;
+    struct onode* o;
+    char key[MAXLINE];
+    int i, j, n, fired = 0;
+
+    if (!rules->index_valid)
+        buildindex();
+
+    /* rules indexed by the opcode of r and rules without an opcode,
+       merged in the order they appear in opts */
+    opkey(r->l_text, key);
+    ip = findindex(key, 0);
+    n = ip ? ip->i_count : 0;
+    for (i = j = 0; i < n || j < rules->anyop.i_count;) {
+        if (j >= rules->anyop.i_count || (i < n && ip->i_rules[i]->o_seq < rules->anyop.i_rules[j]->o_seq))
+            o = ip->i_rules[i++];
+        else
+            o = rules->anyop.i_rules[j++];
+
+        fired = tryrule(o, &r);
+        if (fired > 0)
+            break;
+        if (fired < 0) {
+            /* rules were added after o and r may have moved back:
+               try the rest of the list in order */
+            for (o = o->o_next; o; o = o->o_next)
+                if ((fired = tryrule(o, &r)) > 0)
+                    break;
+            break;
+        }
     }
     activerule = 0;
-    return r->l_next;
+    return fired > 0 ? r : r->l_next;
+}
+
+/* optimise - apply the rule set in use to the lines between head and tail */
+static void optimise(struct lnode* head, struct lnode* tail)
+{
+    struct lnode* p;
+    int pass = 0;
+
+    head->l_text = tail->l_text = "";
+    do {
+        ++pass;
+        if (debug)
+            fprintf(stderr, "\n--- pass %d ---\n", pass);
+        global_again = 0;
+        for (p = head->l_next; p != tail; p = opt(p))
+            ;
+    } while (global_again && pass < MAX_PASS);
+
+    if (global_again) {
+        fprintf(stderr, "error: maximum of %d passes exceeded\n", MAX_PASS);
+        error("       check for recursive substitutions");
+    }
+}
+
+/* newrules - create an empty rule set and use it */
+static struct copt_rules* newrules(void)
+{
+    rules = (struct copt_rules*)calloc(1, sizeof *rules);
+    if (rules == NULL)
+        error("newrules: out of memory\n");
+    rules->nextlab = 1;
+    return rules;
+}
+
+/* addline - link the line being read at the end of code */
+static void addline(struct copt_code* code)
+{
+    code->lin[code->len] = '\0';
+    insert(install(code->lin), &code->tail);
+    code->len = 0;
+}
+
+/* copt_set_cpu - set the cpu checked by %cpu and %notcpu */
+void copt_set_cpu(char* cpu)
+{
+    c_cpu = cpu;
 }
 
+/* copt_load_rules - read a patterns file into a new rule set;
+   return 0 if it cannot be opened */
+struct copt_rules* copt_load_rules(char* filename)
+{
+    FILE* fp;
+
+    if ((fp = fopen(filename, "r")) == NULL)
+        return 0;
+    newrules();
+    init(fp);
+    fclose(fp);
+    return rules;
+}
+
+/* copt_new_code - create an empty list of lines */
+struct copt_code* copt_new_code(void)
+{
+    struct copt_code* code;
+
+    code = (struct copt_code*)calloc(1, sizeof *code);
+    if (code == NULL)
+        error("copt_new_code: out of memory\n");
+    connect(&code->head, &code->tail);
+    code->head.l_prev = code->tail.l_next = 0;
+    return code;
+}
+
+/* copt_add_char - append c to code; lines are split where fgets would
+   split them when z88dk-copt reads the same text */
+void copt_add_char(struct copt_code* code, int c)
+{
+    code->lin[code->len++] = (char)c;
+    if (c == '\n' || code->len == MAXLINE - 1)
+        addline(code);
+}
+
+/* copt_end_code - end the last line when the text does not end with one */
+void copt_end_code(struct copt_code* code)
+{
+    if (code->len > 0)
+        addline(code);
+}
+
+/* copt_optimise - apply rule set r to the complete lines of code; the rule
+   set carries on from where it stopped on the previous lines, so optimising
+   a text in parts gives the same result as optimising it at once, unless a
+   rule matches across the parts */
+void copt_optimise(struct copt_rules* r, struct copt_code* code)
+{
+    rules = r;
+    optimise(&code->head, &code->tail);
+}
+
+/* copt_write_code - write the complete lines of code to out and remove them;
+   return non-zero on a write error */
+int copt_write_code(struct copt_code* code, FILE* out)
+{
+    struct lnode *p, *next;
+
+    for (p = code->head.l_next; p != &code->tail; p = next) {
+        next = p->l_next;
+        fputs(p->l_text, out);
+        free(p);
+    }
+    connect(&code->head, &code->tail);
+    return ferror(out);
+}
+
+#ifndef COPT_NO_MAIN
 /* #define _TESTING */
 
 /* main - peephole optimizer */
@@ -620,9 +962,10 @@ int main(int argc, char** argv)
 #ifdef _TESTING
     FILE* inp;
 #endif
-    int i, pass;
-    struct lnode head, *p, *opt(), tail;
+    int i;
+    struct lnode head, tail;
 
+    newrules();
     for (i = 1; i < argc; i++)
         if (strcasecmp(argv[i], "-D") == 0)
             debug = 1;
@@ -641,55 +984,42 @@ int main(int argc, char** argv)
 #else
     getlst(stdin, "", &head, &tail);
 #endif
-    head.l_text = tail.l_text = "";
-
-    pass = 0;
-    do {
-        ++pass;
-        if (debug)
-            fprintf(stderr, "\n--- pass %d ---\n", pass);
-        global_again = 0;
-        for (p = head.l_next; p != &tail; p = opt(p))
-            ;
-    } while (global_again && pass < MAX_PASS);
-
-    if (global_again) {
-        fprintf(stderr, "error: maximum of %d passes exceeded\n", MAX_PASS);
-        error("       check for recursive substitutions");
-    }
+    head.l_prev = tail.l_next = 0;
+    optimise(&head, &tail);
 
     printlines(head.l_next, &tail, stdout);
     exit(0);
     return 1; /* make compiler happy */
 }
+#endif
 
 #define STACKSIZE 20
 
-int sp;
-int stack[STACKSIZE];
+static int sp;
+static int stack[STACKSIZE];
 
-void push(int l)
+static void push(int l)
 {
     if (sp < STACKSIZE)
         stack[sp++] = l;
     ;
 }
 
-int pop()
+static int pop()
 {
     if (sp > 0)
         return stack[--sp];
     return 0;
 }
 
-int top()
+static int top()
 {
     if (sp > 0)
         return stack[sp - 1];
     return 0;
 }
 
-int rpn_eval(const char* expr, char** vars)
+static int rpn_eval(const char* expr, char** vars)
 {
     const char* ptr = expr;
     char* endptr;
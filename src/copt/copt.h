@@ -0,0 +1,25 @@
+/*
+ * Library interface of the copt peephole optimiser
+ *
+ * Build copt.c with COPT_NO_MAIN to link it into another program. Each rule
+ * set holds the state a z88dk-copt process holds while it reads its input,
+ * so the text can be given to it in parts.
+ */
+
+#ifndef COPT_H
+#define COPT_H
+
+#include <stdio.h>
+
+typedef struct copt_rules copt_rules;
+typedef struct copt_code copt_code;
+
+extern void        copt_set_cpu(char *cpu);
+extern copt_rules *copt_load_rules(char *filename);
+extern copt_code  *copt_new_code(void);
+extern void        copt_add_char(copt_code *code, int c);
+extern void        copt_end_code(copt_code *code);
+extern void        copt_optimise(copt_rules *rules, copt_code *code);
+extern int         copt_write_code(copt_code *code, FILE *out);
+
+#endif
@@ -19,6 +19,8 @@
 static int SetWatch(char* sym, int* isscanf);
 static int SetMiniFunc(unsigned char* arg, uint32_t* format_option_ptr);
 static Kind ForceArgs(Type *dest, Type *src, int isconst);
+static int IsStringLiteral(char *start, int offset);
+static int LowerPrintf(unsigned char *fmt, int offset, int fmtarg, int argnumber, Kind *argkinds, int *argsizes, int *argsps, int emit);
 
 
 /* msys2 tmpfile() is broken:
@@ -85,6 +87,12 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
     double constargval[5];
     FILE *tmpfiles[100];  // 100 arguments enough I guess */
     int   tmplinenos[100];
+    Kind  argkinds[100];    /* For lowering printf: what each argument pushed */
+    int   argsizes[100];
+    int   argsps[100];
+    int   lower_printf = NO;
+    int   format_offset = -1;
+    uint32_t lower_format_option = 0;
     FILE *save_fps;
     int   i;
     int   save_fps_num;
@@ -116,6 +124,14 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
     if (ptr ) {
         funcname = ptr->name;
         watcharg = SetWatch(funcname, &isscanf);
+        /* printf and fprintf with a constant format can be expanded into direct output calls */
+        if ( c_lower_printf && (functype->flags & SMALLC) && functype->funcattrs.hasva && !IS_808x() && !IS_GBZ80() ) {
+            if ( strcmp(funcname, "fprintf") == 0 ) {
+                lower_printf = YES;
+            } else if ( strcmp(funcname, "printf") == 0 && findglb("stdout") != NULL ) {
+                lower_printf = YES;
+            }
+        }
     }
     savesp = Zsp;
     while (ch() != ')') {
@@ -291,12 +307,22 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
                 minifunc = SetMiniFunc(litq + (int)val + 1, &format_option);
                 if (isscanf) {
                     scanf_format_option |= format_option;
+                } else if ( lower_printf && IsStringLiteral(start, (int)val) ) {
+                    /* Decided once all the arguments are known */
+                    format_offset = (int)val;
+                    lower_format_option = format_option;
                 } else {
                     printf_format_option |= format_option;
                 }
             }
             if ( function_pointer_call == 0 ||  fnptr_type->kind == KIND_CPTR ) {
-                nargs += push_function_argument(expr, type, functype->flags & SDCCDECL && argnumber <= array_len(functype->parameters));
+                int size = push_function_argument(expr, type, functype->flags & SDCCDECL && argnumber <= array_len(functype->parameters));
+                if ( argnumber < 100 ) {
+                    argkinds[argnumber] = expr;
+                    argsizes[argnumber] = size;
+                    argsps[argnumber] = Zsp;
+                }
+                nargs += size;
             } else {
                 last_argument_size = push_function_argument_fnptr(expr, type, functype->flags & SDCCDECL && argnumber <= array_len(functype->parameters), tmpfiles[argnumber+1] == NULL);
                 nargs += last_argument_size;
@@ -311,7 +337,15 @@ void callfunction(SYMBOL *ptr, Type *fnptr_type)
     lineno = saveline;
 
 
-    if (function_pointer_call == NO ) {
+    if ( format_offset != -1 && LowerPrintf(litq + format_offset + 1, format_offset, watcharg, argnumber, argkinds, argsizes, argsps, NO) == 0 ) {
+        /* The format will be interpreted at runtime after all */
+        printf_format_option |= lower_format_option;
+        format_offset = -1;
+    }
+
+    if ( format_offset != -1 ) {
+        LowerPrintf(litq + format_offset + 1, format_offset, watcharg, argnumber, argkinds, argsizes, argsps, YES);
+    } else if (function_pointer_call == NO ) {
         /* Check to see if we have a variable number of arguments */
         if ( functype->funcattrs.hasva ) {
             if ( (functype->flags & SMALLC) == SMALLC ) {
@@ -537,3 +571,124 @@ static int SetMiniFunc(unsigned char* arg, uint32_t* format_option_ptr)
     *format_option_ptr = format_option;
     return (complex);
 }
+
+/*
+ *      Check whether the staged code of an argument is just the
+ *      address of the string literal at offset
+ */
+static int IsStringLiteral(char *start, int offset)
+{
+    char buf[64];
+
+    if ( start == NULL || stagenext == NULL ) {
+        return 0;
+    }
+    *stagenext = 0;
+    snprintf(buf, sizeof(buf), "\tld\thl,i_%d+%d\n", litlab, offset);
+    return strcmp(start, buf) == 0;
+}
+
+/*
+ *      Expand printf/fprintf with a constant format into a sequence of
+ *      calls to the library output helpers, so the format isn't parsed
+ *      at runtime.
+ *
+ *      The arguments have already been pushed: the FILE * and the count
+ *      of characters written are pushed on top of them and are updated
+ *      by each helper, the count is left in hl as the return value.
+ *
+ *      Only plain %d %i %u %o %x %X (with an optional l), %s, %c and %%
+ *      are handled, anything else is left to the format interpreter.
+ *      With emit == NO nothing is generated and the return value says
+ *      whether the call can be expanded.
+ */
+static int LowerPrintf(unsigned char *fmt, int offset, int fmtarg, int argnumber, Kind *argkinds, int *argsizes, int *argsps, int emit)
+{
+    unsigned char *start = fmt;
+    unsigned char *text = fmt;
+    char   helper[40];
+    char   conv[2] = { 0, 0 };
+    int    arg = fmtarg + 1;
+    int    islong;
+    char   c;
+
+    if ( fmtarg == 2 && argsizes[1] != 2 ) {
+        return 0;
+    }
+
+    if ( emit ) {
+        if ( fmtarg == 2 ) {
+            /* fprintf(FILE *stream, ...) */
+            vconst(argsps[1] - Zsp);
+            ol("add\thl,sp");
+            callrts("l_gint");
+        } else {
+            ol("ld\thl,(_stdout)");
+        }
+        zpush();
+        vconst(0);
+        zpush();
+    }
+
+    while ( 1 ) {
+        if ( *fmt != '%' && *fmt != 0 ) {
+            fmt++;
+            continue;
+        }
+        if ( fmt != text && emit ) {
+            immedlit(litlab, offset + (int)(text - start));
+            nl();
+            constbc((int)(fmt - text));
+            callrts("__stdio_lowered_text");
+        }
+        if ( *fmt == 0 ) {
+            break;
+        }
+        fmt++;
+        if ( *fmt == '%' ) {
+            /* The second % starts the next piece of text */
+            text = fmt++;
+            continue;
+        }
+        islong = 0;
+        if ( *fmt == 'l' ) {
+            islong = 1;
+            fmt++;
+        }
+        c = *fmt;
+        if ( c == 0 || strchr(islong ? "diuoxX" : "diuoxXsc", c) == NULL ) {
+            return 0;
+        }
+        if ( arg > argnumber || arg >= 100 ) {
+            return 0;
+        }
+        if ( islong ) {
+            if ( argkinds[arg] != KIND_LONG || argsizes[arg] != 4 ) {
+                return 0;
+            }
+        } else if ( argsizes[arg] != 2 || argkinds[arg] == KIND_DOUBLE || argkinds[arg] == KIND_STRUCT ) {
+            return 0;
+        }
+        if ( emit ) {
+            vconst(argsps[arg] - Zsp);
+            ol("add\thl,sp");
+            callrts(islong ? "l_glong" : "l_gint");
+            conv[0] = c == 'i' ? 'd' : c;
+            snprintf(helper, sizeof(helper), "__stdio_lowered_%s%s", islong ? "l" : "", c == 'X' ? "xx" : conv);
+            callrts(helper);
+        }
+        arg++;
+        text = ++fmt;
+    }
+
+    if ( arg != argnumber + 1 ) {
+        return 0;
+    }
+
+    if ( emit ) {
+        ol("pop\thl");      /* hl = count */
+        ol("pop\tbc");
+        Zsp += 4;
+    }
+    return 1;
+}
@@ -163,6 +163,14 @@ extern int      c_old_diagnostic_fmt;
 
 #include "misc.h"
 
+/* opt.c */
+extern char    *c_copt_cpu;
+extern void     opt_add_rules(char *filename);
+extern int      opt_active(void);
+extern int      opt_outc(char c);
+extern void     generate(void);
+extern void     opt_flush(void);
+
 /* plunge.c */
 extern int      skim(char *opstr, void (*testfuncz)(LVALUE* lval, int label), void (*testfuncq)(int label), int dropval, int endval, int (*heir)(LVALUE* lval), LVALUE *lval);
 extern void     dropout(int k, void (*testfuncz)(LVALUE* lval, int label), void (*testfuncq)(int label), int exit1, LVALUE *lval);
@@ -70,6 +70,7 @@ extern char *c_bss_section;
 extern char *c_data_section;
 extern char *c_rodata_section;
 extern int c_disable_builtins;
+extern int c_lower_printf;
 extern uint32_t c_speed_optimisation;
 extern int c_fp_size;
 extern int c_fp_fudge_offset;
@@ -1791,10 +1791,7 @@ static void declfunc(Type *functype, enum storage_type storage)
     }
     goto_cleanup();
     function_appendix(currfn);
-
-#ifdef INBUILT_OPTIMIZER
-    generate();
-#endif
+    generate(); /* Optimise and write out the function */
     Zsp = 0;
     infunc = 0; /* not in fn. any more */
 }
@@ -9,10 +9,6 @@
 #include "ccdefs.h"
 #include <stdarg.h>
 
-#ifdef INBUILT_OPTIMIZER
-int opt_outc(char c);
-#endif
-
 /*
  * get integer of length len bytes from address addr
  */
@@ -190,12 +186,7 @@ void clearstage_info(const char *file, int line, char* before, char* start)
     }
     if (start) {
         if (output != NULL) {
-#ifdef INBUILT_OPTIMIZER
-            if (infunc)
-                AddBuffer(start);
-            else
-#endif
-                outstr(start);
+            outstr(start);
         } else {
             puts(start);
         }
@@ -229,16 +220,12 @@ int outbyte(char c)
         if (output != NULL) {
             if (stagenext) {
                 return (outstage(c));
-            } else {
-#ifdef INBUILT_OPTIMIZER
-                if (infunc)
-                    opt_outc(c);
-                else
-#endif
-                    if (currentbuffer) {
-                    return outbuffer(c);
-                } else if ((putc(c, output)) == EOF)
-                    fabort();
+            } else if (currentbuffer) {
+                return outbuffer(c);
+            } else if (opt_active()) {
+                return opt_outc(c);
+            } else if ((putc(c, output)) == EOF) {
+                fabort();
             }
         } else
             putchar(c);
@@ -350,7 +337,3 @@ void outd2(long n)
 }
 
 /* convert lower case to upper */
-
-#ifdef INBUILT_OPTIMIZER
-#include "opt.c"
-#endif
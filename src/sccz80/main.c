@@ -30,6 +30,7 @@ char Filenorig[FILENAME_LEN + 1];
 int c_notaltreg; /* No alternate registers */
 int c_standard_escapecodes = 0; /* \n = 10, \r = 13 */
 int c_disable_builtins = 0;
+int c_lower_printf = 0;
 int c_line_labels = 0;
 int c_cline_directive = 0;
 int c_cpu = CPU_Z80;
@@ -91,6 +92,7 @@ static void SetDefine(option *arg, char *val);
 static void SetUndefine(option *arg, char *val);
 static void DispInfo(option *arg, char *val);
 static void opt_code_speed(option *arg, char* val);
+static void SetCoptRules(option *arg, char *val);
 static void atexit_deallocate(void);
 
 
@@ -110,6 +112,7 @@ static option  sccz80_opts[] = {
     { 0, "", OPT_HEADER, "Code generation options", NULL, NULL, 0 },
     { 0, "unsigned", OPT_BOOL, "Make all types unsigned", &c_default_unsigned, NULL, 0 },
     { 0, "disable-builtins", OPT_BOOL, "Disable builtin functions",&c_disable_builtins, NULL, 0},
+    { 0, "lower-printf", OPT_BOOL, "Expand printf with a constant format into direct output calls (newlib)", &c_lower_printf, NULL, 0 },
     { 0, "doublestr", OPT_BOOL, "Store FP constants as strings", &c_double_strings, NULL, 0 },
     { 0, "math-z88", OPT_ASSIGN|OPT_INT, "(deprecated) Make FP constants match z88", &c_maths_mode, NULL, MATHS_Z88 },
 
@@ -133,6 +136,8 @@ static option  sccz80_opts[] = {
     { 0, "initseg", OPT_STRING, "=<name> Set the initialisation section name", &c_init_section, NULL, 0 },
     { 0, "gcline", OPT_BOOL, "Generate C_LINE directives", &c_cline_directive, NULL, 0 },
     { 0, "opt-code-speed", OPT_FUNCTION|OPT_STRING, "Optimise for speed not size", NULL, opt_code_speed, 0},
+    { 0, "copt-rules", OPT_FUNCTION, "=<file> Apply a peephole rule set to the output, in the order given", NULL, SetCoptRules, 0 },
+    { 0, "copt-cpu", OPT_STRING, "=<cpu> Set the cpu for the conditions in the peephole rules", &c_copt_cpu, NULL, 0 },
 #ifdef USEFRAME
     { 0, "", OPT_HEADER, "Framepointer configuration:", NULL, NULL, 0 },
     { 0, "frameix", OPT_ASSIGN|OPT_INT, "Use ix as the frame pointer", &c_framepointer_is_ix, NULL, 1},
@@ -832,6 +837,7 @@ void endinclude()
 void closeout()
 {
     tofile(); /* if diverted, return to file */
+    opt_flush(); /* write out what is left with the optimiser */
     if (output) {
         /* if open, close it */
         fclose(output);
@@ -984,6 +990,11 @@ void SetUndefine(option *arg, char* val)
     delmac();
 }
 
+void SetCoptRules(option *arg, char* val)
+{
+    opt_add_rules(val);
+}
+
 
 void SetWarning(option *arg, char *value) 
 {
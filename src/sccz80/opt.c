@@ -0,0 +1,76 @@
+/*
+ *      Small C+ Compiler
+ *
+ *      In-process peephole optimiser
+ *
+ *      The copt rule sets given with -copt-rules are applied in order to
+ *      the generated code before it is written out. The code is collected
+ *      and optimised a function at a time; each rule set keeps its state
+ *      from one function to the next, so the output is the same as piping
+ *      the whole file through one z88dk-copt per rule set.
+ */
+
+#include "ccdefs.h"
+#include "copt.h"
+
+char             *c_copt_cpu = "z80";
+
+static copt_rules **opt_rules;
+static int          opt_num_rules;
+static copt_code   *opt_code;
+
+
+/* Add a rule set, called for each -copt-rules option */
+void opt_add_rules(char *filename)
+{
+    copt_rules  *rules = copt_load_rules(filename);
+
+    if ( rules == NULL ) {
+        fprintf(stderr, "Cannot open peephole rules: %s\n", filename);
+        exit(1);
+    }
+    opt_rules = REALLOC(opt_rules, (opt_num_rules + 1) * sizeof(opt_rules[0]));
+    opt_rules[opt_num_rules++] = rules;
+}
+
+/* Non-zero if the output goes through the optimiser */
+int opt_active(void)
+{
+    return opt_num_rules != 0;
+}
+
+/* Collect a character of the output */
+int opt_outc(char c)
+{
+    if ( opt_code == NULL ) {
+        copt_set_cpu(c_copt_cpu);
+        opt_code = copt_new_code();
+    }
+    copt_add_char(opt_code, c);
+    return c;
+}
+
+/* Optimise the complete lines collected and write them out */
+void generate(void)
+{
+    int     i;
+
+    if ( opt_code == NULL || output == NULL )
+        return;
+    for ( i = 0; i < opt_num_rules; i++ ) {
+        copt_optimise(opt_rules[i], opt_code);
+    }
+    if ( copt_write_code(opt_code, output) ) {
+        opt_code = NULL;    /* don't write it again when closing */
+        fabort();
+    }
+}
+
+/* Write out the rest of the output before the file is closed */
+void opt_flush(void)
+{
+    if ( opt_code != NULL ) {
+        copt_end_code(opt_code);
+        generate();
+    }
+}
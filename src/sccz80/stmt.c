@@ -694,9 +694,6 @@ void doasm()
 {
     cmode = 0; /* mark mode as "asm" */
 
-#ifdef INBUILT_OPTIMIZER
-    generate(); /* Dump queued stuff to be opt'd */
-#endif
     while (1) {
         preprocess(); /* get and print lines */
         if (match("#endasm") || eof) {
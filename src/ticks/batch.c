@@ -0,0 +1,332 @@
+/*
+ * Batch runner
+ *
+ * The programs listed in a manifest are run on a pool of threads, each one
+ * in its own context, and the results are written to stdout in JSON in the
+ * order of the manifest.
+ *
+ * Every line of the manifest is:
+ *
+ *     <program> [<expected exit code>] [-m<cpu>]
+ *
+ * Blank lines and lines starting with # are ignored. The expected exit code
+ * is 0 when not given, the cpu is the one given on the command line.
+ *
+ * The result of a program is pass, fail (it exited with another code),
+ * timeout (the counter ran out), stopped (it reached the end address) or
+ * error (it could not be loaded). The output of the programs that did not
+ * pass is included in the report.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "ticks.h"
+
+#if defined(_WIN32) || defined(WIN32)
+#ifndef strcasecmp
+#define strcasecmp(a,b) stricmp(a,b)
+#endif
+#endif
+
+typedef struct {
+    char       *file;
+    int         expected;
+    int         cpu;
+    char       *memory_model;
+
+    /* Results */
+    char       *error;      // The program could not be run
+    int         exited;
+    int         exit_code;
+    long long   cycles;
+    char       *output;     // What the program printed, kept if it failed
+    long        output_len;
+} batch_test;
+
+static batch_test     *tests;
+static int             num_tests;
+static int             next_test;
+static ticks_context  *options;
+static int             load_addr;
+
+#ifndef _WIN32
+static pthread_mutex_t batch_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK()      pthread_mutex_lock(&batch_lock)
+#define UNLOCK()    pthread_mutex_unlock(&batch_lock)
+#else
+#define LOCK()
+#define UNLOCK()
+#endif
+
+
+static int read_manifest(char *manifest, int cpu, char *memory_model)
+{
+    FILE   *fp;
+    char    buf[1024];
+    int     lineno = 0;
+
+    if ( (fp = fopen(manifest, "r")) == NULL ) {
+        fprintf(stderr, "Cannot open manifest: %s\n", manifest);
+        return -1;
+    }
+    while ( fgets(buf, sizeof(buf), fp) != NULL ) {
+        batch_test  *test;
+        char       **argv;
+        char        *end;
+        int          argc, j;
+
+        lineno++;
+        argv = parse_words(buf, &argc);
+        if ( argc == 0 || argv[0][0] == 0 || argv[0][0] == '#' ) {
+            free(argv);
+            continue;
+        }
+        tests = realloc(tests, (num_tests + 1) * sizeof(tests[0]));
+        test = &tests[num_tests++];
+        memset(test, 0, sizeof(*test));
+        test->file = strdup(argv[0]);
+        test->cpu = cpu;
+        test->memory_model = memory_model;
+        for ( j = 1; j < argc; j++ ) {
+            if ( argv[j][0] == '-' && argv[j][1] == 'm' ) {
+                if ( (test->cpu = ticks_parse_cpu(&argv[j][1])) == -1 ) {
+                    fprintf(stderr, "%s:%d: unknown cpu %s\n", manifest, lineno, argv[j]);
+                    break;
+                }
+                if ( test->cpu == CPU_Z80N ) {
+                    test->memory_model = "zxn";
+                }
+            } else if ( j == 1 && isdigit((unsigned char)argv[j][0]) ) {
+                test->expected = strtol(argv[j], &end, 0);
+                if ( *end != 0 ) {
+                    fprintf(stderr, "%s:%d: bad exit code %s\n", manifest, lineno, argv[j]);
+                    break;
+                }
+            } else {
+                fprintf(stderr, "%s:%d: unexpected %s\n", manifest, lineno, argv[j]);
+                break;
+            }
+        }
+        free(argv);
+        if ( j < argc ) {
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+static int is_com_file(char *filename)
+{
+    char   *ext = strrchr(filename, '.');
+
+    return ext != NULL && strcasecmp(ext, ".com") == 0;
+}
+
+static void run_test(batch_test *test)
+{
+    ticks_context  *ctx;
+    FILE           *fh, *output;
+    long            size;
+
+    if ( (fh = fopen(test->file, "rb")) == NULL ) {
+        test->error = "cannot open the file";
+        return;
+    }
+    fseek(fh, 0, SEEK_END);
+    size = ftell(fh);
+    fseek(fh, 0, SEEK_SET);
+    if ( size <= 0 || size > 65536 ) {
+        test->error = "incorrect length";
+        fclose(fh);
+        return;
+    }
+    if ( (output = tmpfile()) == NULL ) {
+        test->error = "cannot create a file for the output";
+        fclose(fh);
+        return;
+    }
+
+    ctx = malloc(sizeof(*ctx));
+    ticks_context_init(ctx, test->cpu);
+    ctx->pc = options->pc;
+    ctx->counter = options->counter;
+    memory_init(ctx, test->memory_model);
+    hook_context_init(ctx, output);
+    ticks_load(ctx, fh, size, load_addr, is_com_file(test->file));
+    fclose(fh);
+
+    ticks_run(ctx);
+
+    test->exited = ctx->exited;
+    test->exit_code = ctx->exit_code;
+    test->cycles = ctx->st;
+    LOCK();
+    options->ops += ctx->ops;
+    UNLOCK();
+
+    if ( !test->exited || test->exit_code != test->expected ) {
+        fflush(output);
+        fseek(output, 0, SEEK_END);
+        test->output_len = ftell(output);
+        fseek(output, 0, SEEK_SET);
+        test->output = malloc(test->output_len + 1);
+        test->output_len = fread(test->output, 1, test->output_len, output);
+    }
+
+    hook_context_free(ctx);
+    ticks_context_free(ctx);
+    free(ctx);
+    fclose(output);
+}
+
+static void *batch_worker(void *arg)
+{
+    int     n;
+
+    while ( 1 ) {
+        LOCK();
+        n = next_test < num_tests ? next_test++ : -1;
+        UNLOCK();
+        if ( n == -1 ) {
+            break;
+        }
+        run_test(&tests[n]);
+    }
+    return NULL;
+}
+
+static void print_string(char *str, long len)
+{
+    long    j;
+
+    putchar('"');
+    for ( j = 0; j < len; j++ ) {
+        unsigned char c = str[j];
+
+        switch ( c ) {
+        case '"':
+            fputs("\\\"", stdout);
+            break;
+        case '\\':
+            fputs("\\\\", stdout);
+            break;
+        case '\n':
+            fputs("\\n", stdout);
+            break;
+        case '\r':
+            fputs("\\r", stdout);
+            break;
+        case '\t':
+            fputs("\\t", stdout);
+            break;
+        default:
+            // Control characters, and the 8 bit characters as Latin-1
+            if ( c < 0x20 || c >= 0x7f ) {
+                printf("\\u%04x", c);
+            } else {
+                putchar(c);
+            }
+            break;
+        }
+    }
+    putchar('"');
+}
+
+static void print_results(void)
+{
+    int     j, passed = 0;
+
+    printf("{\n  \"tests\": [\n");
+    for ( j = 0; j < num_tests; j++ ) {
+        batch_test *test = &tests[j];
+        char       *result;
+
+        if ( test->error ) {
+            result = "error";
+        } else if ( !test->exited ) {
+            result = test->cycles >= options->counter ? "timeout" : "stopped";
+        } else if ( test->exit_code != test->expected ) {
+            result = "fail";
+        } else {
+            result = "pass";
+            passed++;
+        }
+        printf("    { \"file\": ");
+        print_string(test->file, strlen(test->file));
+        printf(", \"expected\": %d, \"exit\": ", test->expected);
+        if ( test->exited ) {
+            printf("%d", test->exit_code);
+        } else {
+            printf("null");
+        }
+        printf(", \"cycles\": %lld, \"result\": \"%s\"", test->cycles, result);
+        if ( test->error ) {
+            printf(", \"error\": ");
+            print_string(test->error, strlen(test->error));
+        }
+        if ( test->output ) {
+            printf(", \"output\": ");
+            print_string(test->output, test->output_len);
+        }
+        printf(" }%s\n", j + 1 < num_tests ? "," : "");
+    }
+    printf("  ],\n  \"passed\": %d,\n  \"failed\": %d\n}\n", passed, num_tests - passed);
+}
+
+/* Run the programs listed in the manifest, the registers and the limits of
+   options are the starting point of every program. Returns the exit code
+   of ticks: 0 when all the programs passed */
+int batch_run(ticks_context *context, char *manifest, int jobs, char *memory_model, int load_address)
+{
+    int     j, failed = 0;
+
+    options = context;
+    load_addr = load_address;
+    if ( read_manifest(manifest, context->cpu, memory_model) ) {
+        return 1;
+    }
+
+#ifndef _WIN32
+    if ( jobs <= 0 ) {
+        jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if ( jobs > num_tests ) {
+        jobs = num_tests;
+    }
+    if ( jobs > 1 ) {
+        pthread_t  *threads = calloc(jobs, sizeof(threads[0]));
+        int         started = 0;
+
+        for ( j = 0; j < jobs; j++ ) {
+            if ( pthread_create(&threads[j], NULL, batch_worker, NULL) != 0 ) {
+                break;
+            }
+            started++;
+        }
+        // Whatever is left if some threads could not be started
+        batch_worker(NULL);
+        for ( j = 0; j < started; j++ ) {
+            pthread_join(threads[j], NULL);
+        }
+        free(threads);
+    }
+#endif
+    batch_worker(NULL);
+
+    print_results();
+    for ( j = 0; j < num_tests; j++ ) {
+        if ( tests[j].error || !tests[j].exited || tests[j].exit_code != tests[j].expected ) {
+            failed++;
+        }
+    }
+    return failed != 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Translated blocks for ticks
+ *
+ * The instructions of a block are decoded once and run together, the
+ * cycles of the block are added at once. The cache keeps the block that
+ * starts at each address, and counts for each byte the blocks that hold
+ * it so that a write to a byte of code invalidates the blocks holding it.
+ *
+ * The blocks are found by their address, so all of them are dropped when
+ * the paging changes. While two addresses map the same memory a write
+ * through one of them would not be seen at the other, the cache is not
+ * used until the paging changes again.
+ */
+
+#include "ticks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* The block of the addresses where no block can start */
+block  block_none;
+
+
+static void block_check_aliases(ticks_context *ctx)
+{
+    block_cache *cache = ctx->blocks;
+    int          i, j;
+
+    cache->enabled = 1;
+    for ( i = 0; i < MEMORY_PAGES; i++ ) {
+        cache->pages[i] = ctx->memory_pages[i];
+        for ( j = 0; j < i; j++ ) {
+            if ( ctx->memory_pages[i] == ctx->memory_pages[j] ) {
+                cache->enabled = 0;
+            }
+        }
+    }
+}
+
+block_cache *block_cache_new(ticks_context *ctx)
+{
+    block_cache *cache = calloc(1, sizeof(*cache));
+    int          i;
+
+    for ( i = 0; i < 256; i++ ) {
+        cache->cycles[i] = -1;
+    }
+    ctx->blocks = cache;
+    block_check_aliases(ctx);
+    return cache;
+}
+
+void block_cache_free(ticks_context *ctx)
+{
+    if ( ctx->blocks ) {
+        block_flush(ctx);
+        block_free_retired(ctx->blocks);
+        free(ctx->blocks);
+        ctx->blocks = NULL;
+    }
+}
+
+void block_add(ticks_context *ctx, block *blk)
+{
+    block_cache *cache = ctx->blocks;
+    int          i;
+
+    cache->blocks[blk->start] = blk;
+    for ( i = 0; i < blk->len; i++ ) {
+        cache->code[blk->start + i]++;
+    }
+    cache->translated++;
+}
+
+static void block_remove(block_cache *cache, block *blk)
+{
+    int          i;
+
+    cache->blocks[blk->start] = NULL;
+    for ( i = 0; i < blk->len; i++ ) {
+        cache->code[blk->start + i]--;
+    }
+    blk->next = cache->retired;
+    cache->retired = blk;
+}
+
+/* A byte of code has been written, the blocks holding it go */
+void block_invalidate(ticks_context *ctx, int addr)
+{
+    block_cache *cache = ctx->blocks;
+    block       *blk;
+    int          start;
+
+    for ( start = addr; start >= 0 && start > addr - BLOCK_MAX_BYTES; start-- ) {
+        blk = cache->blocks[start];
+        if ( blk != NULL && blk != &block_none && start + blk->len > addr ) {
+            block_remove(cache, blk);
+        }
+    }
+    cache->invalidated = 1;
+}
+
+/* Drop all the blocks */
+void block_flush(ticks_context *ctx)
+{
+    block_cache *cache = ctx->blocks;
+    int          i;
+
+    if ( cache == NULL ) {
+        return;
+    }
+    for ( i = 0; i < 65536; i++ ) {
+        if ( cache->blocks[i] != NULL && cache->blocks[i] != &block_none ) {
+            block_remove(cache, cache->blocks[i]);
+        }
+        cache->blocks[i] = NULL;
+    }
+    cache->invalidated = 1;
+}
+
+/* Called when the paging may have changed */
+void block_check_paging(ticks_context *ctx)
+{
+    block_cache *cache = ctx->blocks;
+
+    if ( cache == NULL || memcmp(cache->pages, ctx->memory_pages, sizeof(cache->pages)) == 0 ) {
+        return;
+    }
+    block_flush(ctx);
+    block_check_aliases(ctx);
+}
+
+void block_free_retired(block_cache *cache)
+{
+    block       *blk;
+
+    while ( (blk = cache->retired) != NULL ) {
+        cache->retired = blk->next;
+        free(blk);
+    }
+}
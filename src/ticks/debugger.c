@@ -3,6 +3,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <stddef.h>
 #ifdef WIN32
 #include <io.h>
 #else
@@ -45,43 +46,47 @@ typedef struct breakpoint {
 
 struct reg {
     char    *name;
-    uint8_t  *low;
-    uint8_t  *high;
-    uint16_t *word;
+    int      low;           /* Offsets in the context, -1 if not there */
+    int      high;
+    int      word;
 };
 
+#define REG(x)   offsetof(ticks_context, x)
+
 static struct reg registers[] = {
-    { "hl",  &l,  &h },
-    { "de",  &e,  &d },
-    { "bc",  &c,  &b },
-    { "hl'", &l_, &h_ },
-    { "de'", &e_, &d_ },
-    { "bc'", &c_, &b_ },
-    { "ix'", &xl, &xh },
-    { "iy'", &yl, &yh },
-    { "sp",  NULL, NULL, &sp },
-    { "pc",  NULL, NULL, &pc },
-    { "a",   &a,   NULL },
-    { "a'",  &a_,  NULL },
-    { "b",   &b,   NULL },
-    { "b'",  &b_,  NULL },
-    { "c",   &c,   NULL },
-    { "c'",  &c_,  NULL },
-    { "d",   &d,   NULL },
-    { "d'",  &d_,  NULL },
-    { "e",   &e,   NULL },
-    { "e'",  &e_,  NULL },
-    { "h",   &h,   NULL },
-    { "h'",  &h_,  NULL },
-    { "l",   &l,   NULL },
-    { "l'",  &l_,  NULL },
-    { "ixh", &xh,  NULL },
-    { "ixl", &xl,  NULL },
-    { "iyh", &yh,  NULL },
-    { "iyl", &yl,  NULL },
-    { NULL, NULL, NULL },
+    { "hl",  REG(l),  REG(h),  -1 },
+    { "de",  REG(e),  REG(d),  -1 },
+    { "bc",  REG(c),  REG(b),  -1 },
+    { "hl'", REG(l_), REG(h_), -1 },
+    { "de'", REG(e_), REG(d_), -1 },
+    { "bc'", REG(c_), REG(b_), -1 },
+    { "ix'", REG(xl), REG(xh), -1 },
+    { "iy'", REG(yl), REG(yh), -1 },
+    { "sp",  -1,      -1,      REG(sp) },
+    { "pc",  -1,      -1,      REG(pc) },
+    { "a",   REG(a),  -1,      -1 },
+    { "a'",  REG(a_), -1,      -1 },
+    { "b",   REG(b),  -1,      -1 },
+    { "b'",  REG(b_), -1,      -1 },
+    { "c",   REG(c),  -1,      -1 },
+    { "c'",  REG(c_), -1,      -1 },
+    { "d",   REG(d),  -1,      -1 },
+    { "d'",  REG(d_), -1,      -1 },
+    { "e",   REG(e),  -1,      -1 },
+    { "e'",  REG(e_), -1,      -1 },
+    { "h",   REG(h),  -1,      -1 },
+    { "h'",  REG(h_), -1,      -1 },
+    { "l",   REG(l),  -1,      -1 },
+    { "l'",  REG(l_), -1,      -1 },
+    { "ixh", REG(xh), -1,      -1 },
+    { "ixl", REG(xl), -1,      -1 },
+    { "iyh", REG(yh), -1,      -1 },
+    { "iyl", REG(yl), -1,      -1 },
+    { NULL, -1, -1, -1 },
 };
 
+#define REG_ADDR(offset) ((uint8_t *)ctx + (offset))
+
 typedef struct {
     char   *cmd;
     int   (*func)(int argc, char **argv);
@@ -130,6 +135,7 @@ static command commands[] = {
 static breakpoint *breakpoints;
 
        int debugger_active = 0;
+       int debugger_enabled = 1;    /* debugger() has to be called before each instruction */
 static int next_address = -1;
        int trace = 0;
 static int hotspot = 0;
@@ -141,10 +147,13 @@ static int hotspots_t[65536];
 
 static int interact_with_tty = 0;
 
+static ticks_context *ctx;          /* The context being debugged */
 
 
-void debugger_init()
+
+void debugger_init(ticks_context *context)
 {
+    ctx = context;
     linenoiseSetCompletionCallback(completion, NULL);
     linenoiseHistoryLoad(HISTORY_FILE); /* Load the history at startup */
     atexit(print_hotspots);
@@ -174,9 +183,21 @@ void debugger()
     char   prompt[100];
     char  *line;
 
+    /* Nothing to do until the debugger is entered again, the state below
+       can only be changed from the command loop */
+    debugger_enabled = debugger_active || trace || hotspot || profiler_enabled ||
+                       breakpoints != NULL || next_address != -1;
+    if ( debugger_enabled == 0 ) {
+        return;
+    }
+
+    if ( profiler_enabled ) {
+        profiler_step();
+    }
+
     if ( trace ) {
         cmd_registers(0, NULL);
-        disassemble2(pc, buf, sizeof(buf));
+        disassemble2(ctx, ctx->pc, buf, sizeof(buf));
 
         if (interact_with_tty)
             printf( "\n%s\n\n",buf);    // In case of active tty, double LF to improve layout in case of 'cont'
@@ -185,15 +206,15 @@ void debugger()
     }
 
     if ( hotspot ) {
-        if ( pc > max_hotspot_addr) {
-            max_hotspot_addr = pc;
+        if ( ctx->pc > max_hotspot_addr) {
+            max_hotspot_addr = ctx->pc;
         }
         if ( last_hotspot_addr != -1 ) {
-            hotspots_t[last_hotspot_addr] += st - last_hotspot_st;
+            hotspots_t[last_hotspot_addr] += ctx->st - last_hotspot_st;
         }
-        hotspots[pc]++;
-        last_hotspot_addr = pc;
-        last_hotspot_st = st;
+        hotspots[ctx->pc]++;
+        last_hotspot_addr = ctx->pc;
+        last_hotspot_st = ctx->st;
     }
 
     if ( debugger_active == 0 ) {
@@ -204,7 +225,7 @@ void debugger()
             if ( elem->enabled == 0 ) {
                 continue;
             }
-            if ( elem->type == BREAK_PC && elem->value == pc ) {
+            if ( elem->type == BREAK_PC && elem->value == ctx->pc ) {
                 printf("Hit breakpoint %d\n",i);
                 dodebug=1;
                 break;
@@ -223,7 +244,7 @@ void debugger()
             }
             i++;
         }
-        if ( pc == next_address ) {
+        if ( ctx->pc == next_address ) {
             next_address = -1;
             dodebug = 1;
         }
@@ -233,16 +254,16 @@ void debugger()
 
 
     if (trace ==0) { // Prevent two lines with the same information
-        disassemble2(pc, buf, sizeof(buf));
+        disassemble2(ctx, ctx->pc, buf, sizeof(buf));
         printf("%s\n",buf);
     }
 
     /* In the debugger, loop continuously for commands */
 
     if (interact_with_tty)
-        snprintf(prompt,sizeof(prompt), "\n" FNT_BCK "    $%04x    >" FNT_RST, pc);     // TODO: Symbol address
+        snprintf(prompt,sizeof(prompt), "\n" FNT_BCK "    $%04x    >" FNT_RST, ctx->pc);     // TODO: Symbol address
     else                                                                                // Original output for non-active tty
-        snprintf(prompt,sizeof(prompt), " %04x >", pc);                                 // TODO: Symbol address
+        snprintf(prompt,sizeof(prompt), " %04x >", ctx->pc);                                 // TODO: Symbol address
 
     while ( (line = linenoise(prompt) ) != NULL ) {
         int argc;
@@ -284,9 +305,9 @@ static int cmd_next(int argc, char **argv)
 {
     char  buf[100];
     int   len;
-    uint8_t opcode = get_memory(pc);
+    uint8_t opcode = get_memory(ctx, ctx->pc);
 
-    len = disassemble2(pc, buf, sizeof(buf));
+    len = disassemble2(ctx, ctx->pc, buf, sizeof(buf));
 
     // Set a breakpoint after the call
     switch ( opcode ) {
@@ -300,7 +321,7 @@ static int cmd_next(int argc, char **argv)
     case 0xf4:
         // It's a call
         debugger_active = 0;
-        next_address = pc + len;
+        next_address = ctx->pc + len;
         return 1;
     }
 
@@ -344,7 +365,7 @@ static int cmd_disassemble(int argc, char **argv)
 {
     char  buf[256];
     int   i = 0;
-    int   where = pc;
+    int   where = ctx->pc;
 
     if ( argc == 2 ) {
         char *end;
@@ -352,13 +373,13 @@ static int cmd_disassemble(int argc, char **argv)
         if ( end == argv[1] ) {
             where = symbol_resolve(argv[1]);
             if ( where == -1 ) {
-                where = pc;
+                where = ctx->pc;
             }
         }
     }
 
     while ( i < 10 ) {
-       where += disassemble2(where, buf, sizeof(buf));
+       where += disassemble2(ctx, where, buf, sizeof(buf));
        printf("%s\n",buf);
        i++;
     }
@@ -395,20 +416,20 @@ static int cmd_registers(int argc, char **argv)
             FNT_CLR "sp "  FNT_RST "$" FNT_BLD "%04X"   FNT_RST "  "
             FNT_CLR "[sp]" FNT_RST "$" FNT_BLD "%04X" FNT_RST "\n",
 
-            f()  | a << 8,  c  | b  << 8, e  | d  << 8, l  | h  << 8, xl | xh << 8,
-            (f()  & 0x80) ? 1 : 0, (f()  & 0x40) ? 1 : 0, (f()  & 0x10) ? 1 : 0, (f()  & 0x04) ? 1 : 0, (f()  & 0x02) ? 1 : 0, (f()  & 0x01) ? 1 : 0,
+            f(ctx)  | ctx->a << 8,  ctx->c  | ctx->b  << 8, ctx->e  | ctx->d  << 8, ctx->l  | ctx->h  << 8, ctx->xl | ctx->xh << 8,
+            (f(ctx)  & 0x80) ? 1 : 0, (f(ctx)  & 0x40) ? 1 : 0, (f(ctx)  & 0x10) ? 1 : 0, (f(ctx)  & 0x04) ? 1 : 0, (f(ctx)  & 0x02) ? 1 : 0, (f(ctx)  & 0x01) ? 1 : 0,
 
-            f_() | a_ << 8, c_ | b_ << 8, e_ | d_ << 8, l_ | h_ << 8, yl | yh << 8,
+            f_(ctx) | ctx->a_ << 8, ctx->c_ | ctx->b_ << 8, ctx->e_ | ctx->d_ << 8, ctx->l_ | ctx->h_ << 8, ctx->yl | ctx->yh << 8,
 
-            pc, get_memory(pc), sp, (get_memory(sp+1) << 8 | get_memory(sp))
+            ctx->pc, get_memory(ctx, ctx->pc), ctx->sp, (get_memory(ctx, ctx->sp+1) << 8 | get_memory(ctx, ctx->sp))
             );
     } else {  // Original output for non-active tty
         printf("pc=%04X, [pc]=%02X,    bc=%04X,  de=%04X,  hl=%04X,  af=%04X, ix=%04X, iy=%04X\n"
                "sp=%04X, [sp]=%04X, bc'=%04X, de'=%04X, hl'=%04X, af'=%04X\n"
                "f: S=%d Z=%d H=%d P/V=%d N=%d C=%d\n",
-               pc, get_memory(pc), c | b << 8, e | d << 8, l | h << 8, f() | a << 8, xl | xh << 8, yl | yh << 8,
-               sp, (get_memory(sp+1) << 8 | get_memory(sp)), c_ | b_ << 8, e_ | d_ << 8, l_ | h_ << 8, f_() | a_ << 8,
-               (f() & 0x80) ? 1 : 0, (f() & 0x40) ? 1 : 0, (f() & 0x10) ? 1 : 0, (f() & 0x04) ? 1 : 0, (f() & 0x02) ? 1 : 0, (f() & 0x01) ? 1 : 0);
+               ctx->pc, get_memory(ctx, ctx->pc), ctx->c | ctx->b << 8, ctx->e | ctx->d << 8, ctx->l | ctx->h << 8, f(ctx) | ctx->a << 8, ctx->xl | ctx->xh << 8, ctx->yl | ctx->yh << 8,
+               ctx->sp, (get_memory(ctx, ctx->sp+1) << 8 | get_memory(ctx, ctx->sp)), ctx->c_ | ctx->b_ << 8, ctx->e_ | ctx->d_ << 8, ctx->l_ | ctx->h_ << 8, f_(ctx) | ctx->a_ << 8,
+               (f(ctx) & 0x80) ? 1 : 0, (f(ctx) & 0x40) ? 1 : 0, (f(ctx) & 0x10) ? 1 : 0, (f(ctx) & 0x04) ? 1 : 0, (f(ctx) & 0x02) ? 1 : 0, (f(ctx) & 0x01) ? 1 : 0);
     }
 
     return 0;
@@ -509,7 +530,7 @@ static int cmd_break(int argc, char **argv)
         if ( value != -1 ) {
             breakpoint *elem = malloc(sizeof(*elem));
             elem->type = BREAK_CHECK8;
-            elem->lcheck_ptr = get_memory_addr(value);
+            elem->lcheck_ptr = get_memory_addr(ctx, value);
             elem->lvalue = parse_number(argv[4], &end);
             elem->enabled = 1;
             elem->text = strdup(argv[2]);
@@ -528,9 +549,9 @@ static int cmd_break(int argc, char **argv)
             int value = parse_number(argv[4],&end);
             breakpoint *elem = malloc(sizeof(*elem));
             elem->type = BREAK_CHECK16;
-            elem->lcheck_ptr = get_memory_addr(addr);
+            elem->lcheck_ptr = get_memory_addr(ctx, addr);
             elem->lvalue = value % 256;
-            elem->hcheck_ptr = get_memory_addr(addr+1);
+            elem->hcheck_ptr = get_memory_addr(ctx, addr+1);
             elem->hvalue = (value % 65536 ) /    256;
             elem->enabled = 1;
             elem->text = strdup(argv[2]);
@@ -550,19 +571,19 @@ static int cmd_break(int argc, char **argv)
         if ( search->name != NULL ) {
             int value = atoi(argv[4]);
             breakpoint *elem = malloc(sizeof(*elem));
-            elem->type = search->high == NULL && search->word == NULL ? BREAK_CHECK8 : BREAK_CHECK16;
-            if  ( search->word != NULL ) {
+            elem->type = search->high == -1 && search->word == -1 ? BREAK_CHECK8 : BREAK_CHECK16;
+            if  ( search->word != -1 ) {
 #ifdef __BIG_ENDIAN__
-                elem->lcheck_ptr = ((uint8_t *)search->word) + 1;
-                elem->hcheck_ptr = ((uint8_t *)search->word);
+                elem->lcheck_ptr = REG_ADDR(search->word) + 1;
+                elem->hcheck_ptr = REG_ADDR(search->word);
 #else
-                elem->hcheck_ptr = ((uint8_t *)search->word) + 1;
-                elem->lcheck_ptr = ((uint8_t *)search->word);
+                elem->hcheck_ptr = REG_ADDR(search->word) + 1;
+                elem->lcheck_ptr = REG_ADDR(search->word);
 #endif
-                printf("%p %p %p\n",elem->lcheck_ptr, elem->hcheck_ptr, &pc);
+                printf("%p %p %p\n",elem->lcheck_ptr, elem->hcheck_ptr, &ctx->pc);
             } else {
-                elem->lcheck_ptr = search->low;
-                elem->hcheck_ptr = search->high;
+                elem->lcheck_ptr = REG_ADDR(search->low);
+                elem->hcheck_ptr = search->high != -1 ? REG_ADDR(search->high) : NULL;
             }
             elem->lvalue = (value % 256);
             elem->hvalue = (value % 65536) / 256;
@@ -601,7 +622,7 @@ static int cmd_examine(int argc, char **argv)
             addr %= 0x10000;                                    // First address with overflow correction
 
             for ( i = 0; i < 128; i++ ) {
-                uint8_t b = get_memory(addr);
+                uint8_t b = get_memory(ctx, addr);
                 abuf[i % 16] = isprint(b) ? ((char) b) : '.';   // Prepare end of dump in ASCII format
 
                 if ( i % 16 == 0 ) {                            // Handle line prefix 
@@ -636,12 +657,12 @@ static int cmd_set(int argc, char **argv)
         if ( end != NULL ) {
             while ( search->name != NULL ) {
                 if ( strcmp(argv[1], search->name) == 0 ) {
-                    if ( search->word ) {
-                        *search->word = val % 65536;
+                    if ( search->word != -1 ) {
+                        *(unsigned short *)REG_ADDR(search->word) = val % 65536;
                     } else {
-                        *search->low = val % 256;
-                        if ( search->high != NULL ) {
-                            *search->high = (val % 65536) / 256;
+                        *REG_ADDR(search->low) = val % 256;
+                        if ( search->high != -1 ) {
+                            *REG_ADDR(search->high) = (val % 65536) / 256;
                         }
                     }
                     break;
@@ -665,7 +686,7 @@ static int cmd_out(int argc, char **argv)
         int value = parse_number(argv[2], &end);
 
         printf("Writing IO: out(%d),%d\n",port,value);
-        out(port,value);
+        out(ctx, port,value);
     }
     return 0;
 }
@@ -733,11 +754,11 @@ static void print_hotspots()
     FILE  *fp;
 
     if ( hotspot == 0 ) return;
-    memory_reset_paging();
+    memory_reset_paging(ctx);
     if ( (fp = fopen("hotspots", "w")) != NULL ) {
         for ( i = 0; i < max_hotspot_addr; i++) {
             if ( hotspots[i] != 0 ) {
-                disassemble2(i, buf, sizeof(buf));
+                disassemble2(ctx, i, buf, sizeof(buf));
                 fprintf(fp, "%d\t%d\t\t%s\n",hotspots[i],hotspots_t[i],buf);
             }
         }
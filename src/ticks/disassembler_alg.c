@@ -12,6 +12,7 @@ static char *assorted_mainpage_opcodes[] = { "rlca", "rrca", "rla", "rra", "daa"
 
 
 typedef struct {
+    ticks_context *ctx;
     int       index;
     unsigned short     pc;
     int       len;
@@ -24,7 +25,7 @@ typedef struct {
 
 
 #define READ_BYTE(state,val) do { \
-    val = get_memory(state->pc++); \
+    val = get_memory(state->ctx, state->pc++); \
     state->instr_bytes[state->len++] = val; \
 } while (0)
 
@@ -230,7 +231,7 @@ static char *handle_im_instructions(dcontext *state, uint8_t y)
 }   
 
 
-int disassemble2(int pc, char *bufstart, size_t buflen)
+int disassemble2(ticks_context *ctx, int pc, char *bufstart, size_t buflen)
 {
     dcontext    s_state = {0};
     dcontext   *state = &s_state;
@@ -244,6 +245,7 @@ int disassemble2(int pc, char *bufstart, size_t buflen)
     char         opbuf1[256];
     char         opbuf2[256];
 
+    state->ctx = ctx;
     state->pc = pc;
     
     label = find_symbol(pc, SYM_ADDRESS);
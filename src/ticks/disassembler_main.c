@@ -135,13 +135,14 @@ static void disassemble_loop(int start, int end)
     char   buf[256];
 
     while ( start < end ) {
-        start += disassemble2(start, buf, sizeof(buf));
+        start += disassemble2(NULL, start, buf, sizeof(buf));
         printf("%s\n",buf);
     }
 }
 
 
-uint8_t get_memory(int pc)
+/* There is no emulated machine, the code is read from the file */
+uint8_t get_memory(ticks_context *ctx, int pc)
 {
     return mem[pc % 65536] ^ inverted;
 }
@@ -5,29 +5,39 @@
 
 static hook_command  hooks[256];
 
-void PatchZ80(void)
+void PatchZ80(ticks_context *ctx)
 {
     int   val;
 
     // CP/M Emulation bodge
-    if ( pc == 7 ) {
-        hook_cpm();
+    if ( ctx->pc == 7 ) {
+        hook_cpm(ctx);
         return;
     }
 
-    if ( hooks[a] != NULL ) {
-        hooks[a]();
+    if ( hooks[ctx->a] != NULL ) {
+        hooks[ctx->a](ctx);
     } else {
-        printf("Unknown code %d\n",a);
-        exit(1);
+        fprintf(ctx->output, "Unknown code %d\n",ctx->a);
+        hook_exit(ctx, 1);
     }
 }
 
 
-static void cmd_exit(void)
+/* The program has finished, the instruction loop returns after the
+   current instruction */
+void hook_exit(ticks_context *ctx, int code)
 {
-	printf("\nTicks: %llu\n",st);
-    exit(l);
+    ctx->exited = 1;
+    ctx->exit_code = code;
+    ctx->counter = 0;
+}
+
+
+static void cmd_exit(ticks_context *ctx)
+{
+	fprintf(ctx->output, "\nTicks: %llu\n",ctx->st);
+    hook_exit(ctx, ctx->l);
 }
 
 void hook_init(void)
@@ -37,3 +47,14 @@ void hook_init(void)
     hook_misc_init(hooks);
     hook_console_init(hooks);
 }
+
+void hook_context_init(ticks_context *ctx, FILE *output)
+{
+    ctx->output = output;
+    hook_io_context_init(ctx);
+}
+
+void hook_context_free(ticks_context *ctx)
+{
+    hook_io_context_free(ctx);
+}
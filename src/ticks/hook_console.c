@@ -8,22 +8,22 @@
 #include <stdlib.h>
 
 
-static void cmd_printchar(void)
+static void cmd_printchar(ticks_context *ctx)
 {
-    if ( l == '\n' || l == '\r' ) {
-        fputc('\n',stdout);
-    } else if ( l == 8 || l == 127 ) {
+    if ( ctx->l == '\n' || ctx->l == '\r' ) {
+        fputc('\n',ctx->output);
+    } else if ( ctx->l == 8 || ctx->l == 127 ) {
         // VT100 code, understood by all terminals, honest
-        printf("%c[1D",27);
+        fprintf(ctx->output,"%c[1D",27);
     } else {
-        fputc(l,stdout);
+        fputc(ctx->l,ctx->output);
     }
     SET_ERROR(Z88DK_ENONE);
-    fflush(stdout);
+    fflush(ctx->output);
 }
 
 
-static void cmd_readkey(void)
+static void cmd_readkey(ticks_context *ctx)
 {
     int   val;
 
@@ -50,8 +50,8 @@ static void cmd_readkey(void)
 #endif
 
 
-    l = val % 256;
-    h = val / 256;
+    ctx->l = val % 256;
+    ctx->h = val / 256;
 
     SET_ERROR(Z88DK_ENONE);
 }
@@ -2,21 +2,21 @@
 #include "ticks.h"
 #include <stdio.h>
 
-void hook_cpm(void)
+void hook_cpm(ticks_context *ctx)
 {
-    if ( c == 0x02 ) {
-        fputc(e, stdout);
-	    fflush(stdout);
-    } else if ( c == 0x09 ) {
+    if ( ctx->c == 0x02 ) {
+        fputc(ctx->e, ctx->output);
+	    fflush(ctx->output);
+    } else if ( ctx->c == 0x09 ) {
         // Print string
-        int addr = d << 8 | e;
+        int addr = ctx->d << 8 | ctx->e;
         int tp;
-        while ( ( tp = *get_memory_addr(addr)) ) {
+        while ( ( tp = *get_memory_addr(ctx, addr)) ) {
             if ( tp == '$' ) 
                 break;
-            fputc(tp, stdout);
+            fputc(tp, ctx->output);
             addr++;
         }
-        fflush(stdout);
+        fflush(ctx->output);
     }
 }
@@ -15,16 +15,12 @@
 #endif
 
 #define CHECK_FD() do {                 \
-        if ( slots[b] == -1 ) { \
+        if ( ctx->slots[ctx->b] == -1 ) { \
             SET_ERROR(Z88DK_EBADF);   \
-            l = h = 255;                 \
+            ctx->l = ctx->h = 255;    \
         } \
     } while (0)
 
-#define NUM_SLOTS 256
-static int slots[NUM_SLOTS];
-
-static int selected_unit = 0;
 static int devices[2];
 
 
@@ -50,25 +46,25 @@ static int normalise_errno()
 
 
 
-int find_slot()
+static int find_slot(ticks_context *ctx)
 {
     int  i;
 
     for ( i = 0; i < NUM_SLOTS; i++ ) {
-        if ( slots[i] == -1 ) {
+        if ( ctx->slots[i] == -1 ) {
             return i;
         }
     }
     return -1;
 }
 
-static void cmd_openfile(void)
+static void cmd_openfile(ticks_context *ctx)
 {
-    char *filename = (char *)get_memory_addr(( l | h <<8));
-    int   z88dk_flags = e | d << 8;
+    char *filename = (char *)get_memory_addr(ctx, ( ctx->l | ctx->h <<8));
+    int   z88dk_flags = ctx->e | ctx->d << 8;
     int   flags = O_RDONLY;
-    int   mode = c | b << 8;
-    int   slot = find_slot();
+    int   mode = ctx->c | ctx->b << 8;
+    int   slot = find_slot(ctx);
 
     if ( z88dk_flags & Z88DK_O_WRONLY ) flags = O_WRONLY;
     if ( z88dk_flags & Z88DK_O_RDWR ) flags = O_RDWR;
@@ -76,7 +72,7 @@ static void cmd_openfile(void)
     if ( z88dk_flags & Z88DK_O_APPEND ) flags |= O_APPEND;
     if ( z88dk_flags & Z88DK_O_CREAT ) flags |= O_CREAT;
 
-    l = h = 255; 
+    ctx->l = ctx->h = 255; 
     if ( slot != -1 ) {
 #ifdef WIN32
         int fd = open(filename, flags, _S_IREAD | _S_IWRITE);
@@ -85,9 +81,9 @@ static void cmd_openfile(void)
 #endif
         
         if ( fd != -1 ) {
-            slots[slot] = fd;
-            l = slot % 256;
-            h = slot / 256;
+            ctx->slots[slot] = fd;
+            ctx->l = slot % 256;
+            ctx->h = slot / 256;
             SET_ERROR(Z88DK_ENONE);
         } else {
             SET_ERROR(Z88DK_ENFILE);
@@ -98,86 +94,87 @@ static void cmd_openfile(void)
     }
 }
 
-static void cmd_closefile(void)
+static void cmd_closefile(ticks_context *ctx)
 {
     CHECK_FD();
-    close(slots[b]);
-    slots[b] = -1;
-    l = h = 0;
+    close(ctx->slots[ctx->b]);
+    ctx->slots[ctx->b] = -1;
+    ctx->l = ctx->h = 0;
     SET_ERROR(Z88DK_ENONE);
 }
 
-static void cmd_writebyte(void)
+static void cmd_writebyte(ticks_context *ctx)
 {
-    char  val = l;
+    char  val = ctx->l;
     int   result;
 
     CHECK_FD();
-    result = write(slots[b], &val, 1);
-    l = result % 256;
-    h = result / 256;
+    result = write(ctx->slots[ctx->b], &val, 1);
+    ctx->l = result % 256;
+    ctx->h = result / 256;
     SET_ERROR(Z88DK_ENONE);
 }
 
-static void cmd_readbyte(void)
+static void cmd_readbyte(ticks_context *ctx)
 {
     char  val;
     int ret;
 
     CHECK_FD();
-    if ( read(slots[b], &val, 1) == 1 ) {
+    if ( read(ctx->slots[ctx->b], &val, 1) == 1 ) {
         ret = val;
         SET_ERROR(Z88DK_ENONE);
     } else {
         ret = 65535;
         SET_ERROR(normalise_errno());
     }
-    l = ret % 256;
-    h = ret / 256;
+    ctx->l = ret % 256;
+    ctx->h = ret / 256;
 }
 
-static void cmd_writeblock(void)
+static void cmd_writeblock(ticks_context *ctx)
 {
     int ret = -1;
 
     CHECK_FD();
 
-    ret = write(slots[b], (char *)get_memory_addr(e | d<<8), (l | h << 8));
+    ret = write(ctx->slots[ctx->b], (char *)get_memory_addr(ctx, ctx->e | ctx->d<<8), (ctx->l | ctx->h << 8));
     if ( ret != -1 ) {
         SET_ERROR(Z88DK_ENONE);
     } else {
         ret = 65535;
         SET_ERROR(normalise_errno());
     }
-    l = ret % 256;
-    h = ret / 256;
+    ctx->l = ret % 256;
+    ctx->h = ret / 256;
 }
 
-static void cmd_readblock(void)
+static void cmd_readblock(ticks_context *ctx)
 {
     int   ret = -1;
 
     CHECK_FD();
 
-    ret = read(slots[b], (char *)get_memory_addr(e | d << 8), (l | h <<8));
+    ret = read(ctx->slots[ctx->b], (char *)get_memory_addr(ctx, ctx->e | ctx->d << 8), (ctx->l | ctx->h <<8));
+    block_flush(ctx);
     if ( ret != -1 ) {
         SET_ERROR(Z88DK_ENONE);
     } else {
         SET_ERROR(normalise_errno());
     }
-    l = ret % 256;
-    h = ret / 256;
+    ctx->l = ret % 256;
+    ctx->h = ret / 256;
 }
 
-static void cmd_seek(void)
+static void cmd_seek(ticks_context *ctx)
 {
     off_t  ret;
-    off_t  dest = ( ( e | d << 8) << 16 ) | (l | h << 8);
+    off_t  dest = ( ( ctx->e | ctx->d << 8) << 16 ) | (ctx->l | ctx->h << 8);
     int    whence = -1;
 
     CHECK_FD();
 
-    switch ( c ) {
+    switch ( ctx->c ) {
     case Z88DK_SEEK_SET:
         whence = SEEK_SET;
         break;
@@ -193,56 +190,57 @@ static void cmd_seek(void)
     }
 
 
-    ret = lseek(slots[b], dest, whence);
+    ret = lseek(ctx->slots[ctx->b], dest, whence);
 
     if ( ret != -1 ) {
         int t = ( ret >> 16 ) & 0xffff;
-        e = t % 256;
-        e = t / 256;
+        ctx->e = t % 256;
+        ctx->e = t / 256;
         t = ( ret >> 0 ) & 0xffff;
-        l = t % 256;
-        h = t / 256;
+        ctx->l = t % 256;
+        ctx->h = t / 256;
         SET_ERROR(Z88DK_ENONE);
     } else {
         SET_ERROR(normalise_errno());
     }
 }
 
-static void cmd_ide_identify(void)
+static void cmd_ide_identify(ticks_context *ctx)
 {
 
 }
 
-static void cmd_ide_select(void)
+static void cmd_ide_select(ticks_context *ctx)
 {
-    selected_unit = l & 1;
+    ctx->selected_unit = ctx->l & 1;
 
     SET_ERROR(Z88DK_ENONE);
 }
 
-static void cmd_ide_read(void)
+static void cmd_ide_read(ticks_context *ctx)
 {
-    off_t  dest = (( ( c | b << 8) << 16 ) | (l | h << 8)) * 512;
+    off_t  dest = (( ( ctx->c | ctx->b << 8) << 16 ) | (ctx->l | ctx->h << 8)) * 512;
 
-    if ( lseek(devices[selected_unit], dest, SEEK_SET) != dest ) {
+    if ( lseek(devices[ctx->selected_unit], dest, SEEK_SET) != dest ) {
         SET_ERROR(normalise_errno());
         return;
     }
-    if ( read(devices[selected_unit], (char *)get_memory_addr((e | d << 8)), 512) != 512 ) {
+    if ( read(devices[ctx->selected_unit], (char *)get_memory_addr(ctx, (ctx->e | ctx->d << 8)), 512) != 512 ) {
         SET_ERROR(normalise_errno());
     }
+    block_flush(ctx);
     SET_ERROR(Z88DK_ENONE);
 }
 
-static void cmd_ide_write(void)
+static void cmd_ide_write(ticks_context *ctx)
 {
-    off_t  dest = (( ( c | b << 8) << 16 ) | (l | h << 8)) * 512;
+    off_t  dest = (( ( ctx->c | ctx->b << 8) << 16 ) | (ctx->l | ctx->h << 8)) * 512;
 
-    if ( lseek(devices[selected_unit], dest, SEEK_SET) != dest ) {
+    if ( lseek(devices[ctx->selected_unit], dest, SEEK_SET) != dest ) {
         SET_ERROR(normalise_errno());
         return;
     }
-    if ( write(devices[selected_unit], (char *)get_memory_addr((e | d << 8)), 512) != 512 ) {
+    if ( write(devices[ctx->selected_unit], (char *)get_memory_addr(ctx, (ctx->e | ctx->d << 8)), 512) != 512 ) {
         SET_ERROR(normalise_errno());
     }
     SET_ERROR(Z88DK_ENONE);
@@ -257,18 +255,36 @@ void hook_io_set_ide_device(int unit, const char *file)
     }
 }
 
-void hook_io_init(hook_command *cmds)
+void hook_io_context_init(ticks_context *ctx)
 {
     int  i;
 
-    /* Reserve slots that are usually used for std* */
-    slots[0] = fileno(stdin);
-    slots[1] = fileno(stdout);
-    slots[2] = fileno(stderr);
+    /* Reserve slots that are usually used for std*, when the console
+       output of the program goes to a file so does its stderr */
+    ctx->slots[0] = fileno(stdin);
+    ctx->slots[1] = fileno(ctx->output);
+    ctx->slots[2] = ctx->output == stdout ? fileno(stderr) : fileno(ctx->output);
     for (i = 3; i < NUM_SLOTS; i++ ) {
-        slots[i] = -1;
+        ctx->slots[i] = -1;
     }
+    ctx->selected_unit = 0;
+}
 
+/* Close the files left open by the program */
+void hook_io_context_free(ticks_context *ctx)
+{
+    int  i;
+
+    for (i = 3; i < NUM_SLOTS; i++ ) {
+        if ( ctx->slots[i] != -1 ) {
+            close(ctx->slots[i]);
+            ctx->slots[i] = -1;
+        }
+    }
+}
+
+void hook_io_init(hook_command *cmds)
+{
     cmds[CMD_OPENF] = cmd_openfile;
     cmds[CMD_CLOSEF] = cmd_closefile;
     cmds[CMD_WRITEBYTE] = cmd_writebyte;
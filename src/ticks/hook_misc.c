@@ -4,17 +4,17 @@
 #include <time.h>
 
 
-static void cmd_gettime(void)
+static void cmd_gettime(ticks_context *ctx)
 {
     time_t  tim = time(NULL);
     int     t;
 
     t = (tim % 65536);
-    l = t % 256;
-    h = t / 256;
+    ctx->l = t % 256;
+    ctx->h = t / 256;
     t = (tim / 65536);
-    e = t % 256;
-    d = t / 256;
+    ctx->e = t % 256;
+    ctx->d = t / 256;
 
     SET_ERROR(Z88DK_ENONE);
 }
@@ -4,197 +4,264 @@
 
 #include "ticks.h"
 #include <stdio.h>
-
-
-
-typedef uint8_t *(*memory_func)(int pc);
-
-
-static void     standard_init(void);
-static uint8_t *standard_get_memory_addr(int pc);
-static void     zxn_init(void);
-static uint8_t *zxn_get_memory_addr(int pc);
-static void     zxn_handle_out(int port, int value);
-static void     zx_init(char *config);
-static uint8_t *zx_get_memory_addr(int pc);
-static void     zx_handle_out(int port, int value);
-static void     z180_init(void);
-static uint8_t *z180_get_memory_addr(int pc);
-static void     z180_handle_out(int port, int value);
-
-static unsigned char *mem;
-static unsigned char  zxnext_mmu[8] = {0xff};
-static unsigned char *zxn_banks[256];
-
-static unsigned char  zx_pages[4] = { 0x11, 0x05, 0x02, 0x00 };
-static unsigned char *zx_banks[8];
-static unsigned char *zx_rom[2];
-
-static memory_func   get_mem_addr;
-static void        (*handle_out)(int port, int value);
-
-void memory_init(char *model) {
-    memory_reset_paging();
+#include <stdlib.h>
+#include <string.h>
+
+
+
+/* The memory of a context and the state of its paging hardware */
+struct memory_state {
+    unsigned char  *mem;
+    unsigned char   zxnext_mmu[8];
+    unsigned char  *zxn_banks[256];
+    int             zxn_nextport;
+
+    unsigned char   zx_pages[4];
+    unsigned char  *zx_banks[8];
+    unsigned char  *zx_rom[2];
+    int             zx_locked;
+
+    uint8_t        *z180_mem;
+    uint8_t         z180_CBAR;
+    uint8_t         z180_CBR;
+    uint8_t         z180_BBR;
+
+    void          (*map_pages)(ticks_context *ctx);
+    void          (*handle_out)(ticks_context *ctx, int port, int value);
+};
+
+static void     standard_init(ticks_context *ctx);
+static void     standard_map_pages(ticks_context *ctx);
+static void     zxn_init(ticks_context *ctx);
+static void     zxn_map_pages(ticks_context *ctx);
+static void     zxn_handle_out(ticks_context *ctx, int port, int value);
+static void     zx_init(ticks_context *ctx, char *config);
+static void     zx_map_pages(ticks_context *ctx);
+static void     zx_handle_out(ticks_context *ctx, int port, int value);
+static void     z180_init(ticks_context *ctx);
+static void     z180_map_pages(ticks_context *ctx);
+static void     z180_handle_out(ticks_context *ctx, int port, int value);
+
+void memory_init(ticks_context *ctx, char *model) {
+    memory_state *m = calloc(1, sizeof(*m));
+
+    m->zx_pages[0] = 0x11;
+    m->zx_pages[1] = 0x05;
+    m->zx_pages[2] = 0x02;
+    m->zx_pages[3] = 0x00;
+    m->z180_CBAR = 0xf0;
+    ctx->memory = m;
+    memory_reset_paging(ctx);
 
     if ( strcmp(model,"zxn") == 0 ) {
-        zxn_init();
+        zxn_init(ctx);
     } else if ( strncmp(model, "zx128", 5) == 0 ) {
-        zx_init(model + 5);
+        zx_init(ctx, model + 5);
     } else if ( strcmp(model,"standard") == 0 ) {
-        standard_init();
+        standard_init(ctx);
     } else if ( strcmp(model, "z180") == 0 ) {
-        z180_init();
+        z180_init(ctx);
     } else {
         fprintf(stderr, "Unknown memory model %s\n",model);
         exit(1);
     }
 }
 
-uint8_t get_memory(int pc)
+void memory_free(ticks_context *ctx)
 {
-  return  *get_memory_addr(pc);
+    memory_state *m = ctx->memory;
+    int           i;
+
+    if ( m == NULL ) {
+        return;
+    }
+    free(m->mem);
+    for ( i = 0; i < 256; i++ ) {
+        free(m->zxn_banks[i]);
+    }
+    for ( i = 0; i < 8; i++ ) {
+        free(m->zx_banks[i]);
+    }
+    for ( i = 0; i < 2; i++ ) {
+        free(m->zx_rom[i]);
+    }
+    free(m->z180_mem);
+    free(m);
+    ctx->memory = NULL;
+}
+
+uint8_t get_memory(ticks_context *ctx, int pc)
+{
+  return  *MEMORY_ADDR(ctx, pc);
 }
 
-uint8_t put_memory(int pc, uint8_t b)
+uint8_t put_memory(ticks_context *ctx, int pc, uint8_t b)
 {
   if (pc < rom_size)
-    return *get_memory_addr(pc);
-  else
-    return *get_memory_addr(pc) = b;
+    return *MEMORY_ADDR(ctx, pc);
+  if ( ctx->blocks && ctx->blocks->code[pc & 0xffff] )
+    block_invalidate(ctx, pc & 0xffff);
+  return *MEMORY_ADDR(ctx, pc) = b;
 }
 
-uint8_t *get_memory_addr(int pc)
+uint8_t *get_memory_addr(ticks_context *ctx, int pc)
 {
-    return get_mem_addr(pc);
+    return MEMORY_ADDR(ctx, pc);
 }
 
-void memory_handle_paging(int port, int value)
+void memory_handle_paging(ticks_context *ctx, int port, int value)
 {
-    if  ( handle_out ) {
-        handle_out(port,value);
+    if  ( ctx->memory->handle_out ) {
+        ctx->memory->handle_out(ctx, port,value);
+        block_check_paging(ctx);
     }
 }
 
-void memory_reset_paging() 
+void memory_reset_paging(ticks_context *ctx) 
 {
     int i;
     for ( i = 0; i < 8; i++ )  {
-        zxnext_mmu[i] = 0xff;
+        ctx->memory->zxnext_mmu[i] = 0xff;
+    }
+    if ( ctx->memory->map_pages ) {
+        ctx->memory->map_pages(ctx);
+        block_check_paging(ctx);
     }
 }
 
 // Z180 MMU support
-static uint8_t *z180_mem = NULL;
-static uint8_t z180_CBAR = 0xf0;
-static uint8_t z180_CBR = 0x00;
-static uint8_t z180_BBR = 0x00;
 
 #define Z180_IO_CBR 56
 #define Z180_IO_BBR 57
 #define Z180_IO_CBAR 58
 
-static uint8_t *z180_get_memory_addr(int pc)
+static void z180_map_pages(ticks_context *ctx)
 {
+    memory_state *m = ctx->memory;
     /*
     CBAR is an 8 bit I/O port that can be accessed by the processor's OUT and IN instructions. 
     The lower 4 bits specify the starting address of the bank area, and the upper 4 give the start of common 1. 
    */
-    // Are we in bank area?
-    int bank_start = ((z180_CBAR) & 0x0f) << 12;
-    int common1_start =  ((z180_CBAR) & 0xf0) << 8;
-    if ( pc >= bank_start && pc < common1_start ) {
-        // Bank area
-        // Physical = Logical + (BBR * 4096)
-        return &z180_mem[ (pc & 0x0fff) + (z180_BBR * 4096)];
-    } else if ( pc >= common1_start ) {
-        // Common 1
-        // Physical = Logical + (CBR * 4096)
-        return &z180_mem[ (pc & 0x0fff) + (z180_CBR * 4096)];
+    int bank_start = ((m->z180_CBAR) & 0x0f) << 12;
+    int common1_start =  ((m->z180_CBAR) & 0xf0) << 8;
+    int i, addr;
+
+    for ( i = 0; i < MEMORY_PAGES; i++ ) {
+        addr = i * MEMORY_PAGE_SIZE;
+        if ( addr >= bank_start && addr < common1_start ) {
+            // Bank area
+            // Physical = Logical + (BBR * 4096)
+            ctx->memory_pages[i] = &m->z180_mem[m->z180_BBR * 4096];
+        } else if ( addr >= common1_start ) {
+            // Common 1
+            // Physical = Logical + (CBR * 4096)
+            ctx->memory_pages[i] = &m->z180_mem[m->z180_CBR * 4096];
+        } else {
+            // Otherwise, it's common 0
+            ctx->memory_pages[i] = &m->z180_mem[addr];
+        }
     }
-    // Otherwise, it's common 0
-    return &z180_mem[pc & 0xffff];
 }
 
-static void z180_handle_out(int port, int value)
+static void z180_handle_out(ticks_context *ctx, int port, int value)
 {
+    memory_state *m = ctx->memory;
+
     switch (port) {
     case Z180_IO_CBR:
-        z180_CBR = value;
+        m->z180_CBR = value;
         break;
     case Z180_IO_BBR:
-        z180_BBR = value;
+        m->z180_BBR = value;
         break;
     case Z180_IO_CBAR:
-        z180_CBAR = value;
+        m->z180_CBAR = value;
         break;
+    default:
+        return;
     }
+    z180_map_pages(ctx);
 }
 
-static void z180_init(void) 
+static void z180_init(ticks_context *ctx) 
 {
-    z180_mem = calloc(1024*1024, sizeof(char));
-    get_mem_addr = z180_get_memory_addr;
-    handle_out = z180_handle_out;
+    memory_state *m = ctx->memory;
+
+    m->z180_mem = calloc(1024*1024, sizeof(char));
+    m->map_pages = z180_map_pages;
+    m->handle_out = z180_handle_out;
+    z180_map_pages(ctx);
 }
 
 
 
 // Standard, 64k flat address space
-static void standard_init(void) 
+static void standard_init(ticks_context *ctx) 
 {
-    mem = calloc(65536, 1);
-    get_mem_addr = standard_get_memory_addr;
+    memory_state *m = ctx->memory;
+
+    m->mem = calloc(65536, 1);
+    m->map_pages = standard_map_pages;
+    standard_map_pages(ctx);
 }
 
 
-static uint8_t *standard_get_memory_addr(int pc)
+static void standard_map_pages(ticks_context *ctx)
 {
-  int segment = pc / 8192;
-  pc &= 0xffff;
+  int i;
 
-  return &mem[pc & 65535];
+  for ( i = 0; i < MEMORY_PAGES; i++ ) {
+    ctx->memory_pages[i] = &ctx->memory->mem[i * MEMORY_PAGE_SIZE];
+  }
 }
 
 
 // ZXN: 256 pages of 8k, paged in at any 8k boundary
-static void zxn_init(void) 
+static void zxn_init(ticks_context *ctx) 
 {
+    memory_state *m = ctx->memory;
     int  i;
 
     for ( i = 0; i < 256; i++ ) {
-        zxn_banks[i] = calloc(8192,1);
+        m->zxn_banks[i] = calloc(8192,1);
     }
 
 
-    standard_init();
-    get_mem_addr = zxn_get_memory_addr;
-    handle_out = zxn_handle_out;
+    standard_init(ctx);
+    m->map_pages = zxn_map_pages;
+    m->handle_out = zxn_handle_out;
+    zxn_map_pages(ctx);
 }
 
-static uint8_t *zxn_get_memory_addr(int pc)
+static void zxn_map_pages(ticks_context *ctx)
 {
-  int segment = pc / 8192;
-  pc &= 0xffff;
+  memory_state *m = ctx->memory;
+  int i, segment;
 
-  if ( zxnext_mmu[segment] != 0xff ) {
-    return &zxn_banks[zxnext_mmu[segment]][pc % 8192];
+  for ( i = 0; i < MEMORY_PAGES; i++ ) {
+    segment = i * MEMORY_PAGE_SIZE / 8192;
+    if ( m->zxnext_mmu[segment] != 0xff ) {
+      ctx->memory_pages[i] = &m->zxn_banks[m->zxnext_mmu[segment]][i * MEMORY_PAGE_SIZE % 8192];
+    } else {
+      ctx->memory_pages[i] = &m->mem[i * MEMORY_PAGE_SIZE];
+    }
   }
-  return &mem[pc & 65535];
 }
 
 
-static void zxn_handle_out(int port, int value)
+static void zxn_handle_out(ticks_context *ctx, int port, int value)
 {
-  static int nextport = 0;
+  memory_state *m = ctx->memory;
 
-  if ( port == 0x243B && nextport == 0 ) {
-      nextport = value;
+  if ( port == 0x243B && m->zxn_nextport == 0 ) {
+      m->zxn_nextport = value;
       return;
   }
-  if ( nextport >= 0x50 && nextport <= 0x57 ) {
-    zxnext_mmu[nextport - 0x50] = value;
+  if ( m->zxn_nextport >= 0x50 && m->zxn_nextport <= 0x57 ) {
+    m->zxnext_mmu[m->zxn_nextport - 0x50] = value;
+    zxn_map_pages(ctx);
   }
-  nextport = 0;
+  m->zxn_nextport = 0;
   return;
 }
 
@@ -216,66 +283,74 @@ static void load_rom(char *filename, unsigned char *buf, size_t len)
 }
 
 // ZX128: 8 pages of 16k @ 0xc000 + 2 rom slots
-static void zx_init(char *config) 
+static void zx_init(ticks_context *ctx, char *config) 
 {
+    memory_state *m = ctx->memory;
     int  i;
 
     for ( i = 0; i < 8; i++ ) {
-        zx_banks[i] = calloc(16384,1);
+        m->zx_banks[i] = calloc(16384,1);
     }
 
     for ( i = 0; i < 2; i++ ) {
-        zx_rom[i] = calloc(16384,1);
+        m->zx_rom[i] = calloc(16384,1);
     }
 
-    get_mem_addr = zx_get_memory_addr;
-    handle_out = zx_handle_out;
+    m->map_pages = zx_map_pages;
+    m->handle_out = zx_handle_out;
+    zx_map_pages(ctx);
 
     if ( *config == ',') {
-        char *ptr = strchr(config+1,',');
-        config++;
-        // We've got some ROM loading config coming up
+        // We've got some ROM loading config coming up, the model is
+        // shared by all the contexts so it is split in a copy
+        char *roms = strdup(config + 1);
+        char *ptr = strchr(roms,',');
+
         if ( ptr != NULL ) {
             *ptr = 0;
         }
-        load_rom(config, zx_rom[0], 16384);
+        load_rom(roms, m->zx_rom[0], 16384);
         if ( ptr != NULL ) {
-            load_rom(ptr + 1, zx_rom[1], 16384);
+            load_rom(ptr + 1, m->zx_rom[1], 16384);
         }
+        free(roms);
     }
 }
 
-static uint8_t *zx_get_memory_addr(int pc)
+static void zx_map_pages(ticks_context *ctx)
 {
-    int segment = pc / 16384;
-    int bank = zx_pages[segment];
+    memory_state *m = ctx->memory;
+    int i, bank;
 
-    pc &= 0xffff;
+    for ( i = 0; i < MEMORY_PAGES; i++ ) {
+        bank = m->zx_pages[i * MEMORY_PAGE_SIZE / 16384];
 
-    if ( bank >= 0x10 ) {
-        return &zx_rom[bank - 0x10][pc % 16384];
+        if ( bank >= 0x10 ) {
+            ctx->memory_pages[i] = &m->zx_rom[bank - 0x10][i * MEMORY_PAGE_SIZE % 16384];
+        } else {
+            ctx->memory_pages[i] = &m->zx_banks[bank][i * MEMORY_PAGE_SIZE % 16384];
+        }
     }
-
-    return &zx_banks[bank][pc % 16384];
 }
 
 
-static void zx_handle_out(int port, int value)
+static void zx_handle_out(ticks_context *ctx, int port, int value)
 {
-  static int locked = 0;
+  memory_state *m = ctx->memory;
 
-  if ( port == 0x7ffd && !locked ) {
+  if ( port == 0x7ffd && !m->zx_locked ) {
       if ( value & 0x20 ) {
-          locked = 1;
+          m->zx_locked = 1;
           return;
       }
-      zx_pages[3] = value & 0x07;
+      m->zx_pages[3] = value & 0x07;
 
       if ( value & 16 ) {
-          zx_pages[0] = 0x10; // 128k ROM
+          m->zx_pages[0] = 0x10; // 128k ROM
       } else {
-          zx_pages[0] = 0x11; // 48k ROM
+          m->zx_pages[0] = 0x11; // 48k ROM
       }
+      zx_map_pages(ctx);
   }
   return;
 }
@@ -0,0 +1,421 @@
+/*
+ * Profiler for ticks
+ *
+ * Cycles are accounted to the instruction that used them and to the node of
+ * the call tree that was executing. The call tree follows CALL and RST
+ * instructions that pushed their return address, a frame is left when the
+ * stack pointer moves above the slot of its return address (RET, or popping
+ * it and jumping), and a jump to a public label is taken as a tail call.
+ * Interrupts are accounted to the code they interrupted.
+ *
+ * At exit a report with the flat profile, the source lines and the call
+ * graph is written, or the collapsed stacks used by flamegraph.pl when the
+ * file name ends with .folded or .collapsed
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ticks.h"
+
+typedef struct pnode pnode;
+
+struct pnode {
+    int         entry;          /* Address of the function, -1 for the root */
+    pnode      *parent;
+    pnode      *children;
+    pnode      *sibling;
+    long long   calls;
+    long long   self;           /* Cycles spent in this function at this point of the tree */
+    long long   total;          /* Including the functions called */
+};
+
+typedef struct {
+    pnode      *caller;
+    int         sp;             /* Where the return address was pushed */
+} pframe;
+
+typedef struct {
+    int         entry;
+    long long   calls;
+    long long   self;
+    long long   total;
+} pfunc;
+
+typedef struct {
+    const char *file;
+    int         line;
+    long long   cycles;
+    long long   count;
+} pline;
+
+typedef struct {
+    int         caller;
+    int         callee;
+    long long   calls;
+    long long   cycles;
+} pedge;
+
+       int        profiler_enabled = 0;
+static ticks_context *ctx;          /* The context being profiled */
+static char      *outputs[4];
+static int        num_outputs = 0;
+
+static long long  addr_cycles[65536];
+static long long  addr_count[65536];
+static char       is_entry[65536];
+
+static pnode      root = { -1 };
+static pnode     *current;
+static pframe    *frames;
+static int        frames_size;
+static int        depth;
+static int        last_pc = -1;
+static int        last_sp;
+static long long  last_st;
+
+static void       profiler_write(void);
+
+
+void profiler_init(ticks_context *context, char *filename)
+{
+    if ( num_outputs == sizeof(outputs) / sizeof(outputs[0]) ) {
+        fprintf(stderr, "Too many profile files\n");
+        exit(1);
+    }
+    if ( num_outputs == 0 ) {
+        atexit(profiler_write);
+    }
+    outputs[num_outputs++] = filename;
+    profiler_enabled = 1;
+    ctx = context;
+}
+
+
+static pnode *get_child(pnode *parent, int entry)
+{
+    pnode *node;
+
+    for ( node = parent->children; node != NULL; node = node->sibling ) {
+        if ( node->entry == entry ) {
+            return node;
+        }
+    }
+    node = calloc(1, sizeof(*node));
+    node->entry = entry;
+    node->parent = parent;
+    node->sibling = parent->children;
+    parent->children = node;
+    return node;
+}
+
+
+/* Is the return address of a call or rst at last_pc on the top of the stack? */
+static int call_taken(void)
+{
+    int op = get_memory(ctx, last_pc);
+    int len;
+
+    if ( op == 0xcd || (op & 0xc7) == 0xc4 ) {
+        len = 3;
+    } else if ( (op & 0xc7) == 0xc7 ) {
+        len = 1;
+    } else {
+        return 0;
+    }
+    return ctx->sp == ((last_sp - 2) & 0xffff) &&
+           (get_memory(ctx, ctx->sp) | get_memory(ctx, ctx->sp + 1) << 8) == ((last_pc + len) & 0xffff) &&
+           ctx->pc != ((last_pc + len) & 0xffff);
+}
+
+
+/* Called before each instruction */
+void profiler_step(void)
+{
+    long long  cycles;
+    int        i;
+
+    if ( last_pc == -1 ) {
+        for ( i = 0; i < 65536; i++ ) {
+            is_entry[i] = is_public_label(i);
+        }
+        current = get_child(&root, ctx->pc);
+        current->calls++;
+    } else {
+        // st is reset at the -start address
+        cycles = ctx->st >= last_st ? ctx->st - last_st : ctx->st;
+        addr_cycles[last_pc] += cycles;
+        addr_count[last_pc]++;
+        current->self += cycles;
+
+        if ( call_taken() ) {
+            if ( depth == frames_size ) {
+                frames_size = frames_size ? frames_size * 2 : 256;
+                frames = realloc(frames, frames_size * sizeof(*frames));
+            }
+            frames[depth].caller = current;
+            frames[depth].sp = ctx->sp;
+            depth++;
+            is_entry[ctx->pc] = 1;
+            current = get_child(current, ctx->pc);
+            current->calls++;
+        } else {
+            // Leave the frames whose return address has been popped
+            while ( depth > 0 && (unsigned)((ctx->sp - frames[depth - 1].sp) & 0xffff) - 1 < 0x8000 ) {
+                current = frames[--depth].caller;
+            }
+            if ( is_entry[ctx->pc] && ctx->pc != current->entry ) {
+                current = get_child(current->parent, ctx->pc);
+                current->calls++;
+            }
+        }
+    }
+    last_pc = ctx->pc;
+    last_sp = ctx->sp;
+    last_st = ctx->st;
+}
+
+
+static const char *function_name(int entry, char *buf, size_t len)
+{
+    const char *name = find_label(entry);
+
+    if ( name == NULL ) {
+        snprintf(buf, len, "$%04x", entry);
+        return buf;
+    }
+    return name;
+}
+
+
+/* Work out the totals of the tree, a function that is already on the
+   path above a node is not counted again in the totals of the functions */
+static long long sum_tree(pnode *node, pfunc *funcs)
+{
+    pnode     *child, *up;
+
+    node->total = node->self;
+    for ( child = node->children; child != NULL; child = child->sibling ) {
+        node->total += sum_tree(child, funcs);
+    }
+    if ( node->entry >= 0 ) {
+        funcs[node->entry].entry = node->entry;
+        funcs[node->entry].calls += node->calls;
+        funcs[node->entry].self += node->self;
+        for ( up = node->parent; up != NULL && up->entry != node->entry; up = up->parent )
+            ;
+        if ( up == NULL ) {
+            funcs[node->entry].total += node->total;
+        }
+    }
+    return node->total;
+}
+
+
+static void collect_edges(pnode *node, pedge **edges, int *num, int *size)
+{
+    pnode *child;
+    int    i;
+
+    for ( child = node->children; child != NULL; child = child->sibling ) {
+        if ( node->entry >= 0 ) {
+            for ( i = 0; i < *num; i++ ) {
+                if ( (*edges)[i].caller == node->entry && (*edges)[i].callee == child->entry ) {
+                    break;
+                }
+            }
+            if ( i == *num ) {
+                if ( *num == *size ) {
+                    *size = *size ? *size * 2 : 256;
+                    *edges = realloc(*edges, *size * sizeof(**edges));
+                }
+                memset(&(*edges)[i], 0, sizeof(**edges));
+                (*edges)[i].caller = node->entry;
+                (*edges)[i].callee = child->entry;
+                (*num)++;
+            }
+            (*edges)[i].calls += child->calls;
+            (*edges)[i].cycles += child->total;
+        }
+        collect_edges(child, edges, num, size);
+    }
+}
+
+
+static int func_compare(const void *p1, const void *p2)
+{
+    const pfunc *f1 = p1, *f2 = p2;
+
+    if ( f1->self != f2->self ) {
+        return f1->self < f2->self ? 1 : -1;
+    }
+    return f1->entry - f2->entry;
+}
+
+static int line_compare(const void *p1, const void *p2)
+{
+    const pline *l1 = p1, *l2 = p2;
+
+    if ( l1->cycles != l2->cycles ) {
+        return l1->cycles < l2->cycles ? 1 : -1;
+    }
+    return l1->line - l2->line;
+}
+
+static int edge_compare(const void *p1, const void *p2)
+{
+    const pedge *e1 = p1, *e2 = p2;
+
+    if ( e1->cycles != e2->cycles ) {
+        return e1->cycles < e2->cycles ? 1 : -1;
+    }
+    return e1->callee - e2->callee;
+}
+
+
+static void write_report(FILE *fp, pfunc *funcs, int num_funcs, long long total)
+{
+    char        buf[20], buf2[20];
+    pedge      *edges = NULL;
+    pline      *lines = NULL;
+    int         num_edges = 0, size_edges = 0, num_lines = 0;
+    int         i, j, lineno;
+    const char *file;
+    double      scale = total ? 100.0 / total : 0;
+
+    fprintf(fp, "Flat profile, %lld cycles\n\n", total);
+    fprintf(fp, "%6s %14s %6s %14s %10s  %s\n", "%self", "self", "%total", "total", "calls", "function");
+    for ( i = 0; i < num_funcs; i++ ) {
+        fprintf(fp, "%6.2f %14lld %6.2f %14lld %10lld  %s\n",
+            funcs[i].self * scale, funcs[i].self, funcs[i].total * scale, funcs[i].total,
+            funcs[i].calls, function_name(funcs[i].entry, buf, sizeof(buf)));
+    }
+
+    // Account each instruction to its source line
+    for ( i = 0; i < 65536; i++ ) {
+        if ( addr_count[i] == 0 || (file = find_source_line(i, &lineno)) == NULL ) {
+            continue;
+        }
+        for ( j = num_lines - 1; j >= 0; j-- ) {
+            if ( lines[j].line == lineno && strcmp(lines[j].file, file) == 0 ) {
+                break;
+            }
+        }
+        if ( j < 0 ) {
+            lines = realloc(lines, (num_lines + 1) * sizeof(*lines));
+            j = num_lines++;
+            lines[j].file = file;
+            lines[j].line = lineno;
+            lines[j].cycles = lines[j].count = 0;
+        }
+        lines[j].cycles += addr_cycles[i];
+        lines[j].count += addr_count[i];
+    }
+    qsort(lines, num_lines, sizeof(*lines), line_compare);
+
+    fprintf(fp, "\n\nSource lines\n\n");
+    if ( num_lines == 0 ) {
+        fprintf(fp, "No line information, assemble with --debug\n");
+    } else {
+        fprintf(fp, "%6s %14s %12s  %s\n", "%", "cycles", "executed", "line");
+        for ( i = 0; i < num_lines; i++ ) {
+            fprintf(fp, "%6.2f %14lld %12lld  %s:%d\n", lines[i].cycles * scale, lines[i].cycles,
+                lines[i].count, lines[i].file, lines[i].line);
+        }
+    }
+    free(lines);
+
+    collect_edges(&root, &edges, &num_edges, &size_edges);
+    qsort(edges, num_edges, sizeof(*edges), edge_compare);
+
+    fprintf(fp, "\n\nCall graph, cycles include the functions called\n");
+    for ( i = 0; i < num_funcs; i++ ) {
+        fprintf(fp, "\n%s: %lld cycles, %lld self, %lld calls\n", function_name(funcs[i].entry, buf, sizeof(buf)),
+            funcs[i].total, funcs[i].self, funcs[i].calls);
+        for ( j = 0; j < num_edges; j++ ) {
+            if ( edges[j].callee == funcs[i].entry ) {
+                fprintf(fp, "    called by %-30s %10lld calls %14lld cycles\n",
+                    function_name(edges[j].caller, buf2, sizeof(buf2)), edges[j].calls, edges[j].cycles);
+            }
+        }
+        for ( j = 0; j < num_edges; j++ ) {
+            if ( edges[j].caller == funcs[i].entry ) {
+                fprintf(fp, "    calls     %-30s %10lld calls %14lld cycles\n",
+                    function_name(edges[j].callee, buf2, sizeof(buf2)), edges[j].calls, edges[j].cycles);
+            }
+        }
+    }
+    free(edges);
+}
+
+
+static void write_stacks(FILE *fp, pnode *node, char *path, size_t len, size_t size)
+{
+    char        buf[20];
+    const char *name;
+    pnode      *child;
+    size_t      n = len;
+
+    if ( node->entry >= 0 ) {
+        name = function_name(node->entry, buf, sizeof(buf));
+        n = len + strlen(name) + (len != 0);
+        if ( n >= size ) {
+            return;
+        }
+        sprintf(path + len, "%s%s", len ? ";" : "", name);
+        if ( node->self ) {
+            fprintf(fp, "%s %lld\n", path, node->self);
+        }
+    }
+    for ( child = node->children; child != NULL; child = child->sibling ) {
+        write_stacks(fp, child, path, n, size);
+    }
+    path[len] = 0;
+}
+
+
+static void profiler_write(void)
+{
+    static char path[8192];
+    pfunc      *funcs;
+    long long   total;
+    size_t      len;
+    FILE       *fp;
+    int         i, num_funcs = 0;
+
+    if ( last_pc == -1 ) {
+        return;
+    }
+
+    // The instruction that was executing at exit
+    profiler_enabled = 0;
+    addr_cycles[last_pc] += ctx->st >= last_st ? ctx->st - last_st : ctx->st;
+    addr_count[last_pc]++;
+    current->self += ctx->st >= last_st ? ctx->st - last_st : ctx->st;
+
+    funcs = calloc(65536, sizeof(*funcs));
+    total = sum_tree(&root, funcs);
+    for ( i = 0; i < 65536; i++ ) {
+        if ( funcs[i].calls ) {
+            funcs[num_funcs++] = funcs[i];
+        }
+    }
+    qsort(funcs, num_funcs, sizeof(*funcs), func_compare);
+
+    for ( i = 0; i < num_outputs; i++ ) {
+        if ( (fp = fopen(outputs[i], "w")) == NULL ) {
+            fprintf(stderr, "Cannot write profile to %s\n", outputs[i]);
+            continue;
+        }
+        len = strlen(outputs[i]);
+        if ( (len > 7 && strcmp(outputs[i] + len - 7, ".folded") == 0) ||
+             (len > 10 && strcmp(outputs[i] + len - 10, ".collapsed") == 0) ) {
+            write_stacks(fp, &root, path, 0, sizeof(path));
+        } else {
+            write_report(fp, funcs, num_funcs, total);
+        }
+        fclose(fp);
+    }
+    free(funcs);
+}
@@ -10,6 +10,17 @@ static symbol  *symbols_byname = NULL;
 
 static cfile   *cfiles = NULL;
 
+typedef struct {
+    int          address;
+    const char  *file;
+    int          line;
+} srcline;
+
+static srcline *srclines = NULL;      /* Sorted by address, built on first use */
+static int      num_srclines = 0;
+static int      num_symbols = 0;
+static int      num_clines = 0;
+
 static void demangle_filename(const char *input, char *buf, size_t buflen, int *lineno)
 {
     char *start = buf;
@@ -50,6 +61,21 @@ static int symbol_compare(const void *p1, const void *p2)
     return s2->address - s1->address;
 }
 
+/* Get the file and line from the "file:line" at the end of a map file entry */
+static void set_source_line(symbol *sym, const char *word)
+{
+    const char *ptr = strrchr(word, ':');
+    char       *file;
+
+    if ( ptr != NULL && ptr != word && isdigit((unsigned char)ptr[1]) ) {
+        file = malloc(ptr - word + 1);
+        memcpy(file, word, ptr - word);
+        file[ptr - word] = 0;
+        sym->file = file;
+        sym->line = atoi(ptr + 1);
+    }
+}
+
 static void add_cline(const char *filename, int lineno, const char *address)
 {                  
     cfile *cf;
@@ -66,6 +92,7 @@ static void add_cline(const char *filename, int lineno, const char *address)
     cl->line = lineno;
     cl->address = strtol(address + 1, NULL, 16);
     HASH_ADD_INT(cf->lines, line, cl);
+    num_clines++;
 }
 
 void read_symbol_file(char *filename)
@@ -90,6 +117,7 @@ void read_symbol_file(char *filename)
                         LL_APPEND(symbols[sym->address], sym);
                     }
                     HASH_ADD_KEYPTR(hh, symbols_byname, sym->name, strlen(sym->name), sym);
+                    num_symbols++;
                 }
                 free(argv);
                 continue;
@@ -98,12 +126,12 @@ void read_symbol_file(char *filename)
                 symbol *sym = calloc(1,sizeof(*sym));
 
                 sym->name = strdup(argv[0]);
-                sym->file = strdup(argv[8]);
                 sym->section = strdup(argv[8]); // TODO, comma
                 sym->islocal = 0;
-                if ( strcmp(argv[5], "local,")) {
+                if ( strcmp(argv[5], "local,") == 0 ) {
                     sym->islocal = 1;
                 }
+                set_source_line(sym, argv[argc - 1]);
                 sym->symtype = SYM_ADDRESS;
                 if ( strcmp(argv[4],"const,") == 0 ) {
                     sym->symtype = SYM_CONST;
@@ -113,6 +141,7 @@ void read_symbol_file(char *filename)
                     LL_APPEND(symbols[sym->address], sym);
                 }
                 HASH_ADD_KEYPTR(hh, symbols_byname, sym->name, strlen(sym->name), sym);
+                num_symbols++;
             } else {
                 /* It's a cline symbol */
                 char   filename[FILENAME_MAX+1];
@@ -191,6 +220,99 @@ const char *find_symbol(int addr, symboltype preferred_type)
     return NULL;
 }
 
+/* The label to name a function at addr by, public labels are preferred
+   to local ones and line markers are never used */
+const char *find_label(int addr)
+{
+    symbol     *sym;
+    const char *local = NULL;
+
+    if ( addr < 0 ) {
+        return NULL;
+    }
+
+    LL_FOREACH(symbols[addr % 65536], sym) {
+        if ( sym->symtype != SYM_ADDRESS || strncmp(sym->name, "__C_LINE_", 9) == 0 ||
+             strncmp(sym->name, "__ASM_LINE_", 11) == 0 ) {
+            continue;
+        }
+        if ( sym->islocal == 0 ) {
+            return sym->name;
+        }
+        if ( local == NULL ) {
+            local = sym->name;
+        }
+    }
+    return local;
+}
+
+int is_public_label(int addr)
+{
+    symbol *sym;
+
+    LL_FOREACH(symbols[addr % 65536], sym) {
+        if ( sym->symtype == SYM_ADDRESS && sym->islocal == 0 ) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int srcline_compare(const void *p1, const void *p2)
+{
+    const srcline *s1 = p1, *s2 = p2;
+
+    return s1->address - s2->address;
+}
+
+/* Source file and line of the code at addr, taken from the nearest
+   preceding C line or symbol that carries a line */
+const char *find_source_line(int addr, int *lineno)
+{
+    int     lo, hi, mid;
+
+    if ( srclines == NULL ) {
+        symbol *sym, *tmp;
+        cfile  *cf, *cftmp;
+        cline  *cl, *cltmp;
+
+        srclines = calloc(num_symbols + num_clines + 1, sizeof(*srclines));
+        HASH_ITER(hh, cfiles, cf, cftmp) {
+            HASH_ITER(hh, cf->lines, cl, cltmp) {
+                srclines[num_srclines].address = cl->address;
+                srclines[num_srclines].file = cf->file;
+                srclines[num_srclines].line = cl->line;
+                num_srclines++;
+            }
+        }
+        HASH_ITER(hh, symbols_byname, sym, tmp) {
+            if ( sym->file != NULL && sym->symtype == SYM_ADDRESS ) {
+                srclines[num_srclines].address = sym->address;
+                srclines[num_srclines].file = sym->file;
+                srclines[num_srclines].line = sym->line;
+                num_srclines++;
+            }
+        }
+        qsort(srclines, num_srclines, sizeof(*srclines), srcline_compare);
+    }
+
+    lo = 0;
+    hi = num_srclines - 1;
+    while ( lo <= hi ) {
+        mid = (lo + hi) / 2;
+        if ( srclines[mid].address <= addr ) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    if ( hi < 0 ) {
+        return NULL;
+    }
+    *lineno = srclines[hi].line;
+    return srclines[hi].file;
+}
+
 char **parse_words(char *line, int *argc)
 {
     int                 i = 0, j = 0 , n = 0;
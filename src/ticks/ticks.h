@@ -5,6 +5,7 @@
 
 
 #include "cmds.h"
+#include <stdio.h>
 #include <sys/types.h>
 #include <inttypes.h>
 
@@ -22,6 +23,7 @@ typedef struct symbol_s symbol;
 struct symbol_s {
     const char    *name;
     const char    *file;
+    int            line;
     const char    *module;
     int            address;
     symboltype     symtype;
@@ -44,12 +46,85 @@ typedef struct {
     UT_hash_handle hh;
 } cfile;
 
-extern unsigned char a,b,c,d,e,h,l;
-extern unsigned char a_,b_,c_,d_,e_,h_,l_;
-extern unsigned char xh, xl, yh, yl;
-extern unsigned short ff, pc, sp;
-extern long long st;
+/* The address space is mapped in 4k pages, the memory model rebuilds
+   memory_pages[] whenever the paging changes */
+#define MEMORY_PAGE_SIZE   4096
+#define MEMORY_PAGES       16
+#define MEMORY_ADDR(ctx, pc) (&(ctx)->memory_pages[((pc) >> 12) & (MEMORY_PAGES - 1)][(pc) & (MEMORY_PAGE_SIZE - 1)])
 
+#define NUM_SLOTS 256
+
+typedef struct memory_state memory_state;
+
+/* A block is a run of straight-line instructions decoded once, it is
+   executed without the checks that the instruction loop makes before
+   each instruction. See block.c */
+#define BLOCK_MAX_OPS      32
+#define BLOCK_MAX_BYTES    (BLOCK_MAX_OPS * 3)
+
+typedef struct {
+    uint8_t         opcode;
+    uint8_t         n;              /* The byte after the opcode */
+    uint16_t        nn;             /* The two bytes after the opcode */
+    uint16_t        next_pc;        /* Address of the next instruction */
+    uint16_t        cycles;         /* Cycles of the block up to and including this instruction */
+} block_op;
+
+typedef struct block block;
+
+struct block {
+    block          *next;           /* In the list of blocks to be freed */
+    uint16_t        start;
+    uint16_t        len;            /* Bytes of code */
+    uint8_t         branch;         /* The jump, call or return that ends the block, 0 if none */
+    uint16_t        branch_pc;
+    int             cycles;         /* The most cycles that the block can take */
+    int             num_ops;        /* Straight-line instructions before the branch */
+    block_op        instr[];
+};
+
+typedef struct {
+    block          *blocks[65536];  /* The block starting at each address */
+    uint8_t         code[65536];    /* Number of blocks holding each byte */
+    block          *retired;        /* Invalidated blocks, freed before the next block runs */
+    int             invalidated;    /* A block was invalidated while one was running */
+    int             enabled;        /* Not while two pages map the same memory */
+    uint8_t        *pages[MEMORY_PAGES]; /* The paging the blocks were translated with */
+    int             cycles[256];    /* Cycles of each opcode (the most for a branch), -1 until measured */
+    long long       translated;
+    long long       block_ops;      /* Instructions run from blocks */
+} block_cache;
+
+/* The state of an emulated machine, each program runs in its own context
+   so that several of them can run at the same time */
+typedef struct ticks_context ticks_context;
+
+struct ticks_context {
+    unsigned char   a, b, c, d, e, h, l;
+    unsigned char   a_, b_, c_, d_, e_, h_, l_;
+    unsigned char   xh, xl, yh, yl;
+    unsigned char   i, r, r7, ih, iy, iff, im, w, ear, halted, altd, ioi, ioe;
+    unsigned short  ff, pc, sp, mp, t, u;
+    unsigned short  ff_, fa, fa_, fb, fb_, fr, fr_;
+    int             v;
+    long long       st, sttap, stint, counter, ops;
+    uint8_t        *memory_pages[MEMORY_PAGES];
+    memory_state   *memory;
+    block_cache    *blocks;         /* NULL if the cpu has no translated blocks */
+    int             cpu;
+
+    /* Tape in port $FE */
+    int             tap, wavpos, wavlen, mues;
+    FILE           *ft;
+    unsigned char  *tapbuf;
+
+    /* Hooks */
+    FILE           *output;         /* Console output of the program */
+    int             slots[NUM_SLOTS];
+    int             selected_unit;
+    int             exited;         /* The program has exited with exit_code */
+    int             exit_code;
+};
 
 #define is8080() ( (c_cpu & CPU_8080) )
 #define is8085() ( (c_cpu & CPU_8085) )
@@ -73,15 +148,15 @@ extern int debugger_active;
 extern int rom_size;		/* amount of memory in low addresses that is read-only */
 
 /* Break down flags */
-extern int f(void);
-extern int f_(void);
+extern int f(ticks_context *ctx);
+extern int f_(ticks_context *ctx);
 
 #define SET_ERROR(error) do {                   \
         if ( (error) == Z88DK_ENONE ) {           \
-            ff &= ~256;                           \
+            ctx->ff &= ~256;                      \
         } else {                                  \
-            ff |= 256;                            \
-            a = (error);                          \
+            ctx->ff |= 256;                       \
+            ctx->a = (error);                     \
         }                                         \
     } while (0)
 
@@ -116,35 +191,64 @@ extern int f_(void);
 #define Z88DK_ENFILE   5
 #define Z88DK_ENOMEM   6
 
-typedef void (*hook_command)(void);
+typedef void (*hook_command)(ticks_context *ctx);
 
-extern void      PatchZ80(void);
+extern void      PatchZ80(ticks_context *ctx);
 extern void      hook_init(void);
+extern void      hook_context_init(ticks_context *ctx, FILE *output);
+extern void      hook_context_free(ticks_context *ctx);
+extern void      hook_exit(ticks_context *ctx, int code);
 extern void      hook_io_init(hook_command *cmds);
+extern void      hook_io_context_init(ticks_context *ctx);
+extern void      hook_io_context_free(ticks_context *ctx);
 extern void      hook_io_set_ide_device(int unit, const char *file);
 extern void      hook_misc_init(hook_command *cmds);
-extern void      hook_cpm(void);
+extern void      hook_cpm(ticks_context *ctx);
 extern void      hook_console_init(hook_command *cmds);
-extern void      debugger_init();
+extern void      debugger_init(ticks_context *ctx);
 extern void      debugger();
-extern int       disassemble(int pc, char *buf, size_t buflen);
-extern int       disassemble2(int pc, char *buf, size_t buflen);
+extern int       debugger_enabled;
+extern void      profiler_init(ticks_context *ctx, char *filename);
+extern void      profiler_step(void);
+extern int       profiler_enabled;
+extern int       disassemble(ticks_context *ctx, int pc, char *buf, size_t buflen);
+extern int       disassemble2(ticks_context *ctx, int pc, char *buf, size_t buflen);
 extern void      read_symbol_file(char *filename);
 extern const char     *find_symbol(int addr, symboltype preferred_symtype);
+extern const char     *find_label(int addr);
+extern int       is_public_label(int addr);
+extern const char     *find_source_line(int addr, int *lineno);
 extern symbol   *find_symbol_byname(const char *name);
 extern int symbol_resolve(char *name);
 extern char **parse_words(char *line, int *argc);
 
-extern void memory_init(char *model);
-extern void memory_handle_paging(int port, int value);
-extern void memory_reset_paging();
+extern void ticks_context_init(ticks_context *ctx, int cpu);
+extern void ticks_context_free(ticks_context *ctx);
+extern void ticks_load(ticks_context *ctx, FILE *fh, long size, int load_address, int is_com);
+extern void ticks_run(ticks_context *ctx);
+extern int  ticks_parse_cpu(const char *option);
+extern int  batch_run(ticks_context *options, char *manifest, int jobs, char *memory_model, int load_address);
+
+extern block_cache *block_cache_new(ticks_context *ctx);
+extern void block_cache_free(ticks_context *ctx);
+extern void block_add(ticks_context *ctx, block *blk);
+extern void block_invalidate(ticks_context *ctx, int addr);
+extern void block_flush(ticks_context *ctx);
+extern void block_check_paging(ticks_context *ctx);
+extern void block_free_retired(block_cache *cache);
+extern block block_none;
+
+extern void memory_init(ticks_context *ctx, char *model);
+extern void memory_free(ticks_context *ctx);
+extern void memory_handle_paging(ticks_context *ctx, int port, int value);
+extern void memory_reset_paging(ticks_context *ctx);
 
 
-extern void        out(int port, int value);
+extern void        out(ticks_context *ctx, int port, int value);
 
 
-extern uint8_t    *get_memory_addr(int pc);
-extern uint8_t     get_memory(int pc);
-extern uint8_t     put_memory(int pc, uint8_t b);
+extern uint8_t    *get_memory_addr(ticks_context *ctx, int pc);
+extern uint8_t     get_memory(ticks_context *ctx, int pc);
+extern uint8_t     put_memory(ticks_context *ctx, int pc, uint8_t b);
 
 #endif
@@ -419,3 +419,47 @@ void print_assertions(void)
 {
 	HTT_scan(&assertions, print_assert);
 }
+
+/*
+ * save one assertion into the precompiled header
+ */
+static void save_assert(void *va)
+{
+	struct assert *a = va;
+	size_t i;
+
+	pch_put_str(HASH_ITEM_NAME(a));
+	pch_put_num(a->nbval);
+	for (i = 0; i < a->nbval; i ++) pch_put_tokens(a->val + i);
+}
+
+/*
+ * save the assertion table into the precompiled header
+ */
+void save_assertions(void)
+{
+	if (assertions_init_done) HTT_scan(&assertions, save_assert);
+	pch_put_str("");
+}
+
+/*
+ * replace the assertion table with the one from the precompiled header
+ */
+void load_assertions(void)
+{
+	char *name;
+
+	init_assertions();
+	while (*(name = pch_get_str())) {
+		struct assert *a = new_assertion();
+		size_t i;
+
+		a->nbval = pch_get_num();
+		if (a->nbval) {
+			a->val = getmem(a->nbval * sizeof(struct token_fifo));
+			for (i = 0; i < a->nbval; i ++)
+				pch_get_tokens(a->val + i);
+		}
+		HTT_put(&assertions, a, name);
+	}
+}
@@ -42,7 +42,9 @@
 #include <stddef.h>
 #include <limits.h>
 #include <time.h>
+#include <sys/stat.h>
 #include "ucppi.h"
+#include "ucpp.h"
 #include "mem.h"
 #include "nhash.h"
 #ifdef UCPP_MMAP
@@ -321,6 +323,94 @@ static void init_found_files(void)
 	found_files_sys_init_done = 1;
 }
 
+/*
+ * Save the size and date of the files found so far into the
+ * precompiled header; they are compared in check_file_stamps().
+ */
+static void save_file_stamp(void *m)
+{
+	char *name = HASH_ITEM_NAME(m);
+	struct stat st;
+
+	if (stat(name, &st)) return;
+	pch_put_str(name);
+	pch_put_num(st.st_size);
+	pch_put_num(st.st_mtime);
+}
+
+void save_file_stamps(void)
+{
+	HTT_scan(&found_files, save_file_stamp);
+}
+
+static void save_found_file(void *m)
+{
+	struct found_file *ff = m;
+
+	pch_put_str(HASH_ITEM_NAME(ff));
+	pch_put_str(ff->name ? ff->name : "");
+	pch_put_str(ff->protect ? ff->protect : "");
+}
+
+static void save_found_file_sys(void *m)
+{
+	struct found_file_sys *ffs = m;
+
+	pch_put_str(HASH_ITEM_NAME(ffs));
+	pch_put_str(HASH_ITEM_NAME(ffs->rff));
+	pch_put_num(ffs->incdir);
+}
+
+/*
+ * Save the files found and their guard macros into the precompiled
+ * header.
+ */
+void save_found_files(void)
+{
+	HTT_scan(&found_files, save_found_file);
+	pch_put_str("");
+	HTT_scan(&found_files_sys, save_found_file_sys);
+	pch_put_str("");
+}
+
+void load_found_files(void)
+{
+	char *name, *s;
+
+	init_found_files();
+	while (*(name = pch_get_str())) {
+		struct found_file *ff = new_found_file();
+
+		if (*(s = pch_get_str())) ff->name = sdup(s);
+		if (*(s = pch_get_str())) ff->protect = sdup(s);
+		HTT_put(&found_files, ff, name);
+	}
+	while (*(name = pch_get_str())) {
+		struct found_file *ff = HTT_get(&found_files, pch_get_str());
+		int incdir = pch_get_num();
+
+		if (ff) {
+			struct found_file_sys *ffs = new_found_file_sys();
+
+			ffs->rff = ff;
+			ffs->incdir = incdir;
+			HTT_put(&found_files_sys, ffs, name);
+		}
+	}
+}
+
+/*
+ * The include path is part of the key of the precompiled header.
+ */
+void save_include_path(void)
+{
+	size_t i;
+
+	for (i = 0; i < include_path_nb; i ++)
+		pch_put_str(include_path[i]);
+	pch_put_str("");
+}
+
 /*
  * Set the lexer state at the beginning of a file.
  */
@@ -356,6 +446,7 @@ void init_buf_lexer_state(struct lexer_state *ls, int wb)
 	reinit_lexer_state(ls, wb);
 #ifndef NO_UCPP_BUF
 	ls->output_buf = wb ? getmem(OUTPUT_BUF_MEMG) : 0;
+	ls->output_hook = 0;
 #endif
 	ls->sbuf = 0;
 	ls->output_fifo = 0;
@@ -2329,6 +2420,9 @@ static void usage(char *command_name)
 			"output\n"
 	"  -Ma             emit also dependancies for system files\n"
 	"  -o file         store output in file\n"
+	"  -include file   process 'file' before the input file\n"
+	"  -pch file       keep the state after the -include file in the "
+			"snapshot 'file'\n"
 	"macro and assertion options:\n"
 	"  -Dmacro         predefine 'macro'\n"
 	"  -Dmacro=def     predefine 'macro' with 'def' content\n"
@@ -2360,16 +2454,17 @@ static void version(void)
 
 /*
  * parse_opt() initializes many things according to the command-line
- * options.
+ * options. The text output is given to output when it is not null.
  * Return values:
  * 0  on success
  * 1  on semantic error (redefinition of a special macro, for instance)
  * 2  on syntaxic error (unknown options for instance)
  */
-static int parse_opt(int argc, char *argv[], struct lexer_state *ls)
+static int parse_opt(int argc, char *argv[], struct lexer_state *ls,
+	void (*output)(unsigned char *, size_t))
 {
 	int i, ret = 0;
-	char *filename = 0;
+	char *filename = 0, *prefix_header = 0, *pch_file = 0;
 	int with_std_incpath = 0;
 	int print_version = 0, print_defs = 0, print_asserts = 0;
 	int system_macros = 0, standard_assertions = 1;
@@ -2377,6 +2472,11 @@ static int parse_opt(int argc, char *argv[], struct lexer_state *ls)
 	init_lexer_state(ls);
 	ls->flags = DEFAULT_CPP_FLAGS;
 	emit_output = ls->output = stdout;
+	ls->output_hook = output;
+	emit_dependencies = emit_defines = emit_assertions = 0;
+	no_special_macros = 0;
+	c99_compliant = 1;
+	c99_hosted = 1;
 	for (i = 1; i < argc; i ++) if (argv[i][0] == '-') {
 		if (!strcmp(argv[i], "-h")) {
 			return 2;
@@ -2459,6 +2559,18 @@ static int parse_opt(int argc, char *argv[], struct lexer_state *ls)
 				}
 				emit_output = ls->output;
 			}
+		} else if (!strcmp(argv[i], "-include")) {
+			if ((++ i) >= argc) {
+				error(-1, "missing filename after -include");
+				return 2;
+			}
+			prefix_header = argv[i];
+		} else if (!strcmp(argv[i], "-pch")) {
+			if ((++ i) >= argc) {
+				error(-1, "missing filename after -pch");
+				return 2;
+			}
+			pch_file = argv[i];
 		} else if (!strcmp(argv[i], "-v")) {
 			print_version = 1;
 		} else if (argv[i][1] != 'I' && argv[i][1] != 'J'
@@ -2503,10 +2615,8 @@ static int parse_opt(int argc, char *argv[], struct lexer_state *ls)
 #ifdef NO_LIBC_BUF
 		setbuf(ls->input, 0);
 #endif
-		set_init_filename(filename, 1);
 	} else {
 		ls->input = stdin;
-		set_init_filename("<stdin>", 0);
 	}
 	for (i = 1; i < argc; i ++) {
 		if (argv[i][0] == '-' && argv[i][1] == 'I')
@@ -2550,6 +2660,16 @@ static int parse_opt(int argc, char *argv[], struct lexer_state *ls)
 
         }
 
+	if (pch_file && !prefix_header)
+		warning(-1, "-pch has no effect without -include");
+	if (prefix_header && include_prefix(ls, prefix_header, pch_file))
+		return 1;
+	if (filename) {
+		set_init_filename(filename, 1);
+	} else {
+		set_init_filename("<stdin>", 0);
+	}
+
 	if (print_version) {
 		version();
 		return 1;
@@ -2565,19 +2685,27 @@ static int parse_opt(int argc, char *argv[], struct lexer_state *ls)
 	return ret;
 }
 
-int main(int argc, char *argv[])
+/*
+ * ucpp_main() runs ucpp as from the command line argv. When output is
+ * not null, it is given the preprocessed text instead of the output
+ * file. It can be called again for another file.
+ */
+int ucpp_main(int argc, char *argv[],
+	void (*output)(unsigned char *, size_t))
 {
 	struct lexer_state ls;
 	int r, fr = 0;
 
 	init_cpp();
-	if ((r = parse_opt(argc, argv, &ls)) != 0) {
+	if ((r = parse_opt(argc, argv, &ls, output)) != 0) {
 		if (r == 2) usage(argv[0]);
-		return EXIT_FAILURE;
+		fr = 1;
+	} else {
+		enter_file(&ls, ls.flags);
+		while ((r = cpp(&ls)) < CPPERR_EOF) fr = fr || (r > 0);
+		fr = fr || check_cpp_errors(&ls);
 	}
-	enter_file(&ls, ls.flags);
-	while ((r = cpp(&ls)) < CPPERR_EOF) fr = fr || (r > 0);
-	fr = fr || check_cpp_errors(&ls);
+	if (ls.output && ls.output != stdout) fclose(ls.output);
 	free_lexer_state(&ls);
 	wipeout();
 #ifdef MEM_DEBUG
@@ -2585,4 +2713,11 @@ int main(int argc, char *argv[])
 #endif
 	return fr ? EXIT_FAILURE : EXIT_SUCCESS;
 }
+
+#ifndef UCPP_NO_MAIN
+int main(int argc, char *argv[])
+{
+	return ucpp_main(argc, argv, 0);
+}
+#endif
 #endif
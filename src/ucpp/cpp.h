@@ -167,6 +167,7 @@ struct lexer_state {
 
 	/* output control */
 	FILE *output;
+	void (*output_hook)(unsigned char *, size_t);	/* instead of output */
 	struct token_fifo *output_fifo, *toplevel_of;
 #ifndef NO_UCPP_BUF
 	unsigned char *output_buf;
@@ -437,6 +437,11 @@ void flush_output(struct lexer_state *ls)
 	size_t x = ls->sbuf, y = 0, z;
 
 	if (ls->sbuf == 0) return;
+	if (ls->output_hook) {
+		ls->output_hook(ls->output_buf, ls->sbuf);
+		ls->sbuf = 0;
+		return;
+	}
 	do {
 		z = fwrite(ls->output_buf + y, 1, x, ls->output);
 		x -= z;
@@ -1920,3 +1920,68 @@ struct macro *get_macro(char *name)
 {
 	return HTT_get(&macros, name);
 }
+
+/*
+ * save one macro into the precompiled header
+ */
+static void save_macro(void *vm)
+{
+	struct macro *m = vm;
+	int i;
+
+	pch_put_str(HASH_ITEM_NAME(m));
+	pch_put_num(m->narg + 1);
+	for (i = 0; i < m->narg; i ++) pch_put_str(m->arg[i]);
+	pch_put_num(m->vaarg);
+#ifdef LOW_MEM
+	pch_put_num(m->cval.length);
+	pch_put_mem(m->cval.t, m->cval.length);
+#else
+	pch_put_tokens(&m->val);
+#endif
+}
+
+/*
+ * save the macro table into the precompiled header
+ */
+void save_macros(void)
+{
+	HTT_scan(&macros, save_macro);
+	pch_put_str("");
+}
+
+/*
+ * replace the macro table with the one from the precompiled header
+ */
+void load_macros(void)
+{
+	char *name;
+
+	wipe_macros();
+	HTT_init(&macros, del_macro);
+	macros_init_done = 1;
+	while (*(name = pch_get_str())) {
+		struct macro *m = new_macro();
+		int i;
+
+		m->narg = (int)pch_get_num() - 1;
+		if (m->narg > 0) {
+			m->arg = getmem(m->narg * sizeof(char *));
+			for (i = 0; i < m->narg; i ++)
+				m->arg[i] = sdup(pch_get_str());
+		}
+		m->vaarg = pch_get_num();
+#ifdef LOW_MEM
+		m->cval.length = pch_get_num();
+		if (m->cval.length) {
+			m->cval.t = getmem(m->cval.length);
+			mmv(m->cval.t, pch_get_mem(m->cval.length),
+				m->cval.length);
+		}
+		m->cval.rp = 0;
+#else
+		pch_get_tokens(&m->val);
+#endif
+		HTT_put(&macros, m, name);
+	}
+}
@@ -0,0 +1,351 @@
+/*
+ * Precompiled prefix headers for ucpp
+ *
+ * A prefix header given with -include is preprocessed before the main
+ * file. With -pch, the state it leaves behind (macros, assertions, the
+ * files found and their #ifndef guards) is saved in a snapshot together
+ * with the output it produced. Later runs with the same options load the
+ * snapshot instead of preprocessing the header again.
+ *
+ * The snapshot starts with a key made of the options that affect the
+ * preprocessing: the lexer flags, the include path and the macros and
+ * assertions defined before the header (-D, -U, -A, -B...). It is followed
+ * by the size and date of every file that was read. The snapshot is only
+ * used when the key is identical and no file has changed, otherwise it
+ * is written again.
+ */
+
+#include "tune.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "ucppi.h"
+#include "mem.h"
+
+/* Change it when the format of the snapshots changes */
+#define PCH_VERSION	"ucpp-pch 1"
+
+#define PCH_MEMG	4096
+
+static unsigned char *pch_data = 0;
+static size_t pch_len = 0, pch_size = 0, pch_pos = 0;
+static int pch_error = 0;
+
+static void pch_reset(void)
+{
+	if (pch_data) freemem(pch_data);
+	pch_data = 0;
+	pch_len = pch_size = pch_pos = 0;
+	pch_error = 0;
+}
+
+/*
+ * Append to the snapshot being built.
+ */
+void pch_put_mem(void *p, size_t n)
+{
+	if (pch_len + n > pch_size) {
+		size_t ns = (pch_len + n + PCH_MEMG) & ~(size_t)(PCH_MEMG - 1);
+
+		pch_data = pch_size ? incmem(pch_data, pch_size, ns)
+			: getmem(ns);
+		pch_size = ns;
+	}
+	mmv(pch_data + pch_len, p, n);
+	pch_len += n;
+}
+
+void pch_put_num(unsigned long x)
+{
+	unsigned char b[4];
+
+	b[0] = x; b[1] = x >> 8; b[2] = x >> 16; b[3] = x >> 24;
+	pch_put_mem(b, 4);
+}
+
+void pch_put_str(char *s)
+{
+	pch_put_mem(s, strlen(s) + 1);
+}
+
+void pch_put_tokens(struct token_fifo *tf)
+{
+	size_t i;
+
+	pch_put_num(tf->nt);
+	for (i = 0; i < tf->nt; i ++) {
+		pch_put_num(tf->t[i].type);
+		pch_put_num(tf->t[i].line + 1);		/* -1 is no line */
+		if (S_TOKEN(tf->t[i].type)) pch_put_str(tf->t[i].name);
+	}
+}
+
+/*
+ * Read from the snapshot being loaded. Reading past the end sets
+ * pch_error and returns zeroes.
+ */
+void *pch_get_mem(size_t n)
+{
+	static unsigned char zero[4];
+	void *p;
+
+	if (pch_error || n > pch_len - pch_pos) {
+		pch_error = 1;
+		return zero;
+	}
+	p = pch_data + pch_pos;
+	pch_pos += n;
+	return p;
+}
+
+unsigned long pch_get_num(void)
+{
+	unsigned char *b = pch_get_mem(4);
+
+	return b[0] | ((unsigned long)b[1] << 8)
+		| ((unsigned long)b[2] << 16) | ((unsigned long)b[3] << 24);
+}
+
+char *pch_get_str(void)
+{
+	unsigned char *s;
+
+	if (pch_error
+		|| memchr(pch_data + pch_pos, 0, pch_len - pch_pos) == 0) {
+		pch_error = 1;
+		return "";
+	}
+	s = pch_data + pch_pos;
+	pch_pos += strlen((char *)s) + 1;
+	return (char *)s;
+}
+
+void pch_get_tokens(struct token_fifo *tf)
+{
+	size_t i, nt = pch_get_num();
+
+	tf->nt = tf->art = 0;
+	if (pch_error || nt > pch_len - pch_pos) {
+		pch_error = 1;
+		return;
+	}
+	if (nt == 0) return;
+	tf->t = getmem(nt * sizeof(struct token));
+	for (i = 0; i < nt; i ++) {
+		struct token *t = tf->t + i;
+
+		t->type = pch_get_num();
+		t->line = (long)pch_get_num() - 1;
+		if (S_TOKEN(t->type)) t->name = sdup(pch_get_str());
+		tf->nt ++;
+	}
+}
+
+/*
+ * Compare the files read by the prefix header with the stamps saved in
+ * the snapshot.
+ */
+static int check_file_stamps(void)
+{
+	char *name;
+	struct stat st;
+
+	while (*(name = pch_get_str())) {
+		unsigned long size = pch_get_num(), mtime = pch_get_num();
+
+		if (stat(name, &st)
+			|| ((unsigned long)st.st_size & 0xffffffffUL) != size
+			|| ((unsigned long)st.st_mtime & 0xffffffffUL) != mtime)
+			return 0;
+	}
+	return !pch_error;
+}
+
+static void write_text(struct lexer_state *ls, void *text, size_t len)
+{
+	if (ls->output_hook) ls->output_hook(text, len);
+	else fwrite(text, 1, len, ls->output);
+}
+
+/*
+ * Load the snapshot if it matches the key. The output of the prefix
+ * header is copied to the output of ls.
+ */
+static int load_snapshot(struct lexer_state *ls, char *snapshot,
+	unsigned char *key, size_t key_len)
+{
+	FILE *f = fopen(snapshot, "rb");
+	unsigned long len;
+	long size;
+	void *out;
+	unsigned char *p;
+
+	if (!f) return 0;
+	pch_reset();
+	if (fseek(f, 0, SEEK_END) || (size = ftell(f)) <= 0
+		|| fseek(f, 0, SEEK_SET)) {
+		fclose(f);
+		return 0;
+	}
+	pch_data = getmem(size);
+	pch_size = pch_len = size;
+	if (fread(pch_data, 1, size, f) != (size_t)size) pch_error = 1;
+	fclose(f);
+
+	len = pch_get_num();
+	p = pch_get_mem(len);
+	if (pch_error || len != key_len || memcmp(p, key, key_len) != 0
+		|| !check_file_stamps()) {
+		pch_reset();
+		return 0;
+	}
+
+	len = pch_get_num();
+	out = pch_get_mem(len);
+	if (pch_error) {
+		pch_reset();
+		return 0;
+	}
+	if (ls->flags & KEEP_OUTPUT) write_text(ls, out, len);
+	load_macros();
+	load_assertions();
+	load_found_files();
+	if (pch_error || strcmp(pch_get_str(), PCH_VERSION)) {
+		error(-1, "corrupted precompiled header '%s'", snapshot);
+		pch_reset();
+		return -1;
+	}
+	pch_reset();
+	return 1;
+}
+
+/*
+ * Write the snapshot through a temporary file, so that a concurrent
+ * run never sees half of it.
+ */
+static void save_snapshot(char *snapshot, unsigned char *key,
+	size_t key_len, void *out, size_t out_len)
+{
+	size_t nl = strlen(snapshot);
+	char *tmp = getmem(nl + 5);
+	FILE *f;
+
+	pch_reset();
+	pch_put_num(key_len);
+	pch_put_mem(key, key_len);
+	save_file_stamps();
+	pch_put_str("");
+	pch_put_num(out_len);
+	pch_put_mem(out, out_len);
+	save_macros();
+	save_assertions();
+	save_found_files();
+	pch_put_str(PCH_VERSION);
+
+	mmv(tmp, snapshot, nl);
+	mmv(tmp + nl, ".tmp", 5);
+	if ((f = fopen(tmp, "wb")) != 0) {
+		int ok = fwrite(pch_data, 1, pch_len, f) == pch_len;
+
+		if (fclose(f) == 0 && ok) {
+			remove(snapshot);
+			if (rename(tmp, snapshot) == 0) tmp[0] = 0;
+		}
+		if (tmp[0]) remove(tmp);
+	}
+	if (tmp[0]) warning(-1, "cannot write precompiled header '%s'",
+		snapshot);
+	freemem(tmp);
+	pch_reset();
+}
+
+/*
+ * Preprocess the prefix header with its own lexer state; its output
+ * goes to out.
+ */
+static int run_prefix(struct lexer_state *ls, char *header, FILE *out)
+{
+	struct lexer_state pls;
+	int r, fr = 0;
+
+	init_lexer_state(&pls);
+	pls.flags = ls->flags;
+	pls.output = out;
+	if (out == ls->output) pls.output_hook = ls->output_hook;
+	pls.input = fopen(header, "r");
+	if (!pls.input) {
+		error(-1, "file '%s' not found", header);
+		return 1;
+	}
+	set_init_filename(header, 1);
+	enter_file(&pls, pls.flags);
+	while ((r = cpp(&pls)) < CPPERR_EOF) fr = fr || (r > 0);
+#ifndef NO_UCPP_BUF
+	flush_output(&pls);
+#endif
+	free_lexer_state(&pls);
+	return fr;
+}
+
+/*
+ * Preprocess the prefix header, or load its snapshot if it is up to
+ * date. Called once the options have been set, before the main file.
+ * Returns non-zero on error.
+ */
+int include_prefix(struct lexer_state *ls, char *header, char *snapshot)
+{
+	unsigned char *key;
+	size_t key_len;
+	FILE *out;
+	void *text = 0;
+	long text_len = 0;
+	int r;
+
+	/* Dependencies are only listed when the header is read */
+	if (!snapshot || emit_dependencies)
+		return run_prefix(ls, header, ls->output);
+
+	pch_reset();
+	pch_put_str(PCH_VERSION);
+	pch_put_num(ls->flags);
+	pch_put_num(c99_compliant);
+	pch_put_num(c99_hosted);
+	pch_put_num(no_special_macros);
+	pch_put_str(header);
+	save_include_path();
+	save_macros();
+	save_assertions();
+	key = pch_data;
+	key_len = pch_len;
+	pch_data = 0;
+	pch_reset();
+
+	if ((r = load_snapshot(ls, snapshot, key, key_len)) != 0) {
+		freemem(key);
+		return r < 0;
+	}
+
+	if ((out = tmpfile()) == 0) {
+		freemem(key);
+		return run_prefix(ls, header, ls->output);
+	}
+	if ((r = run_prefix(ls, header, out)) == 0
+		&& fseek(out, 0, SEEK_END) == 0
+		&& (text_len = ftell(out)) >= 0
+		&& fseek(out, 0, SEEK_SET) == 0) {
+		text = getmem(text_len + 1);
+		if (fread(text, 1, text_len, out) == (size_t)text_len) {
+			if (ls->flags & KEEP_OUTPUT)
+				write_text(ls, text, text_len);
+			save_snapshot(snapshot, key, key_len, text, text_len);
+		} else {
+			error(-1, "cannot read the output of '%s'", header);
+			r = 1;
+		}
+		freemem(text);
+	}
+	fclose(out);
+	freemem(key);
+	return r;
+}
@@ -0,0 +1,18 @@
+/*
+ * Entry point to run ucpp from another program
+ */
+
+#ifndef UCPP__UCPP__
+#define UCPP__UCPP__
+
+#include <stddef.h>
+
+/*
+ * Preprocess as the command line argv asks. When output is not null, the
+ * preprocessed text is given to it instead of being written to the output
+ * file. Returns EXIT_SUCCESS or EXIT_FAILURE.
+ */
+int ucpp_main(int argc, char *argv[],
+	void (*output)(unsigned char *, size_t));
+
+#endif
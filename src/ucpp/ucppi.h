@@ -92,12 +92,16 @@ struct assert {
 #define handle_unassert		ucpp_handle_unassert
 #define get_assertion		ucpp_get_assertion
 #define wipe_assertions		ucpp_wipe_assertions
+#define save_assertions		ucpp_save_assertions
+#define load_assertions		ucpp_load_assertions
 
 int cmp_token_list(struct token_fifo *, struct token_fifo *);
 int handle_assert(struct lexer_state *);
 int handle_unassert(struct lexer_state *);
 struct assert *get_assertion(char *);
 void wipe_assertions(void);
+void save_assertions(void);
+void load_assertions(void);
 
 /*
  * from macro.c
@@ -123,6 +127,8 @@ struct macro {
 #define substitute_macro	ucpp_substitute_macro
 #define get_macro		ucpp_get_macro
 #define wipe_macros		ucpp_wipe_macros
+#define save_macros		ucpp_save_macros
+#define load_macros		ucpp_load_macros
 #define dsharp_lexer		ucpp_dsharp_lexer
 #define compile_time		ucpp_compile_time
 #define compile_date		ucpp_compile_date
@@ -139,6 +145,8 @@ int substitute_macro(struct lexer_state *, struct macro *,
 	struct token_fifo *, int, int, long);
 struct macro *get_macro(char *);
 void wipe_macros(void);
+void save_macros(void);
+void load_macros(void);
 
 extern struct lexer_state dsharp_lexer;
 extern char compile_time[], compile_date[];
@@ -177,6 +185,10 @@ extern JMP_BUF eval_exception;
 #define throw_away		ucpp_throw_away
 #define garbage_collect		ucpp_garbage_collect
 #define init_buf_lexer_state	ucpp_init_buf_lexer_state
+#define save_file_stamps	ucpp_save_file_stamps
+#define save_found_files	ucpp_save_found_files
+#define load_found_files	ucpp_load_found_files
+#define save_include_path	ucpp_save_include_path
 #ifdef PRAGMA_TOKENIZE
 #define compress_token_list	ucpp_compress_token_list
 #endif
@@ -185,10 +197,37 @@ char *token_name(struct token *);
 void throw_away(struct garbage_fifo *, char *);
 void garbage_collect(struct garbage_fifo *);
 void init_buf_lexer_state(struct lexer_state *, int);
+void save_file_stamps(void);
+void save_found_files(void);
+void load_found_files(void);
+void save_include_path(void);
 #ifdef PRAGMA_TOKENIZE
 struct comp_token_fifo compress_token_list(struct token_fifo *);
 #endif
 
+/*
+ * from pch.c
+ */
+#define pch_put_mem		ucpp_pch_put_mem
+#define pch_put_num		ucpp_pch_put_num
+#define pch_put_str		ucpp_pch_put_str
+#define pch_put_tokens		ucpp_pch_put_tokens
+#define pch_get_mem		ucpp_pch_get_mem
+#define pch_get_num		ucpp_pch_get_num
+#define pch_get_str		ucpp_pch_get_str
+#define pch_get_tokens		ucpp_pch_get_tokens
+#define include_prefix		ucpp_include_prefix
+
+void pch_put_mem(void *, size_t);
+void pch_put_num(unsigned long);
+void pch_put_str(char *);
+void pch_put_tokens(struct token_fifo *);
+void *pch_get_mem(size_t);
+unsigned long pch_get_num(void);
+char *pch_get_str(void);
+void pch_get_tokens(struct token_fifo *);
+int include_prefix(struct lexer_state *, char *, char *);
+
 #define ouch		ucpp_ouch
 #define error		ucpp_error
 #define warning		ucpp_warning
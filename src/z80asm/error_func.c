@@ -195,6 +195,15 @@ void error_not_defined(const char *name)
 	
 	STR_DELETE(msg);
 }
+void error_circular_definition(const char *chain)
+{
+	STR_DEFINE(msg, STR_SIZE);
+
+	Str_append_sprintf( msg, "circular definition of symbols: %s", chain );
+	do_error( ErrError, Str_data(msg) );
+	
+	STR_DELETE(msg);
+}
 void error_illegal_ident(void)
 {
 	STR_DEFINE(msg, STR_SIZE);
@@ -330,6 +339,15 @@ void error_invalid_filler_option(const char *filler_hex)
 	
 	STR_DELETE(msg);
 }
+void error_invalid_jobs_option(const char *jobs)
+{
+	STR_DEFINE(msg, STR_SIZE);
+
+	Str_append_sprintf( msg, "invalid number of jobs: %s", jobs );
+	do_error( ErrError, Str_data(msg) );
+	
+	STR_DELETE(msg);
+}
 void warn_org_ignored(const char *filename, const char *section_name)
 {
 	STR_DEFINE(msg, STR_SIZE);
@@ -519,3 +537,12 @@ void error_cmd_failed(const char *cmd)
 	
 	STR_DELETE(msg);
 }
+void error_job_failed(const char *filename)
+{
+	STR_DEFINE(msg, STR_SIZE);
+
+	Str_append_sprintf( msg, "assembly of '%s' did not complete", filename );
+	do_error( ErrError, Str_data(msg) );
+	
+	STR_DELETE(msg);
+}
@@ -23,6 +23,7 @@ extern void error_missing_close_block(void);
 extern void error_unbalanced_struct_at(const char *filename, int line_nr);
 extern void error_unbalanced_struct(void);
 extern void error_not_defined(const char *name);
+extern void error_circular_definition(const char *chain);
 extern void error_illegal_ident(void);
 extern void error_jr_not_local(void);
 extern void error_expected_const_expr(void);
@@ -38,6 +39,7 @@ extern void error_org_not_aligned(int org, int align);
 extern void error_invalid_org_option(const char *org_hex);
 extern void error_invalid_org(int origin);
 extern void error_invalid_filler_option(const char *filler_hex);
+extern void error_invalid_jobs_option(const char *jobs);
 extern void warn_org_ignored(const char *filename, const char *section_name);
 extern void error_not_obj_file(const char *filename);
 extern void error_obj_file_version(const char *filename, int found_version, int expected_version);
@@ -59,3 +61,4 @@ extern void warn_dma_unsupported_command(void);
 extern void warn_dma_half_cycle_timing(void);
 extern void warn_dma_ready_signal_unsupported(void);
 extern void error_cmd_failed(const char *cmd);
+extern void error_job_failed(const char *filename);
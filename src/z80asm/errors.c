@@ -123,6 +123,12 @@ int get_num_errors( void )
     return errors.count;
 }
 
+void add_error_count( int count )
+{
+    init_module();
+    errors.count += count;
+}
+
 /*-----------------------------------------------------------------------------
 *	Open file to receive all errors / warnings from now on
 *	File is appended, to allow assemble	and link errors to be joined in the same file.
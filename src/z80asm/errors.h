@@ -38,6 +38,7 @@ extern int         get_error_line(void);
 *----------------------------------------------------------------------------*/
 extern void reset_error_count( void );
 extern int  get_num_errors( void );
+extern void add_error_count( int count );	/* errors counted by a -j worker */
 
 /*-----------------------------------------------------------------------------
 *	Open file to receive all errors / warnings from now on
@@ -127,6 +127,42 @@ static long _calc_power(long base, long exp)
 /* hash of (tok,op_type) to Operator* */
 static StrHash* operator_hash;
 
+/* operator codes used in object file bytecode - index in this table;
+   codes are stored in object files, append new operators at the end */
+static const struct {
+	tokid_t		tok;
+	op_type_t	op_type;
+} operator_codes[] = {
+	{ TK_TERN_COND,		TERNARY_OP },
+	{ TK_LOG_OR,		BINARY_OP },
+	{ TK_LOG_AND,		BINARY_OP },
+	{ TK_BIN_OR,		BINARY_OP },
+	{ TK_BIN_XOR,		BINARY_OP },
+	{ TK_BIN_AND,		BINARY_OP },
+	{ TK_EQUAL,			BINARY_OP },
+	{ TK_LESS,			BINARY_OP },
+	{ TK_GREATER,		BINARY_OP },
+	{ TK_LESS_EQ,		BINARY_OP },
+	{ TK_GREATER_EQ,	BINARY_OP },
+	{ TK_NOT_EQ,		BINARY_OP },
+	{ TK_LEFT_SHIFT,	BINARY_OP },
+	{ TK_RIGHT_SHIFT,	BINARY_OP },
+	{ TK_PLUS,			BINARY_OP },
+	{ TK_MINUS,			BINARY_OP },
+	{ TK_MULTIPLY,		BINARY_OP },
+	{ TK_DIVIDE,		BINARY_OP },
+	{ TK_MOD,			BINARY_OP },
+	{ TK_POWER,			BINARY_OP },
+	{ TK_MINUS,			UNARY_OP },
+	{ TK_PLUS,			UNARY_OP },
+	{ TK_BIN_NOT,		UNARY_OP },
+	{ TK_LOG_NOT,		UNARY_OP },
+};
+
+#define NUM_OPERATOR_CODES	((int)(sizeof(operator_codes) / sizeof(operator_codes[0])))
+
+static Operator* operators_by_code[NUM_OPERATOR_CODES];
+
 /* compute hash key */
 static const char* operator_hash_key(tokid_t tok, op_type_t op_type)
 {
@@ -156,11 +192,22 @@ static void init_operator_hash(void)
 		op_##_operation.assoc		= _assoc;								\
 		/* cast into unary type, cannot decide union path at compile time */ \
 		op_##_operation.calc.unary	= (long(*)(long))calc_##_operation;		\
+		op_##_operation.code		= -1;									\
 																			\
 		key = operator_hash_key( _tok, _type );								\
 		StrHash_set( &operator_hash, key, & op_##_operation );				\
 	}
 #include "expr_def.h"
+
+	/* map object file bytecodes */
+	for (int code = 0; code < NUM_OPERATOR_CODES; code++) {
+		Operator* op = (Operator*)StrHash_get(operator_hash,
+			operator_hash_key(operator_codes[code].tok, operator_codes[code].op_type));
+		xassert(op != NULL);
+		xassert(code < EXPR_BC_OPERATOR);
+		op->code = code;
+		operators_by_code[code] = op;
+	}
 }
 
 /* fini operator_hash */
@@ -180,6 +227,16 @@ Operator* Operator_get(tokid_t tok, op_type_t op_type)
 	return (Operator*)StrHash_get(operator_hash, key);
 }
 
+/* get the operator descriptor for the given object file bytecode, NULL if invalid */
+Operator* Operator_get_by_code(int code)
+{
+	init_module();
+	if (code < 0 || code >= NUM_OPERATOR_CODES)
+		return NULL;
+	else
+		return operators_by_code[code];
+}
+
 /*-----------------------------------------------------------------------------
 *	Stack for calculator
 *----------------------------------------------------------------------------*/
@@ -671,6 +728,167 @@ Expr* expr_parse(void)
 	return self;
 }
 
+/*-----------------------------------------------------------------------------
+*	Object file bytecode
+*----------------------------------------------------------------------------*/
+static void append_code_byte(ByteArray* code, int value)
+{
+	*(ByteArray_push(code)) = (byte_t)value;
+}
+
+bool Expr_encode(Expr* self, ByteArray* code, StrHash** names)
+{
+	for (size_t i = 0; i < ExprOpArray_size(self->rpn_ops); i++)
+	{
+		ExprOp* expr_op = ExprOpArray_item(self->rpn_ops, i);
+		long value;
+		int index;
+
+		switch (expr_op->op_type)
+		{
+		case ASMPC_OP:
+			append_code_byte(code, EXPR_BC_ASMPC);
+			break;
+
+		case NUMBER_OP:
+			value = expr_op->d.value;
+			if (value >= 0 && value <= 0xFF) {
+				append_code_byte(code, EXPR_BC_BYTE);
+				append_code_byte(code, value);
+			}
+			else if (value >= INT32_MIN && value <= INT32_MAX) {
+				append_code_byte(code, EXPR_BC_NUMBER);
+				append_code_byte(code, value >> 0);
+				append_code_byte(code, value >> 8);
+				append_code_byte(code, value >> 16);
+				append_code_byte(code, value >> 24);
+			}
+			else
+				return false;
+			break;
+
+		case SYMBOL_OP:
+			index = (int)(intptr_t)StrHash_get(*names, expr_op->d.symbol->name);
+			if (index == 0) {
+				index = (int)(*names)->count + 1;
+				if (index > 0xFFFF)
+					return false;
+				StrHash_set(names, expr_op->d.symbol->name, (void*)(intptr_t)index);
+			}
+			append_code_byte(code, EXPR_BC_SYMBOL);
+			append_code_byte(code, (index - 1) >> 0);
+			append_code_byte(code, (index - 1) >> 8);
+			break;
+
+		case CONST_EXPR_OP:
+			append_code_byte(code, EXPR_BC_CONST_EXPR);
+			break;
+
+		case UNARY_OP:
+		case BINARY_OP:
+		case TERNARY_OP:
+			if (expr_op->d.op->code < 0)
+				return false;
+			append_code_byte(code, EXPR_BC_OPERATOR | expr_op->d.op->code);
+			break;
+
+		default:
+			xassert(0);
+		}
+	}
+
+	return true;
+}
+
+Expr* expr_decode(const char* text, const byte_t* code, int size,
+	const char** names, int num_names)
+{
+	Expr* self = OBJ_NEW(Expr);
+	Str_set(self->text, text);
+
+	int i = 0;
+	int depth = 0;						/* calculator stack depth */
+	while (i < size)
+	{
+		int bc = code[i++];
+		int index;
+		long value;
+		Symbol* symptr;
+		Operator* op;
+
+		switch (bc)
+		{
+		case EXPR_BC_ASMPC:
+			ExprOp_init_asmpc(ExprOpArray_push(self->rpn_ops));
+			self->type = MAX(self->type, TYPE_ADDRESS);
+			depth++;
+			break;
+
+		case EXPR_BC_BYTE:
+			if (i + 1 > size)
+				goto error;
+			ExprOp_init_number(ExprOpArray_push(self->rpn_ops), code[i]);
+			self->type = MAX(self->type, TYPE_CONSTANT);
+			depth++;
+			i += 1;
+			break;
+
+		case EXPR_BC_NUMBER:
+			if (i + 4 > size)
+				goto error;
+			value = (int32_t)(
+				((uint32_t)code[i + 0] << 0) |
+				((uint32_t)code[i + 1] << 8) |
+				((uint32_t)code[i + 2] << 16) |
+				((uint32_t)code[i + 3] << 24));
+			ExprOp_init_number(ExprOpArray_push(self->rpn_ops), value);
+			self->type = MAX(self->type, TYPE_CONSTANT);
+			depth++;
+			i += 4;
+			break;
+
+		case EXPR_BC_SYMBOL:
+			if (i + 2 > size)
+				goto error;
+			index = code[i] | (code[i + 1] << 8);
+			if (index >= num_names)
+				goto error;
+			symptr = get_used_symbol(names[index]);
+			ExprOp_init_symbol(ExprOpArray_push(self->rpn_ops), symptr);
+			self->type = MAX(self->type, symptr->type);
+			depth++;
+			i += 2;
+			break;
+
+		case EXPR_BC_CONST_EXPR:
+			ExprOp_init_const_expr(ExprOpArray_push(self->rpn_ops));
+			break;
+
+		default:
+			if ((bc & EXPR_BC_OPERATOR) == 0)
+				goto error;
+			op = Operator_get_by_code(bc & ~EXPR_BC_OPERATOR);
+			if (op == NULL)
+				goto error;
+
+			/* operators pop their arguments and push the result */
+			depth -= op->op_type == TERNARY_OP ? 2 : op->op_type == BINARY_OP ? 1 : 0;
+			if (depth < 1)
+				goto error;
+			ExprOp_init_operator(ExprOpArray_push(self->rpn_ops), op->tok, op->op_type);
+		}
+	}
+
+	if (depth != 1)
+		goto error;
+
+	return self;
+
+error:
+	OBJ_DELETE(self);
+	return NULL;
+}
+
 /*-----------------------------------------------------------------------------
 *	evaluate expression if possible, set result.not_evaluable if failed
 *   e.g. symbol not defined
@@ -16,6 +16,7 @@ see http://www.engr.mun.ca/~theo/Misc/exp_parsing.htm
 #include "class.h"
 #include "classlist.h"
 #include "scan.h"
+#include "strhash.h"
 #include "sym.h"
 #include "utarray.h"
 
@@ -47,6 +48,7 @@ typedef struct Operator
 	op_type_t	op_type;			/* UNARY_OP, BINARY_OP, TERNARY_OP */
 	int			prec;				/* precedence lowest (1) to highest (N) */
 	assoc_t		assoc;				/* left or rigth association */
+	int			code;				/* operator code in object file bytecode */
 	union
 	{
 		long (*unary)(long a);						/* compute unary operator */
@@ -58,6 +60,9 @@ typedef struct Operator
 /* get the operator descriptor for the given (sym, op_type) */
 extern Operator* Operator_get(tokid_t tok, op_type_t op_type);
 
+/* get the operator descriptor for the given object file bytecode, NULL if invalid */
+extern Operator* Operator_get_by_code(int code);
+
 /*-----------------------------------------------------------------------------
 *	Expression operations
 *----------------------------------------------------------------------------*/
@@ -137,6 +142,28 @@ END_CLASS;
 
 CLASS_LIST(Expr);					/* list of expressions */
 
+/*-----------------------------------------------------------------------------
+*	Expression bytecode stored in object files: the rpn_ops of the expression,
+*	with symbols stored as indexes into the module's table of names
+*----------------------------------------------------------------------------*/
+#define EXPR_BC_ASMPC		'$'			/* ASMPC */
+#define EXPR_BC_BYTE		'b'			/* number 0..255, followed by byte */
+#define EXPR_BC_NUMBER		'N'			/* number, followed by dword */
+#define EXPR_BC_SYMBOL		'S'			/* symbol, followed by word index of name */
+#define EXPR_BC_CONST_EXPR	'#'			/* constant expression */
+#define EXPR_BC_OPERATOR	0x80		/* operator, ORed with operator code */
+
+/* append bytecode of expression to code; names maps each symbol name to its
+   index + 1 in the table of names, new names are added at the end;
+   return false if the expression cannot be encoded, e.g. number above 32 bits */
+extern bool Expr_encode(Expr* self, ByteArray* code, StrHash** names);
+
+/* create expression from its infix text and bytecode, as stored in an object file,
+   with symbols looked up in the current module;
+   return NULL if the bytecode is invalid */
+extern Expr* expr_decode(const char* text, const byte_t* code, int size,
+	const char** names, int num_names);
+
 /* compute ExprOp using Calc_xxx functions */
 extern void ExprOp_compute(ExprOp* self, Expr* expr, bool not_defined_error);
 
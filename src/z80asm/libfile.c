@@ -12,9 +12,13 @@
 #include "utlist.h"
 #include "zobjfile.h"
 #include "options.h"
+#include "utarray.h"
+#include <string.h>
 
 char Z80libhdr[] = "Z80LMF" OBJ_VERSION;
 
+extern char Z80objhdr[];
+
 /*-----------------------------------------------------------------------------
 *	define a library file name from the command line
 *----------------------------------------------------------------------------*/
@@ -29,8 +33,312 @@ static const char *search_libfile(const char *filename )
 	}
 }
 
+/*-----------------------------------------------------------------------------
+*	Module directory
+*	Libraries made with -d keep a directory of their modules, so that they
+*	can be updated in place when only some of the object files changed.
+*	- the first entry is a deleted module (size 0, skipped by the linker)
+*	  with the object signature, SIGNATURE_LIBDIR and the position of the
+*	  directory
+*	- the directory lists the modules in library order: position of the
+*	  module entry, object file size, 64-bit FNV-1a hash of the object file
+*	  and object file name
+*	Changed modules are appended and linked into the chain of next pointers
+*	in place of the old ones, so that the library order is kept; the old
+*	entries are marked deleted. The library is written again from scratch
+*	when more than half of it is unused.
+*----------------------------------------------------------------------------*/
+#define LIBDIR_HEAD_SIZE	(4 + 4 + SIGNATURE_SIZE + SIGNATURE_SIZE + 4)
+#define LIBDIR_ENTRY_SIZE	(4 + 4 + 4 + 4 + 2)
+
+typedef struct libdir_module_t {
+	const char	*filename;			/* object file name (strpool) */
+	int			 ptr;				/* position of the module entry, -1 if new */
+	int			 size;				/* size of the object file */
+	uint64_t	 hash;				/* FNV-1a hash of the object file */
+} libdir_module_t;
+
+static UT_icd ut_libdir_module_icd = { sizeof(libdir_module_t), NULL, NULL, NULL };
+
+static uint64_t hash_bytes(const byte_t *data, size_t size)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	while (size-- > 0) {
+		hash ^= *data++;
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+static void libdir_signature(char *signature)
+{
+	snprintf(signature, SIGNATURE_SIZE + 1, SIGNATURE_LIBDIR SIGNATURE_VERS, LIBDIR_VERSION);
+}
+
+static int get_dword(const byte_t *p)
+{
+	return (int)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/* write the directory at the current position */
+static void write_libdir(UT_array *modules, FILE *fp)
+{
+	xfwrite_dword(utarray_len(modules), fp);
+	for (libdir_module_t *m = (libdir_module_t*)utarray_front(modules); m != NULL;
+		m = (libdir_module_t*)utarray_next(modules, m)) {
+		xfwrite_dword(m->ptr, fp);
+		xfwrite_dword(m->size, fp);
+		xfwrite_dword((int)(uint32_t)m->hash, fp);
+		xfwrite_dword((int)(uint32_t)(m->hash >> 32), fp);
+		xfwrite_wcount_cstr(m->filename, fp);
+	}
+}
+
+/* read the directory of an open library, return false if it has none */
+static bool read_libdir(FILE *fp, UT_array *modules, int *p_dir_ptr)
+{
+	byte_t head[SIGNATURE_SIZE + LIBDIR_HEAD_SIZE];
+	char signature[SIGNATURE_SIZE + 1];
+	byte_t *dir = NULL;
+	bool ok = false;
+
+	/* library signature and the first entry */
+	fseek(fp, 0, SEEK_END);
+	long lib_size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (fread(head, 1, sizeof(head), fp) != sizeof(head) ||
+		memcmp(head, Z80libhdr, SIGNATURE_SIZE) != 0 ||
+		get_dword(head + SIGNATURE_SIZE + 4) != 0 ||
+		memcmp(head + SIGNATURE_SIZE + 8, Z80objhdr, SIGNATURE_SIZE) != 0)
+		return false;
+
+	libdir_signature(signature);
+	if (memcmp(head + SIGNATURE_SIZE + 8 + SIGNATURE_SIZE, signature, SIGNATURE_SIZE) != 0)
+		return false;
+
+	/* read the whole directory */
+	int dir_ptr = get_dword(head + SIGNATURE_SIZE + 8 + 2 * SIGNATURE_SIZE);
+	if (dir_ptr < (int)sizeof(head) || dir_ptr + 4 > lib_size)
+		return false;
+	size_t dir_size = lib_size - dir_ptr;
+	dir = xmalloc(dir_size);
+	fseek(fp, dir_ptr, SEEK_SET);
+	if (fread(dir, 1, dir_size, fp) != dir_size)
+		goto end;
+
+	int count = get_dword(dir);
+	size_t i = 4;
+	for (int n = 0; n < count; n++) {
+		if (i + LIBDIR_ENTRY_SIZE > dir_size)
+			goto end;
+
+		libdir_module_t m;
+		m.ptr = get_dword(dir + i);
+		m.size = get_dword(dir + i + 4);
+		m.hash = (uint32_t)get_dword(dir + i + 8) | ((uint64_t)(uint32_t)get_dword(dir + i + 12) << 32);
+		size_t len = dir[i + 16] | (dir[i + 17] << 8);
+		i += LIBDIR_ENTRY_SIZE;
+		if (i + len > dir_size ||
+			m.ptr < (int)sizeof(head) || m.size <= 0 || m.ptr + 8 + m.size > dir_ptr)
+			goto end;
+		m.filename = spool_add_n((char *)dir + i, len);
+		i += len;
+
+		utarray_push_back(modules, &m);
+	}
+
+	*p_dir_ptr = dir_ptr;
+	ok = true;
+
+end:
+	xfree(dir);
+	return ok;
+}
+
+/* read the object files of the library, compute their hashes */
+static bool read_modules(argv_t *src_files, UT_array *modules)
+{
+	for (char **pfile = argv_front(src_files); *pfile; pfile++) {
+		libdir_module_t m;
+		m.filename = spool_add(get_obj_filename(*pfile));
+		m.ptr = -1;
+
+		ByteArray *obj_file_data = read_obj_file_data(m.filename);
+		if (obj_file_data == NULL)
+			return false;					/* error */
+
+		m.size = ByteArray_size(obj_file_data);
+		m.hash = hash_bytes(ByteArray_item(obj_file_data, 0), m.size);
+
+		utarray_push_back(modules, &m);
+	}
+	return true;
+}
+
+/* find the unused module of the old directory with the same object file */
+static libdir_module_t *find_old_module(UT_array *old_modules, bool *used, int guess,
+	libdir_module_t *m)
+{
+	int count = utarray_len(old_modules);
+
+	for (int n = 0; n < count; n++) {
+		int i = (guess + n) % count;		/* usually in the same order */
+		libdir_module_t *old = (libdir_module_t*)utarray_eltptr(old_modules, i);
+		if (!used[i] && old->filename == m->filename) {
+			if (old->size == m->size && old->hash == m->hash) {
+				used[i] = true;
+				return old;
+			}
+			return NULL;					/* changed */
+		}
+	}
+	return NULL;							/* new */
+}
+
+/* write a module entry at the current position */
+static bool write_module(libdir_module_t *m, int next, FILE *lib_file)
+{
+	ByteArray *obj_file_data = read_obj_file_data(m->filename);
+	if (obj_file_data == NULL)
+		return false;						/* error */
+
+	xfwrite_dword(next, lib_file);
+	xfwrite_dword(m->size, lib_file);
+	xfwrite_bytes((char *)ByteArray_item(obj_file_data, 0), m->size, lib_file);
+	return true;
+}
+
+/*-----------------------------------------------------------------------------
+*	update the changed modules of a library with a directory; return false
+*	if it has to be written from scratch
+*----------------------------------------------------------------------------*/
+static bool update_library(const char *lib_filename, argv_t *src_files)
+{
+	UT_array *modules, *old_modules;
+	bool *used = NULL;
+	int dir_ptr;
+	bool done = false;
+
+	if (!file_exists(lib_filename))
+		return false;
+
+	FILE *lib_file = fopen(lib_filename, "r+b");
+	if (lib_file == NULL)
+		return false;
+
+	utarray_new(modules, &ut_libdir_module_icd);
+	utarray_new(old_modules, &ut_libdir_module_icd);
+
+	if (!read_libdir(lib_file, old_modules, &dir_ptr))
+		goto end;
+
+	if (!read_modules(src_files, modules)) {
+		xfclose(lib_file);					/* error */
+		lib_file = NULL;
+		remove(lib_filename);
+		done = true;
+		goto end;
+	}
+
+	/* keep the unchanged modules, place the others where the directory was */
+	int old_count = utarray_len(old_modules);
+	int count = utarray_len(modules);
+	int num_new = 0;
+	long end_ptr = dir_ptr, dir_size = 4, live_size = SIGNATURE_SIZE + LIBDIR_HEAD_SIZE;
+
+	used = xcalloc(old_count + 1, sizeof(bool));
+	for (int i = 0; i < count; i++) {
+		libdir_module_t *m = (libdir_module_t*)utarray_eltptr(modules, i);
+		libdir_module_t *old = find_old_module(old_modules, used, i, m);
+		if (old != NULL)
+			m->ptr = old->ptr;
+		else {
+			m->ptr = end_ptr;
+			end_ptr += 8 + m->size;
+			num_new++;
+		}
+		live_size += 8 + m->size;
+		dir_size += LIBDIR_ENTRY_SIZE + strlen(m->filename);
+	}
+	live_size += dir_size;
+
+	/* nothing to do if all modules are kept in the same order */
+	if (num_new == 0 && count == old_count) {
+		bool same = true;
+		for (int i = 0; i < count && same; i++)
+			same = ((libdir_module_t*)utarray_eltptr(modules, i))->ptr ==
+				((libdir_module_t*)utarray_eltptr(old_modules, i))->ptr;
+		if (same) {
+			done = true;
+			goto end;
+		}
+	}
+
+	/* compact if more than half unused */
+	fseek(lib_file, 0, SEEK_END);
+	if (MAX(ftell(lib_file), end_ptr + dir_size) > 2 * live_size + 4096)
+		goto end;
+
+	if (opts.verbose)
+		printf("Updating library '%s': %d of %d modules changed\n",
+			path_canon(lib_filename), num_new, count);
+
+	/* write the new modules */
+	xfseek(lib_file, dir_ptr, SEEK_SET);
+	for (int i = 0; i < count; i++) {
+		libdir_module_t *m = (libdir_module_t*)utarray_eltptr(modules, i);
+		if (m->ptr >= dir_ptr) {
+			int next = (i + 1 < count) ? ((libdir_module_t*)utarray_eltptr(modules, i + 1))->ptr : -1;
+			if (!write_module(m, next, lib_file)) {
+				xfclose(lib_file);			/* error */
+				lib_file = NULL;
+				remove(lib_filename);
+				done = true;
+				goto end;
+			}
+		}
+	}
+	int new_dir_ptr = ftell(lib_file);
+	write_libdir(modules, lib_file);
+
+	/* relink the kept modules in the new order */
+	for (int i = 0; i < count; i++) {
+		libdir_module_t *m = (libdir_module_t*)utarray_eltptr(modules, i);
+		if (m->ptr < dir_ptr) {
+			int next = (i + 1 < count) ? ((libdir_module_t*)utarray_eltptr(modules, i + 1))->ptr : -1;
+			xfseek(lib_file, m->ptr, SEEK_SET);
+			xfwrite_dword(next, lib_file);
+		}
+	}
+
+	/* mark the replaced modules deleted */
+	for (int i = 0; i < old_count; i++) {
+		if (!used[i]) {
+			xfseek(lib_file, ((libdir_module_t*)utarray_eltptr(old_modules, i))->ptr + 4, SEEK_SET);
+			xfwrite_dword(0, lib_file);
+		}
+	}
+
+	/* point the first entry to the first module and the new directory */
+	xfseek(lib_file, SIGNATURE_SIZE, SEEK_SET);
+	xfwrite_dword(count > 0 ? ((libdir_module_t*)utarray_front(modules))->ptr : -1, lib_file);
+	xfseek(lib_file, SIGNATURE_SIZE + 8 + 2 * SIGNATURE_SIZE, SEEK_SET);
+	xfwrite_dword(new_dir_ptr, lib_file);
+	done = true;
+
+end:
+	if (lib_file != NULL)
+		xfclose(lib_file);
+	if (used != NULL)
+		xfree(used);
+	utarray_free(modules);
+	utarray_free(old_modules);
+	return done;
+}
+
 /*-----------------------------------------------------------------------------
 *	make library from list of files; convert each source to object file name 
+*	with -d, keep a directory and update only the changed modules
 *----------------------------------------------------------------------------*/
 void make_library(const char *lib_filename, argv_t *src_files)
 {
@@ -38,11 +346,19 @@ void make_library(const char *lib_filename, argv_t *src_files)
 	FILE	*lib_file;
 	const char *obj_filename;
 	size_t	 fptr, obj_size;
+	UT_array *modules = NULL;
+	char	 signature[SIGNATURE_SIZE + 1];
 
 	lib_filename = search_libfile(lib_filename);
 	if ( lib_filename == NULL )
 		return;					/* ERROR */
 
+	if (opts.date_stamp) {
+		if (update_library(lib_filename, src_files))
+			return;
+		utarray_new(modules, &ut_libdir_module_icd);
+	}
+
 	if (opts.verbose)
 		printf("Creating library '%s'\n", path_canon(lib_filename));
 
@@ -50,6 +366,16 @@ void make_library(const char *lib_filename, argv_t *src_files)
 	lib_file = xfopen( lib_filename, "wb" );	
 	xfwrite_cstr(Z80libhdr, lib_file);
 
+	/* write first entry pointing to the directory */
+	if (modules != NULL) {
+		libdir_signature(signature);
+		xfwrite_dword(SIGNATURE_SIZE + LIBDIR_HEAD_SIZE, lib_file);	/* first module */
+		xfwrite_dword(0, lib_file);
+		xfwrite_cstr(Z80objhdr, lib_file);
+		xfwrite_cstr(signature, lib_file);
+		xfwrite_dword(-1, lib_file);		/* directory, written at the end */
+	}
+
 	/* write each object file */
 	for (char **pfile = argv_front(src_files); *pfile; pfile++)
 	{
@@ -62,6 +388,8 @@ void make_library(const char *lib_filename, argv_t *src_files)
 		{
 			xfclose(lib_file);			/* error */
 			remove(lib_filename);
+			if (modules != NULL)
+				utarray_free(modules);
 			return;
 		}
 
@@ -77,6 +405,24 @@ void make_library(const char *lib_filename, argv_t *src_files)
 
 		/* write module */
 		xfwrite_bytes((char *)ByteArray_item(obj_file_data, 0), obj_size, lib_file);
+
+		if (modules != NULL) {
+			libdir_module_t m;
+			m.filename = spool_add(obj_filename);
+			m.ptr = fptr;
+			m.size = obj_size;
+			m.hash = hash_bytes(ByteArray_item(obj_file_data, 0), obj_size);
+			utarray_push_back(modules, &m);
+		}
+	}
+
+	/* write directory at the end */
+	if (modules != NULL) {
+		long dir_ptr = ftell(lib_file);
+		write_libdir(modules, lib_file);
+		xfseek(lib_file, SIGNATURE_SIZE + 8 + 2 * SIGNATURE_SIZE, SEEK_SET);
+		xfwrite_dword(dir_ptr, lib_file);
+		utarray_free(modules);
 	}
 
 	/* close and write lib file */
@@ -21,8 +21,10 @@ Repository: https://github.com/z88dk/z88dk
 #include "strutil.h"
 #include "sym.h"
 #include "symbol.h"
+#include "uthash.h"
 #include "utstring.h"
 #include "z80asm.h"
+#include "zobjfile.h"
 #include "zutils.h"
 
 #include <ctype.h>
@@ -31,14 +33,22 @@ Repository: https://github.com/z88dk/z88dk
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 // list of objects/libraries to search during linking
 typedef struct obj_file_t {
 	struct obj_file_t* next, *prev;		// doubly linked list
 	const char*		filename;			// library file name (strpool)
 	int				size;				// size of library file
-	byte_t*			data;				// contents of library file, loaded before linking
+	byte_t*			data;				// contents of library file, mapped before linking
 	int				i;					// point to next position to parse
 	Module*			module;				// weak pointer to main module information, if object file
+	void*			mem;				// memory holding data, NULL if data is inside a library
+	bool			mapped;				// mem is mapped from the file, not allocated
 } obj_file_t;
 
 
@@ -110,11 +120,36 @@ static const char* parse_bcount_str(obj_file_t* obj) {
 	return parse_str(obj, len);
 }
 
+// skip a string without adding it to the string pool
+static void skip_bcount_str(obj_file_t* obj) {
+	int len = parse_byte(obj);
+	xassert(obj->i + len <= obj->size);
+	obj->i += len;
+}
+
+// copy a string to buffer[256] without adding it to the string pool
+static const char* peek_bcount_str(obj_file_t* obj, char* buffer) {
+	int len = parse_byte(obj);
+	xassert(obj->i + len <= obj->size);
+	memcpy(buffer, obj->data + obj->i, len);
+	buffer[len] = '\0';
+	obj->i += len;
+	return buffer;
+}
+
 static const char* parse_wcount_str(obj_file_t* obj) {
 	int len = parse_word(obj);
 	return parse_str(obj, len);
 }
 
+static int obj_version(obj_file_t* obj) {
+	xassert(obj->size >= 8);
+	int version = 0;
+	for (int i = 6; i < 8 && isdigit(obj->data[i]); i++)
+		version = version * 10 + obj->data[i] - '0';
+	return version;
+}
+
 static bool goto_modname(obj_file_t* obj) {
 	obj->i = 8 + 0 * 4;
 	obj->i = parse_int(obj);
@@ -155,24 +190,55 @@ static void obj_files_append(obj_file_t** plist, const char* filename, Module* m
 	obj->module = module;
 }
 
+// map the file read-only, so that only the pages of the modules that are
+// parsed are read; read it to memory if it cannot be mapped
+static bool obj_file_map(obj_file_t* obj) {
+#ifndef _WIN32
+	if (obj->size > 0) {
+		int fd = open(obj->filename, O_RDONLY);
+		if (fd >= 0) {
+			void* mem = mmap(NULL, obj->size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (mem != MAP_FAILED) {
+				obj->mem = obj->data = mem;
+				obj->mapped = true;
+				return true;
+			}
+		}
+	}
+#endif
+
+	FILE* fp = fopen(obj->filename, "rb");
+	if (!fp)
+		return false;
+	obj->mem = obj->data = xmalloc(obj->size);
+	obj->mapped = false;
+	xfread(obj->data, 1, obj->size, fp);
+	fclose(fp);
+	return true;
+}
+
+static void obj_file_unmap(obj_file_t* obj) {
+	if (obj->mem) {
+#ifndef _WIN32
+		if (obj->mapped)
+			munmap(obj->mem, obj->size);
+		else
+#endif
+			xfree(obj->mem);
+	}
+	obj->mem = obj->data = NULL;
+}
+
 static bool obj_files_read_data(obj_file_t** plist) {
 	init();
 
 	for (obj_file_t* obj = *plist; obj; obj = obj->next) {
 		obj->size = file_size(obj->filename);
-		if (obj->size < 0) {
-			error_read_file(obj->filename);
-			return false;
-		}
-
-		obj->data = xmalloc(obj->size);
-		FILE* fp = fopen(obj->filename, "rb");
-		if (!fp){
+		if (obj->size < 0 || !obj_file_map(obj)) {
 			error_read_file(obj->filename);
 			return false;
 		}
-		xfread(obj->data, 1, obj->size, fp);
-		fclose(fp);
 	}
 
 	return true;
@@ -182,7 +248,7 @@ static void obj_files_free(obj_file_t** plist) {
 	while (*plist) {
 		obj_file_t* elem = *plist;
 		DL_DELETE(*plist, elem);
-		xfree(elem->data);
+		obj_file_unmap(elem);
 		xfree(elem);
 	}
 }
@@ -272,13 +338,12 @@ void object_module_append(obj_file_t* obj, Module* module) {
 		}
 	}
 
-	// append a copy to the list of objects to be linked
+	// append to the list of objects to be linked, the data stays in the library
 	obj_file_t* new_obj = xnew(obj_file_t);
 	DL_APPEND(g_objects, new_obj);
 	new_obj->filename = obj->filename;
 	new_obj->size = obj->size;
-	new_obj->data = xmalloc(obj->size);
-	memcpy(new_obj->data, obj->data, obj->size);
+	new_obj->data = obj->data;
 	new_obj->i = 0;
 	new_obj->module = module;
 }
@@ -325,6 +390,13 @@ static void read_cur_module_exprs(ExprList* exprs, obj_file_t* obj) {
 	utstring_new(expr_text_2);
 	const char* last_filename = spool_add(obj->filename);
 
+	// table of names used by the expressions bytecode
+	bool has_bytecode = obj_version(obj) >= OBJ_VERSION_BYTECODE;
+	int num_names = has_bytecode ? parse_word(obj) : 0;
+	const char** names = xmalloc((num_names + 1) * sizeof(const char*));
+	for (int i = 0; i < num_names; i++)
+		names[i] = parse_bcount_str(obj);
+
 	while (true) {
 		int type = parse_byte(obj);
 		if (type == 0)
@@ -346,18 +418,35 @@ static void read_cur_module_exprs(ExprList* exprs, obj_file_t* obj) {
 		const char* target_name = parse_bcount_str(obj);
 		const char* expr_text_1 = parse_wcount_str(obj);
 
-		// call parser to interpret expression followed by newline
-		utstring_clear(expr_text_2);
-		utstring_printf(expr_text_2, "%s\n", expr_text_1);
-
-		SetTemporaryLine(utstring_body(expr_text_2));
-		EOL = false;                // reset end of line parsing flag - a line is to be parsed...
-		scan_expect_operands();
-		GetSym();
+		// bytecode, if any
+		int code_size = has_bytecode ? parse_word(obj) : 0;
+		xassert(obj->i + code_size <= obj->size);
+		const byte_t* code = obj->data + obj->i;
+		obj->i += code_size;
+
+		Expr* expr;
+		if (code_size > 0) {
+			// decode pre-compiled expression
+			set_asmpc_env(CURRENTMODULE, section_name, source_filename, line_nr, asmpc, false);
+			expr = expr_decode(expr_text_1, code, code_size, names, num_names);
+			if (!expr)
+				error_not_obj_file(obj->filename);
+		}
+		else {
+			// call parser to interpret expression followed by newline
+			utstring_clear(expr_text_2);
+			utstring_printf(expr_text_2, "%s\n", expr_text_1);
+
+			SetTemporaryLine(utstring_body(expr_text_2));
+			EOL = false;                // reset end of line parsing flag - a line is to be parsed...
+			scan_expect_operands();
+			GetSym();
+
+			// parse expression and store in the list
+			set_asmpc_env(CURRENTMODULE, section_name, source_filename, line_nr, asmpc, false);
+			expr = expr_parse();
+		}
 
-		// parse expression and store in the list
-		set_asmpc_env(CURRENTMODULE, section_name, source_filename, line_nr, asmpc, false);
-		Expr* expr = expr_parse();
 		if (expr) {
 			expr->range = 0;
 			switch (type) {
@@ -390,6 +479,7 @@ static void read_cur_module_exprs(ExprList* exprs, obj_file_t* obj) {
 		}
 	}
 
+	xfree(names);
 	utstring_free(expr_text_2);
 }
 
@@ -482,19 +572,287 @@ static int compute_equ_exprs_once(ExprList* exprs, bool show_error, bool module_
 		return 0;
 }
 
+/*-----------------------------------------------------------------------------
+*   Dependency graph of EQU expressions: each node is an expression that
+*	defines a symbol; the edges go from a node to the nodes whose expressions
+*	use the symbol it defines
+*----------------------------------------------------------------------------*/
+typedef struct equ_node_t {
+	Expr*			expr;
+	Symbol*			target;				/* symbol defined by the expression */
+	intArray*		dependents;			/* nodes that use target */
+	bool			computed : 1;
+	bool			queued : 1;
+	int				dfs_state;			/* cycle search: 0 new, 1 in path, 2 done */
+} equ_node_t;
+
+typedef struct equ_target_t {
+	Symbol*			sym;				/* key */
+	int				node;
+	UT_hash_handle	hh;
+} equ_target_t;
+
+typedef struct equ_graph_t {
+	equ_node_t*		nodes;
+	equ_target_t*	targets;			/* one per node */
+	equ_target_t*	targets_hash;		/* target symbol -> first node */
+	int				num_nodes;
+} equ_graph_t;
+
+static void equ_graph_init(equ_graph_t* graph, ExprList* exprs)
+{
+	ExprListElem* iter;
+	Expr* expr;
+	equ_target_t* found;
+	int n, i;
+
+	memset(graph, 0, sizeof(*graph));
+
+	n = 0;
+	for (iter = ExprList_first(exprs); iter != NULL; iter = ExprList_next(iter))
+		if (iter->obj->target_name)
+			n++;
+
+	graph->nodes = xcalloc(n + 1, sizeof(equ_node_t));
+	graph->targets = xcalloc(n + 1, sizeof(equ_target_t));
+
+	/* create nodes in list order, touch target symbols so that they end in object file */
+	for (iter = ExprList_first(exprs); iter != NULL; iter = ExprList_next(iter))
+	{
+		expr = iter->obj;
+		if (expr->target_name)
+		{
+			equ_node_t* node = &graph->nodes[graph->num_nodes];
+			node->expr = expr;
+			node->dependents = OBJ_NEW(intArray);
+
+			set_cur_module(expr->module);
+			node->target = get_used_symbol(expr->target_name);
+			node->target->is_touched = true;
+
+			HASH_FIND_PTR(graph->targets_hash, &node->target, found);
+			if (!found)
+			{
+				equ_target_t* target = &graph->targets[graph->num_nodes];
+				target->sym = node->target;
+				target->node = graph->num_nodes;
+				HASH_ADD_PTR(graph->targets_hash, sym, target);
+			}
+
+			graph->num_nodes++;
+		}
+	}
+
+	/* link each producer to the expressions that use its symbol */
+	for (n = 0; n < graph->num_nodes; n++)
+	{
+		Expr* expr = graph->nodes[n].expr;
+
+		for (i = 0; i < (int)ExprOpArray_size(expr->rpn_ops); i++)
+		{
+			ExprOp* expr_op = ExprOpArray_item(expr->rpn_ops, i);
+			if (expr_op->op_type == SYMBOL_OP)
+			{
+				HASH_FIND_PTR(graph->targets_hash, &expr_op->d.symbol, found);
+				if (found)
+				{
+					intArray* dependents = graph->nodes[found->node].dependents;
+					size_t size = intArray_size(dependents);
+					if (size == 0 || *intArray_item(dependents, size - 1) != n)
+						*(intArray_push(dependents)) = n;
+				}
+			}
+		}
+	}
+}
+
+static void equ_graph_fini(equ_graph_t* graph)
+{
+	int n;
+
+	HASH_CLEAR(hh, graph->targets_hash);
+	for (n = 0; n < graph->num_nodes; n++)
+		OBJ_DELETE(graph->nodes[n].dependents);
+	xfree(graph->nodes);
+	xfree(graph->targets);
+}
+
+/* evaluate expressions in dependency order: each expression is evaluated once
+   and again only when one of the symbols it uses is computed */
+static void compute_equ_graph(equ_graph_t* graph, bool module_relative_addr)
+{
+	intArray* queue;
+	size_t head, i;
+	long value;
+	int n;
+
+	queue = OBJ_NEW(intArray);
+	for (n = 0; n < graph->num_nodes; n++)
+	{
+		*(intArray_push(queue)) = n;
+		graph->nodes[n].queued = true;
+	}
+
+	for (head = 0; head < intArray_size(queue); head++)
+	{
+		equ_node_t* node = &graph->nodes[*intArray_item(queue, head)];
+		Expr* expr = node->expr;
+
+		node->queued = false;
+		if (node->computed)
+			continue;
+
+		/* expressions with symbols from other sections need to be passed to the link phase */
+		set_expr_env(expr, module_relative_addr);
+		if (!module_relative_addr || /* link phase */
+			(Expr_is_local_in_section(expr, CURRENTMODULE, CURRENTSECTION) &&	/* or symbols from other sections */
+				Expr_without_addresses(expr))		/* expression addressees - needs to be computed at link time */
+			)
+		{
+			value = Expr_eval(expr, false);
+			if (!expr->result.not_evaluable && expr->is_computed)
+			{
+				update_symbol(expr->target_name, value, expr->type);
+				node->computed = true;
+
+				/* expressions waiting for this symbol can now be tried */
+				for (i = 0; i < intArray_size(node->dependents); i++)
+				{
+					equ_node_t* dependent = &graph->nodes[*intArray_item(node->dependents, i)];
+					if (!dependent->computed && !dependent->queued)
+					{
+						*(intArray_push(queue)) = (int)(dependent - graph->nodes);
+						dependent->queued = true;
+					}
+				}
+			}
+		}
+	}
+
+	OBJ_DELETE(queue);
+}
+
+/* remove and delete computed expressions from the list */
+static void remove_computed_equ_exprs(equ_graph_t* graph, ExprList* exprs)
+{
+	ExprListElem* iter;
+	Expr* expr, * expr2;
+	int n;
+
+	n = 0;
+	iter = ExprList_first(exprs);
+	while (iter != NULL)
+	{
+		expr = iter->obj;
+		if (expr->target_name && graph->nodes[n++].computed)
+		{
+			expr2 = ExprList_remove(exprs, &iter);
+			xassert(expr == expr2);
+
+			OBJ_DELETE(expr);
+		}
+		else
+			iter = ExprList_next(iter);
+	}
+}
+
+/* report each cycle of expressions that depend on each other */
+static void report_equ_cycles(equ_graph_t* graph)
+{
+	intArray* path;					/* nodes of the current search path */
+	intArray* next_edge;			/* next dependent to visit from each path node */
+	int start, n, i;
+
+	path = OBJ_NEW(intArray);
+	next_edge = OBJ_NEW(intArray);
+
+	for (start = 0; start < graph->num_nodes; start++)
+	{
+		if (graph->nodes[start].dfs_state != 0)
+			continue;
+
+		*(intArray_push(path)) = start;
+		*(intArray_push(next_edge)) = 0;
+		graph->nodes[start].dfs_state = 1;
+
+		while (intArray_size(path) > 0)
+		{
+			size_t top = intArray_size(path) - 1;
+			equ_node_t* node = &graph->nodes[*intArray_item(path, top)];
+			int* edge = intArray_item(next_edge, top);
+
+			if (*edge >= (int)intArray_size(node->dependents))
+			{
+				node->dfs_state = 2;
+				intArray_pop(path);
+				intArray_pop(next_edge);
+				continue;
+			}
+
+			n = *intArray_item(node->dependents, (*edge)++);
+			if (graph->nodes[n].dfs_state == 0)
+			{
+				*(intArray_push(path)) = n;
+				*(intArray_push(next_edge)) = 0;
+				graph->nodes[n].dfs_state = 1;
+			}
+			else if (graph->nodes[n].dfs_state == 1)
+			{
+				/* back edge: n uses the symbol of the path top, which depends on n;
+				   list the cycle in definition order starting at n */
+				STR_DEFINE(chain, STR_SIZE);
+
+				for (i = (int)top; i >= 0; i--)
+				{
+					equ_node_t* member = &graph->nodes[*intArray_item(path, i)];
+					if (Str_len(chain) == 0)
+						Str_append_sprintf(chain, "%s", graph->nodes[n].target->name);
+					Str_append_sprintf(chain, " -> %s", member->target->name);
+					if (*intArray_item(path, i) == n)
+						break;
+				}
+
+				set_expr_env(graph->nodes[n].expr, false);
+				error_circular_definition(Str_data(chain));
+
+				STR_DELETE(chain);
+			}
+		}
+	}
+
+	OBJ_DELETE(path);
+	OBJ_DELETE(next_edge);
+}
+
 /* compute all equ expressions, removing them from the list */
 void compute_equ_exprs(ExprList* exprs, bool show_error, bool module_relative_addr)
 {
+	equ_graph_t graph;
 	int  compute_result;
 
-	/* loop to solve dependencies while some are solved */
+	/* solve dependencies in topological order */
+	equ_graph_init(&graph, exprs);
+	compute_equ_graph(&graph, module_relative_addr);
+	remove_computed_equ_exprs(&graph, exprs);
+	equ_graph_fini(&graph);
+
+	/* catch dependencies not seen by the graph, e.g. the same name resolved
+	   to different symbols; usually computes nothing */
 	do {
 		compute_result = compute_equ_exprs_once(exprs, false, module_relative_addr);
 	} while (compute_result > 0);
 
-	/* if some unresolved, give up and show error */
-	if (show_error && compute_result < 0)
-		compute_equ_exprs_once(exprs, true, module_relative_addr);
+	if (show_error)
+	{
+		/* if some unresolved, give up and show error */
+		if (compute_result < 0)
+			compute_equ_exprs_once(exprs, true, module_relative_addr);
+
+		/* expressions left waiting for each other */
+		equ_graph_init(&graph, exprs);
+		report_equ_cycles(&graph);
+		equ_graph_fini(&graph);
+	}
 }
 
 /* compute and patch expressions */
@@ -738,76 +1096,210 @@ static bool pending_syms(StrHash* extern_syms) {
 		return true;
 }
 
-// search one module for unresolved symbols and link if needed
-static bool linked_module(obj_file_t* obj, StrHash* extern_syms) {
-	bool linked = false;
+// module inside a library, indexed once per link
+typedef struct lib_module_t {
+	obj_file_t		obj;				// module data inside the library file data
+	int				id;					// search order: libraries in command line order,
+										// modules in library order
+	bool			linked;				// true if already pulled in
+} lib_module_t;
+
+static UT_icd ut_lib_module_icd = { sizeof(lib_module_t), NULL, NULL, NULL };
+
+// index of all library modules and of the global symbols they define
+typedef struct lib_index_t {
+	UT_array*		modules;			// lib_module_t, in search order
+	StrHash*		symbols;			// global name -> first lib_module_t that defines it
+	intArray*		queue;				// min-heap of ids of candidate modules
+} lib_index_t;
+
+// build the index of all modules of all libraries
+static void lib_index_init(lib_index_t* index) {
+	utarray_new(index->modules, &ut_lib_module_icd);
+	index->symbols = OBJ_NEW(StrHash);
+	index->queue = OBJ_NEW(intArray);
+
+	// collect all modules of all libraries
+	for (obj_file_t* lib = g_libraries; lib != NULL; lib = lib->next) {
+		int next_pos = -1;
+		for (int pos = 8; pos > 0 && pos < lib->size; pos = next_pos) {
+			lib->i = pos;
+			next_pos = parse_int(lib);
+			int module_size = parse_int(lib);
+
+			if (module_size == 0)
+				continue;					// deleted module
 
-	// get module name
-	xassert(goto_modname(obj));
-	const char* modname = parse_bcount_str(obj);
+			lib_module_t module;
+			memset(&module, 0, sizeof(module));
+			module.obj.filename = lib->filename;
+			module.obj.data = lib->data + lib->i;
+			module.obj.size = module_size;
+			module.id = utarray_len(index->modules);
 
-	// get defined names
-	if (goto_defined_names(obj)) {
-		while (!linked) {
-			int scope = parse_byte(obj);
-			if (scope == 0)	
-				break;					// end of list
-			obj->i++;					// skip type
-			parse_bcount_str(obj);		// skip section name
-			obj->i += 4;				// skip value
-			const char* symbol_name = parse_bcount_str(obj);
-			parse_bcount_str(obj);		// skip defined file name
-			obj->i += 4;				// skip line number
-
-			// link module if one defined symbol matches pending externals
-			if (scope == 'G' && StrHash_exists(extern_syms, symbol_name)) {
-				link_lib_module(modname, obj, extern_syms);
-				linked = true;
+			utarray_push_back(index->modules, &module);
+		}
+	}
+
+	// map each global name to the first module that defines it; the array
+	// does not grow anymore, pointers to its elements are stable; only the
+	// names are read, the code of the modules is not touched
+	char symbol_name[256];
+	for (lib_module_t* module = (lib_module_t*)utarray_front(index->modules); module != NULL;
+		module = (lib_module_t*)utarray_next(index->modules, module)) {
+		obj_file_t* obj = &module->obj;
+		if (goto_defined_names(obj)) {
+			while (true) {
+				int scope = parse_byte(obj);
+				if (scope == 0)
+					break;					// end of list
+				obj->i++;					// skip type
+				skip_bcount_str(obj);		// skip section name
+				obj->i += 4;				// skip value
+				peek_bcount_str(obj, symbol_name);
+				skip_bcount_str(obj);		// skip defined file name
+				obj->i += 4;				// skip line number
+
+				if (scope == 'G' && !StrHash_exists(index->symbols, symbol_name))
+					StrHash_set(&index->symbols, symbol_name, module);
 			}
 		}
 	}
-	return linked;
 }
 
-// search chain of libraries for modules that resolve any of the pending symbols
-// break search after first found module, so that first all dependencies of this module
-// are linked in, before going to the next library module
-static bool linked_libraries(StrHash* extern_syms) {
-	// search library chain
-	bool linked = false;
-	// search all libraries
-	for (obj_file_t* lib = g_libraries; !linked && lib != NULL; lib = lib->next) {
-		// search all object modules inside each library
-		int next_pos = -1;
-		for (int pos = 8; !linked && pos > 0 && pos < lib->size; pos = next_pos) {
-			lib->i = pos;
-			next_pos = parse_int(lib);
-			int module_size = parse_int(lib);
+static void lib_index_fini(lib_index_t* index) {
+	utarray_free(index->modules);
+	OBJ_DELETE(index->symbols);
+	OBJ_DELETE(index->queue);
+}
 
-			if (module_size == 0)
-				continue;					// deleted module
+static void lib_queue_push(intArray* queue, int id) {
+	size_t i = intArray_size(queue);
+	*(intArray_push(queue)) = id;
+
+	// sift up
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		int* a = intArray_item(queue, parent);
+		int* b = intArray_item(queue, i);
+		if (*a <= *b)
+			break;
+		int tmp = *a; *a = *b; *b = tmp;
+		i = parent;
+	}
+}
+
+static int lib_queue_pop(intArray* queue) {
+	size_t size = intArray_size(queue);
+	xassert(size > 0);
+	int id = *intArray_item(queue, 0);
+	*intArray_item(queue, 0) = *intArray_item(queue, size - 1);
+	intArray_pop(queue);
+	size--;
+
+	// sift down
+	size_t i = 0;
+	while (true) {
+		size_t child = 2 * i + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size && *intArray_item(queue, child + 1) < *intArray_item(queue, child))
+			child++;
+		int* a = intArray_item(queue, i);
+		int* b = intArray_item(queue, child);
+		if (*a <= *b)
+			break;
+		int tmp = *a; *a = *b; *b = tmp;
+		i = child;
+	}
+	return id;
+}
 
-			// define an obj_file_t to link
-			obj_file_t obj;
-			obj.filename = lib->filename;
-			obj.data = lib->data + lib->i;
-			obj.size = module_size;
-			obj.i = 0;
-			if (linked_module(&obj, extern_syms))
-				linked = true;
+// queue the first library module that defines a still undefined symbol
+static void lib_queue_extern(lib_index_t* index, const char* name) {
+	if (find_global_symbol(name) != NULL)
+		return;								// already defined
+
+	lib_module_t* module = (lib_module_t*)StrHash_get(index->symbols, name);
+	if (module != NULL && !module->linked)
+		lib_queue_push(index->queue, module->id);
+}
+
+// queue the modules that resolve the external names of the given object
+static void lib_queue_obj_externs(lib_index_t* index, obj_file_t* obj) {
+	xassert(goto_modname(obj));
+	int end_external_names = obj->i;
+	if (goto_external_names(obj)) {
+		while (obj->i < end_external_names) {
+			const char* name = parse_bcount_str(obj);
+			lib_queue_extern(index, name);
 		}
 	}
-	return linked;
 }
 
-// link libraries in the order given in the command line
+// check if the module defines any of the pending external symbols
+static bool lib_module_needed(lib_module_t* module, StrHash* extern_syms) {
+	obj_file_t* obj = &module->obj;
+	char symbol_name[256];
+	if (goto_defined_names(obj)) {
+		while (true) {
+			int scope = parse_byte(obj);
+			if (scope == 0)
+				break;						// end of list
+			obj->i++;						// skip type
+			skip_bcount_str(obj);			// skip section name
+			obj->i += 4;					// skip value
+			peek_bcount_str(obj, symbol_name);
+			skip_bcount_str(obj);			// skip defined file name
+			obj->i += 4;					// skip line number
+
+			if (scope == 'G' &&
+				StrHash_exists(extern_syms, symbol_name) &&
+				find_global_symbol(symbol_name) == NULL)
+				return true;
+		}
+	}
+	return false;
+}
+
+// link libraries in the order given in the command line:
+// the next module pulled in is always the first module, in library search
+// order, that defines any of the pending symbols, so that all dependencies
+// of a module are linked in before the next library module; the candidates
+// are kept in a priority queue fed by a symbol index, so that each library
+// is scanned only once
 static void link_libraries(StrHash* extern_syms) {
-	// while symbols to resolve and new module pulled in
-	while (!get_num_errors() &&
-		pending_syms(extern_syms) &&
-		linked_libraries(extern_syms)) {
-		// loop
+	lib_index_t index;
+	lib_index_init(&index);
+
+	// queue modules for the externals of the object files
+	if (pending_syms(extern_syms)) {
+		for (StrHashElem* elem = StrHash_first(extern_syms); elem != NULL; elem = StrHash_next(elem))
+			lib_queue_extern(&index, elem->key);
 	}
+
+	while (!get_num_errors() && intArray_size(index.queue) > 0) {
+		int id = lib_queue_pop(index.queue);
+		lib_module_t* module = (lib_module_t*)utarray_eltptr(index.modules, id);
+		xassert(module);
+
+		// skip modules already linked or whose symbols were meanwhile defined
+		if (module->linked || !lib_module_needed(module, extern_syms))
+			continue;
+
+		module->linked = true;
+		xassert(goto_modname(&module->obj));
+		const char* modname = parse_bcount_str(&module->obj);
+		module->obj.i = 0;
+		link_lib_module(modname, &module->obj, extern_syms);
+
+		// queue modules that resolve the new external symbols
+		lib_queue_obj_externs(&index, &module->obj);
+	}
+
+	pending_syms(extern_syms);				// drop symbols defined by library modules
+
+	lib_index_fini(&index);
 }
 
 /*-----------------------------------------------------------------------------
@@ -68,6 +68,7 @@ static void option_cpu_ti83plus(void);
 static void option_appmake_zx(void);
 static void option_appmake_zx81(void);
 static void option_filler(const char *filler_arg );
+static void option_jobs(const char *jobs_arg );
 static void option_debug_info();
 static void define_assembly_defines();
 static void include_z80asm_lib();
@@ -701,6 +702,15 @@ static void option_filler(const char *filler_arg )
 		opts.filler = value;
 }
 
+static void option_jobs(const char *jobs_arg )
+{
+	int value = number_arg(jobs_arg);
+	if (value < 1)
+		error_invalid_jobs_option(jobs_arg);
+	else
+		opts.jobs = value;
+}
+
 static void option_debug_info()
 {
 	opts.debug_info = true;
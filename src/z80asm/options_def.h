@@ -52,6 +52,7 @@ OPT_VAR(argv_t *,	lib_path, NULL)			/* path for library files */
 OPT_VAR(argv_t *,	files,	  NULL)			/* list of input files */
 
 OPT_VAR(int,		filler,		0)			/* filler byte for defs */
+OPT_VAR(int,		jobs,		1)			/* files assembled in parallel */
 
 /*-----------------------------------------------------------------------------
 *   define options
@@ -97,7 +98,8 @@ OPT(OptString, (void*)&opts.output_directory, "-O", "--out-dir", "Output directo
 OPT(OptString, (void*)&opts.bin_file, "-o", "--output", "Output binary file", "FILE")
 OPT(OptSet, &opts.make_bin, "-b", "--make-bin", "Assemble and link/relocate to file" FILEEXT_BIN, "")
 OPT(OptSet, &opts.split_bin, "", "--split-bin", "Create one binary file per section", "")
-OPT(OptSet, &opts.date_stamp, "-d", "--update", "Assemble only updated files", "")
+OPT(OptSet, &opts.date_stamp, "-d", "--update", "Assemble only updated files, update libraries in place", "")
+OPT(OptCallArg, option_jobs, "-j", "--jobs", "Assemble up to N files in parallel", "N")
 OPT(OptCallArg, option_origin, "-r", "--origin", "Relocate binary file to given address (decimal or hex)", "ADDR")
 OPT(OptSet, &opts.relocatable, "-R", "--relocatable", "Create relocatable code", "")
 OPT(OptSet, &opts.reloc_info, "", "--reloc-info", "Geneate binary file relocation information", "")
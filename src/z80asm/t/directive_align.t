@@ -107,7 +107,7 @@ END
 check_bin_file("test.bin", pack("C*", 0, (0) x 15, 1,2,3,4));
 
 z80nm("test.o", <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section code: 1 bytes
     C $0000: 00
@@ -170,7 +170,7 @@ z80asm(
 END
 );
 z80nm("test.o", <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 1 bytes
     C $0000: C9
@@ -186,7 +186,7 @@ z80asm(
 END
 );
 z80nm("test.o", <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: lib
   Section "": 1 bytes
     C $0000: C9
@@ -203,7 +203,7 @@ z80asm(
 END
 );
 z80nm("test.o", <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: lib2
   Section "": 1 bytes
     C $0000: C9
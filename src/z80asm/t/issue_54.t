@@ -69,7 +69,7 @@ END
 
 
 z80nm("test.o", <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 1 bytes, ORG $FDE8
     C $0000: C9
@@ -0,0 +1,67 @@
+#!/usr/bin/perl
+
+# Z88DK Z80 Macro Assembler
+#
+# Copyright (C) Paulo Custodio, 2011-2020
+# License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+# Repository: https://github.com/z88dk/z88dk/
+#
+# Test -d -x: libraries keep a module directory and are updated in place
+
+use Modern::Perl;
+use Test::More;
+require './t/testlib.pl';
+
+unlink_testfiles();
+spew("test.lst", join("\n", map {"test$_.asm"} 1..3));
+for (1..3) {
+	spew("test$_.asm", "public f$_\nf$_: ld a,$_\nret");
+}
+spew("test.asm", <<'END');
+	extern f1, f2, f3
+	call f1
+	call f2
+	call f3
+	ret
+END
+
+# without -d: no directory
+run('z80asm -xtest.lib @test.lst');
+my $plain = slurp("test.lib");
+unlike $plain, qr/Z80LDR01/, "no directory";
+
+# with -d: library with directory
+unlink "test.lib";
+run('z80asm -d -xtest.lib @test.lst');
+my $lib = slurp("test.lib");
+like $lib, qr/^Z80LMF\d\d.{8}Z80RMF\d\dZ80LDR01/s, "directory";
+like $lib, qr/test1\.o.*test2\.o.*test3\.o/s, "directory names";
+
+run('z80asm -b -itest.lib test.asm');
+check_bin_file("test.bin", pack("C*", 0xCD, 10, 0, 0xCD, 13, 0, 0xCD, 16, 0, 0xC9,
+									  0x3E, 1, 0xC9, 0x3E, 2, 0xC9, 0x3E, 3, 0xC9));
+
+# nothing changed: library not touched
+run('z80asm -d -xtest.lib @test.lst');
+is slurp("test.lib"), $lib, "same library";
+
+# change one module: appended, others kept in place
+sleep 1;
+spew("test2.asm", "public f2\nf2: ld a,22\nret");
+run('z80asm -d -xtest.lib @test.lst');
+my $new_lib = slurp("test.lib");
+ok length($new_lib) > length($lib), "module appended";
+
+run('z80asm -b -itest.lib test.asm');
+check_bin_file("test.bin", pack("C*", 0xCD, 10, 0, 0xCD, 13, 0, 0xCD, 16, 0, 0xC9,
+									  0x3E, 1, 0xC9, 0x3E, 22, 0xC9, 0x3E, 3, 0xC9));
+
+# z80nm shows the directory and the modules in library order
+build_z80nm();
+my $nm = `z80nm -d test.lib`;
+like $nm, qr/Module directory at \$[0-9A-F]+: 3 modules/, "z80nm directory";
+like $nm, qr/test1\.o.*test2\.o.*test3\.o/s, "z80nm directory order";
+like $nm, qr/Name: test1.*Name: test2.*Name: test3/s, "z80nm module order";
+
+unlink_testfiles();
+done_testing();
@@ -0,0 +1,69 @@
+#!/usr/bin/perl
+
+# Z88DK Z80 Macro Assembler
+#
+# Copyright (C) Gunther Strube, InterLogic 1993-99
+# Copyright (C) Paulo Custodio, 2011-2020
+# License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+# Repository: https://github.com/z88dk/z88dk/
+#
+# Test resolution of DEFC expressions that depend on each other at link time
+
+use Modern::Perl;
+use Test::More;
+require './t/testlib.pl';
+
+unlink_testfiles();
+
+# long chain defined in reverse order, resolved from an address
+my $asm = "\tpublic start\nstart:\tnop\n";
+for (my $i = 1000; $i > 0; $i--) {
+	$asm .= "\tdefc chain$i = chain".($i-1)." + 1\n";
+}
+$asm .= "\tdefc chain0 = start\n";
+$asm .= "\tdefw chain1000\n";
+z80asm($asm, "-b");
+check_bin_file("test.bin", pack("Cv", 0, 1000));
+
+# chain across modules
+spew("test1.asm", <<'...');
+	public aa
+	extern bb
+	defc aa = bb * 2
+...
+spew("test2.asm", <<'...');
+	public bb
+	extern cc
+	defc bb = cc + 1
+...
+spew("test3.asm", <<'...');
+	public cc
+	extern aa
+	defc cc = ASMPC
+	defw aa
+...
+run("z80asm -b test1.asm test2.asm test3.asm", 0, '', '');
+check_bin_file("test1.bin", pack("v", 2));
+
+# circular definition across modules
+spew("test3.asm", <<'...');
+	public cc
+	extern aa
+	defc cc = aa - 1
+	defw aa
+...
+run("z80asm -b test1.asm test2.asm test3.asm", 1, '', <<'...');
+Error at file 'test1.asm' line 3: circular definition of symbols: aa -> bb -> cc -> aa
+...
+
+# circular definition in one module
+z80asm(<<'...', "-b", 1, '', <<'...');
+	defc aa = bb + 1
+	defc bb = aa + 1
+	defw aa
+...
+Error at file 'test.asm' line 1: circular definition of symbols: aa -> bb -> aa
+...
+
+unlink_testfiles();
+done_testing();
@@ -66,7 +66,7 @@ t_z80asm_capture(asm_file(), "", "", 0);
 $obj = read_binfile(o_file());
 t_binary($obj, objfile(NAME => 'test'));
 t_z80nm(o_file(), <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
 END
 
@@ -78,7 +78,7 @@ $obj = read_binfile(o_file());
 t_binary($obj, objfile(NAME => 'test',
 					   CODE => [["", -1, 1, "\x00"]]));
 t_z80nm(o_file(), <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 1 bytes
     C $0000: 00
@@ -92,7 +92,7 @@ $obj = read_binfile(o_file());
 t_binary($obj, objfile(NAME => 'test',
 					   CODE => [["", -1, 1, "\x00" x 0x10000]]));
 t_z80nm(o_file(), <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 65536 bytes
     C $0000: 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00
@@ -4201,7 +4201,7 @@ $obj = read_binfile(o_file());
 t_binary($obj, objfile(NAME => 'test',
 					   CODE => [["", 0, 1, "\x00"]]));
 t_z80nm(o_file(), <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 1 bytes, ORG $0000
     C $0000: 00
@@ -4214,7 +4214,7 @@ $obj = read_binfile(o_file());
 t_binary($obj, objfile(NAME => 'test',
 					   CODE => [["", 0xFFFF, 1, "\x00"]]));
 t_z80nm(o_file(), <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 1 bytes, ORG $FFFF
     C $0000: 00
@@ -4249,7 +4249,7 @@ t_binary($obj, objfile(NAME => 'test',
                                     "\x21\x00\x00\x39".
                                     "\x21\x7F\x00\x39"]]));
 t_z80nm(o_file(), <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 42 bytes
     C $0000: 3E 0C DD 46 0C 11 0C 00 0C 00 00 00 EB 21 80 00
@@ -4296,7 +4296,7 @@ t_binary($obj, objfile(NAME => 'test',
                     "\x21\x00\x00\x39".
                     "\x21\x7F\x00\x39"]]));
 t_z80nm(o_file(), <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 42 bytes
     C $0000: 3E 0C DD 46 0C 11 0C 00 0C 00 00 00 EB 21 80 00
@@ -4348,7 +4348,7 @@ t_binary($obj, objfile(NAME => 'test',
                     "\x21\x00\x00\x39".
                     "\x21\x7F\x00\x39"]]));
 t_z80nm(o_file(), <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 42 bytes
     C $0000: 3E 0C DD 46 0C 11 0C 00 0C 00 00 00 EB 21 80 00
@@ -4378,12 +4378,13 @@ t_z80asm_capture(asm_file(), "", "", 0);
 $obj = read_binfile(o_file());
 t_binary($obj, objfile(NAME => 'test',
 		       EXPR => [
-				["U", "test.asm",3,  "", 0,  1, "", "label*4"],
-				["S", "",4,          "", 2,  4, "", "label*5"],
-				["C", "test.inc",2,  "", 5,  6, "", "label*2"],
-				["C", "test.asm",6,  "", 8,  9, "", "label2*4"],
-				["C", "test.inc",2,  "",11, 12, "", "label*2"],
-				["L", "test.asm",8,  "",14, 14, "", "label2*6"]],
+				["U", "test.asm",3,  "", 0,  1, "", "label*4",  "S\0\0b\x04\x90"],
+				["S", "",4,          "", 2,  4, "", "label*5",  "S\0\0b\x05\x90"],
+				["C", "test.inc",2,  "", 5,  6, "", "label*2",  "S\0\0b\x02\x90"],
+				["C", "test.asm",6,  "", 8,  9, "", "label2*4", "S\1\0b\x04\x90"],
+				["C", "test.inc",2,  "",11, 12, "", "label*2",  "S\0\0b\x02\x90"],
+				["L", "test.asm",8,  "",14, 14, "", "label2*6", "S\1\0b\x06\x90"]],
+		       NAMES => ["label", "label2"],
 		       SYMBOLS => [
 					["L", "A", "", 0, "label", "test.asm", 3],
 					["L", "A", "", 8, "label2", "test.asm", 6]],
@@ -4395,7 +4396,7 @@ t_binary($obj, objfile(NAME => 'test',
 					"\x01\x00\x00".			# addr  11
 					"\x00\x00\x00\x00"]]));	# addr  14
 t_z80nm(o_file(), <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 18 bytes, ORG $0003
     C $0000: 3E 00 DD 46 00 01 00 00 11 00 00 01 00 00 00 00
@@ -4427,8 +4428,9 @@ t_z80asm_capture(asm_file(), "", "", 0);
 $obj = read_binfile(o_file());
 t_binary($obj, objfile(NAME => 'test',
 		       EXPR => [
-				["C", "test.asm",7, "", 1, 2, "", "extobj"],
-				["C", "",8,         "", 4, 5, "", "extlib"]],
+				["C", "test.asm",7, "", 1, 2, "", "extobj", "S\0\0"],
+				["C", "",8,         "", 4, 5, "", "extlib", "S\1\0"]],
+		       NAMES => ["extobj", "extlib"],
 		       SYMBOLS => [
 					["L", "A", "", 0, "local", "test.asm", 6],
 				    ["G", "A", "", 1, "global", "test.asm", 7]],
@@ -4438,7 +4440,7 @@ t_binary($obj, objfile(NAME => 'test',
 		                "\xCD\x00\x00".
 		                "\xCD\x00\x00"]]));
 t_z80nm(o_file(), <<'END');
-Object  file test.o at $0000: Z80RMF14
+Object  file test.o at $0000: Z80RMF15
   Name: test
   Section "": 7 bytes
     C $0000: 00 CD 00 00 CD 00 00
@@ -4469,15 +4471,15 @@ my $obj2 = read_binfile(o2_file());
 my $lib  = read_binfile(lib_file());
 t_binary($lib, libfile( $obj1, $obj2 ));
 t_z80nm(lib_file(), <<'END');
-Library file test.lib at $0000: Z80LMF14
-Object  file test.lib at $0010: Z80RMF14
+Library file test.lib at $0000: Z80LMF15
+Object  file test.lib at $0010: Z80RMF15
   Name: test1
   Section "": 1 bytes
     C $0000: C9
   Symbols:
     G A $0000 mult (section "") (file test1.asm:3)
 
-Object  file test.lib at $0067: Z80RMF14
+Object  file test.lib at $0067: Z80RMF15
   Name: test2
   Section "": 1 bytes
     C $0000: C9
@@ -4504,7 +4506,8 @@ write_file(asm2_file(), "EXTERN main \n jp main");
 t_z80asm_capture(asm2_file(), "", "", 0);
 $obj = read_binfile(o2_file());
 t_binary($obj, objfile(NAME => 'test2',
-				EXPR => [["C", "test2.asm",2, "", 0, 1, "", "main"]],
+				EXPR => [["C", "test2.asm",2, "", 0, 1, "", "main", "S\0\0"]],
+				NAMES => ["main"],
 				LIBS => ["main"],
 				CODE => [["", -1, 1, "\xC3\0\0"]]));
 write_binfile(o3_file(), $obj);
@@ -4512,6 +4515,14 @@ write_binfile(o3_file(), $obj);
 t_z80asm_capture(join(" ", "", "-b -d", asm_file(), asm1_file(), asm2_file()), "", "", 0);
 t_binary(read_binfile(bin_file()), "\xC3\x00\x00");
 
+# expressions without bytecode are parsed from the text
+write_binfile(o2_file(), objfile(NAME => 'test2',
+				EXPR => [["C", "test2.asm",2, "", 0, 1, "", "main+2*3"]],
+				LIBS => ["main"],
+				CODE => [["", -1, 1, "\xC3\0\0"]]));
+t_z80asm_capture(join(" ", "", "-b", o_file(), o1_file(), o2_file()), "", "", 0);
+t_binary(read_binfile(bin_file()), "\xC3\x06\x00");
+
 #------------------------------------------------------------------------------
 # White box tests
 #------------------------------------------------------------------------------
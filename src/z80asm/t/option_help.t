@@ -75,7 +75,8 @@ Binary Output:
   -o, --output=FILE      Output binary file
   -b, --make-bin         Assemble and link/relocate to file.bin
   --split-bin            Create one binary file per section
-  -d, --update           Assemble only updated files
+  -d, --update           Assemble only updated files, update libraries in place
+  -j, --jobs=N           Assemble up to N files in parallel
   -r, --origin=ADDR      Relocate binary file to given address (decimal or hex)
   -R, --relocatable      Create relocatable code
   --reloc-info           Geneate binary file relocation information
@@ -0,0 +1,69 @@
+#!/usr/bin/perl
+
+# Z88DK Z80 Module Assembler
+#
+# Copyright (C) Paulo Custodio, 2011-2020
+# License: The Artistic License 2.0, http://www.perlfoundation.org/artistic_license_2_0
+# Repository: https://github.com/z88dk/z88dk/
+#
+# Test -j, --jobs
+
+use Modern::Perl;
+use Test::More;
+require './t/testlib.pl';
+
+# link
+for my $options ('-j=2', '-j2', '--jobs=3', '--jobs=1') {
+	make_test_files();
+	run("z80asm $options -b test1.asm test2.asm test3.asm test4.asm");
+	check_bin_file("test1.bin", pack("C*", 1..4));
+}
+
+# library
+make_test_files();
+run('z80asm -j=4 -xtest.lib test1.asm test2.asm test3.asm test4.asm');
+ok -f "test.lib", "test.lib";
+spew("test.asm", <<'END');
+	extern test1, test4
+	defw test1, test4
+END
+run('z80asm -b -itest.lib test.asm');
+ok -f "test.bin", "test.bin";
+
+# errors are shown in the order of the input files
+make_test_files();
+spew("test2.asm", "ld a,");
+spew("test4.asm", "jp nowhere");
+run('z80asm -j=4 -b test1.asm test2.asm test3.asm test4.asm', 1, "", <<'ERR');
+Error at file 'test2.asm' line 1: syntax error
+Error at file 'test4.asm' line 1: symbol 'nowhere' not defined
+ERR
+ok -f "test2.err", "test2.err";
+ok -f "test4.err", "test4.err";
+ok ! -f "test1.bin", "no test1.bin";
+
+# objects given, or up-to-date with -d, are not assembled again
+make_test_files();
+run('z80asm -b test1.asm test2.asm test3.asm test4.asm');
+unlink "test1.asm", "test3.asm";
+run('z80asm -j=4 -d -b test1.o test2.asm test3 test4.asm');
+check_bin_file("test1.bin", pack("C*", 1..4));
+
+# invalid values
+for my $jobs (0, -1, 'x') {
+	make_test_files();
+	run("z80asm -j=$jobs -b test1.asm", 1, "", <<"ERR");
+Error: invalid number of jobs: $jobs
+ERR
+}
+
+unlink_testfiles();
+done_testing();
+
+sub make_test_files {
+	unlink_testfiles();
+	for (1..4) {
+		spew("test$_.asm", "public test$_\ntest$_: defb $_");
+		ok -f "test$_.asm", "create test$_.asm";
+	}
+}
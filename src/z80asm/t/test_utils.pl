@@ -18,7 +18,7 @@ use Test::Differences;
 use List::Uniq 'uniq';
 use Data::HexDump;
 
-my $OBJ_FILE_VERSION = "14";
+my $OBJ_FILE_VERSION = "15";
 my $STOP_ON_ERR = grep {/-stop/} @ARGV;
 my $KEEP_FILES	= grep {/-keep/} @ARGV;
 my $test	 = "test";
@@ -375,12 +375,15 @@ sub objfile {
 	# store expressions
 	if ($args{EXPR}) {
 		store_ptr(\$o, $expr_addr);
+		my @names = @{$args{NAMES} // []};
+		$o .= pack("v", scalar(@names)) . join('', map {pack_string($_)} @names);
 		for (@{$args{EXPR}}) {
-			@$_ == 8 or die;
-			my($type, $filename, $line_nr, $section, $asmptr, $ptr, $target_name, $text) = @$_;
+			@$_ == 8 || @$_ == 9 or die;
+			my($type, $filename, $line_nr, $section, $asmptr, $ptr, $target_name, $text, $code) = @$_;
 			$o .= $type . pack_lstring($filename) . pack("V", $line_nr) .
 			        pack_string($section) . pack("vv", $asmptr, $ptr) .
-					pack_string($target_name) . pack_lstring($text);
+					pack_string($target_name) . pack_lstring($text) .
+					pack_lstring($code // "");
 		}
 		$o .= "\0";
 	}
@@ -54,7 +54,7 @@ ok $bin eq  "\x01\x02\x03\x04\x05".
 			"\x55\x55\xaa\xaa", "bin ok";
 
 run_ok("z80nm -a $test.o", <<'END', '');
-Object  file test1.o at $0000: Z80RMF14
+Object  file test1.o at $0000: Z80RMF15
   Name: test1
   Section "": 50 bytes
     C $0000: 01 02 03 04 05 68 65 6C 6C 6F 77 6F 72 6C 64 34
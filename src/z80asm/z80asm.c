@@ -23,6 +23,12 @@ Repository: https://github.com/z88dk/z88dk
 #include "zobjfile.h"
 #include <sys/stat.h>
 
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 /* external functions */
 void Z80pass2( void );
 void CreateBinFile( void );
@@ -41,17 +47,53 @@ size_t sizeof_reloctable   = 0;
 
 char *reloctable = NULL, *relocptr = NULL;
 
+/* set while loading the object file assembled by a -j worker */
+static bool obj_assembled = false;
+
 /* local functions */
 static void query_assemble(const char *src_filename );
 static void do_assemble(const char *src_filename );
 
 /*-----------------------------------------------------------------------------
-*   Assemble one source file
+*   Find the file to use for the given input file name, NULL if none found
 *	- if a .o file is given, and it exists, it is used without trying to assemble first
 *	- if the given file exists, whatever the extension, try to assembly it
 *	- if all above fail, try to replace/append the .asm extension and assemble
 *	- if all above fail, try to replace/append the .o extension and link
 *----------------------------------------------------------------------------*/
+static const char *find_input_file(const char *filename, bool *load_obj_only)
+{
+	const char *obj_filename = path_canon(get_obj_filename(filename));
+
+	*load_obj_only = false;
+
+	/* try to load object file */
+	if (strcmp(filename, obj_filename) == 0 &&			/* input is object file */
+		file_exists(filename)							/* .o file exists */
+		) {
+		*load_obj_only = true;
+		return filename;
+	}
+
+	/* use input file if it exists */
+	if (file_exists(filename))
+		return filename;								/* use whatever extension was given */
+
+	const char *asm_filename = get_asm_filename(filename);
+	if (file_exists(asm_filename))						/* file with .asm extension exists */
+		return asm_filename;
+
+	if (file_exists(obj_filename)) {
+		*load_obj_only = true;
+		return obj_filename;
+	}
+
+	return NULL;
+}
+
+/*-----------------------------------------------------------------------------
+*   Assemble one source file, see find_input_file() for the file used
+*----------------------------------------------------------------------------*/
 void assemble_file( const char *filename )
 {
 	// must canonize input file name so that comparison to .o below works
@@ -66,34 +108,10 @@ void assemble_file( const char *filename )
 	obj_filename = path_canon(get_obj_filename(filename));
 	path_mkdir(path_dir(obj_filename));
 
-	/* try to load object file */
-	if (strcmp(filename, obj_filename) == 0 &&			/* input is object file */
-		file_exists(filename)							/* .o file exists */
-		) {
-		load_obj_only = true;
-		src_filename = filename;
-	}
-	else {
-		load_obj_only = false;
-
-		/* use input file if it exists */
-		if (file_exists(filename)) {
-			src_filename = filename;						/* use whatever extension was given */
-		}
-		else {
-			const char *asm_filename = get_asm_filename(filename);
-			if (file_exists(asm_filename)) {				/* file with .asm extension exists */
-				src_filename = asm_filename;
-			}
-			else if (file_exists(obj_filename)) {
-				load_obj_only = true;
-				src_filename = obj_filename;
-			}
-			else {				
-				error_read_file(filename);
-				return;
-			}
-		}
+	src_filename = find_input_file(filename, &load_obj_only);
+	if (src_filename == NULL) {
+		error_read_file(filename);
+		return;
 	}
 	
 	/* append the directoy of the file being assembled to the include path 
@@ -143,13 +161,14 @@ static void query_assemble(const char *src_filename )
     src_stat_result = stat( src_filename, &src_stat );		/* BUG_0033 */
     obj_stat_result = stat( obj_filename, &obj_stat );
 
-    if ( opts.date_stamp &&									/* -d option */
+    if ( ( obj_assembled ||								/* -j worker just assembled it */
+           ( opts.date_stamp &&								/* -d option */
             obj_stat_result >= 0 &&							/* object file exists */
             ( src_stat_result >= 0 ?						/* if source file exists, ... */
               src_stat.st_mtime <= obj_stat.st_mtime		/* ... source older than object */
               : true										/* ... else source does not exist, but object exists
 															   --> consider up-to-date (e.g. test.c -> test.o) */
-            ) &&
+            ) ) ) &&
 			object_file_append(obj_filename, CURRENTMODULE, true, true)	/* object file valid and size loaded */
        )
     {
@@ -220,6 +239,171 @@ static void do_assemble(const char *src_filename )
 		putchar('\n');    /* separate module texts */
 }
 
+/*-----------------------------------------------------------------------------
+*	Assemble files in parallel (-j)
+*	Each source file that needs assembling is assembled by a worker process
+*	forked after the command line is parsed. The output of each worker is
+*	captured and shown in the order of the input files. The main process
+*	then loads the object files as if -d had found them up-to-date, so
+*	linking and library creation see the same modules as before.
+*----------------------------------------------------------------------------*/
+#ifndef _WIN32
+typedef struct job_t
+{
+	const char	*filename;			/* input file name */
+	pid_t		 pid;				/* worker, 0 if not started */
+	FILE		*out, *err;			/* captured stdout and stderr */
+	bool		 done;				/* worker finished or not started */
+	bool		 ok;				/* object file assembled */
+} job_t;
+
+/* check if the file will be assembled, and not loaded from an object file */
+static bool needs_assembly(const char *filename)
+{
+	struct stat src_stat, obj_stat;
+	bool load_obj_only;
+
+	const char *src_filename = find_input_file(path_canon(filename), &load_obj_only);
+	if (src_filename == NULL || load_obj_only)
+		return false;
+
+	/* let the main process check if the object file is up-to-date */
+	if (opts.date_stamp &&
+		stat(get_obj_filename(src_filename), &obj_stat) >= 0 &&
+		(stat(src_filename, &src_stat) < 0 || src_stat.st_mtime <= obj_stat.st_mtime))
+		return false;
+
+	return true;
+}
+
+static void start_job(job_t *job)
+{
+	job->done = true;
+	if (!needs_assembly(job->filename))
+		return;
+
+	/* create output directory here, the workers could race creating it */
+	path_mkdir(path_dir(get_obj_filename(path_canon(job->filename))));
+
+	if ((job->out = tmpfile()) == NULL)
+		return;
+	if ((job->err = tmpfile()) == NULL) {
+		fclose(job->out);
+		job->out = NULL;
+		return;
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+	job->pid = fork();
+	if (job->pid == 0) {
+		dup2(fileno(job->out), STDOUT_FILENO);
+		dup2(fileno(job->err), STDERR_FILENO);
+
+		assemble_file(job->filename);
+		close_error_file();
+
+		fflush(stdout);
+		fflush(stderr);
+		_exit(get_num_errors() ? 1 : 0);	/* skip the atexit() cleanup of the parent's data */
+	}
+	else if (job->pid < 0) {				/* assemble it in the main process instead */
+		job->pid = 0;
+		fclose(job->out);
+		fclose(job->err);
+		job->out = job->err = NULL;
+	}
+	else {
+		job->done = false;
+	}
+}
+
+static void copy_output(FILE *from, FILE *to)
+{
+	char buffer[BUFSIZ];
+	size_t n;
+
+	rewind(from);
+	while ((n = fread(buffer, 1, sizeof(buffer), from)) > 0)
+		fwrite(buffer, 1, n, to);
+	fflush(to);
+	fclose(from);
+}
+
+static void show_job(job_t *job)
+{
+	if (job->pid == 0)
+		return;
+
+	copy_output(job->out, stdout);
+	copy_output(job->err, stderr);
+	job->out = job->err = NULL;
+
+	if (!job->ok)
+		add_error_count(1);					/* the worker has shown its errors */
+}
+
+static void end_job(job_t *jobs, int num_jobs, pid_t pid, int status)
+{
+	for (int i = 0; i < num_jobs; i++) {
+		if (jobs[i].pid == pid && !jobs[i].done) {
+			jobs[i].done = true;
+			jobs[i].ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+			if (!WIFEXITED(status)) {
+				set_error_null();
+				error_job_failed(jobs[i].filename);
+			}
+			return;
+		}
+	}
+}
+
+static job_t *assemble_jobs(argv_t *files)
+{
+	int num_jobs = argv_len(files);
+	job_t *jobs = xcalloc(num_jobs, sizeof(job_t));
+	int next = 0, shown = 0, running = 0;
+
+	for (int i = 0; i < num_jobs; i++)
+		jobs[i].filename = argv_front(files)[i];
+
+	while (shown < num_jobs) {
+		while (next < num_jobs && running < opts.jobs) {
+			start_job(&jobs[next++]);
+			if (!jobs[next - 1].done)
+				running++;
+		}
+
+		/* show output in input order */
+		while (shown < next && jobs[shown].done)
+			show_job(&jobs[shown++]);
+
+		if (running > 0) {
+			int status;
+			pid_t pid = wait(&status);
+			if (pid < 0) {
+				if (errno == EINTR)
+					continue;
+				for (int i = 0; i < next; i++) {	/* no more workers to wait for */
+					if (!jobs[i].done) {
+						jobs[i].done = true;
+						set_error_null();
+						error_job_failed(jobs[i].filename);
+					}
+				}
+				running = 0;
+			}
+			else {
+				end_job(jobs, next, pid, status);
+				running--;
+			}
+		}
+	}
+
+	return jobs;
+}
+#endif
+
 /***************************************************************************************************
  * Main entry of Z80asm
  ***************************************************************************************************/
@@ -233,6 +417,22 @@ int z80asm_main( int argc, char *argv[] )
 	*	and assembles each one in turn */
 	parse_argv(argc, argv);
 	if (!get_num_errors()) {
+#ifndef _WIN32
+		if (opts.jobs > 1 && argv_len(opts.files) > 1) {
+			job_t *jobs = assemble_jobs(opts.files);
+
+			/* load the objects, assemble the files no worker could take */
+			for (int i = 0; i < argv_len(opts.files); i++) {
+				if (jobs[i].pid != 0 && !jobs[i].ok)
+					continue;
+				obj_assembled = jobs[i].ok;
+				assemble_file(jobs[i].filename);
+				obj_assembled = false;
+			}
+			xfree(jobs);
+		}
+		else
+#endif
 		for (char **pfile = argv_front(opts.files); *pfile; pfile++)
 			assemble_file(*pfile);
 	}
@@ -18,6 +18,7 @@ Handle object file contruction, reading and writing
 #include "model.h"
 #include "options.h"
 #include "str.h"
+#include "strhash.h"
 #include "strutil.h"
 #include "utstring.h"
 #include "zobjfile.h"
@@ -42,15 +43,44 @@ static long write_expr(FILE* fp)
 	char range;
 	const char* target_name;
 	long expr_ptr;
+	StrHash* names;
+	StrHashElem* name_it;
+	ByteArray* code;
+	intArray* code_start;
+	int i, start, size;
 
 	if (ExprList_empty(CURRENTMODULE->exprs))	/* no expressions */
 		return -1;
 
-	expr_ptr = ftell(fp);
+	/* encode all expressions, collect the names used */
+	names = OBJ_NEW(StrHash);
+	code = OBJ_NEW(ByteArray);
+	code_start = OBJ_NEW(intArray);
+
 	for (iter = ExprList_first(CURRENTMODULE->exprs); iter != NULL; iter = ExprList_next(iter))
 	{
 		expr = iter->obj;
 
+		/* a consolidated object drops the undefined local symbols the expressions
+		   point to, keep only the text in that case */
+		start = ByteArray_size(code);
+		*(intArray_push(code_start)) = start;
+		if (opts.consol_obj_file || !Expr_encode(expr, code, &names))
+			ByteArray_set_size(code, start);		/* empty: linker parses text */
+	}
+	*(intArray_push(code_start)) = ByteArray_size(code);
+
+	expr_ptr = ftell(fp);
+
+	/* store table of names */
+	xfwrite_word(names->count, fp);
+	for (name_it = StrHash_first(names); name_it != NULL; name_it = StrHash_next(name_it))
+		xfwrite_bcount_cstr(name_it->key, fp);
+
+	for (iter = ExprList_first(CURRENTMODULE->exprs), i = 0; iter != NULL; iter = ExprList_next(iter), i++)
+	{
+		expr = iter->obj;
+
 		/* store range */
 		range = 0;
 		if (expr->target_name)
@@ -95,11 +125,19 @@ static long write_expr(FILE* fp)
 		xfwrite_word(expr->code_pos, fp);				/* patchptr */
 		xfwrite_bcount_cstr(target_name, fp);			/* target symbol for expression */
 		xfwrite_wcount_cstr(Str_data(expr->text), fp);	/* expression */
+
+		/* bytecode, empty if not encoded */
+		start = *intArray_item(code_start, i);
+		size = *intArray_item(code_start, i + 1) - start;
+		xfwrite_wcount_bytes(size > 0 ? ByteArray_item(code, start) : NULL, size, fp);
 	}
 
 	xfwrite_byte(0, fp);								/* terminator */
 
 	STR_DELETE(last_sourcefile);
+	OBJ_DELETE(names);
+	OBJ_DELETE(code);
+	OBJ_DELETE(code_start);
 
 	return expr_ptr;
 }
@@ -269,14 +307,19 @@ void write_obj_file(const char* source_filename)
 *----------------------------------------------------------------------------*/
 static bool test_header(FILE* file)
 {
-	char buffer[Z80objhdr_size];
+	char buffer[Z80objhdr_size + 1];
+	int version;
 
 	if (fread(buffer, 1, Z80objhdr_size, file) == Z80objhdr_size &&
-		memcmp(buffer, Z80objhdr, Z80objhdr_size) == 0
-		)
-		return true;
-	else
-		return false;
+		memcmp(buffer, Z80objhdr, Z80objhdr_version_pos) == 0
+		) {
+		buffer[Z80objhdr_size] = '\0';
+		if (sscanf(buffer + Z80objhdr_version_pos, "%d", &version) == 1 &&
+			version >= OBJ_VERSION_MIN_LINK &&
+			version <= OBJ_VERSION_BYTECODE)
+			return true;
+	}
+	return false;
 }
 
 /*-----------------------------------------------------------------------------
@@ -556,7 +599,7 @@ bool check_obj_lib_file(const char* filename,
 		error_file(filename);
 		goto error;
 	}
-	if (version != expected) {
+	if (version < OBJ_VERSION_MIN_LINK || version > expected) {
 		error_version(filename, version, expected);
 		goto error;
 	}
@@ -18,7 +18,12 @@ Handle object file contruction, reading and writing
 #include <stdio.h>
 #include <stdlib.h>
 
-#define OBJ_VERSION	"14"
+#define OBJ_VERSION	"15"
+
+/* oldest object file version accepted by the linker; before version 15
+   expressions are stored only as text and need to be parsed again */
+#define OBJ_VERSION_MIN_LINK	14
+#define OBJ_VERSION_BYTECODE	15
 
 /*-----------------------------------------------------------------------------
 *   Write current module to object file - object file name is computed
@@ -82,7 +87,7 @@ extern ByteArray* read_obj_file_data(const char* filename);
    load module name and size, when assembling with -d and up-to-date */
 extern bool objmodule_loaded(const char* obj_filename);
 
-// check if the given filename exists and is an object file of the correct version
+// check if the given filename exists and is an object file of a version accepted by the linker
 extern bool check_object_file(const char* obj_filename);
 extern bool check_object_file_no_errors(const char* obj_filename);
 
@@ -14,13 +14,14 @@
 
 void usage(char *name)
 {
-	die("Usage %s [-a][-l][-e][-c] library\n"
+	die("Usage %s [-a][-l][-e][-c][-d] library\n"
 		"Display the contents of a z80asm library file\n"
 		"\n"
 		"-a\tShow all\n"
 		"-l\tShow local symbols\n"
 		"-e\tShow expression patches\n"
-		"-c\tShow code dump\n",
+		"-c\tShow code dump\n"
+		"-d\tShow module directory\n",
 		name);
 }
 
@@ -30,14 +31,16 @@ int main(int argc, char *argv[])
 	opt_obj_hide_local = true;
 	opt_obj_hide_expr = true;
 	opt_obj_hide_code = true;
+	opt_obj_hide_libdir = true;
 
 	int 	opt;
-	while ((opt = getopt(argc, argv, "leca")) != -1) {
+	while ((opt = getopt(argc, argv, "lecda")) != -1) {
 		switch (opt) {
 		case 'l': opt_obj_hide_local = false; break;
 		case 'e': opt_obj_hide_expr = false; break;
 		case 'c': opt_obj_hide_code = false; break;
-		case 'a': opt_obj_hide_local = opt_obj_hide_expr = opt_obj_hide_code = false; break;
+		case 'd': opt_obj_hide_libdir = false; break;
+		case 'a': opt_obj_hide_local = opt_obj_hide_expr = opt_obj_hide_code = opt_obj_hide_libdir = false; break;
 		default:
 			usage(argv[0]);
 			return 0;
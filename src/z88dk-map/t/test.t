@@ -0,0 +1,202 @@
+#!/usr/bin/perl
+#-----------------------------------------------------------------------------
+# z88dk-map - report the memory used by a z80asm build
+# License: http://www.perlfoundation.org/artistic_license_2_0
+#-----------------------------------------------------------------------------
+
+use Modern::Perl;
+use Path::Tiny;
+use Test::More;
+use Capture::Tiny 'capture';
+use Config;
+
+$ENV{PATH} = join($Config{path_sep}, 
+				".",
+				"../z80asm",
+				"../../bin",
+				$ENV{PATH});
+
+#------------------------------------------------------------------------------
+# build tools
+#------------------------------------------------------------------------------
+ok 0 == system("make"), "make";
+
+#------------------------------------------------------------------------------
+# build: two objects and a library module
+#------------------------------------------------------------------------------
+path("test_a.asm")->spew(<<'END');
+	section code
+	extern f1, f2
+	public main
+main:	call f1
+	call f2
+	ret
+	section data
+tbl:	defs 20
+	section bss
+buf:	defs 100
+END
+
+path("test_b.asm")->spew(<<'END');
+	section code
+	public f2
+f2:	ld a,1
+loop:	djnz loop
+	ret
+	section rodata
+msg:	defm "hello"
+END
+
+path("test_l1.asm")->spew(<<'END');
+	section code
+	public f1
+f1:	ld hl,0
+	ret
+	section data
+ldat:	defw 1,2,3
+END
+
+ok 0 == system("z80asm -xtest_lib test_l1.asm"), "library";
+ok 0 == system("z80asm -b -m -itest_lib.lib test_a.asm test_b.asm"), "build";
+path("test_a.map")->copy("test_old.map");
+
+#------------------------------------------------------------------------------
+# sections
+#------------------------------------------------------------------------------
+run("z88dk-map -s test_a.map", 0, <<'END', "");
+Sections:
+  Section                  Head   Tail      Bytes
+  code                     $0000  $0010        16
+  data                     $0010  $002A        26
+  bss                      $002A  $008E       100
+  rodata                   $008E  $0093         5
+  Total                                       147
+
+END
+
+#------------------------------------------------------------------------------
+# default section: bounded by __head and __tail, up to the next section
+#------------------------------------------------------------------------------
+path("test_d.asm")->spew(<<'END');
+	defb 1,2,3,4,5,6,7,8
+first:	defs 36
+last:	defb 0
+END
+
+ok 0 == system("z80asm -b -m test_d.asm"), "build";
+
+run("z88dk-map -s test_d.map", 0, <<'END', "");
+Sections:
+  Section                  Head   Tail      Bytes
+  (default)                $0000  $002D        45
+  Total                                        45
+
+END
+
+path("test_d.asm")->append(<<'END');
+	section code
+code1:	defs 10
+END
+
+ok 0 == system("z80asm -b -m test_d.asm"), "build";
+
+run("z88dk-map -s test_d.map", 0, <<'END', "");
+Sections:
+  Section                  Head   Tail      Bytes
+  (default)                $0000  $002D        45
+  code                     $002D  $0037        10
+  Total                                        55
+
+END
+
+#------------------------------------------------------------------------------
+# modules and libraries, estimated and from the objects
+#------------------------------------------------------------------------------
+run("z88dk-map -m test_a.map", 0, <<'END', "");
+Modules:
+  Module                              Bytes  Library
+  test_a                                127~ 
+  test_b                                 10~ 
+  test_l1                                10~ 
+  (~ estimated from the map, give the objects and libraries for exact sizes)
+
+END
+
+run("z88dk-map -l -m test_a.map test_a.o test_b.o test_lib.lib", 0, <<'END', "");
+Libraries:
+  Library                                   Modules    Bytes
+  test_lib.lib                                    1       10
+  (not from a library)                            2      137
+
+Modules:
+  Module                              Bytes  Library
+  test_a                                127  
+  test_b                                 10  
+  test_l1                                10  test_lib.lib
+
+END
+
+#------------------------------------------------------------------------------
+# largest symbols
+#------------------------------------------------------------------------------
+run("z88dk-map -t 3 test_a.map", 0, <<'END', "");
+Largest symbols:
+  Symbol                           Addr      Bytes  Section          Module
+  buf                              $002A       100  bss              test_a
+  tbl                              $0010        20  data             test_a
+  main                             $0000         7  code             test_a
+
+END
+
+#------------------------------------------------------------------------------
+# banks
+#------------------------------------------------------------------------------
+run("z88dk-map -b main,0,0x40 -b rodata,0x80,0x20 test_a.map", 0, <<'END', "");
+Banks:
+  Bank             Start  End        Used     Free
+  main             $0000  $003F       142      -78  overflow
+  rodata           $0080  $009F         5       27
+
+END
+
+#------------------------------------------------------------------------------
+# compare builds
+#------------------------------------------------------------------------------
+path("test_a.asm")->edit(sub { s/defs 100/defs 180/; s/defs 20/defs 10/; });
+ok 0 == system("z80asm -b -m -itest_lib.lib test_a.asm test_b.asm"), "build";
+
+run("z88dk-map -d test_old.map test_a.map", 0, <<'END', "");
+Section changes:
+  Name                                  Old      New   Change
+  bss                                   100      180      +80
+  data                                   26       16      -10
+
+Module changes:
+  Name                                  Old      New   Change
+  test_a                                127      197      +70
+
+Symbol changes:
+  Name                                  Old      New   Change
+  buf@test_a                            100      180      +80
+  tbl@test_a                             20       10      -10
+
+Total: 147 -> 217 bytes (+70)
+END
+
+run("z88dk-map -d test_old.map -g 80 test_a.map", 0, undef, "");
+run("z88dk-map -d test_old.map -g 50 test_a.map", 1, undef, <<'END');
+error: the build grew by 70 bytes, more than 50
+END
+
+unlink(<test*>);
+done_testing;
+
+
+sub run {
+	my($cmd, $exit, $out, $err) = @_;
+	ok 1, $cmd;
+	my($stdout, $stderr, $return) = capture { system $cmd; };
+	is $stdout, $out, "stdout" if defined $out;
+	is $stderr, $err, "stderr" if defined $err;
+	is !!$return, !!$exit, "exit";
+}
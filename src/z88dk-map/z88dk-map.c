@@ -1,3 +1,13 @@
+//-----------------------------------------------------------------------------
+// z88dk-map - report the memory used by a z80asm build
+// License: http://www.perlfoundation.org/artistic_license_2_0
+//
+// The map file written by z80asm -m is loaded into an indexed model: the
+// address symbols give the sections, the modules and the size of each
+// symbol (up to the next symbol). The object files and libraries of the
+// build, when given, tell the exact size of each module and the library
+// it was linked from.
+//-----------------------------------------------------------------------------
 
 // Version Information
 
@@ -5,9 +15,929 @@
 
 char *version = "v" Z88DK_VERSION;
 
+#include "die.h"
+#include "objfile.h"
+#include "optparse.h"
+#include "strutil.h"
+#include "uthash.h"
+#include "utlist.h"
+#include "utarray.h"
+#include "zutils.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//-----------------------------------------------------------------------------
+// Usage and command line options
+//-----------------------------------------------------------------------------
+static char usage[] =
+//   x   x   x   x   x   x   x   x   x   x   x   x   x   x   x   x   x   x   x
+"Usage: z88dk-map [options] file.map [objects and libraries of the build]\n"
+"  -v|--verbose                          ; show what is going on\n"
+"  -s|--sections                         ; bytes used by each section\n"
+"  -m|--modules                          ; bytes used by each module\n"
+"  -l|--libraries                        ; bytes used by each library\n"
+"  -t|--top n                            ; the n largest symbols\n"
+"  -b|--bank name,start,size             ; free space in a memory bank\n"
+"  -d|--diff old.map                     ; compare with an older build\n"
+"  -g|--max-growth n                     ; with -d fail if the build grew by\n"
+"                                        ; more than n bytes\n"
+"All the reports are shown when none is selected.\n"
+"A bank holds the sections named after it (name or name_*) and the other\n"
+"sections that start within it.\n"
+;
+
+#define OPT_VERBOSE			'v'
+#define OPT_SECTIONS		's'
+#define OPT_MODULES			'm'
+#define OPT_LIBRARIES		'l'
+#define OPT_TOP				't'
+#define OPT_BANK			'b'
+#define OPT_DIFF			'd'
+#define OPT_MAX_GROWTH		'g'
+
+static struct optparse_long longopts[] = {
+{ "verbose",	OPT_VERBOSE,		OPTPARSE_NONE },
+{ "sections",	OPT_SECTIONS,		OPTPARSE_NONE },
+{ "modules",	OPT_MODULES,		OPTPARSE_NONE },
+{ "libraries",	OPT_LIBRARIES,		OPTPARSE_NONE },
+{ "top",		OPT_TOP,			OPTPARSE_REQUIRED },
+{ "bank",		OPT_BANK,			OPTPARSE_REQUIRED },
+{ "diff",		OPT_DIFF,			OPTPARSE_REQUIRED },
+{ "max-growth",	OPT_MAX_GROWTH,		OPTPARSE_REQUIRED },
+{ 0,0,0 }
+};
+
+#define DEFAULT_TOP			20
+
+static bool opt_verbose = false;
+static bool opt_sections = false;
+static bool opt_modules = false;
+static bool opt_libraries = false;
+static int  opt_top = 0;
+static int  opt_max_growth = -1;
+
+//-----------------------------------------------------------------------------
 // Internal Representation of Memory Map
+//-----------------------------------------------------------------------------
+typedef struct map_library_s {
+	const char*	name;
+	int			size;
+	int			num_modules;			// linked from this library
+	UT_hash_handle hh;
+} map_library_t;
+
+typedef struct map_module_s {
+	const char*	name;
+	map_library_t* library;				// NULL if not from a library
+	bool		exact;					// size taken from the object file
+	int			size;
+	int			map_size;				// size estimated from the map alone
+	UT_hash_handle hh;
+} map_module_t;
+
+typedef struct map_section_s {
+	const char*	name;
+	int			head, tail;				// -1 if not in the map
+	UT_array*	bounds;					// addresses where a symbol or a module starts or ends
+	UT_hash_handle hh;
+} map_section_t;
+
+typedef struct map_symbol_s {
+	const char*	key;					// name@module
+	const char*	name;
+	int			value;
+	bool		is_addr;
+	bool		is_public;
+	int			size;					// bytes up to the next symbol or module
+	map_module_t* module;
+	map_section_t* section;
+	UT_hash_handle hh;
+} map_symbol_t;
+
+typedef struct map_s {
+	const char*	filename;
+	map_symbol_t* symbols;
+	map_section_t* sections;
+	map_module_t* modules;
+	map_library_t* libraries;
+	UT_array*	addr_symbols;			// map_symbol_t*, sorted by section and value
+} map_t;
+
+typedef struct map_bank_s {
+	const char*	name;
+	int			start, size;
+	int			used;
+	bool		overflow;				// a section does not fit
+	struct map_bank_s* next;
+} map_bank_t;
+
+static map_bank_t* banks = NULL;
+
+static const char* section_title(map_section_t* section)
+{
+	return section->name[0] ? section->name : "(default)";
+}
+
+static int parse_int(const char* arg)
+{
+	char* end;
+	long value = strtol(arg, &end, 0);
+	if (*arg == '\0' || *end != '\0')
+		die("error: invalid number '%s'\n", arg);
+	return (int)value;
+}
+
+static map_section_t* get_section(map_t* map, const char* name)
+{
+	map_section_t* section;
+	HASH_FIND_STR(map->sections, name, section);
+	if (!section) {
+		section = xnew(map_section_t);
+		section->name = spool_add(name);
+		section->head = section->tail = -1;
+		utarray_new(section->bounds, &ut_int_icd);
+		HASH_ADD_KEYPTR(hh, map->sections, section->name, strlen(section->name), section);
+	}
+	return section;
+}
+
+static map_module_t* get_module(map_t* map, const char* name)
+{
+	map_module_t* module;
+	HASH_FIND_STR(map->modules, name, module);
+	if (!module) {
+		module = xnew(map_module_t);
+		module->name = spool_add(name);
+		HASH_ADD_KEYPTR(hh, map->modules, module->name, strlen(module->name), module);
+	}
+	return module;
+}
+
+//-----------------------------------------------------------------------------
+// Read the map file
+//-----------------------------------------------------------------------------
+
+// split the next comma separated field, with the blanks around it removed
+static char* next_field(char** p)
+{
+	char* field = *p;
+	char* end;
+
+	while (isspace((unsigned char)*field))
+		field++;
+	end = strchr(field, ',');
+	if (end) {
+		*p = end + 1;
+	}
+	else {
+		end = field + strlen(field);
+		*p = end;
+	}
+	while (end > field && isspace((unsigned char)end[-1]))
+		end--;
+	*end = '\0';
+	return field;
+}
+
+// the section symbols of the linker are __head, __tail, __size and the same
+// for each section: __<section>_head, ...
+// __head and __tail bound the whole program, which starts with the default
+// section "", and are taken as its bounds until map_compute()
+static void map_section_symbol(map_t* map, const char* name, int value)
+{
+	size_t len = strlen(name);
+	bool is_head;
+
+	if ((len == 6 || len > 7) && strcmp(name + len - 5, "_head") == 0)
+		is_head = true;
+	else if ((len == 6 || len > 7) && strcmp(name + len - 5, "_tail") == 0)
+		is_head = false;
+	else
+		return;
+
+	char* section_name = xstrdup(name + 2);
+	section_name[len > 7 ? len - 7 : 0] = '\0';
+	map_section_t* section = get_section(map, section_name);
+	if (is_head)
+		section->head = value;
+	else
+		section->tail = value;
+	xfree(section_name);
+}
+
+static void map_read(map_t* map, const char* filename)
+{
+	FILE* fp = xfopen(filename, "r");
+	UT_string* key = utstr_new();
+	char line[1024];
+	int line_nr = 0;
+
+	map->filename = spool_add(filename);
+
+	while (fgets(line, sizeof(line), fp)) {
+		char* p = line;
+		char* name, *type, *scope, *def, *module, *section, *end;
+
+		line_nr++;
+
+		// name = $VALUE ; type, scope, def, module, section, file:line
+		while (isspace((unsigned char)*p))
+			p++;
+		if (*p == '\0')
+			continue;
+		name = p;
+		while (*p && !isspace((unsigned char)*p))
+			p++;
+		if (*p)
+			*p++ = '\0';
+		while (isspace((unsigned char)*p))
+			p++;
+		if (p[0] != '=' || p[1] != ' ' || p[2] != '$')
+			die("error: %s:%d: not a map file line\n", filename, line_nr);
+		long value = strtol(p + 3, &end, 16);
+		p = strchr(end, ';');
+		if (!p)
+			die("error: %s:%d: the map file was not written by z80asm -m\n", filename, line_nr);
+		p++;
+		type = next_field(&p);
+		scope = next_field(&p);
+		def = next_field(&p);
+		module = next_field(&p);
+		section = next_field(&p);
+
+		// symbols defined by the linker
+		if (strcmp(def, "def") == 0 && *module == '\0') {
+			map_section_symbol(map, name, (int)value);
+			continue;
+		}
+
+		map_symbol_t* sym = xnew(map_symbol_t);
+		utstr_set_fmt(key, "%s@%s", name, module);
+		sym->key = spool_add(utstr_body(key));
+		sym->name = spool_add(name);
+		sym->value = (int)value;
+		sym->is_addr = strcmp(type, "addr") == 0;
+		sym->is_public = strcmp(scope, "local") != 0;
+		sym->module = get_module(map, module);
+		sym->section = get_section(map, section);
+
+		map_symbol_t* found;
+		HASH_FIND_STR(map->symbols, sym->key, found);
+		if (found) {
+			xfree(sym);					// same name in the same module
+			continue;
+		}
+		HASH_ADD_KEYPTR(hh, map->symbols, sym->key, strlen(sym->key), sym);
+	}
+
+	utstr_free(key);
+	xfclose(fp);
+
+	if (opt_verbose)
+		printf("Read map file '%s': %d symbols, %d sections, %d modules\n",
+			filename, HASH_COUNT(map->symbols), HASH_COUNT(map->sections), HASH_COUNT(map->modules));
+}
+
+//-----------------------------------------------------------------------------
+// Read the objects and libraries: the size of the code of each module in
+// each section, placed by one of its symbols that is in the map
+//-----------------------------------------------------------------------------
+static void map_add_object(map_t* map, objfile_t* obj, map_library_t* library)
+{
+	UT_string* key = utstr_new();
+	map_module_t* module;
+	section_t* section;
+
+	HASH_FIND_STR(map->modules, utstr_body(obj->modname), module);
+	if (!module || module->exact)		// not linked, or found in an earlier file
+		goto out;
+
+	module->exact = true;
+	module->size = 0;
+	module->library = library;
+	if (library) {
+		library->num_modules++;
+	}
+
+	DL_FOREACH(obj->sections, section) {
+		int size = (int)utarray_len(section->data);
+		symbol_t* symbol;
+		map_section_t* map_section;
+
+		if (size == 0)
+			continue;
+
+		module->size += size;
+		if (library)
+			library->size += size;
+
+		HASH_FIND_STR(map->sections, utstr_body(section->name), map_section);
+		if (!map_section)
+			continue;
+
+		DL_FOREACH(section->symbols, symbol) {
+			map_symbol_t* sym;
+
+			if (symbol->type != 'A')
+				continue;
+			utstr_set_fmt(key, "%s@%s", utstr_body(symbol->name), utstr_body(obj->modname));
+			HASH_FIND_STR(map->symbols, utstr_body(key), sym);
+			if (sym && sym->section == map_section) {
+				int start = sym->value - symbol->value;
+				int end = start + size;
+				utarray_push_back(map_section->bounds, &start);
+				utarray_push_back(map_section->bounds, &end);
+				break;
+			}
+		}
+	}
+
+out:
+	utstr_free(key);
+}
+
+static void map_read_file(map_t* map, const char* filename)
+{
+	file_t* file = file_new();
+	map_library_t* library = NULL;
+	objfile_t* obj;
+
+	file_read(file, filename);
+
+	if (file->type == is_library) {
+		library = xnew(map_library_t);
+		library->name = spool_add(filename);
+		HASH_ADD_KEYPTR(hh, map->libraries, library->name, strlen(library->name), library);
+	}
+
+	DL_FOREACH(file->objs, obj) {
+		map_add_object(map, obj, library);
+	}
+
+	file_free(file);
+}
+
+//-----------------------------------------------------------------------------
+// Compute the size of each symbol and module
+//-----------------------------------------------------------------------------
+static int compare_int(const void* a, const void* b)
+{
+	int ia = *(const int*)a, ib = *(const int*)b;
+	return (ia > ib) - (ia < ib);
+}
+
+// by section, then value; the public symbols first at the same address
+static int compare_addr_symbols(const void* a, const void* b)
+{
+	map_symbol_t* sa = *(map_symbol_t**)a;
+	map_symbol_t* sb = *(map_symbol_t**)b;
+	int cmp;
+
+	if ((cmp = strcmp(sa->section->name, sb->section->name)) != 0)
+		return cmp;
+	if (sa->value != sb->value)
+		return sa->value < sb->value ? -1 : 1;
+	if (sa->is_public != sb->is_public)
+		return sa->is_public ? -1 : 1;
+	return strcmp(sa->name, sb->name);
+}
+
+// first bound after value, or value if none
+static int next_bound(map_section_t* section, int value)
+{
+	int* bounds = (int*)utarray_front(section->bounds);
+	int lo = 0, hi = (int)utarray_len(section->bounds);
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (bounds[mid] <= value)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < (int)utarray_len(section->bounds) ? bounds[lo] : value;
+}
+
+static void map_compute(map_t* map)
+{
+	map_symbol_t* sym, *tmp;
+	map_section_t* section, *other, *stmp, *otmp;
+	map_symbol_t** syms;
+	int i, n;
+
+	utarray_new(map->addr_symbols, &ut_ptr_icd);
+	HASH_ITER(hh, map->symbols, sym, tmp) {
+		if (sym->is_addr)
+			utarray_push_back(map->addr_symbols, &sym);
+	}
+	utarray_sort(map->addr_symbols, compare_addr_symbols);
+	syms = (map_symbol_t**)utarray_front(map->addr_symbols);
+	n = (int)utarray_len(map->addr_symbols);
+
+	// the default section ends where the first section after it starts
+	HASH_FIND_STR(map->sections, "", section);
+	if (section && section->head >= 0 && section->tail >= 0) {
+		HASH_ITER(hh, map->sections, other, otmp) {
+			if (other != section && other->head >= section->head && other->head < section->tail)
+				section->tail = other->head;
+		}
+	}
+
+	// sections without __<section>_head and _tail
+	for (i = 0; i < n; i++) {
+		section = syms[i]->section;
+		if (section->tail < 0 && (section->head < 0 || syms[i]->value < section->head))
+			section->head = syms[i]->value;
+	}
+	HASH_ITER(hh, map->sections, section, stmp) {
+		if (section->tail >= 0 || section->head < 0)
+			continue;
+		section->tail = section->head;
+		HASH_ITER(hh, map->sections, other, otmp) {
+			if (other != section && other->head > section->head &&
+				(section->tail == section->head || other->head < section->tail))
+				section->tail = other->head;
+		}
+		for (i = 0; i < n; i++) {
+			if (syms[i]->section == section && syms[i]->value >= section->tail)
+				section->tail = syms[i]->value + 1;
+		}
+	}
+
+	// symbols end at the next symbol, module or section end
+	for (i = 0; i < n; i++) {
+		utarray_push_back(syms[i]->section->bounds, &syms[i]->value);
+	}
+	HASH_ITER(hh, map->sections, section, stmp) {
+		if (section->tail >= 0)
+			utarray_push_back(section->bounds, &section->tail);
+		utarray_sort(section->bounds, compare_int);
+	}
+	for (i = 0; i < n; i++) {
+		sym = syms[i];
+		sym->size = next_bound(sym->section, sym->value) - sym->value;
+
+		// the bytes at one address go to the module of the first symbol
+		if (i == 0 || syms[i - 1]->section != sym->section || syms[i - 1]->value != sym->value) {
+			sym->module->map_size += sym->size;
+		}
+	}
+
+	map_module_t* module, *mtmp;
+	HASH_ITER(hh, map->modules, module, mtmp) {
+		if (!module->exact)
+			module->size = module->map_size;
+	}
+}
+
+static void map_free(map_t* map)
+{
+	map_symbol_t* sym, *tmp;
+	map_section_t* section, *stmp;
+	map_module_t* module, *mtmp;
+	map_library_t* library, *ltmp;
+
+	HASH_ITER(hh, map->symbols, sym, tmp) {
+		HASH_DEL(map->symbols, sym);
+		xfree(sym);
+	}
+	HASH_ITER(hh, map->sections, section, stmp) {
+		HASH_DEL(map->sections, section);
+		utarray_free(section->bounds);
+		xfree(section);
+	}
+	HASH_ITER(hh, map->modules, module, mtmp) {
+		HASH_DEL(map->modules, module);
+		xfree(module);
+	}
+	HASH_ITER(hh, map->libraries, library, ltmp) {
+		HASH_DEL(map->libraries, library);
+		xfree(library);
+	}
+	if (map->addr_symbols)
+		utarray_free(map->addr_symbols);
+}
+
+static int section_size(map_section_t* section)
+{
+	return section->head >= 0 && section->tail > section->head ? section->tail - section->head : 0;
+}
+
+static int map_total(map_t* map)
+{
+	map_section_t* section, *tmp;
+	int total = 0;
+
+	HASH_ITER(hh, map->sections, section, tmp) {
+		total += section_size(section);
+	}
+	return total;
+}
+
+//-----------------------------------------------------------------------------
+// Reports
+//-----------------------------------------------------------------------------
+static int compare_sections(map_section_t* a, map_section_t* b)
+{
+	if (a->head != b->head)
+		return a->head < b->head ? -1 : 1;
+	return strcmp(a->name, b->name);
+}
+
+static int compare_modules(map_module_t* a, map_module_t* b)
+{
+	if (a->size != b->size)
+		return a->size > b->size ? -1 : 1;
+	return strcmp(a->name, b->name);
+}
+
+static int compare_libraries(map_library_t* a, map_library_t* b)
+{
+	if (a->size != b->size)
+		return a->size > b->size ? -1 : 1;
+	return strcmp(a->name, b->name);
+}
+
+static int compare_symbol_sizes(const void* a, const void* b)
+{
+	map_symbol_t* sa = *(map_symbol_t**)a;
+	map_symbol_t* sb = *(map_symbol_t**)b;
+
+	if (sa->size != sb->size)
+		return sa->size > sb->size ? -1 : 1;
+	return compare_addr_symbols(a, b);
+}
+
+static void report_sections(map_t* map)
+{
+	map_section_t* section, *tmp;
+
+	HASH_SORT(map->sections, compare_sections);
+
+	printf("Sections:\n");
+	printf("  %-24s %-6s %-6s %8s\n", "Section", "Head", "Tail", "Bytes");
+	HASH_ITER(hh, map->sections, section, tmp) {
+		if (section_size(section) == 0)
+			continue;
+		printf("  %-24s $%04X  $%04X  %8d\n",
+			section_title(section), section->head, section->tail, section_size(section));
+	}
+	printf("  %-24s %-6s %-6s %8d\n\n", "Total", "", "", map_total(map));
+}
+
+static void report_modules(map_t* map)
+{
+	map_module_t* module, *tmp;
+	bool estimated = false;
+
+	HASH_SORT(map->modules, compare_modules);
+
+	printf("Modules:\n");
+	printf("  %-32s %8s  %s\n", "Module", "Bytes", "Library");
+	HASH_ITER(hh, map->modules, module, tmp) {
+		if (module->size == 0)
+			continue;
+		printf("  %-32s %8d%c %s\n", module->name, module->size,
+			module->exact ? ' ' : '~', module->library ? module->library->name : "");
+		if (!module->exact)
+			estimated = true;
+	}
+	if (estimated)
+		printf("  (~ estimated from the map, give the objects and libraries for exact sizes)\n");
+	printf("\n");
+}
+
+static void report_libraries(map_t* map)
+{
+	map_library_t* library, *tmp;
+	map_module_t* module, *mtmp;
+	int objects_size = 0, num_objects = 0;
+
+	HASH_SORT(map->libraries, compare_libraries);
+
+	HASH_ITER(hh, map->modules, module, mtmp) {
+		if (!module->library && module->size > 0) {
+			objects_size += module->size;
+			num_objects++;
+		}
+	}
+
+	printf("Libraries:\n");
+	if (!map->libraries) {
+		printf("  (give the libraries of the build)\n\n");
+		return;
+	}
+	printf("  %-40s %8s %8s\n", "Library", "Modules", "Bytes");
+	HASH_ITER(hh, map->libraries, library, tmp) {
+		printf("  %-40s %8d %8d\n", library->name, library->num_modules, library->size);
+	}
+	printf("  %-40s %8d %8d\n\n", "(not from a library)", num_objects, objects_size);
+}
+
+static void report_top(map_t* map, int top)
+{
+	UT_array* sorted;
+	map_symbol_t** syms;
+	int i, n, shown = 0;
+
+	utarray_new(sorted, &ut_ptr_icd);
+	utarray_concat(sorted, map->addr_symbols);
+	utarray_sort(sorted, compare_symbol_sizes);
+	syms = (map_symbol_t**)utarray_front(sorted);
+	n = (int)utarray_len(sorted);
+
+	printf("Largest symbols:\n");
+	printf("  %-32s %-6s %8s  %-16s %s\n", "Symbol", "Addr", "Bytes", "Section", "Module");
+	for (i = 0; i < n && shown < top; i++) {
+		// only one symbol of those at the same address
+		if (i > 0 && syms[i - 1]->section == syms[i]->section && syms[i - 1]->value == syms[i]->value)
+			continue;
+		printf("  %-32s $%04X  %8d  %-16s %s\n", syms[i]->name, syms[i]->value, syms[i]->size,
+			section_title(syms[i]->section), syms[i]->module->name);
+		shown++;
+	}
+	printf("\n");
+
+	utarray_free(sorted);
+}
+
+static bool section_in_bank(map_section_t* section, map_bank_t* bank)
+{
+	size_t len = strlen(bank->name);
+	return strncmp(section->name, bank->name, len) == 0 &&
+		(section->name[len] == '\0' || section->name[len] == '_');
+}
+
+static void report_banks(map_t* map)
+{
+	map_section_t* section, *tmp;
+	map_bank_t* bank;
+
+	LL_FOREACH(banks, bank) {
+		bank->used = 0;
+		bank->overflow = false;
+	}
+
+	HASH_ITER(hh, map->sections, section, tmp) {
+		int size = section_size(section);
+		if (size == 0)
+			continue;
+
+		// by name, then by address
+		LL_FOREACH(banks, bank) {
+			if (section_in_bank(section, bank))
+				break;
+		}
+		if (!bank) {
+			LL_FOREACH(banks, bank) {
+				if (section->head >= bank->start && section->head < bank->start + bank->size)
+					break;
+			}
+		}
+		if (!bank)
+			continue;
+
+		bank->used += size;
+		if (section->head < bank->start || section->tail > bank->start + bank->size)
+			bank->overflow = true;
+	}
+
+	printf("Banks:\n");
+	printf("  %-16s %-6s %-6s %8s %8s\n", "Bank", "Start", "End", "Used", "Free");
+	LL_FOREACH(banks, bank) {
+		printf("  %-16s $%04X  $%04X  %8d %8d%s\n", bank->name, bank->start, bank->start + bank->size - 1,
+			bank->used, bank->size - bank->used, bank->overflow ? "  overflow" : "");
+	}
+	printf("\n");
+}
+
+//-----------------------------------------------------------------------------
+// Compare with an older build
+//-----------------------------------------------------------------------------
+typedef struct map_delta_s {
+	const char*	name;
+	int			old_size, new_size;
+} map_delta_t;
+
+static UT_icd ut_delta_icd = { sizeof(map_delta_t), NULL, NULL, NULL };
+
+static int compare_deltas(const void* a, const void* b)
+{
+	const map_delta_t* da = a;
+	const map_delta_t* db = b;
+	int ca = abs(da->new_size - da->old_size);
+	int cb = abs(db->new_size - db->old_size);
+
+	if (ca != cb)
+		return ca > cb ? -1 : 1;
+	return strcmp(da->name, db->name);
+}
+
+static void add_delta(UT_array* deltas, const char* name, int old_size, int new_size)
+{
+	if (old_size != new_size) {
+		map_delta_t delta = { name, old_size, new_size };
+		utarray_push_back(deltas, &delta);
+	}
+}
+
+static void print_deltas(const char* title, UT_array* deltas, int top)
+{
+	map_delta_t* delta;
+	int shown = 0;
+
+	utarray_sort(deltas, compare_deltas);
+
+	printf("%s:\n", title);
+	printf("  %-32s %8s %8s %8s\n", "Name", "Old", "New", "Change");
+	for (delta = (map_delta_t*)utarray_front(deltas); delta && shown < top;
+		delta = (map_delta_t*)utarray_next(deltas, delta), shown++) {
+		printf("  %-32s %8d %8d %+8d\n", delta->name, delta->old_size, delta->new_size,
+			delta->new_size - delta->old_size);
+	}
+	if (utarray_len(deltas) == 0)
+		printf("  (no changes)\n");
+	printf("\n");
+
+	utarray_clear(deltas);
+}
+
+static int report_diff(map_t* old_map, map_t* map, int top)
+{
+	UT_array* deltas;
+	map_section_t* section, *found_section, *stmp;
+	map_module_t* module, *found_module, *mtmp;
+	map_symbol_t* sym, *found_sym, *tmp;
+	int old_total = map_total(old_map);
+	int new_total = map_total(map);
+
+	utarray_new(deltas, &ut_delta_icd);
+
+	HASH_ITER(hh, map->sections, section, stmp) {
+		HASH_FIND_STR(old_map->sections, section->name, found_section);
+		add_delta(deltas, section_title(section),
+			found_section ? section_size(found_section) : 0, section_size(section));
+	}
+	HASH_ITER(hh, old_map->sections, section, stmp) {
+		HASH_FIND_STR(map->sections, section->name, found_section);
+		if (!found_section)
+			add_delta(deltas, section_title(section), section_size(section), 0);
+	}
+	print_deltas("Section changes", deltas, INT_MAX);
+
+	// the modules of both builds are compared by their size in the maps
+	HASH_ITER(hh, map->modules, module, mtmp) {
+		HASH_FIND_STR(old_map->modules, module->name, found_module);
+		add_delta(deltas, module->name, found_module ? found_module->map_size : 0, module->map_size);
+	}
+	HASH_ITER(hh, old_map->modules, module, mtmp) {
+		HASH_FIND_STR(map->modules, module->name, found_module);
+		if (!found_module)
+			add_delta(deltas, module->name, module->map_size, 0);
+	}
+	print_deltas("Module changes", deltas, top);
+
+	HASH_ITER(hh, map->symbols, sym, tmp) {
+		if (!sym->is_addr)
+			continue;
+		HASH_FIND_STR(old_map->symbols, sym->key, found_sym);
+		add_delta(deltas, sym->key, found_sym && found_sym->is_addr ? found_sym->size : 0, sym->size);
+	}
+	HASH_ITER(hh, old_map->symbols, sym, tmp) {
+		if (!sym->is_addr)
+			continue;
+		HASH_FIND_STR(map->symbols, sym->key, found_sym);
+		if (!found_sym || !found_sym->is_addr)
+			add_delta(deltas, sym->key, sym->size, 0);
+	}
+	print_deltas("Symbol changes", deltas, top);
+
+	utarray_free(deltas);
+
+	printf("Total: %d -> %d bytes (%+d)\n", old_total, new_total, new_total - old_total);
+
+	if (opt_max_growth >= 0 && new_total - old_total > opt_max_growth) {
+		fprintf(stderr, "error: the build grew by %d bytes, more than %d\n",
+			new_total - old_total, opt_max_growth);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+// Parse command line
+//-----------------------------------------------------------------------------
+static void add_bank(char* arg)
+{
+	map_bank_t* bank = xnew(map_bank_t);
+	char* start = strchr(arg, ',');
+	char* size = start ? strchr(start + 1, ',') : NULL;
+
+	if (!size)
+		die("error: expected name,start,size in --bank argument '%s'\n", arg);
+	*start++ = '\0';
+	*size++ = '\0';
+	bank->name = spool_add(arg);
+	bank->start = parse_int(start);
+	bank->size = parse_int(size);
+	if (bank->size <= 0)
+		die("error: invalid size in --bank argument '%s'\n", arg);
+	LL_APPEND(banks, bank);
+}
 
 int main(int argc, char **argv)
 {
-    return 0;
+	char* old_filename = NULL;
+	int exit_code = EXIT_SUCCESS;
+
+	// show usage
+	if (argc < 2) {
+		printf("%s", usage);
+		exit(EXIT_SUCCESS);
+	}
+
+	// parse options
+	struct optparse options;
+	int option;
+
+	optparse_init(&options, argv);
+	while ((option = optparse_long(&options, longopts, NULL)) != -1) {
+		switch (option) {
+		case OPT_VERBOSE: opt_verbose = opt_obj_verbose = true; break;
+		case OPT_SECTIONS: opt_sections = true; break;
+		case OPT_MODULES: opt_modules = true; break;
+		case OPT_LIBRARIES: opt_libraries = true; break;
+		case OPT_TOP:
+			opt_top = parse_int(options.optarg);
+			break;
+		case OPT_BANK:
+			add_bank(options.optarg);
+			break;
+		case OPT_DIFF:
+			old_filename = options.optarg;
+			break;
+		case OPT_MAX_GROWTH:
+			opt_max_growth = parse_int(options.optarg);
+			break;
+		case '?':
+			die("error: %s\n", options.errmsg);
+		default: xassert(0);
+		}
+	}
+
+	// collect map file
+	char* filename = optparse_arg(&options);
+	if (!filename)
+		die("error: no map file\n");
+	if (opt_max_growth >= 0 && !old_filename)
+		die("error: --max-growth needs --diff\n");
+
+	// read the build
+	map_t map = { 0 };
+	char* arg;
+
+	map_read(&map, filename);
+	while ((arg = optparse_arg(&options)) != NULL)
+		map_read_file(&map, arg);
+	map_compute(&map);
+
+	if (old_filename) {
+		map_t old_map = { 0 };
+
+		map_read(&old_map, old_filename);
+		map_compute(&old_map);
+		exit_code = report_diff(&old_map, &map, opt_top > 0 ? opt_top : DEFAULT_TOP);
+		map_free(&old_map);
+	}
+	else {
+		// all the reports if none selected
+		if (!opt_sections && !opt_modules && !opt_libraries && opt_top == 0 && !banks) {
+			opt_sections = opt_modules = opt_libraries = true;
+			opt_top = DEFAULT_TOP;
+		}
+
+		if (opt_sections)
+			report_sections(&map);
+		if (banks)
+			report_banks(&map);
+		if (opt_libraries)
+			report_libraries(&map);
+		if (opt_modules)
+			report_modules(&map);
+		if (opt_top > 0)
+			report_top(&map, opt_top);
+	}
+
+	map_free(&map);
+
+	map_bank_t* bank, *btmp;
+	LL_FOREACH_SAFE(banks, bank, btmp) {
+		LL_DELETE(banks, bank);
+		xfree(bank);
+	}
+
+	return exit_code;
 }
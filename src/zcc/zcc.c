@@ -26,13 +26,29 @@
 #include        <sys/stat.h>
 #include        "zcc.h"
 #include        "regex/regex.h"
+#include        "ucpp.h"
+#include        "zpragma.h"
 #include 	"dirname.h"
 
 #ifdef WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define         WIN32_LEAN_AND_MEAN
+#endif
+#include        <windows.h>
 #include        <direct.h>
 #include        <process.h>
+#include        <sys/utime.h>
+#ifndef __MINGW__
+#include        "../z88dk-lib/dirent.h"
+#else
+#include        <dirent.h>
+#endif
 #else
 #include        <unistd.h>
+#include        <fcntl.h>
+#include        <utime.h>
+#include        <dirent.h>
+#include        <sys/wait.h>
 #endif
 
 
@@ -142,6 +158,13 @@ static char           *changesuffix(char *, char *);
 static char           *find_file_ext(char *filename);
 static int             is_path_absolute(char *filename);
 static int             process(char *, char *, char *, char *, enum iostyle, int, int, int);
+static int             run_filters(char **cmds, int num, char *in, char *out);
+static int             preprocess(int number, int sccz80_mode);
+static void            compile_file(int i);
+static void            compile_files_parallel(int first, int last);
+static int             cache_lookup(int i);
+static void            cache_store(int i);
+static void            cache_print_stats(void);
 static int             linkthem(char *);
 static int             get_filetype_by_suffix(char *);
 static void            BuildAsmLine(char *, size_t, char *);
@@ -160,6 +183,7 @@ static void            configure_compiler();
 static void            configure_misc_options();
 static void            configure_maths_library(char **libstring);
 
+static int             sccz80_copt_rules(char **rules);
 static void            apply_copt_rules(int filenumber, int num, char **rules, char *ext1, char *ext2, char *ext);
 static void            zsdcc_asm_filter_comments(int filenumber, char *ext);
 static void            remove_temporary_files(void);
@@ -214,6 +238,11 @@ static int             swallow_M = 0;
 static int             c_print_specs = 0;
 static int             c_zorg = -1;
 static int             c_sccz80_inline_ints = 0;
+static int             c_jobs = 1;
+static int             job_child = 0;    /* Set in the processes started by compile_files_parallel() */
+static char           *c_cache_dir = NULL;
+static int             c_cache_size = 256;    /* Megabytes */
+static int             c_cache_stats = 0;
 static int             max_argc;
 static int             gargc;
 static char          **gargv;
@@ -475,6 +504,10 @@ static arg_t     myargs[] = {
     { "l", AF_MORE, AddLinkLibrary, NULL, NULL, "Add a library" },
     { "O", AF_MORE, SetNumber, &peepholeopt, NULL, "Set the peephole optimiser setting for copt" },
     { "SO", AF_MORE, SetNumber, &sdccpeepopt, NULL, "Set the peephole optimiser setting for sdcc-peephole" },
+    { "j", AF_MORE, SetNumber, &c_jobs, NULL, "Compile up to this many files in parallel" },
+    { "cache-dir", AF_MORE, SetString, &c_cache_dir, NULL, "Cache compiled objects in this directory" },
+    { "cache-size", AF_MORE, SetNumber, &c_cache_size, NULL, "Maximum size of the object cache in megabytes" },
+    { "cache-stats", AF_BOOL_TRUE, SetBoolean, &c_cache_stats, NULL, "Show statistics of the object cache" },
     { "h", AF_BOOL_TRUE, SetBoolean, &c_help, NULL, "Display this text" },
     { "v", AF_BOOL_TRUE, SetBoolean, &verbose, NULL, "Output all commands that are run (-vn suppresses)" },
     { "bn", AF_MORE, SetString, &c_linker_output_file, NULL, "Set the output file for the linker stage" },
@@ -683,7 +716,18 @@ process(char *suffix, char *nextsuffix, char *processor, char *extraargs, enum i
         fflush(stdout);
     }
 
-    status = system(buffer);
+    if (ios == filter && cleanup) {
+        // run the filter directly, without a shell
+        char  *cmd = buffer;
+        snprintf(buffer, sizeof(buffer), "%s %s", processor, extraargs);
+        status = run_filters(&cmd, 1, filelist[number], outname);
+        if (status < 0) {
+            snprintf(buffer, sizeof(buffer), "%s %s < \"%s\" > \"%s\"", processor, extraargs, filelist[number], outname);
+            status = system(buffer);
+        }
+    }
+    else
+        status = system(buffer);
 
     if (status != 0) {
         errs = 1;
@@ -699,6 +743,217 @@ process(char *suffix, char *nextsuffix, char *processor, char *extraargs, enum i
 }
 
 
+#ifdef WIN32
+#define SHELL_SPECIAL   "%"
+#define SHELL_OPERATORS "|&<>^"
+#else
+#define SHELL_SPECIAL   "\\$`"
+#define SHELL_OPERATORS "|&;<>()*?[]~#{}!"
+#endif
+
+/* Split a command line into an argument vector. Returns NULL if the command
+   needs a shell to run, i.e. it uses anything but blanks and quotes */
+static char **split_command(char *cmd)
+{
+    char  **argv, *buf, *p, *q;
+    int     argc = 0, quote;
+
+    argv = mustmalloc((strlen(cmd) / 2 + 2) * sizeof(*argv));
+    buf = p = q = muststrdup(cmd);
+
+    while (1) {
+        while (isspace(*p))
+            p++;
+        if (*p == '\0')
+            break;
+        argv[argc++] = q;
+        for (quote = 0; *p && (quote || !isspace(*p)); p++) {
+            if (quote && *p == quote)
+                quote = 0;
+            else if (!quote && isquote(*p))
+                quote = *p;
+            else if (quote != '\'' && strchr(SHELL_SPECIAL, *p) != NULL)
+                break;
+            else if (!quote && (strchr(SHELL_OPERATORS, *p) != NULL || (*p == '=' && argc == 1)))
+                break;
+            else
+                *q++ = *p;
+        }
+        if (quote || (*p && !isspace(*p)))
+            argc = 0;    /* shell syntax */
+        if (argc == 0)
+            break;
+        if (*p)
+            p++;    /* q may have caught up with p */
+        *q++ = '\0';
+    }
+
+    if (argc == 0) {
+        free(buf);
+        free(argv);
+        return NULL;
+    }
+    argv[argc] = NULL;
+    return argv;
+}
+
+/* Run filter commands cmds[0] to cmds[num-1] connected by pipes, the first
+ * reading from file in and the last writing to file out. Returns 0 if all
+ * filters succeeded or -1 if the commands need a shell to run. */
+static int run_filters(char **cmds, int num, char *in, char *out)
+{
+#ifdef WIN32
+    return -1;
+#else
+    char  **argv[MAX_COPT_RULE_FILES];
+    pid_t   pids[MAX_COPT_RULE_FILES];
+    int     i, fds[2], fd_in, fd_out, status, errs = 0;
+
+    if (num > MAX_COPT_RULE_FILES)
+        return -1;
+    for (i = 0; i < num; i++) {
+        if ((argv[i] = split_command(cmds[i])) == NULL) {
+            while (i-- > 0) {
+                free(argv[i][0]);
+                free(argv[i]);
+            }
+            return -1;
+        }
+    }
+
+    if ((fd_in = open(in, O_RDONLY)) < 0) {
+        fprintf(stderr, "Cannot open %s\n", in);
+        errs = 1;
+    }
+    else if ((fd_out = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0) {
+        fprintf(stderr, "Cannot create %s\n", out);
+        close(fd_in);
+        errs = 1;
+    }
+    else {
+        fflush(stdout);
+        fflush(stderr);
+        for (i = 0; i < num; i++) {
+            // the last filter writes to the output file, the others to a pipe
+            fds[0] = -1;
+            fds[1] = -1;
+            if (i < num - 1 && pipe(fds) != 0) {
+                fprintf(stderr, "Cannot create pipe\n");
+                break;
+            }
+            if ((pids[i] = fork()) == 0) {
+                dup2(fd_in, 0);
+                dup2(fds[1] >= 0 ? fds[1] : fd_out, 1);
+                close(fd_in);
+                close(fd_out);
+                if (fds[0] >= 0) {
+                    close(fds[0]);
+                    close(fds[1]);
+                }
+                execvp(argv[i][0], argv[i]);
+                fprintf(stderr, "Cannot run %s\n", argv[i][0]);
+                _exit(127);
+            }
+            if (pids[i] < 0) {
+                fprintf(stderr, "Cannot run %s\n", argv[i][0]);
+                if (fds[0] >= 0) {
+                    close(fds[0]);
+                    close(fds[1]);
+                }
+                break;
+            }
+            // the next filter reads from the pipe
+            close(fd_in);
+            fd_in = fds[0];
+            if (fds[1] >= 0)
+                close(fds[1]);
+        }
+        // fd_in is the input file or the read end of the last pipe made
+        // when a pipe or a filter could not be started
+        if (fd_in >= 0)
+            close(fd_in);
+        close(fd_out);
+        if (i < num)
+            errs = 1;
+
+        // wait for all started filters
+        while (i-- > 0) {
+            if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                errs = 1;
+        }
+    }
+
+    for (i = 0; i < num; i++) {
+        free(argv[i][0]);
+        free(argv[i]);
+    }
+    return errs;
+#endif
+}
+
+static void preprocess_output(unsigned char *text, size_t len)
+{
+    zpragma_text((const char *)text, len);
+}
+
+/* Run ucpp and zpragma inside zcc, going from the .c file straight to the .i
+ * file. Returns -1 if they have to be run as commands instead, i.e. another
+ * preprocessor was chosen or the arguments need a shell. */
+static int preprocess(int number, int sccz80_mode)
+{
+    char    buffer[8192], **argv, *outname;
+    int     argc, status;
+    FILE   *out;
+
+    if (!hassuffix(filelist[number], ".c"))
+        return 0;
+    if (strcmp(c_cpp_exe, "z88dk-ucpp") != 0 || strcmp(c_zpragma_exe, "z88dk-zpragma") != 0 ||
+        c_stylecpp != outspecified || !cleanup)
+        return -1;
+
+    snprintf(buffer, sizeof(buffer), "%s %s", c_cpp_exe, cpparg);
+    if ((argv = split_command(buffer)) == NULL)
+        return -1;
+    for (argc = 0; argv[argc] != NULL; argc++)
+        ;
+    argv = realloc(argv, (argc + 2) * sizeof(*argv));
+    if (argv == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    argv[argc++] = filelist[number];
+    argv[argc] = NULL;
+
+    outname = changesuffix(temporary_filenames[number], ".i");
+    if (verbose) {
+        printf("%s %s \"%s\" | %s %s-zcc-opt=%s > \"%s\"\n", c_cpp_exe, cpparg, filelist[number],
+            c_zpragma_exe, sccz80_mode ? "-sccz80 " : "", zcc_opt_def, outname);
+        fflush(stdout);
+    }
+
+    if ((out = fopen(outname, "w")) == NULL) {
+        fprintf(stderr, "Cannot create %s\n", outname);
+        status = 1;
+    }
+    else {
+        zpragma_init(sccz80_mode, zcc_opt_def, out);
+        status = ucpp_main(argc, argv, preprocess_output);
+        zpragma_end();
+        if (fclose(out) != 0)
+            status = 1;
+    }
+
+    free(argv[0]);
+    free(argv);
+    if (status != 0) {
+        free(outname);
+        return 1;
+    }
+    free(filelist[number]);
+    filelist[number] = outname;
+    return 0;
+}
+
 int linkthem(char *linker)
 {
     int             i, len, offs, status;
@@ -824,10 +1079,9 @@ int linkthem(char *linker)
 
 int main(int argc, char **argv)
 {
-    int             i, ft, gc;
+    int             i, gc;
     char           *ptr;
     char            config_filename[FILENAME_MAX + 1];
-    char            asmarg[4096];    /* Hell, that should be long enough! */
     char            buffer[LINEMAX + 1];    /* For reading in option file */
     FILE           *fp;
 
@@ -999,6 +1253,11 @@ int main(int argc, char **argv)
     }
 
 
+    if (c_cache_stats && nfiles <= 0 && !c_help) {
+        cache_print_stats();
+        exit(0);
+    }
+
     if (nfiles <= 0 || c_help) {
         print_help_text(argv[0]);
         exit(0);
@@ -1145,422 +1404,1116 @@ int main(int argc, char **argv)
     // This nastiness is marked "HACK" in the loop below.  Maybe something better will come along later.
 
     // Parse through the files, handling each one in turn
-    for (i = 1; (i <= nfiles) && (i != 0); i += (i != 0))  // HACK 1 OF 2
+    if (c_jobs > 1 && nfiles > 2) {
+        // All files but the first can be processed concurrently, the first one must still go last
+        compile_files_parallel(1, nfiles);
+        compile_file(0);
+    }
+    else {
+        for (i = 1; (i <= nfiles) && (i != 0); i += (i != 0))  // HACK 1 OF 2
+        {
+            if (i == nfiles) i = 0;                            // HACK 2 OF 2
+            compile_file(i);
+        }
+    }
+
+    if (verbose) printf("\nGENERATING OUTPUT\n");
+
+    if (m4only) exit(0);
+
+    if (clangonly) {
+        if (nfiles > 1) outputfile = NULL;
+        copy_output_files_to_destdir(".ll", 1);
+        exit(0);
+    }
+
+    if (llvmonly) exit(0);
+
+    if (preprocessonly) {
+        if (nfiles > 1) outputfile = NULL;
+        copy_output_files_to_destdir(".i", 1);
+        exit(0);
+    }
+
+    if (assembleonly) {
+        if (nfiles > 1) outputfile = NULL;
+        copy_output_files_to_destdir(".asm", 1);
+        copy_output_files_to_destdir(".s", 1);
+        exit(0);
+    }
+
     {
-        if (i == nfiles) i = 0;                            // HACK 2 OF 2
-        if (verbose) printf("\nPROCESSING %s\n", original_filenames[i]);
-    SWITCH_REPEAT:
-        switch (get_filetype_by_suffix(filelist[i]))
+        char *tempofile = outputfile;
+        outputfile = NULL;
+        if (lston) copy_output_files_to_destdir(".lis", 1);
+        if (symbolson) copy_output_files_to_destdir(".sym", 1);
+        outputfile = tempofile;
+    }
+
+    if (compileonly) {
+        if ((nfiles > 1) && (outputfile != NULL)) {
+            /* consolidated object file */
+            outputfile = changesuffix(outputfile, ".o");
+            if (linkthem(c_linker))
+                exit(1);
+        }
+        else
         {
-        case M4FILE:
-            if (process(".m4", "", "m4", (m4arg == NULL) ? "" : m4arg, filter, i, YES, YES))
+            /* independent object files */
+            copy_output_files_to_destdir(c_extension, 1);
+        }
+        exit(0);
+    }
+
+    /* Set the default name as necessary */
+
+    if (outputfile == NULL)
+        outputfile = c_linker_output_file ? c_linker_output_file : defaultout;
+
+    strcpy(filenamebuf, outputfile);
+
+    if ((ptr = find_file_ext(filenamebuf)) != NULL)
+        *ptr = 0;
+
+    /* Link */
+
+    if (linkthem(c_linker))
+    {
+        if (build_bin && lston && copy_file(c_crt0, ".lis", filenamebuf, ".lis"))
+            fprintf(stderr, "Cannot copy crt0 list file\n");
+
+        exit(1);
+    }
+
+    /* Build binary */
+
+    if (build_bin) {
+
+        int status = 0;
+
+        if (mapon && copy_file(c_crt0, ".map", filenamebuf, ".map")) {
+            fprintf(stderr, "Cannot copy map file\n");
+            status = 1;
+        }
+
+        if (symbolson && copy_file(c_crt0, ".sym", filenamebuf, ".sym")) {
+            fprintf(stderr, "Cannot copy symbols file\n");
+            status = 1;
+        }
+
+        if (globaldefon && copy_defc_file(c_crt0, ".def", filenamebuf, ".def")) {
+            fprintf(stderr, "Cannot create global defc file\n");
+            status = 1;
+        }
+
+        if (lston && copy_file(c_crt0, ".lis", filenamebuf, ".lis")) {
+            fprintf(stderr, "Cannot copy crt0 list file\n");
+            status = 1;
+        }
+
+        if (createapp) {
+            /* Building an application - run the appmake command on it */
+            snprintf(buffer, sizeof(buffer), "%s %s -b \"%s\" -c \"%s\"", c_appmake_exe, appmakeargs ? appmakeargs : "", outputfile, c_crt0);
+            if (verbose) {
+                printf("%s\n", buffer);
+                fflush(stdout);
+            }
+            if (system(buffer)) {
+                fprintf(stderr, "Building application code failed\n");
+                status = 1;
+            }
+        }
+
+        exit(status);
+    }
+}
+
+
+/* Run the compile pipeline of file i up to the object file */
+static void compile_file(int i)
+{
+    int             ft, status;
+    char           *ptr;
+    char            asmarg[4096];    /* Hell, that should be long enough! */
+
+    if (verbose) printf("\nPROCESSING %s\n", original_filenames[i]);
+SWITCH_REPEAT:
+    switch (get_filetype_by_suffix(filelist[i]))
+    {
+    case M4FILE:
+        if (process(".m4", "", "m4", (m4arg == NULL) ? "" : m4arg, filter, i, YES, YES))
+            exit(1);
+        // Disqualify recursive .m4 extensions
+        ft = get_filetype_by_suffix(filelist[i]);
+        if (ft == M4FILE) {
+            fprintf(stderr, "Cannot process recursive .m4 file %s\n", original_filenames[i]);
+            exit(1);
+        }
+        // Write processed file to original source location immediately
+        ptr = stripsuffix(original_filenames[i], ".m4");
+        if (copy_file(filelist[i], "", ptr, "")) {
+            fprintf(stderr, "Couldn't write output file %s\n", ptr);
+            exit(1);
+        }
+        // Copied file becomes the new original file
+        free(original_filenames[i]);
+        free(filelist[i]);
+        original_filenames[i] = ptr;
+        filelist[i] = muststrdup(ptr);
+        // No more processing for .h and .inc files
+        ft = get_filetype_by_suffix(filelist[i]);
+        if ((ft == HDRFILE) || (ft == INCFILE)) return;
+        // Continue processing macro expanded source file
+        goto SWITCH_REPEAT;
+        break;
+    CASE_LLFILE:
+    case LLFILE:
+        if (m4only || clangonly) return;
+        // llvm-cbe translates llvm-ir to c
+        if (zopt && process(".ll", ".opt.ll", "zopt", llvmopt, outspecified_flag, i, YES, NO))
+            exit(1);
+        if (process(".ll", ".cbe.c", c_llvm_exe, llvmarg, outspecified_flag, i, YES, NO))
+            exit(1);
+        // Write .cbe.c to original directory immediately
+        ptr = changesuffix(original_filenames[i], ".cbe.c");
+        if (copy_file(filelist[i], "", ptr, "")) {
+            fprintf(stderr, "Couldn't write output file %s\n", ptr);
+            exit(1);
+        }
+        // Copied file becomes the new original file
+        free(original_filenames[i]);
+        free(filelist[i]);
+        original_filenames[i] = ptr;
+        filelist[i] = muststrdup(ptr);
+    case CFILE:
+        if (m4only) return;
+        // special treatment for clang+llvm
+        if ((strcmp(c_compiler_type, "clang") == 0) && !hassuffix(filelist[i], ".cbe.c")) {
+            if (process(".c", ".ll", c_clang_exe, clangarg, outspecified_flag, i, YES, NO))
                 exit(1);
-            // Disqualify recursive .m4 extensions
-            ft = get_filetype_by_suffix(filelist[i]);
-            if (ft == M4FILE) {
-                fprintf(stderr, "Cannot process recursive .m4 file %s\n", original_filenames[i]);
+            goto CASE_LLFILE;
+        }
+        if (clangonly || llvmonly) return;
+        if (hassuffix(filelist[i], ".cbe.c"))
+            BuildOptions(&cpparg, clangcpparg);
+        // past clang+llvm related pre-processing
+        if (compiler_type == CC_SDCC) {
+            char zpragma_args[1024];
+            snprintf(zpragma_args, sizeof(zpragma_args),"-zcc-opt=%s", zcc_opt_def);
+            if ((status = preprocess(i, NO)) > 0)
                 exit(1);
-            }
-            // Write processed file to original source location immediately
-            ptr = stripsuffix(original_filenames[i], ".m4");
-            if (copy_file(filelist[i], "", ptr, "")) {
-                fprintf(stderr, "Couldn't write output file %s\n", ptr);
+            if (status < 0 && process(".c", ".i2", c_cpp_exe, cpparg, c_stylecpp, i, YES, YES))
                 exit(1);
-            }
-            // Copied file becomes the new original file
-            free(original_filenames[i]);
-            free(filelist[i]);
-            original_filenames[i] = ptr;
-            filelist[i] = muststrdup(ptr);
-            // No more processing for .h and .inc files
-            ft = get_filetype_by_suffix(filelist[i]);
-            if ((ft == HDRFILE) || (ft == INCFILE)) continue;
-            // Continue processing macro expanded source file
-            goto SWITCH_REPEAT;
-            break;
-        CASE_LLFILE:
-        case LLFILE:
-            if (m4only || clangonly) continue;
-            // llvm-cbe translates llvm-ir to c
-            if (zopt && process(".ll", ".opt.ll", "zopt", llvmopt, outspecified_flag, i, YES, NO))
+            if (status < 0 && process(".i2", ".i", c_zpragma_exe, zpragma_args, filter, i, YES, NO))
+                exit(1);
+        }
+        else {
+            char zpragma_args[1024];
+            snprintf(zpragma_args, sizeof(zpragma_args),"-sccz80 -zcc-opt=%s", zcc_opt_def);
+
+            if ((status = preprocess(i, YES)) > 0)
                 exit(1);
-            if (process(".ll", ".cbe.c", c_llvm_exe, llvmarg, outspecified_flag, i, YES, NO))
+            if (status < 0 && process(".c", ".i2", c_cpp_exe, cpparg, c_stylecpp, i, YES, YES))
                 exit(1);
-            // Write .cbe.c to original directory immediately
-            ptr = changesuffix(original_filenames[i], ".cbe.c");
+            if (status < 0 && process(".i2", ".i", c_zpragma_exe, zpragma_args, filter, i, YES, NO))
+                exit(1);
+        }
+    case CPPFILE:
+        if (m4only || clangonly || llvmonly || preprocessonly) return;
+        if (cache_lookup(i))
+            return;
+        if (compiler_type == CC_SCCZ80 && strcmp(c_copt_exe, "z88dk-copt") == 0 && cleanup) {
+            // sccz80 applies the peephole rules itself, going straight to the .asm file
+            char  *rules[MAX_COPT_RULE_FILES], *args = muststrdup(comparg), *cpu = select_cpu(CPU_MAP_TOOL_COPT);
+            char   buf[FILENAME_MAX + 20];
+            int    j, num_rules = sccz80_copt_rules(rules);
+
+            for (j = 0; j < num_rules; j++) {
+                snprintf(buf, sizeof(buf), "-copt-rules=\"%s\"", rules[j]);
+                BuildOptions(&args, buf);
+            }
+            if (strncmp(cpu, "-m", 2) == 0) {
+                snprintf(buf, sizeof(buf), "-copt-cpu=%s", cpu + 2);
+                BuildOptions(&args, buf);
+            }
+            if (process(".i", ".asm", c_compiler, args, compiler_style, i, YES, NO))
+                exit(1);
+            free(args);
+            goto CASE_ASMFILE;
+        }
+        if (process(".i", ".opt", c_compiler, comparg, compiler_style, i, YES, NO))
+            exit(1);
+    case OPTFILE:
+        if (m4only || clangonly || llvmonly || preprocessonly) return;
+        if (compiler_type == CC_SDCC) {
+            char  *rules[MAX_COPT_RULE_FILES];
+            int    num_rules = 0;
+
+            // filter comments out of asz80 asm file see issue #801 on github
+            if (peepholeopt) zsdcc_asm_filter_comments(i, ".op1");
+
+            /* sdcc_opt.9 bugfixes critical sections and implements RST substitution */
+            // rules[num_rules++] = c_sdccopt9;
+
+            switch (peepholeopt)
+            {
+            case 0:
+                rules[num_rules++] = c_sdccopt9;
+                break;
+            case 1:
+                rules[num_rules++] = c_sdccopt1;
+                rules[num_rules++] = c_sdccopt9;
+                break;
+            default:
+                rules[num_rules++] = c_sdccopt1;
+                rules[num_rules++] = c_sdccopt9;
+                rules[num_rules++] = c_sdccopt2;
+                break;
+            }
+
+            if ( c_coptrules_target ) {
+                rules[num_rules++] = c_coptrules_target;
+            }
+            if ( c_coptrules_cpu ) {
+                rules[num_rules++] = c_coptrules_cpu;
+            }
+            if ( c_coptrules_user ) {
+                rules[num_rules++] = c_coptrules_user;
+            }
+
+            if (peepholeopt == 0)
+                apply_copt_rules(i, num_rules, rules, ".opt", ".op1", ".s");
+            else
+                apply_copt_rules(i, num_rules, rules, ".op1", ".opt", ".asm");
+        } else {
+            char  *rules[MAX_COPT_RULE_FILES];
+            int    num_rules = sccz80_copt_rules(rules);
+
+            apply_copt_rules(i, num_rules, rules, ".opt", ".op1", ".asm");
+        }
+        // continue processing if this is not a .s file
+        if ((compiler_type != CC_SDCC) || (peepholeopt != 0))
+            goto CASE_ASMFILE;
+        // user wants to stop at the .s file if stopping at assembly translation
+        if (assembleonly) return;
+    case SFILE:
+        if (m4only || clangonly || llvmonly || preprocessonly) return;
+        // filter comments out of asz80 asm file see issue #801 on github
+        zsdcc_asm_filter_comments(i, ".s2");
+        if (process(".s2", ".asm", c_copt_exe, c_sdccopt1, filter, i, YES, NO))
+            exit(1);
+    CASE_ASMFILE:
+    case ASMFILE:
+        if (m4only || clangonly || llvmonly || preprocessonly || assembleonly)
+            return;
+
+        // See #16 on github.
+        // z80asm is unable to output object files to an arbitrary destination directory.
+        // We don't want to assemble files in their original source directory because that would
+        // create a temporary object file there which may accidentally overwrite user files.
+
+        // Instead the plan is to copy the asm file to the temp directory and add the original
+        // source directory to the include search path
+
+        BuildAsmLine(asmarg, sizeof(asmarg), " -s ");
+
+        // Check if source .asm file is in the temp directory already (indicates this is an intermediate file)
+        ptr = changesuffix(temporary_filenames[i], ".asm");
+        if (strcmp(ptr, filelist[i]) == 0) {
+            free(ptr);
+            ptr = muststrdup(asmarg);
+        } else {
+            char *p, tmp[FILENAME_MAX*2 + 2];
+
+            // copy .asm file to temp directory
             if (copy_file(filelist[i], "", ptr, "")) {
                 fprintf(stderr, "Couldn't write output file %s\n", ptr);
                 exit(1);
             }
-            // Copied file becomes the new original file
-            free(original_filenames[i]);
-            free(filelist[i]);
-            original_filenames[i] = ptr;
-            filelist[i] = muststrdup(ptr);
-        case CFILE:
-            if (m4only) continue;
-            // special treatment for clang+llvm
-            if ((strcmp(c_compiler_type, "clang") == 0) && !hassuffix(filelist[i], ".cbe.c")) {
-                if (process(".c", ".ll", c_clang_exe, clangarg, outspecified_flag, i, YES, NO))
-                    exit(1);
-                goto CASE_LLFILE;
+
+            // determine path to original source directory
+            p = last_path_char(filelist[i]);
+
+            if (!is_path_absolute(filelist[i])) {
+                int len;
+#ifdef WIN32
+                if (_getcwd(tmp, sizeof(tmp) - 1) == NULL)
+                    *tmp = '\0';
+#else
+                if (getcwd(tmp, sizeof(tmp) - 1) == NULL)
+                    *tmp = '\0';
+#endif
+                if (p) {
+                    len = strlen(tmp);
+                    snprintf(tmp + len, sizeof(tmp) - len - 1, "/%.*s", (int)(p - filelist[i]), filelist[i]);
+                }
+
+                if (*tmp == '\0')
+                    strcpy(tmp, ".");
             }
-            if (clangonly || llvmonly) continue;
-            if (hassuffix(filelist[i], ".cbe.c"))
-                BuildOptions(&cpparg, clangcpparg);
-            // past clang+llvm related pre-processing
-            if (compiler_type == CC_SDCC) {
-                char zpragma_args[1024];
-                snprintf(zpragma_args, sizeof(zpragma_args),"-zcc-opt=%s", zcc_opt_def);
-                if (process(".c", ".i2", c_cpp_exe, cpparg, c_stylecpp, i, YES, YES))
-                    exit(1);
-                if (process(".i2", ".i", c_zpragma_exe, zpragma_args, filter, i, YES, NO))
-                    exit(1);
+            else if (p) {
+                snprintf(tmp, sizeof(tmp) - 1, "%.*s", (int)(p - filelist[i]), filelist[i]);
+            } else {
+                strcpy(tmp, ".");
             }
-            else {
-                char zpragma_args[1024];
-                snprintf(zpragma_args, sizeof(zpragma_args),"-sccz80 -zcc-opt=%s", zcc_opt_def);
 
-                if (process(".c", ".i2", c_cpp_exe, cpparg, c_stylecpp, i, YES, YES))
-                    exit(1);
-                if (process(".i2", ".i", c_zpragma_exe, zpragma_args, filter, i, YES, NO))
-                    exit(1);
+            // working file is now the .asm file in the temp directory
+            free(filelist[i]);
+            filelist[i] = ptr;
+
+            // add original source directory to the include path
+            ptr = mustmalloc((strlen(asmarg) + strlen(tmp) + 7) * sizeof(char));
+            sprintf(ptr, "%s -I\"%s\" ", asmarg, tmp);
+        }
+
+        // insert module directive at front of .asm file see issue #46 on github
+        // this is a bit of a hack - foo.asm is copied to foo.tmp and then foo.tmp is written back to foo.asm with module header
+
+        {
+            char *p, *q, tmp[FILENAME_MAX*2 + 100];
+
+            p = changesuffix(temporary_filenames[i], ".tmp");
+
+            if (copy_file(filelist[i], "", p, "")) {
+                fprintf(stderr, "Couldn't write output file %s\n", p);
+                exit(1);
             }
-        case CPPFILE:
-            if (m4only || clangonly || llvmonly || preprocessonly) continue;
-            if (process(".i", ".opt", c_compiler, comparg, compiler_style, i, YES, NO))
+
+            if ((q = last_path_char(original_filenames[i])) != NULL )
+                q++;
+            else
+                q = original_filenames[i];
+
+            snprintf(tmp, sizeof(tmp) - 3, "MODULE %s\n"
+                     "LINE 0, \"%s\"\n\n", q, original_filenames[i]);
+
+            // change non-alnum chars in module name to underscore
+
+            for (q = tmp+7; *q != '\n'; ++q)
+                if (!isalnum(*q)) *q = '_';
+
+            if (prepend_file(p, "", filelist[i], "", tmp)) {
+                fprintf(stderr, "Couldn't append output file %s\n", p);
                 exit(1);
-        case OPTFILE:
-            if (m4only || clangonly || llvmonly || preprocessonly) continue;
-            if (compiler_type == CC_SDCC) {
-                char  *rules[MAX_COPT_RULE_FILES];
-                int    num_rules = 0;
+            }
 
-                // filter comments out of asz80 asm file see issue #801 on github
-                if (peepholeopt) zsdcc_asm_filter_comments(i, ".op1");
+            free(p);
+        }
 
-                /* sdcc_opt.9 bugfixes critical sections and implements RST substitution */
-                // rules[num_rules++] = c_sdccopt9;
+        // must be late assembly for the first file when making a binary
+        if ((i == 0) && build_bin)
+        {
+            c_crt_incpath = ptr;
+            if (verbose) printf("WILL ACT AS CRT\n");
+            return;
+        }
 
-                switch (peepholeopt)
-                {
-                case 0:
-                    rules[num_rules++] = c_sdccopt9;
-                    break;
-                case 1:
-                    rules[num_rules++] = c_sdccopt1;
-                    rules[num_rules++] = c_sdccopt9;
-                    break;
-                default:
-                    rules[num_rules++] = c_sdccopt1;
-                    rules[num_rules++] = c_sdccopt9;
-                    rules[num_rules++] = c_sdccopt2;
-                    break;
-                }
+        if (process(".asm", c_extension, c_assembler, ptr, assembler_style, i, YES, NO))
+            exit(1);
+        free(ptr);
+        cache_store(i);
+        break;
+    case OBJFILE:
+        break;
+    default:
+        if (strcmp(filelist[i], original_filenames[i]) == 0)
+            fprintf(stderr, "Filetype of %s unrecognized\n", filelist[i]);
+        else
+            fprintf(stderr, "Filetype of %s (%s) unrecognized\n", filelist[i], original_filenames[i]);
+        exit(1);
+    }
+}
 
-                if ( c_coptrules_target ) {
-                    rules[num_rules++] = c_coptrules_target;
-                }
-                if ( c_coptrules_cpu ) {
-                    rules[num_rules++] = c_coptrules_cpu;
-                }
-                if ( c_coptrules_user ) {
-                    rules[num_rules++] = c_coptrules_user;
-                }
+#ifndef WIN32
+/* Append the output file of job i with extension ext to stream out, or to
+   the file named out_name if out is NULL, then remove it */
+static void collect_job_file(int i, char *ext, FILE *out, char *out_name)
+{
+    char   *name, buffer[LINEMAX + 1];
+    size_t  n;
+    FILE   *in;
+
+    name = changesuffix(temporary_filenames[i], ext);
+    if ((in = fopen(name, "rb")) != NULL) {
+        if (out_name != NULL && (out = fopen(out_name, "ab")) == NULL) {
+            fprintf(stderr, "Could not open %s: File in use?\n", out_name);
+            exit(1);
+        }
+        while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+            fwrite(buffer, 1, n, out);
+        fclose(in);
+        if (out_name != NULL)
+            fclose(out);
+        else
+            fflush(out);
+    }
+    remove(name);
+    free(name);
+}
+
+/* Child process: compile file i with all output redirected to files next
+   to its temporary file, and write the names of the resulting files */
+static void run_job(int i)
+{
+    char   *name, buffer[LINEMAX + 1];
+    FILE   *fp;
+
+    job_child = 1;
+
+    name = changesuffix(temporary_filenames[i], ".jout");
+    if (freopen(name, "w", stdout) == NULL)
+        exit(1);
+    free(name);
+    name = changesuffix(temporary_filenames[i], ".jerr");
+    if (freopen(name, "w", stderr) == NULL)
+        exit(1);
+    free(name);
 
-                if (peepholeopt == 0)
-                    apply_copt_rules(i, num_rules, rules, ".opt", ".op1", ".s");
-                else
-                    apply_copt_rules(i, num_rules, rules, ".op1", ".opt", ".asm");
-            } else {
-                char  *rules[MAX_COPT_RULE_FILES];
-                int    num_rules = 0;
+    // pragmas of this file go to a zcc_opt.def of its own, appended to the real one in file order
+    name = changesuffix(temporary_filenames[i], ".jdef");
+    comparg = replace_str(comparg, zcc_opt_def, name);
+    zcc_opt_def = name;
 
-                /* z80rules.9 implements intrinsics and RST substitution */
-                rules[num_rules++] = c_coptrules9;
+    compile_file(i);
 
-                switch (peepholeopt) {
-                case 0:
-                    break;
-                case 1:
-                    rules[num_rules++] = c_coptrules1;
-                    break;
-                case 2:
-                    rules[num_rules++] = c_coptrules2;
-                    rules[num_rules++] = c_coptrules1;
-                    break;
-                default:
-                    rules[num_rules++] = c_coptrules2;
-                    rules[num_rules++] = c_coptrules1;
-                    rules[num_rules++] = c_coptrules3;
-                    break;
-                }
+    name = changesuffix(temporary_filenames[i], ".jres");
+    if ((fp = fopen(name, "w")) == NULL) {
+        fprintf(stderr, "Could not create %s\n", name);
+        exit(1);
+    }
+    snprintf(buffer, sizeof(buffer), "%s\n%s\n", filelist[i], original_filenames[i]);
+    fputs(buffer, fp);
+    fclose(fp);
+    exit(0);
+}
+#endif
 
-                if ( c_coptrules_target ) {
-                    rules[num_rules++] = c_coptrules_target;
-                }
-                if ( c_coptrules_cpu ) {
-                    rules[num_rules++] = c_coptrules_cpu;
-                }
-                if ( c_coptrules_sccz80 ) {
-                    rules[num_rules++] = c_coptrules_sccz80;
-                }
-                if ( c_coptrules_user ) {
-                    rules[num_rules++] = c_coptrules_user;
-                }
+/* Compile files first to last-1, running up to c_jobs of them at the same time.
+ * Output, pragmas and errors are collected in file order once all jobs have
+ * finished, so the result is the same as processing the files one by one. */
+static void compile_files_parallel(int first, int last)
+{
+#ifdef WIN32
+    int    i;
 
-                apply_copt_rules(i, num_rules, rules, ".opt", ".op1", ".asm");
+    for (i = first; i < last; i++)
+        compile_file(i);
+#else
+    pid_t *pids;
+    int   *failed;
+    int    i, next, running, status, stop;
+    char  *name, buffer[LINEMAX + 1];
+    pid_t  pid;
+    FILE  *fp;
+
+    pids = mustmalloc(nfiles * sizeof(*pids));
+    failed = mustmalloc(nfiles * sizeof(*failed));
+
+    fflush(stdout);
+    fflush(stderr);
+
+    next = first;
+    running = stop = 0;
+    while ((next < last && !stop) || running > 0) {
+        while (next < last && !stop && running < c_jobs) {
+            if ((pid = fork()) == 0)
+                run_job(next);
+            if (pid < 0) {
+                fprintf(stderr, "Cannot start job for %s\n", original_filenames[next]);
+                stop = 1;
+                break;
             }
-            // continue processing if this is not a .s file
-            if ((compiler_type != CC_SDCC) || (peepholeopt != 0))
-                goto CASE_ASMFILE;
-            // user wants to stop at the .s file if stopping at assembly translation
-            if (assembleonly) continue;
-        case SFILE:
-            if (m4only || clangonly || llvmonly || preprocessonly) continue;
-            // filter comments out of asz80 asm file see issue #801 on github
-            zsdcc_asm_filter_comments(i, ".s2");
-            if (process(".s2", ".asm", c_copt_exe, c_sdccopt1, filter, i, YES, NO))
-                exit(1);
-        CASE_ASMFILE:
-        case ASMFILE:
-            if (m4only || clangonly || llvmonly || preprocessonly || assembleonly)
-                continue;
+            pids[next] = pid;
+            failed[next++] = 0;
+            running++;
+        }
+        if (running == 0)
+            break;
 
-            // See #16 on github.
-            // z80asm is unable to output object files to an arbitrary destination directory.
-            // We don't want to assemble files in their original source directory because that would
-            // create a temporary object file there which may accidentally overwrite user files.
+        if ((pid = wait(&status)) < 0)
+            break;
+        for (i = first; i < next && pids[i] != pid; i++)
+            ;
+        if (i == next)
+            continue;
+        running--;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            // no new jobs after an error, the ones before it still report
+            failed[i] = 1;
+            stop = 1;
+        }
+    }
 
-            // Instead the plan is to copy the asm file to the temp directory and add the original
-            // source directory to the include search path
+    for (i = first; i < next; i++) {
+        collect_job_file(i, ".jout", stdout, NULL);
+        collect_job_file(i, ".jerr", stderr, NULL);
+        if (failed[i])
+            exit(1);
+        collect_job_file(i, ".jdef", NULL, zcc_opt_def);
 
-            BuildAsmLine(asmarg, sizeof(asmarg), " -s ");
+        name = changesuffix(temporary_filenames[i], ".jres");
+        if ((fp = fopen(name, "r")) == NULL)
+            exit(1);
+        if (fgets(buffer, sizeof(buffer), fp) != NULL) {
+            KillEOL(buffer);
+            free(filelist[i]);
+            filelist[i] = muststrdup(buffer);
+        }
+        if (fgets(buffer, sizeof(buffer), fp) != NULL) {
+            KillEOL(buffer);
+            free(original_filenames[i]);
+            original_filenames[i] = muststrdup(buffer);
+        }
+        fclose(fp);
+        remove(name);
+        free(name);
+    }
+    if (next < last)
+        exit(1);
 
-            // Check if source .asm file is in the temp directory already (indicates this is an intermediate file)
-            ptr = changesuffix(temporary_filenames[i], ".asm");
-            if (strcmp(ptr, filelist[i]) == 0) {
-                free(ptr);
-                ptr = muststrdup(asmarg);
-            } else {
-                char *p, tmp[FILENAME_MAX*2 + 2];
+    free(pids);
+    free(failed);
+#endif
+}
 
-                // copy .asm file to temp directory
-                if (copy_file(filelist[i], "", ptr, "")) {
-                    fprintf(stderr, "Couldn't write output file %s\n", ptr);
-                    exit(1);
-                }
 
-                // determine path to original source directory
-                p = last_path_char(filelist[i]);
+/*
+ * Object cache
+ *
+ * Objects compiled from C are kept in c_cache_dir, named after a 128 bit
+ * FNV-1a hash of everything that goes into them once the source has been
+ * preprocessed: the .i file, the compiler, copt rules and assembler with
+ * their options, the cpu and the source file name. An entry KEY is made of
+ * KEY.o, the KEY.lis and KEY.sym files if they were asked for, and KEY.def
+ * with the lines the compiler added to zcc_opt.def. The least recently used
+ * entries are removed when the cache grows beyond c_cache_size megabytes.
+ */
 
-                if (!is_path_absolute(filelist[i])) {
-                    int len;
 #ifdef WIN32
-                    if (_getcwd(tmp, sizeof(tmp) - 1) == NULL)
-                        *tmp = '\0';
+#define cache_mkdir(d)  mkdir(d)
+#define cache_sleep()   Sleep(5)
 #else
-                    if (getcwd(tmp, sizeof(tmp) - 1) == NULL)
-                        *tmp = '\0';
+#define cache_mkdir(d)  mkdir(d, 0777)
+#define cache_sleep()   usleep(5000)
 #endif
-                    if (p) {
-                        len = strlen(tmp);
-                        snprintf(tmp + len, sizeof(tmp) - len - 1, "/%.*s", (int)(p - filelist[i]), filelist[i]);
-                    }
 
-                    if (*tmp == '\0')
-                        strcpy(tmp, ".");
-                }
-                else if (p) {
-                    snprintf(tmp, sizeof(tmp) - 1, "%.*s", (int)(p - filelist[i]), filelist[i]);
-                } else {
-                    strcpy(tmp, ".");
-                }
+typedef struct {
+    uint32_t  w[4];             /* Least significant word first */
+} hash128_t;
 
-                // working file is now the .asm file in the temp directory
-                free(filelist[i]);
-                filelist[i] = ptr;
+static char   cache_key[33];
+static int    cache_file = -1;  /* File being compiled after a cache miss */
+static long   cache_opt_size;   /* Size of zcc_opt.def before compiling it */
 
-                // add original source directory to the include path
-                ptr = mustmalloc((strlen(asmarg) + strlen(tmp) + 7) * sizeof(char));
-                sprintf(ptr, "%s -I\"%s\" ", asmarg, tmp);
-            }
-
-            // insert module directive at front of .asm file see issue #46 on github
-            // this is a bit of a hack - foo.asm is copied to foo.tmp and then foo.tmp is written back to foo.asm with module header
-
-            {
-                char *p, *q, tmp[FILENAME_MAX*2 + 100];
+static void hash_init(hash128_t *h)
+{
+    h->w[3] = 0x6c62272e;
+    h->w[2] = 0x07bb0142;
+    h->w[1] = 0x62b82175;
+    h->w[0] = 0x6295c58d;
+}
 
-                p = changesuffix(temporary_filenames[i], ".tmp");
+static void hash_bytes(hash128_t *h, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    uint32_t  r[4];
+    uint64_t  c;
+    int       k;
+
+    while (len--) {
+        h->w[0] ^= *p++;
+
+        /* multiply by the FNV prime 2^88 + 0x13b */
+        for (c = 0, k = 0; k < 4; k++) {
+            c += (uint64_t)h->w[k] * 0x13b;
+            r[k] = (uint32_t)c;
+            c >>= 32;
+        }
+        c = (uint64_t)r[2] + (uint32_t)(h->w[0] << 24);
+        r[2] = (uint32_t)c;
+        r[3] += (uint32_t)(c >> 32) + ((h->w[0] >> 8) | (h->w[1] << 24));
+        memcpy(h->w, r, sizeof(r));
+    }
+}
 
-                if (copy_file(filelist[i], "", p, "")) {
-                    fprintf(stderr, "Couldn't write output file %s\n", p);
-                    exit(1);
-                }
+static void hash_string(hash128_t *h, const char *s)
+{
+    if (s == NULL)
+        s = "";
+    hash_bytes(h, s, strlen(s) + 1);
+}
 
-                if ((q = last_path_char(original_filenames[i])) != NULL )
-                    q++;
-                else
-                    q = original_filenames[i];
+static void hash_int(hash128_t *h, long val)
+{
+    char  buf[32];
 
-                snprintf(tmp, sizeof(tmp) - 3, "MODULE %s\n"
-                         "LINE 0, \"%s\"\n\n", q, original_filenames[i]);
+    snprintf(buf, sizeof(buf), "%ld", val);
+    hash_string(h, buf);
+}
 
-                // change non-alnum chars in module name to underscore
+static int hash_file(hash128_t *h, char *name)
+{
+    char    buffer[8192];
+    size_t  n;
+    FILE   *fp;
 
-                for (q = tmp+7; *q != '\n'; ++q)
-                    if (!isalnum(*q)) *q = '_';
+    if ((fp = fopen(name, "rb")) == NULL)
+        return -1;
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        hash_bytes(h, buffer, n);
+    fclose(fp);
+    return 0;
+}
 
-                if (prepend_file(p, "", filelist[i], "", tmp)) {
-                    fprintf(stderr, "Couldn't append output file %s\n", p);
-                    exit(1);
-                }
+/* Identify a tool by the size and date of its executable as found in PATH */
+static void hash_exe(hash128_t *h, char *exe)
+{
+    char         name[FILENAME_MAX + 1], *path, *p, *end;
+    struct stat  st;
+    int          found;
+#ifdef WIN32
+    const char   sep = ';';
+#else
+    const char   sep = ':';
+#endif
 
-                free(p);
-            }
+    hash_string(h, exe);
+    if (exe == NULL)
+        return;
 
-            // must be late assembly for the first file when making a binary
-            if ((i == 0) && build_bin)
-            {
-                c_crt_incpath = ptr;
-                if (verbose) printf("WILL ACT AS CRT\n");
-                continue;
+    found = (stat(exe, &st) == 0);
+    if (!found && strchr(exe, '/') == NULL && strchr(exe, '\\') == NULL && (path = getenv("PATH")) != NULL) {
+        for (p = path; !found && *p; p = (*end ? end + 1 : end)) {
+            if ((end = strchr(p, sep)) == NULL)
+                end = p + strlen(p);
+            snprintf(name, sizeof(name), "%.*s/%s", (int)(end - p), p, exe);
+            found = (stat(name, &st) == 0);
+#ifdef WIN32
+            if (!found) {
+                strncat(name, ".exe", sizeof(name) - strlen(name) - 1);
+                found = (stat(name, &st) == 0);
             }
-
-            if (process(".asm", c_extension, c_assembler, ptr, assembler_style, i, YES, NO))
-                exit(1);
-            free(ptr);
-            break;
-        case OBJFILE:
-            break;
-        default:
-            if (strcmp(filelist[i], original_filenames[i]) == 0)
-                fprintf(stderr, "Filetype of %s unrecognized\n", filelist[i]);
-            else
-                fprintf(stderr, "Filetype of %s (%s) unrecognized\n", filelist[i], original_filenames[i]);
-            exit(1);
+#endif
         }
     }
+    if (found) {
+        hash_int(h, (long)st.st_size);
+        hash_int(h, (long)st.st_mtime);
+    }
+}
 
-    if (verbose) printf("\nGENERATING OUTPUT\n");
+static void hash_rules(hash128_t *h, char *rules)
+{
+    char  *copy, *name;
 
-    if (m4only) exit(0);
+    if (rules == NULL)
+        return;
+    copy = muststrdup(rules);
+    name = strip_outer_quotes(zcc_strstrip(copy));
+    hash_string(h, name);
+    hash_file(h, name);
+    free(copy);
+}
 
-    if (clangonly) {
-        if (nfiles > 1) outputfile = NULL;
-        copy_output_files_to_destdir(".ll", 1);
-        exit(0);
-    }
+static char *cache_name(char *name, char *ext)
+{
+    char  *ret;
 
-    if (llvmonly) exit(0);
+    zcc_asprintf(&ret, "%s/%s%s", c_cache_dir, name, ext);
+    return ret;
+}
 
-    if (preprocessonly) {
-        if (nfiles > 1) outputfile = NULL;
-        copy_output_files_to_destdir(".i", 1);
-        exit(0);
+/* Copy file src from offset to file dst opened with mode, returns the bytes copied or -1 */
+static long cache_copy(char *src, long offset, char *dst, char *mode)
+{
+    char    buffer[8192];
+    size_t  n;
+    long    total = 0;
+    FILE   *in, *out;
+
+    if ((in = fopen(src, "rb")) == NULL)
+        return -1;
+    if (fseek(in, offset, SEEK_SET) != 0 || (out = fopen(dst, mode)) == NULL) {
+        fclose(in);
+        return -1;
     }
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        if (fwrite(buffer, 1, n, out) != n)
+            total = -1;
+        else if (total >= 0)
+            total += n;
+    }
+    fclose(in);
+    if (fclose(out) != 0)
+        total = -1;
+    return total;
+}
 
-    if (assembleonly) {
-        if (nfiles > 1) outputfile = NULL;
-        copy_output_files_to_destdir(".asm", 1);
-        copy_output_files_to_destdir(".s", 1);
-        exit(0);
+/* Serialise updates of the statistics between zcc processes */
+static int cache_lock(int lock)
+{
+    char        *name = cache_name("lock", "");
+    struct stat  st;
+    int          tries;
+
+    if (!lock) {
+        rmdir(name);
+        free(name);
+        return 1;
+    }
+    for (tries = 0; tries < 2000; tries++) {
+        if (cache_mkdir(name) == 0) {
+            free(name);
+            return 1;
+        }
+        // a lock left by a zcc that was killed
+        if (stat(name, &st) == 0 && time(NULL) - st.st_mtime > 10)
+            rmdir(name);
+        cache_sleep();
     }
+    free(name);
+    return 0;
+}
 
-    {
-        char *tempofile = outputfile;
-        outputfile = NULL;
-        if (lston) copy_output_files_to_destdir(".lis", 1);
-        if (symbolson) copy_output_files_to_destdir(".sym", 1);
-        outputfile = tempofile;
+static int cache_sort_used(const void *a, const void *b)
+{
+    const time_t  ta = *(const time_t *)a;
+    const time_t  tb = *(const time_t *)b;
+
+    return (ta > tb) - (ta < tb);
+}
+
+/* Remove the least recently used entries until the cache is below 90% of
+   its maximum size, returns the size left */
+static long cache_evict(void)
+{
+    typedef struct {
+        time_t  used;
+        char    key[33];
+    } entry_t;
+    static char   *exts[] = { NULL, ".lis", ".sym", ".def" };
+    entry_t       *entries = NULL;
+    struct dirent *ent;
+    struct stat    st;
+    DIR           *dir;
+    char          *name;
+    long           total = 0, limit = c_cache_size * 1024L * 1024L / 10 * 9;
+    int            n = 0, k, e;
+
+    if ((dir = opendir(c_cache_dir)) == NULL)
+        return 0;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strspn(ent->d_name, "0123456789abcdef") != 32)
+            continue;
+        name = cache_name(ent->d_name, "");
+        if (stat(name, &st) == 0) {
+            total += (long)st.st_size;
+            if (strcmp(ent->d_name + 32, c_extension) == 0) {
+                entries = realloc(entries, (n + 1) * sizeof(*entries));
+                entries[n].used = st.st_mtime;
+                snprintf(entries[n++].key, sizeof(entries[0].key), "%.32s", ent->d_name);
+            }
+        }
+        free(name);
+    }
+    closedir(dir);
+
+    qsort(entries, n, sizeof(*entries), cache_sort_used);
+    exts[0] = c_extension;
+    for (k = 0; k < n && total > limit; k++) {
+        for (e = 0; e < sizeof(exts) / sizeof(exts[0]); e++) {
+            name = cache_name(entries[k].key, exts[e]);
+            if (stat(name, &st) == 0 && remove(name) == 0)
+                total -= (long)st.st_size;
+            free(name);
+        }
     }
+    free(entries);
+    return total;
+}
 
-    if (compileonly) {
-        if ((nfiles > 1) && (outputfile != NULL)) {
-            /* consolidated object file */
-            outputfile = changesuffix(outputfile, ".o");
-            if (linkthem(c_linker))
-                exit(1);
+/* Add to the statistics kept in the cache directory */
+static void cache_update_stats(long hits, long misses, long bytes)
+{
+    char  *name = cache_name("stats", "");
+    long   h = 0, m = 0, b = 0;
+    FILE  *fp;
+
+    if (cache_lock(1)) {
+        if ((fp = fopen(name, "r")) != NULL) {
+            if (fscanf(fp, "%ld %ld %ld", &h, &m, &b) != 3)
+                h = m = b = 0;
+            fclose(fp);
         }
-        else
-        {
-            /* independent object files */
-            copy_output_files_to_destdir(c_extension, 1);
+        h += hits;
+        m += misses;
+        b += bytes;
+        if (b > c_cache_size * 1024L * 1024L)
+            b = cache_evict();
+        if ((fp = fopen(name, "w")) != NULL) {
+            fprintf(fp, "%ld %ld %ld\n", h, m, b);
+            fclose(fp);
         }
-        exit(0);
+        cache_lock(0);
     }
+    free(name);
+}
 
-    /* Set the default name as necessary */
+static void cache_print_stats(void)
+{
+    char  *name;
+    long   h = 0, m = 0, b = 0;
+    FILE  *fp;
 
-    if (outputfile == NULL)
-        outputfile = c_linker_output_file ? c_linker_output_file : defaultout;
+    if (c_cache_dir == NULL) {
+        fprintf(stderr, "No cache directory given with -cache-dir\n");
+        exit(1);
+    }
+    name = cache_name("stats", "");
+    if ((fp = fopen(name, "r")) != NULL) {
+        if (fscanf(fp, "%ld %ld %ld", &h, &m, &b) != 3)
+            h = m = b = 0;
+        fclose(fp);
+    }
+    free(name);
 
-    strcpy(filenamebuf, outputfile);
+    printf("cache directory     %s\n", c_cache_dir);
+    printf("cache hits          %ld\n", h);
+    printf("cache misses        %ld\n", m);
+    printf("cache size          %.1f MB\n", b / (1024.0 * 1024.0));
+    printf("max cache size      %d MB\n", c_cache_size);
+}
 
-    if ((ptr = find_file_ext(filenamebuf)) != NULL)
-        *ptr = 0;
+/* Look up the object of preprocessed file i in the cache and use it if found */
+static int cache_lookup(int i)
+{
+    static char **rules[] = { &c_coptrules1, &c_coptrules2, &c_coptrules3, &c_coptrules9, &c_coptrules_cpu,
+                              &c_coptrules_sccz80, &c_coptrules_target, &c_coptrules_user,
+                              &c_sdccopt1, &c_sdccopt2, &c_sdccopt3, &c_sdccopt9 };
+    hash128_t     h;
+    struct stat   st;
+    char          cwd[FILENAME_MAX + 1], *ptr, *name, *outname;
+    int           k, ok;
+
+    cache_file = -1;
+    if (c_cache_dir == NULL || assembleonly || (i == 0 && build_bin) || !hassuffix(filelist[i], ".i"))
+        return 0;
 
-    /* Link */
+    hash_init(&h);
+    hash_string(&h, "zcc object cache 1");
+    hash_string(&h, original_filenames[i]);
+#ifdef WIN32
+    if (_getcwd(cwd, sizeof(cwd) - 1) == NULL)
+#else
+    if (getcwd(cwd, sizeof(cwd) - 1) == NULL)
+#endif
+        *cwd = '\0';
+    hash_string(&h, cwd);
+    for (k = 0; k < CPU_MAP_TOOL_SIZE; k++)
+        hash_string(&h, select_cpu(k));
+
+    hash_exe(&h, c_compiler);
+    ptr = replace_str(comparg, zcc_opt_def, "zcc_opt.def");
+    hash_string(&h, ptr);
+    free(ptr);
+    hash_int(&h, compiler_type);
 
-    if (linkthem(c_linker))
-    {
-        if (build_bin && lston && copy_file(c_crt0, ".lis", filenamebuf, ".lis"))
-            fprintf(stderr, "Cannot copy crt0 list file\n");
+    hash_exe(&h, c_copt_exe);
+    hash_int(&h, peepholeopt);
+    hash_int(&h, sdccpeepopt);
+    for (k = 0; k < sizeof(rules) / sizeof(rules[0]); k++)
+        hash_rules(&h, *rules[k]);
 
-        exit(1);
+    hash_exe(&h, c_assembler);
+    ptr = replace_str(asmargs ? asmargs : "", zcc_opt_dir, "zcc_opt");
+    hash_string(&h, ptr);
+    free(ptr);
+    hash_string(&h, c_asmopts);
+    hash_int(&h, z80verbose);
+    hash_int(&h, symbolson);
+    hash_int(&h, lston);
+
+    if (hash_file(&h, filelist[i]) != 0)
+        return 0;
+    snprintf(cache_key, sizeof(cache_key), "%08x%08x%08x%08x",
+        (unsigned)h.w[3], (unsigned)h.w[2], (unsigned)h.w[1], (unsigned)h.w[0]);
+
+    cache_mkdir(c_cache_dir);
+    cache_opt_size = (stat(zcc_opt_def, &st) == 0) ? (long)st.st_size : 0;
+
+    name = cache_name(cache_key, c_extension);
+    outname = changesuffix(temporary_filenames[i], c_extension);
+    ok = (stat(name, &st) == 0) && (cache_copy(name, 0, outname, "wb") >= 0);
+    free(name);
+    if (ok && lston) {
+        name = cache_name(cache_key, ".lis");
+        ptr = changesuffix(outname, ".lis");
+        ok = (cache_copy(name, 0, ptr, "wb") >= 0);
+        free(ptr);
+        free(name);
+    }
+    if (ok && symbolson) {
+        name = cache_name(cache_key, ".sym");
+        ptr = changesuffix(outname, ".sym");
+        ok = (cache_copy(name, 0, ptr, "wb") >= 0);
+        free(ptr);
+        free(name);
+    }
+
+    if (ok) {
+        name = cache_name(cache_key, ".def");
+        ok = (cache_copy(name, 0, zcc_opt_def, "ab") >= 0);
+        free(name);
+    }
+
+    if (!ok) {
+        free(outname);
+        cache_file = i;
+        cache_update_stats(0, 1, 0);
+        return 0;
     }
 
-    /* Build binary */
+    if (verbose)
+        printf("Using cached object %s%s\n", cache_key, c_extension);
+    name = cache_name(cache_key, c_extension);
+    utime(name, NULL);    /* recently used */
+    free(name);
+    free(filelist[i]);
+    filelist[i] = outname;
+    cache_update_stats(1, 0, 0);
+    return 1;
+}
 
-    if (build_bin) {
+/* Store the object of file i after a cache miss */
+static void cache_store(int i)
+{
+    char   *name, *tmp, *ptr, pid[32];
+    long    n, bytes = 0;
 
-        int status = 0;
+    if (cache_file != i)
+        return;
+    cache_file = -1;
+
+    name = cache_name(cache_key, ".def");
+    bytes += (n = cache_copy(zcc_opt_def, cache_opt_size, name, "wb"));
+    if (n < 0) {
+        // nothing was added to zcc_opt.def
+        FILE *fp = fopen(name, "wb");
+        bytes = (fp != NULL && fclose(fp) == 0) ? 0 : -1;
+    }
+    free(name);
+    if (bytes >= 0 && lston) {
+        ptr = changesuffix(filelist[i], ".lis");
+        name = cache_name(cache_key, ".lis");
+        bytes = ((n = cache_copy(ptr, 0, name, "wb")) < 0) ? -1 : bytes + n;
+        free(name);
+        free(ptr);
+    }
+    if (bytes >= 0 && symbolson) {
+        ptr = changesuffix(filelist[i], ".sym");
+        name = cache_name(cache_key, ".sym");
+        bytes = ((n = cache_copy(ptr, 0, name, "wb")) < 0) ? -1 : bytes + n;
+        free(name);
+        free(ptr);
+    }
+    if (bytes < 0)
+        return;
 
-        if (mapon && copy_file(c_crt0, ".map", filenamebuf, ".map")) {
-            fprintf(stderr, "Cannot copy map file\n");
-            status = 1;
-        }
+    // the object goes last and under a temporary name: it marks the entry complete
+#ifdef WIN32
+    snprintf(pid, sizeof(pid), ".%d.tmp", _getpid());
+#else
+    snprintf(pid, sizeof(pid), ".%d.tmp", (int)getpid());
+#endif
+    tmp = cache_name(cache_key, pid);
+    name = cache_name(cache_key, c_extension);
+    if ((n = cache_copy(filelist[i], 0, tmp, "wb")) >= 0) {
+        remove(name);
+        if (rename(tmp, name) == 0)
+            cache_update_stats(0, 0, bytes + n);
+        else
+            remove(tmp);
+    }
+    free(tmp);
+    free(name);
+}
 
-        if (symbolson && copy_file(c_crt0, ".sym", filenamebuf, ".sym")) {
-            fprintf(stderr, "Cannot copy symbols file\n");
-            status = 1;
-        }
 
-        if (globaldefon && copy_defc_file(c_crt0, ".def", filenamebuf, ".def")) {
-            fprintf(stderr, "Cannot create global defc file\n");
-            status = 1;
-        }
+/* List the copt rule files for sccz80 output in the order they are applied */
+static int sccz80_copt_rules(char **rules)
+{
+    int    num_rules = 0;
 
-        if (lston && copy_file(c_crt0, ".lis", filenamebuf, ".lis")) {
-            fprintf(stderr, "Cannot copy crt0 list file\n");
-            status = 1;
-        }
+    /* z80rules.9 implements intrinsics and RST substitution */
+    rules[num_rules++] = c_coptrules9;
 
-        if (createapp) {
-            /* Building an application - run the appmake command on it */
-            snprintf(buffer, sizeof(buffer), "%s %s -b \"%s\" -c \"%s\"", c_appmake_exe, appmakeargs ? appmakeargs : "", outputfile, c_crt0);
-            if (verbose) {
-                printf("%s\n", buffer);
-                fflush(stdout);
-            }
-            if (system(buffer)) {
-                fprintf(stderr, "Building application code failed\n");
-                status = 1;
-            }
-        }
+    switch (peepholeopt) {
+    case 0:
+        break;
+    case 1:
+        rules[num_rules++] = c_coptrules1;
+        break;
+    case 2:
+        rules[num_rules++] = c_coptrules2;
+        rules[num_rules++] = c_coptrules1;
+        break;
+    default:
+        rules[num_rules++] = c_coptrules2;
+        rules[num_rules++] = c_coptrules1;
+        rules[num_rules++] = c_coptrules3;
+        break;
+    }
 
-        exit(status);
+    if ( c_coptrules_target ) {
+        rules[num_rules++] = c_coptrules_target;
+    }
+    if ( c_coptrules_cpu ) {
+        rules[num_rules++] = c_coptrules_cpu;
+    }
+    if ( c_coptrules_sccz80 ) {
+        rules[num_rules++] = c_coptrules_sccz80;
     }
+    if ( c_coptrules_user ) {
+        rules[num_rules++] = c_coptrules_user;
+    }
+    return num_rules;
 }
 
-
 static void apply_copt_rules(int filenumber, int num, char **rules, char *ext1, char *ext2, char *ext)
 {
     char   argbuf[FILENAME_MAX+1];
-    int    i;
+    int    i, status;
     char  *input_ext;
     char  *output_ext;
+    char  *cmds[MAX_COPT_RULE_FILES];
+    char  *outname;
+
+    // Unless the intermediate files are kept, pipe the passes into each other
+    if (cleanup && num > 1 && hassuffix(filelist[filenumber], ext1)) {
+        outname = changesuffix(temporary_filenames[filenumber], ext);
+        for (i = 0; i < num; i++)
+            zcc_asprintf(&cmds[i], "%s %s %s", c_copt_exe, select_cpu(CPU_MAP_TOOL_COPT), rules[i]);
+
+        if (verbose) {
+            printf("%s < \"%s\"", cmds[0], filelist[filenumber]);
+            for (i = 1; i < num; i++)
+                printf(" | %s", cmds[i]);
+            printf(" > \"%s\"\n", outname);
+            fflush(stdout);
+        }
+        status = run_filters(cmds, num, filelist[filenumber], outname);
+
+        for (i = 0; i < num; i++)
+            free(cmds[i]);
+        if (status == 0) {
+            free(filelist[filenumber]);
+            filelist[filenumber] = outname;
+            return;
+        }
+        free(outname);
+        if (status > 0)
+            exit(1);
+    }
 
     for ( i = 0; i < num ; i++ ) {
         if (i % 2 == 0) {
@@ -2867,6 +3820,10 @@ void remove_temporary_files(void)
 {
     int             j;
 
+    /* Jobs leave their files to the parent process */
+    if (job_child)
+        return;
+
     /* Show all error files */
 
     for (j = 0; j < nfiles; j++) {
@@ -2891,6 +3848,10 @@ void remove_temporary_files(void)
             remove_file_with_extension(temporary_filenames[j], ".def");
             remove_file_with_extension(temporary_filenames[j], ".tmp");
             remove_file_with_extension(temporary_filenames[j], ".lis");
+            remove_file_with_extension(temporary_filenames[j], ".jout");
+            remove_file_with_extension(temporary_filenames[j], ".jerr");
+            remove_file_with_extension(temporary_filenames[j], ".jdef");
+            remove_file_with_extension(temporary_filenames[j], ".jres");
         }
     }
     // Cleanup zcc_opt files
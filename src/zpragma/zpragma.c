@@ -4,18 +4,22 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <inttypes.h>
+#include "zpragma.h"
 
 #define NAMESIZE 256
 
-static char buf[65536];
-
 static char filename[FILENAME_MAX+1];
 static char *c_zcc_opt = "zcc_opt.def";
 static int  lineno = 0;
 static int  sccz80_mode = 0;
+static FILE *output;
+
+static char   *line_buf = NULL;
+static size_t  line_len = 0;
+static size_t  line_size = 0;
 
 
-char *skip_ws(char *ptr)
+static char *skip_ws(char *ptr)
 {
     while ( isspace(*ptr) ) {
         ptr++;
@@ -23,7 +27,7 @@ char *skip_ws(char *ptr)
     return ptr;
 }
 
-void strip_nl(char *ptr)
+static void strip_nl(char *ptr)
 {
     char *nl;
     if ( ( nl = strchr(ptr,'\n') ) != NULL || (nl = strchr(ptr,'\r')) != NULL ) {
@@ -31,7 +35,7 @@ void strip_nl(char *ptr)
     }
 }
 
-void first_word_only(char *ptr)
+static void first_word_only(char *ptr)
 {
     while (!isspace(*ptr))
         ++ptr;
@@ -43,7 +47,7 @@ void first_word_only(char *ptr)
  * things that the startup code might need
  */
 
-void write_pragma_string(char *ptr)
+static void write_pragma_string(char *ptr)
 {
     char *text;
     FILE *fp;
@@ -71,7 +75,7 @@ void write_pragma_string(char *ptr)
 
 /* Dump some bytes into the zcc_opt.def file */
 
-void write_bytes(char *line, int flag)
+static void write_bytes(char *line, int flag)
 {
     FILE   *fp;
     char    sname[NAMESIZE+1];
@@ -134,7 +138,7 @@ void write_bytes(char *line, int flag)
 }	
 
 
-void write_defined(char *sname, int32_t value, int export)
+static void write_defined(char *sname, int32_t value, int export)
 {
     FILE *fp;
 
@@ -153,21 +157,7 @@ void write_defined(char *sname, int32_t value, int export)
     fclose(fp);
 }
 
-void write_need(char *sname, int value)
-{
-    FILE *fp;
-
-    if ( (fp=fopen(c_zcc_opt,"a")) == NULL ) {
-        fprintf(stderr,"%s:%d Cannot open zcc_opt.def file\n", filename, lineno);
-        exit(1);
-    }
-    fprintf(fp,"\nIF !NEED_%s\n",sname);
-    fprintf(fp,"\tdefc\tNEED_%s = %d\n",sname, value);
-    fprintf(fp,"ENDIF\n\n");
-    fclose(fp);
-}
-
-void write_redirect(char *sname, char *value)
+static void write_redirect(char *sname, char *value)
 {
     FILE *fp;
 
@@ -195,7 +185,7 @@ typedef struct convspec_s {
     uint32_t llval;
 } CONVSPEC;
 
-CONVSPEC printf_formats[] = {
+static CONVSPEC printf_formats[] = {
     { 'd', 1, 0x01, 0x1000, 0x01 },
     { 'u', 1, 0x02, 0x2000, 0x02 },
     { 'x', 2, 0x04, 0x4000, 0x04 },
@@ -219,7 +209,7 @@ CONVSPEC printf_formats[] = {
     { 0, 0, 0, 0 }
 };
 
-CONVSPEC scanf_formats[] = {
+static CONVSPEC scanf_formats[] = {
     { 'd', 1, 0x01, 0x1000, 0x01 },
     { 'u', 1, 0x02, 0x2000, 0x02 },
     { 'x', 2, 0x04, 0x4000, 0x04 },
@@ -320,128 +310,188 @@ static uint64_t parse_format_string(char *arg, CONVSPEC *specifiers)
     return format_option;
 }
 
-int main(int argc, char **argv)
+void zpragma_init(int sccz80, char *zcc_opt, FILE *out)
 {
-    int     i;
-    char   *ptr;
-
-    for ( i = 1 ; i < argc; i++ ) {
-        if (strcmp(argv[i],"-sccz80") == 0 ) {
-            sccz80_mode = 1;
-        } else if ( strncmp(argv[i],"-zcc-opt=", 9) == 0 ) {
-            c_zcc_opt = argv[i] + 9;
-        }
-    }
-
+    sccz80_mode = sccz80;
+    c_zcc_opt = zcc_opt;
+    output = out;
     strcpy(filename,"<stdin>");
     lineno = 0;
+    line_len = 0;
+}
 
-    while ( fgets(buf, sizeof(buf) - 1, stdin) != NULL ) {
-        lineno++;
-        ptr = skip_ws(buf);
-        if ( strncmp(ptr,"#pragma", 7) == 0 ) {
-            int  ol = 1;
-            ptr = skip_ws(ptr + 7);
-         
-            if ( ( strncmp(ptr, "output",6) == 0 ) || ( strncmp(ptr, "define",6) == 0 ) || ( strncmp(ptr, "export",6) == 0 ) ) {
-                char *offs;
-                int   value = 0;
+/* Process one line of preprocessed source, the line may be modified */
+void zpragma_line(char *line)
+{
+    char   *ptr;
+
+    lineno++;
+    ptr = skip_ws(line);
+    if ( strncmp(ptr,"#pragma", 7) == 0 ) {
+        int  ol = 1;
+        ptr = skip_ws(ptr + 7);
+     
+        if ( ( strncmp(ptr, "output",6) == 0 ) || ( strncmp(ptr, "define",6) == 0 ) || ( strncmp(ptr, "export",6) == 0 ) ) {
+            char *offs;
+            int   value = 0;
 				int   exp = strncmp(ptr, "export",6) == 0;
 
-                ptr = skip_ws(ptr+6);
-                
-                if ( (offs = strchr(ptr+1,'=') ) != NULL  ) {
-                    value = (int)strtol(offs+1,NULL,0);
-                    *offs = 0;
-                }
-                write_defined(ptr,value,exp);
-                if ( strncmp(ptr, "STACKPTR",8) == 0 ) {
-                    write_defined("REGISTER_SP",value,exp);                    
-                }
-                if ( strncmp(ptr, "nostreams",9) == 0 ) {
-                    write_defined("CRT_ENABLE_STDIO",0,exp);                    
-                }
-            } else if ( strncmp(ptr, "redirect",8) == 0 ) {
-                char *offs;
-                char *value = "0";
-                ptr = skip_ws(ptr+8);
-                if ( (offs = strchr(ptr+1,'=') ) != NULL  ) {
-                    value = offs + 1;
-                    *offs = 0;
-                }
-                write_redirect(ptr,value);
-            } else if ( strncmp(ptr,"printf", 6) == 0 ) {
-                uint64_t value = parse_format_string(ptr + 6, printf_formats);
-                write_defined("CLIB_OPT_PRINTF", (int32_t)(value & 0xffffffff), 0);
-                write_defined("CLIB_OPT_PRINTF_2", (int32_t)((value >> 32) & 0xffffffff), 0);
-            } else if ( strncmp(ptr,"scanf", 5) == 0 ) {
-                uint64_t value = parse_format_string(ptr + 5, scanf_formats);
-                write_defined("CLIB_OPT_SCANF", (int32_t)(value & 0xffffffff), 0);
-                write_defined("CLIB_OPT_SCANF_2", (int32_t)((value >> 32) & 0xffffffff), 0);
-            } else if ( strncmp(ptr,"string",6) == 0 ) {
-                write_pragma_string(ptr + 6);
-            } else if ( strncmp(ptr, "data", 4) == 0 ) {
-                write_bytes(ptr + 4, 1);
-            } else if ( strncmp(ptr, "byte", 4) == 0 ) {
-                write_bytes(ptr + 4, 0);
-            } else if ( sccz80_mode == 0 && strncmp(ptr, "asm", 3) == 0 ) {
-                fputs("__asm\n",stdout);
-                ol = 0;
-            } else if ( sccz80_mode == 0 && strncmp(ptr, "endasm", 6) == 0 ) {
-                fputs("__endasm;\n",stdout);
-                ol = 0;
-            } else if ( sccz80_mode == 1 && strncmp(ptr, "asm", 3) == 0 ) {
-                fputs("#asm\n",stdout);
-                ol = 0;
-            } else if ( sccz80_mode == 1 && strncmp(ptr, "endasm", 6) == 0 ) {
-                fputs("#endasm\n",stdout);
-                ol = 0;
-            } else if (strncmp(ptr, "-zorg=", 6) == 0 ) {
-                /* It's an option, this may tweak something */
-                write_defined("CRT_ORG_CODE", strtol(ptr+6, NULL, 0), 0);
-            } else if ( strncmp(ptr, "-reqpag=", 8) == 0 ) {
-                write_defined("CRT_Z88_BADPAGES", strtol(ptr+8, NULL, 0), 0);
-            } else if ( strncmp(ptr, "-defvars=", 8) == 0 ) {
-                write_defined("defvarsaddr", strtol(ptr+8, NULL, 0), 0);
-            } else if ( strncmp(ptr, "-safedata=", 10) == 0 ) {
-                write_defined("CRT_Z88_SAFEDATA", strtol(ptr+9, NULL, 0), 0);
-            } else if ( strncmp(ptr, "-startup=", 9) == 0 ) {
-                write_defined("startup", strtol(ptr+9, NULL, 0), 0);
-            } else if ( strncmp(ptr, "-farheap=", 9) == 0 ) {
-                write_defined("farheapsz", strtol(ptr+9, NULL, 0), 0);
-            } else if ( strncmp(ptr, "-expandz88", 9) == 0 ) {
-                write_defined("CRT_Z88_EXPANDED", 1, 0);
-            } else if ( strncmp(ptr, "-no-expandz88", 9) == 0 ) {
-                write_defined("CRT_Z88_EXPANDED", 0, 0);
-            } else {
-                printf("%s\n",buf);
+            ptr = skip_ws(ptr+6);
+            
+            if ( (offs = strchr(ptr+1,'=') ) != NULL  ) {
+                value = (int)strtol(offs+1,NULL,0);
+                *offs = 0;
+            }
+            write_defined(ptr,value,exp);
+            if ( strncmp(ptr, "STACKPTR",8) == 0 ) {
+                write_defined("REGISTER_SP",value,exp);                    
             }
-            if ( ol ) {
-                fputs("\n",stdout);
+            if ( strncmp(ptr, "nostreams",9) == 0 ) {
+                write_defined("CRT_ENABLE_STDIO",0,exp);                    
             }
-        } else if ( sccz80_mode == 0 && strncmp(ptr, "#asm", 4) == 0 ) {
-            fputs("__asm\n",stdout);
-        } else if ( sccz80_mode == 0 && strncmp(ptr, "#endasm", 7) == 0 ) {
-            fputs("__endasm;\n",stdout);
-        } else if ( sccz80_mode == 1 && strncmp(ptr, "__asm", 5) == 0 && strncmp(ptr,"__asm__", 7) ) {
-            fputs("#asm\n",stdout);
-        } else if ( sccz80_mode == 1 && strncmp(ptr, "__endasm", 8) == 0 ) {
-            fputs("#endasm;\n",stdout);
+        } else if ( strncmp(ptr, "redirect",8) == 0 ) {
+            char *offs;
+            char *value = "0";
+            ptr = skip_ws(ptr+8);
+            if ( (offs = strchr(ptr+1,'=') ) != NULL  ) {
+                value = offs + 1;
+                *offs = 0;
+            }
+            write_redirect(ptr,value);
+        } else if ( strncmp(ptr,"printf", 6) == 0 ) {
+            uint64_t value = parse_format_string(ptr + 6, printf_formats);
+            write_defined("CLIB_OPT_PRINTF", (int32_t)(value & 0xffffffff), 0);
+            write_defined("CLIB_OPT_PRINTF_2", (int32_t)((value >> 32) & 0xffffffff), 0);
+        } else if ( strncmp(ptr,"scanf", 5) == 0 ) {
+            uint64_t value = parse_format_string(ptr + 5, scanf_formats);
+            write_defined("CLIB_OPT_SCANF", (int32_t)(value & 0xffffffff), 0);
+            write_defined("CLIB_OPT_SCANF_2", (int32_t)((value >> 32) & 0xffffffff), 0);
+        } else if ( strncmp(ptr,"string",6) == 0 ) {
+            write_pragma_string(ptr + 6);
+        } else if ( strncmp(ptr, "data", 4) == 0 ) {
+            write_bytes(ptr + 4, 1);
+        } else if ( strncmp(ptr, "byte", 4) == 0 ) {
+            write_bytes(ptr + 4, 0);
+        } else if ( sccz80_mode == 0 && strncmp(ptr, "asm", 3) == 0 ) {
+            fputs("__asm\n",output);
+            ol = 0;
+        } else if ( sccz80_mode == 0 && strncmp(ptr, "endasm", 6) == 0 ) {
+            fputs("__endasm;\n",output);
+            ol = 0;
+        } else if ( sccz80_mode == 1 && strncmp(ptr, "asm", 3) == 0 ) {
+            fputs("#asm\n",output);
+            ol = 0;
+        } else if ( sccz80_mode == 1 && strncmp(ptr, "endasm", 6) == 0 ) {
+            fputs("#endasm\n",output);
+            ol = 0;
+        } else if (strncmp(ptr, "-zorg=", 6) == 0 ) {
+            /* It's an option, this may tweak something */
+            write_defined("CRT_ORG_CODE", strtol(ptr+6, NULL, 0), 0);
+        } else if ( strncmp(ptr, "-reqpag=", 8) == 0 ) {
+            write_defined("CRT_Z88_BADPAGES", strtol(ptr+8, NULL, 0), 0);
+        } else if ( strncmp(ptr, "-defvars=", 8) == 0 ) {
+            write_defined("defvarsaddr", strtol(ptr+8, NULL, 0), 0);
+        } else if ( strncmp(ptr, "-safedata=", 10) == 0 ) {
+            write_defined("CRT_Z88_SAFEDATA", strtol(ptr+9, NULL, 0), 0);
+        } else if ( strncmp(ptr, "-startup=", 9) == 0 ) {
+            write_defined("startup", strtol(ptr+9, NULL, 0), 0);
+        } else if ( strncmp(ptr, "-farheap=", 9) == 0 ) {
+            write_defined("farheapsz", strtol(ptr+9, NULL, 0), 0);
+        } else if ( strncmp(ptr, "-expandz88", 9) == 0 ) {
+            write_defined("CRT_Z88_EXPANDED", 1, 0);
+        } else if ( strncmp(ptr, "-no-expandz88", 9) == 0 ) {
+            write_defined("CRT_Z88_EXPANDED", 0, 0);
         } else {
-            int skip = 0;
-            if ( (skip=2, strncmp(ptr,"# ",2) == 0)  || ( skip=5, strncmp(ptr,"#line",5) == 0) ) {
-                int     num=0;
-                char    tmp[FILENAME_MAX+1];
+            fprintf(output,"%s\n",line);
+        }
+        if ( ol ) {
+            fputs("\n",output);
+        }
+    } else if ( sccz80_mode == 0 && strncmp(ptr, "#asm", 4) == 0 ) {
+        fputs("__asm\n",output);
+    } else if ( sccz80_mode == 0 && strncmp(ptr, "#endasm", 7) == 0 ) {
+        fputs("__endasm;\n",output);
+    } else if ( sccz80_mode == 1 && strncmp(ptr, "__asm", 5) == 0 && strncmp(ptr,"__asm__", 7) ) {
+        fputs("#asm\n",output);
+    } else if ( sccz80_mode == 1 && strncmp(ptr, "__endasm", 8) == 0 ) {
+        fputs("#endasm;\n",output);
+    } else {
+        int skip = 0;
+        if ( (skip=2, strncmp(ptr,"# ",2) == 0)  || ( skip=5, strncmp(ptr,"#line",5) == 0) ) {
+            int     num=0;
+            char    tmp[FILENAME_MAX+1];
+
+            ptr = skip_ws(ptr + skip);
+
+            tmp[0]=0;
+            sscanf(ptr,"%d %s",&num,tmp);
+            if   (num) lineno=--num;
+            if      (strlen(tmp)) strcpy(filename,tmp);
+        }
 
-                ptr = skip_ws(ptr + skip);
+        fputs(line,output);
+    }
+}
 
-                tmp[0]=0;
-                sscanf(ptr,"%d %s",&num,tmp);
-                if   (num) lineno=--num;
-                if      (strlen(tmp)) strcpy(filename,tmp);
+/* Take preprocessed text in pieces of any length, each complete line is
+   processed as soon as it has been received */
+void zpragma_text(const char *text, size_t len)
+{
+    const char *nl;
+    size_t      n;
+
+    while ( len > 0 ) {
+        nl = memchr(text, '\n', len);
+        n = nl ? (size_t)(nl - text) + 1 : len;
+        if ( line_len + n + 1 > line_size ) {
+            line_size = (line_len + n + 1) * 2;
+            if ( (line_buf = realloc(line_buf, line_size)) == NULL ) {
+                fprintf(stderr,"Out of memory\n");
+                exit(1);
             }
+        }
+        memcpy(line_buf + line_len, text, n);
+        line_len += n;
+        text += n;
+        len -= n;
+        if ( nl ) {
+            line_buf[line_len] = 0;
+            zpragma_line(line_buf);
+            line_len = 0;
+        }
+    }
+}
 
-            fputs(buf,stdout);
+/* Process a last line without a newline */
+void zpragma_end(void)
+{
+    if ( line_len > 0 ) {
+        line_buf[line_len] = 0;
+        zpragma_line(line_buf);
+        line_len = 0;
+    }
+}
+
+#ifndef ZPRAGMA_NO_MAIN
+int main(int argc, char **argv)
+{
+    static char buf[65536];
+    int     i;
+    char   *zcc_opt = "zcc_opt.def";
+    int     sccz80 = 0;
+
+    for ( i = 1 ; i < argc; i++ ) {
+        if (strcmp(argv[i],"-sccz80") == 0 ) {
+            sccz80 = 1;
+        } else if ( strncmp(argv[i],"-zcc-opt=", 9) == 0 ) {
+            zcc_opt = argv[i] + 9;
         }
     }
+
+    zpragma_init(sccz80, zcc_opt, stdout);
+    while ( fgets(buf, sizeof(buf) - 1, stdin) != NULL ) {
+        zpragma_line(buf);
+    }
+    return 0;
 }
+#endif
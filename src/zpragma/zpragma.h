@@ -0,0 +1,22 @@
+/*
+ * Filter #pragmas out of preprocessed source into zcc_opt.def
+ */
+
+#ifndef ZPRAGMA_H
+#define ZPRAGMA_H
+
+#include <stdio.h>
+
+/* Start a file, the filtered source is written to out */
+extern void zpragma_init(int sccz80, char *zcc_opt, FILE *out);
+
+/* Filter one line of source, the line may be modified */
+extern void zpragma_line(char *line);
+
+/* Filter source given in pieces of any length */
+extern void zpragma_text(const char *text, size_t len);
+
+/* Filter the last line when it has no newline */
+extern void zpragma_end(void);
+
+#endif
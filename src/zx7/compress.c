@@ -28,47 +28,51 @@
 
 #include "zx7.h"
 
-unsigned char* output_data;
-size_t output_index;
-size_t bit_index;
-int bit_mask;
-long diff;
-
-void read_bytes(int n, long *delta) {
-   diff += n;
-   if (diff > *delta)
-       *delta = diff;
+/* The output being written, one for each file compressed at the same time */
+typedef struct {
+    unsigned char *output_data;
+    size_t output_index;
+    size_t bit_index;
+    int bit_mask;
+    long diff;
+} Output;
+
+static void read_bytes(Output *out, int n, long *delta) {
+   out->diff += n;
+   if (out->diff > *delta)
+       *delta = out->diff;
 }
 
-void write_byte(int value) {
-    output_data[output_index++] = value;
-    diff--;
+static void write_byte(Output *out, int value) {
+    out->output_data[out->output_index++] = value;
+    out->diff--;
 }
 
-void write_bit(int value) {
-    if (bit_mask == 0) {
-        bit_mask = 128;
-        bit_index = output_index;
-        write_byte(0);
+static void write_bit(Output *out, int value) {
+    if (out->bit_mask == 0) {
+        out->bit_mask = 128;
+        out->bit_index = out->output_index;
+        write_byte(out, 0);
     }
     if (value > 0) {
-        output_data[bit_index] |= bit_mask;
+        out->output_data[out->bit_index] |= out->bit_mask;
     }
-    bit_mask >>= 1;
+    out->bit_mask >>= 1;
 }
 
-void write_elias_gamma(int value) {
+static void write_elias_gamma(Output *out, int value) {
     int i;
 
     for (i = 2; i <= value; i <<= 1) {
-        write_bit(0);
+        write_bit(out, 0);
     }
     while ((i >>= 1) > 0) {
-        write_bit(value & i);
+        write_bit(out, value & i);
     }
 }
 
 unsigned char *compress(Optimal *optimal, unsigned char *input_data, size_t input_size, long skip, size_t *output_size, long *delta) {
+    Output out;
     size_t input_index;
     size_t input_prev;
     int offset1;
@@ -78,14 +82,14 @@ unsigned char *compress(Optimal *optimal, unsigned char *input_data, size_t inpu
     /* calculate and allocate output buffer */
     input_index = input_size-1;
     *output_size = (optimal[input_index].bits+18+7)/8;
-    output_data = (unsigned char *)malloc(*output_size);
-    if (!output_data) {
+    out.output_data = (unsigned char *)malloc(*output_size);
+    if (!out.output_data) {
          fprintf(stderr, "Error: Insufficient memory\n");
          exit(1);
     }
 
     /* initialize delta */
-    diff = *output_size - input_size + skip;
+    out.diff = *output_size - input_size + skip;
     *delta = 0;
 
     /* un-reverse optimal sequence */
@@ -96,55 +100,55 @@ unsigned char *compress(Optimal *optimal, unsigned char *input_data, size_t inpu
         input_index = input_prev;
     }
 
-    output_index = 0;
-    bit_mask = 0;
+    out.output_index = 0;
+    out.bit_mask = 0;
 
     /* first byte is always literal */
-    write_byte(input_data[input_index]);
-    read_bytes(1, delta);
+    write_byte(&out, input_data[input_index]);
+    read_bytes(&out, 1, delta);
 
     /* process remaining bytes */
     while ((input_index = optimal[input_index].bits) > 0) {
         if (optimal[input_index].len == 0) {
 
             /* literal indicator */
-            write_bit(0);
+            write_bit(&out, 0);
 
             /* literal value */
-            write_byte(input_data[input_index]);
-            read_bytes(1, delta);
+            write_byte(&out, input_data[input_index]);
+            read_bytes(&out, 1, delta);
 
         } else {
 
             /* sequence indicator */
-            write_bit(1);
+            write_bit(&out, 1);
 
             /* sequence length */
-            write_elias_gamma(optimal[input_index].len-1);
+            write_elias_gamma(&out, optimal[input_index].len-1);
 
             /* sequence offset */
             offset1 = optimal[input_index].offset-1;
             if (offset1 < 128) {
-                write_byte(offset1);
+                write_byte(&out, offset1);
             } else {
                 offset1 -= 128;
-                write_byte((offset1 & 127) | 128);
+                write_byte(&out, (offset1 & 127) | 128);
                 for (mask = 1024; mask > 127; mask >>= 1) {
-                    write_bit(offset1 & mask);
+                    write_bit(&out, offset1 & mask);
                 }
             }
-            read_bytes(optimal[input_index].len, delta);
+            read_bytes(&out, optimal[input_index].len, delta);
         }
     }
 
     /* sequence indicator */
-    write_bit(1);
+    write_bit(&out, 1);
 
     /* end marker > MAX_LEN */
     for (i = 0; i < 16; i++) {
-        write_bit(0);
+        write_bit(&out, 0);
     }
-    write_bit(1);
+    write_bit(&out, 1);
 
-    return output_data;
+    return out.output_data;
 }
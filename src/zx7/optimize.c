@@ -25,6 +25,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "zx7.h"
 
@@ -43,31 +44,116 @@ int count_bits(int offset, int len) {
     return 1 + (offset > 128 ? 12 : 8) + elias_gamma_bits(len-1);
 }
 
+/* Of two positions to come from, the one with fewer bits and, when equal,
+   the later one, that is, the shorter sequence */
+static int better_position(Optimal *optimal, int a, int b) {
+    if (a < 0 || b < 0) {
+        return a < 0 ? b : a;
+    }
+    if (optimal[a].bits != optimal[b].bits) {
+        return optimal[a].bits < optimal[b].bits ? a : b;
+    }
+    return a > b ? a : b;
+}
+
+/* The positions are kept in a segment tree of the best position in each
+   range, so that the best of a long range of lengths is found at once */
+static void add_position(Optimal *optimal, int *tree, size_t tree_size, size_t position) {
+    size_t node;
+
+    node = tree_size + position;
+    tree[node] = position;
+    for (node >>= 1; node > 0; node >>= 1) {
+        tree[node] = better_position(optimal, tree[2*node], tree[2*node+1]);
+    }
+}
+
+static int best_position(Optimal *optimal, int *tree, size_t tree_size, size_t first, size_t last) {
+    size_t lo;
+    size_t hi;
+    int best;
+
+    best = -1;
+    for (lo = tree_size + first, hi = tree_size + last + 1; lo < hi; lo >>= 1, hi >>= 1) {
+        if (lo & 1) {
+            best = better_position(optimal, best, tree[lo++]);
+        }
+        if (hi & 1) {
+            best = better_position(optimal, best, tree[--hi]);
+        }
+    }
+    return best;
+}
+
+/* Try the sequences of lengths first_len to last_len at offset, shortest
+   first, each one only replacing a strictly better encoding. The lengths
+   with the same Elias gamma code cost the same, so a long run of them
+   just needs the best position to come from */
+static void try_sequences(Optimal *optimal, int *tree, size_t tree_size, size_t i, int offset, size_t first_len, size_t last_len) {
+    size_t len;
+    size_t band_end;
+    size_t bits;
+    int position;
+
+    for (len = first_len; len <= last_len; len = band_end+1) {
+        for (band_end = 2; band_end < len; band_end <<= 1) {
+        }
+        if (band_end > last_len) {
+            band_end = last_len;
+        }
+        if (band_end-len < 8) {
+            for (; len <= band_end; len++) {
+                bits = optimal[i-len].bits + count_bits(offset, len);
+                if (optimal[i].bits > bits) {
+                    optimal[i].bits = bits;
+                    optimal[i].offset = offset;
+                    optimal[i].len = len;
+                }
+            }
+        } else {
+            position = best_position(optimal, tree, tree_size, i-band_end, i-len);
+            bits = optimal[position].bits + count_bits(offset, i-position);
+            if (optimal[i].bits > bits) {
+                optimal[i].bits = bits;
+                optimal[i].offset = offset;
+                optimal[i].len = i-position;
+            }
+        }
+    }
+}
+
 Optimal* optimize(unsigned char *input_data, size_t input_size, long skip) {
-    size_t *min;
-    size_t *max;
+    size_t *last;
+    size_t *last_len;
     size_t *matches;
     size_t *match_slots;
+    int *tree;
+    size_t tree_size;
     Optimal *optimal;
     size_t *match;
     int match_index;
     int offset;
     size_t len;
     size_t best_len;
-    size_t bits;
+    size_t max_len;
     size_t i;
 
+    for (tree_size = 1; tree_size < input_size; tree_size <<= 1) {
+    }
+
     /* allocate all data structures at once */
-    min = (size_t *)calloc(MAX_OFFSET+1, sizeof(size_t));
-    max = (size_t *)calloc(MAX_OFFSET+1, sizeof(size_t));
+    last = (size_t *)calloc(MAX_OFFSET+1, sizeof(size_t));
+    last_len = (size_t *)calloc(MAX_OFFSET+1, sizeof(size_t));
     matches = (size_t *)calloc(256*256, sizeof(size_t));
     match_slots = (size_t *)calloc(input_size, sizeof(size_t));
+    tree = (int *)malloc(2*tree_size*sizeof(int));
     optimal = (Optimal *)calloc(input_size, sizeof(Optimal));
 
-    if (!min || !max || !matches || !match_slots || !optimal) {
+    if (!last || !last_len || !matches || !match_slots || !tree || !optimal) {
          fprintf(stderr, "Error: Insufficient memory\n");
          exit(1);
     }
+    memset(tree, -1, 2*tree_size*sizeof(int));
 
     /* index skipped bytes */
     for (i = 1; i <= skip; i++) {
@@ -78,6 +164,7 @@ Optimal* optimize(unsigned char *input_data, size_t input_size, long skip) {
 
     /* first byte is always literal */
     optimal[skip].bits = 8;
+    add_position(optimal, tree, tree_size, skip);
 
     /* process remaining bytes */
     for (; i < input_size; i++) {
@@ -85,41 +172,56 @@ Optimal* optimize(unsigned char *input_data, size_t input_size, long skip) {
         optimal[i].bits = optimal[i-1].bits + 9;
         match_index = input_data[i-1] << 8 | input_data[i];
         best_len = 1;
-        for (match = &matches[match_index]; *match != 0 && best_len < MAX_LEN; match = &match_slots[*match]) {
+        max_len = i-skip < MAX_LEN ? i-skip : MAX_LEN;
+
+        /* the offsets that share the last two bytes, nearest first: each
+           one gives the lengths longer than those of the nearer ones */
+        for (match = &matches[match_index]; *match != 0 && best_len < max_len; match = &match_slots[*match]) {
             offset = i - *match;
             if (offset > MAX_OFFSET) {
                 *match = 0;
                 break;
             }
 
-            for (len = 2; len <= MAX_LEN && i >= skip+len; len++) {
-                if (len > best_len) {
-                    best_len = len;
-                    bits = optimal[i-len].bits + count_bits(offset, len);
-                    if (optimal[i].bits > bits) {
-                        optimal[i].bits = bits;
-                        optimal[i].offset = offset;
-                        optimal[i].len = len;
-                    }
-                } else if (max[offset] != 0 && i+1 == max[offset]+len) {
-                    len = i-min[offset];
-                    if (len > best_len) {
-                        len = best_len;
-                    }
-                }
-                if (i < offset+len || input_data[i-len] != input_data[i-len-offset]) {
-                    break;
+            /* no sequence at a farther offset can be longer */
+            if (best_len > i-offset) {
+                break;
+            }
+
+            /* the match at this offset is one longer than at the previous
+               byte, or it is counted back from here unless it cannot be
+               longer than best_len */
+            if (last[offset] == i-1) {
+                len = last_len[offset]+1;
+            } else if (input_data[i-best_len] != input_data[i-best_len-offset]) {
+                continue;
+            } else {
+                for (len = 2; len <= i-offset && input_data[i-len] == input_data[i-len-offset]; len++) {
                 }
             }
-            min[offset] = i+1-len;
-            max[offset] = i;
+            last[offset] = i;
+            last_len[offset] = len;
+
+            if (len > max_len) {
+                len = max_len;
+            }
+            if (len > best_len) {
+                try_sequences(optimal, tree, tree_size, i, offset, best_len+1, len);
+                best_len = len;
+            }
         }
         match_slots[i] = matches[match_index];
         matches[match_index] = i;
+
+        add_position(optimal, tree, tree_size, i);
     }
 
-    /* save time by releasing the largest block only, the O.S. will clean everything else later */
+    /* release everything but the result, several files may be compressed in turn */
+    free(last);
+    free(last_len);
+    free(matches);
     free(match_slots);
+    free(tree);
 
     return optimal;
 }
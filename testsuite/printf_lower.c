@@ -0,0 +1,36 @@
+
+typedef struct { char flags; } FILE;
+
+extern FILE *stdout;
+
+extern int printf(char *fmt, ...) __smallc;
+extern int fprintf(FILE *fp, char *fmt, ...) __smallc;
+
+int printf_text()
+{
+    return printf("Hello world\n");
+}
+
+void printf_conversions(int i, unsigned int u, char *s, char c)
+{
+    printf("%d %i %u %o %x %X %s %c 100%%\n", i, i, u, u, u, u, s, c);
+}
+
+void printf_long(long l, unsigned long ul)
+{
+    printf("%ld %lu %lx\n", l, ul, ul);
+}
+
+int fprintf_conversions(FILE *fp, int i)
+{
+    return fprintf(fp, "Score: %d", i);
+}
+
+void printf_not_lowered(char *fmt, int i, long l)
+{
+    printf(fmt, i);               // Format not constant
+    printf("%5d", i);             // Width
+    printf("%f", 1.0);            // Float
+    printf("%d", l);              // Long for %d
+    printf("%d %d", i);           // Missing argument
+}